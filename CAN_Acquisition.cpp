@@ -39,6 +39,11 @@ cAcquireCAN::cAcquireCAN(ACQ_CAN_PORT _portNumber)
 	queryIndex   = 0;
 	RxCtr        = 0;
 	TxCtr        = 0;
+	queryMs      = QUERY_MS;
+	trace        = NULL;
+	trigger      = NULL;
+	extAccept    = false;
+	baudRate     = NONE;
 
 	//set pointer reference to proper object for that physical port
 	portNumber = _portNumber;
@@ -53,6 +58,8 @@ cAcquireCAN::cAcquireCAN(ACQ_CAN_PORT _portNumber)
  */
 void cAcquireCAN::initialize(ACQ_BAUD_RATE baud)
 {
+	baudRate = baud;
+
 	if (portNumber == CAN_PORT_0)
 	{
 		//setup port0 hardware
@@ -82,6 +89,9 @@ void cAcquireCAN::initialize(ACQ_BAUD_RATE baud)
 
 
 
+			//timestamp = the frame is complete
+			CAN.set_timestamp_capture_point(1);
+
 			//enable RX interrupt for mailbox0
 			CAN.enable_interrupt(CAN_IER_MB0);
 		}
@@ -113,10 +123,25 @@ void cAcquireCAN::initialize(ACQ_BAUD_RATE baud)
 			CAN2.mailbox_set_priority(1, 15);
 			CAN2.mailbox_set_datalen(1, 8);
 
+			//timestamp = the frame is complete
+			CAN2.set_timestamp_capture_point(1);
+
 			//enable RX interrupt for mailbox1
 			CAN2.enable_interrupt(CAN_IER_MB0);
 		}
 	}
+
+	//reset_all_mailbox() closed the 29bit mailbox
+	if (extAccept)
+	{
+		acceptExtended();
+	}
+
+	//a trigger capture set before the port was initialized sees every ID too
+	if (trigger)
+	{
+		triggerMailboxes(true);
+	}
 }
 
 /**
@@ -152,8 +177,8 @@ void cAcquireCAN::addMessage(cCANFrame *frame, ACQ_FRAME_TYPE type)
 
 		//we need to setup the masks for the ID's in the receive mailbox
 		//receive mailbox is mailbox #0
-		MAM_mask = buildMAM(frame->ID);
-		MID_mask |= frame->ID;
+		MAM_mask = buildMAM(frame->ID, frame->mask);
+		MID_mask |= frame->ID & frame->mask;
 	}
 
 }
@@ -163,18 +188,23 @@ void cAcquireCAN::addMessage(cCANFrame *frame, ACQ_FRAME_TYPE type)
  * Each new message must be bitwise compared (NOR) with previous messages to compile a common bitmask.
  * 
  * @param ID     New ID being added to the RX queue
+ * @param mask   acceptance mask of the new ID, bits set to '0' are "don't care"
  * @return MAM mask file per STM hardware requirements 
  */
-U32 cAcquireCAN::buildMAM(U32 ID)
+U32 cAcquireCAN::buildMAM(U32 ID, U32 mask)
 {
 	U32 XOR_mask;
 	U32 retVal;
 	U8  i;
 
+	//any "don't care" bits of the new ID can never be used for filtering
+	XOR_mask = ~mask;
+
 	for (i=0; i < msgCntRx; i++)
 	{
 		//XOR new ID with all messages, all bits that do not match are set to 1 in XOR mask
-		XOR_mask |= rxMsgs[i]->ID^ID; 
+		//as are all the "don't care" bits of messages that accept a range of ID's
+		XOR_mask |= (rxMsgs[i]->ID^ID) | ~rxMsgs[i]->mask; 
 	}
 	//per page 1211 of datasheet, invert all non-matching bits to '0'
 	retVal = ~XOR_mask;
@@ -190,16 +220,23 @@ U32 cAcquireCAN::buildMAM(U32 ID)
 void cAcquireCAN::runRates(ACQ_RATE_CAN rate)
 {
 	UINT8 i ;
+	bool sent;
 
 	if (rate == QUERY_MSG)
 	{
-		//check to see if we have any query message entries
-		if (msgCntQuery)
+		//transmit the next message in the "query-response" queue,
+		//only send a single message to allow time for the node to respond before making another request.
+		//messages that abort their transmission (e.g. a PID that is backing off) do not use up the query slot, 
+		//move on to the next message in the queue
+		for (i=0; i < msgCntQuery; i++)
 		{
-			//transmit the next message in the "query-response" queue,
-			//only send a single message to allow time for the node to respond before making another request
-			TXmsg(queryMsgs[queryIndex]);
+			sent = TXmsg(queryMsgs[queryIndex]);
 			queryIndex = (queryIndex == (msgCntQuery - 1)) ?  0 : queryIndex + 1;
+
+			if (sent)
+			{
+				break;
+			}
 		}
 
 	} else
@@ -221,20 +258,14 @@ void cAcquireCAN::runRates(ACQ_RATE_CAN rate)
  * This method transmits a single frame using the low-level driver code
  * 
  * @param *I  - pointer to cCANFrame object to be transmitted
+ * @return - true if the frame was transmitted, false if the frame's CallbackTx() aborted it
  */
-void cAcquireCAN::TXmsg(cCANFrame *I)
+bool cAcquireCAN::TXmsg(cCANFrame *I)
 {
-	UINT32 mbStatus, status;
+	UINT32 mbStatus, status, sentTime;
 	bool validFrame = false;
-
-	// transmit a message here, set up CAN hardware
-	//wait until our mailbox is ready to accept a new message and we are not in a bus error state
-	do
-	{
-		mbStatus = C->mailbox_get_status(1);
-		status = C->get_status();
-
-	}while (!(mbStatus & CAN_MSR_MRDY) && !(status & CAN_SR_ERRP) && !(status & CAN_SR_BOFF));
+	bool loaded = false;
+	bool masked;
 
 	//if a higher level protocol is used, fire callback to handle any modificaiton of the message or abort message
 	validFrame = I->CallbackTx();
@@ -242,20 +273,162 @@ void cAcquireCAN::TXmsg(cCANFrame *I)
 	//if no abort, stuff the frame and payload 
 	if (validFrame)
 	{
-        
-		//set CAN ID  for mailbox,check for extended ID
-		C->mailbox_set_id(1, I->ID, I->ID > 0x7FF ? true : false);
+		//called from the timer interrupt or from application code with interrupts enabled
+		masked = __get_PRIMASK();
 
-		//load payloads	for this mailbox 
-		C->mailbox_set_datal(1,I->U.P.lowerPayload);
-		C->mailbox_set_datah(1, I->U.P.upperPayload);
+		// transmit a message here, set up CAN hardware
+		//wait until our mailbox is ready to accept a new message and we are not in a bus error state.
+		//The check and the load are done with interrupts off, the CAN TX interrupt loads this mailbox too (sendFrame queue)
+		do
+		{
+			noInterrupts();
+			mbStatus = C->mailbox_get_status(1);
+			status = C->get_status();
+
+			if ((mbStatus & CAN_MSR_MRDY) || (status & CAN_SR_ERRP) || (status & CAN_SR_BOFF))
+			{
+				//set CAN ID  for mailbox,check for extended ID
+				C->mailbox_set_id(1, I->ID, I->ID > 0x7FF ? true : false);
+
+				//sendFrame() sets the length (and the remote flag) of the frames it forwards, scheduled frames are data frames
+				C->mailbox_set_datalen(1, (I->dlc > 8) ? 8 : I->dlc);
+				C->mailbox_set_rtr(1, false);
+
+				//load payloads	for this mailbox 
+				C->mailbox_set_datal(1,I->U.P.lowerPayload);
+				C->mailbox_set_datah(1, I->U.P.upperPayload);
+
+				// send this mailbox
+				C->global_send_transfer_cmd(CAN_TCR_MB1);
+				loaded = true;
+				sentTime = micros();
+
+				if (trace)
+				{
+					trace->log(sentTime, I->ID, I->ID > 0x7FF, false, true, (I->dlc > 8) ? 8 : I->dlc, I->U.b, portNumber);
+				}
+
+				//still with interrupts off, a response can not be handled before the frame knows it was sent
+				I->CallbackSent(sentTime);
+			}
 
-		// send this mailbox
-		C->global_send_transfer_cmd(CAN_TCR_MB1);
+			if (!masked)
+			{
+				interrupts();
+			}
+		}while (!loaded);
 
 		//increment transmit counter
 		TxCtr += 1; 
 	}
+
+	return(validFrame);
+}
+
+/**
+ * This method queues a single raw frame for transmission without waiting for a mailbox
+ * 
+ * @param F  - frame to be transmitted
+ * @return - true if the frame was sent or queued, false if the low-level TX queue is full
+ */
+bool cAcquireCAN::sendFrame(TX_CAN_FRAME &F)
+{
+	bool sent;
+	bool masked = __get_PRIMASK();
+
+	//may be called from the receive path (interrupts already off), don't turn them back on there
+	noInterrupts();
+	sent = C->sendFrame(F);
+	if (sent && trace)
+	{
+		trace->log(micros(), F.id, F.extended, F.rtr, true, F.length, F.data.bytes, portNumber);
+	}
+	if (!masked)
+	{
+		interrupts();
+	}
+
+	if (sent)
+	{
+		//increment transmit counter
+		TxCtr += 1;
+	}
+	return(sent);
+}
+
+/**
+ * Log every frame received or sent by this scheduler into a trace ring
+ * 
+ * @param ring - trace ring, NULL to stop logging
+ */
+void cAcquireCAN::setTrace(cTraceRing *ring)
+{
+	noInterrupts();
+	trace = ring;
+	interrupts();
+}
+
+/**
+ * Check every frame received by this scheduler against the conditions of a trigger capture
+ * 
+ * @param capture - trigger capture, NULL to stop checking
+ */
+void cAcquireCAN::setTrigger(cTriggerCapture *capture)
+{
+	noInterrupts();
+	trigger = capture;
+	triggerMailboxes(capture != NULL);
+	interrupts();
+}
+
+/**
+ * Receive every 29bit ID through mailbox EXT_RX_MAILBOX, mailbox 0 only takes 11bit ID's when a catch-all frame is
+ * registered
+ */
+void cAcquireCAN::acceptExtended()
+{
+	extAccept = true;
+
+	if (baudRate == NONE)
+	{
+		//initialize() opens it
+		return;
+	}
+
+	noInterrupts();
+	C->mailbox_set_mode(EXT_RX_MAILBOX, CAN_MB_RX_MODE);
+	C->setRXFilter(EXT_RX_MAILBOX, 0, 0, true);
+	interrupts();
+}
+
+/**
+ * Open / close the mailboxes that accept every ID for the trigger capture, the lowest numbered mailbox that accepts a
+ * frame takes it: frames for the registered ID's still go to mailbox 0
+ * 
+ * @param open - open the mailboxes
+ */
+void cAcquireCAN::triggerMailboxes(bool open)
+{
+	if (baudRate == NONE)
+	{
+		//initialize() opens them
+		return;
+	}
+
+	if (open)
+	{
+		C->mailbox_set_mode(TRIGGER_STD_MAILBOX, CAN_MB_RX_MODE);
+		C->setRXFilter(TRIGGER_STD_MAILBOX, 0, 0, false);
+		C->mailbox_set_mode(TRIGGER_EXT_MAILBOX, CAN_MB_RX_MODE);
+		C->setRXFilter(TRIGGER_EXT_MAILBOX, 0, 0, true);
+	}
+	else
+	{
+		C->disable_interrupt(0x01 << TRIGGER_STD_MAILBOX);
+		C->disable_interrupt(0x01 << TRIGGER_EXT_MAILBOX);
+		C->mailbox_set_mode(TRIGGER_STD_MAILBOX, CAN_MB_DISABLE_MODE);
+		C->mailbox_set_mode(TRIGGER_EXT_MAILBOX, CAN_MB_DISABLE_MODE);
+	}
 }
 
 /**
@@ -277,11 +450,21 @@ void cAcquireCAN::RXmsg()
 	//pull all data frames out of the buffer 
 	while (C->read(newFrame))
 	{
+		if (trace)
+		{
+			trace->log(micros(), newFrame.id, newFrame.extended, newFrame.rtr, false, newFrame.length, newFrame.data.bytes, portNumber);
+		}
+
+		if (trigger)
+		{
+			trigger->frame(micros(), newFrame.id, newFrame.extended, newFrame.rtr, newFrame.length, newFrame.data.bytes, portNumber);
+		}
+
 		//scan through message list and read the corresponding header ID
 		for (i=0; i < msgCntRx; i++)
 		{
-			//look for a valid entry for the CAN ID we just received        
-			if (rxMsgs[i]->ID == newFrame.id)
+			//look for a valid entry for the CAN ID we just received (only bits set in the mask must match)
+			if (((rxMsgs[i]->ID ^ newFrame.id) & rxMsgs[i]->mask) == 0)
 			{
                 
 				//fire callback to higher-level protocol (e.g. check PID parameter ID)
@@ -352,10 +535,13 @@ void cAcquireCAN::run(ACQ_MODE mode)
 		 //increment 1mS tick counter
 		_1mSCntr = (mode == TIMER_2mS) ? _1mSCntr + 2 : _1mSCntr + 1;
 
+		//higher layer protocols that keep their own time (e.g. UDS), offered a transmit slot every tick
+		runRates(TICK_MSG);
+
 		//after Xms has passed, run all xHz transmissions based upon XmS tick counter		
 
 		//transmit the next message in the "query-response" queue
-		if ((_1mSCntr - _queryCntr) >= QUERY_MS)
+		if ((_1mSCntr - _queryCntr) >= queryMs)
 		{
 			//periodic requests
 			runRates(QUERY_MSG);
@@ -443,6 +629,66 @@ UINT32 cAcquireCAN::getRxCtr()
 	return(RxCtr);
 }
 
+/**
+ * Set the time in between query-response requests (QUERY_MSG frames)
+ * 
+ * @param ms - interval in mS, limited to 1-1000mS (the scheduler tick counters restart every second)
+ */
+void cAcquireCAN::setQueryInterval(UINT16 ms)
+{
+	queryMs = (ms < 1) ? 1 : ((ms > 1000) ? 1000 : ms);
+}
+
+/**
+ * Get the time in between query-response requests
+ * 
+ * @return interval in mS
+ */
+UINT16 cAcquireCAN::getQueryInterval()
+{
+	return(queryMs);
+}
+
+/**
+ * Get the physical port this scheduler runs on
+ * 
+ * @return port number
+ */
+ACQ_CAN_PORT cAcquireCAN::getPort()
+{
+	return(portNumber);
+}
+
+/**
+ * Convert the controller timestamp of a received frame to micros()
+ * 
+ * @param R - received frame
+ * @return micros() at the end of the frame
+ */
+UINT32 cAcquireCAN::getRxTime(RX_CAN_FRAME *R)
+{
+	UINT32 age = (C->get_internal_timer_value() - R->time) & 0xFFFF;
+	UINT32 now = micros();
+
+	if (baudRate == NONE)
+	{
+		return(now);
+	}
+	return(now - (UINT32)(((UINT64)age * 1000) / baudRate));
+}
+
+/**
+ * Constructor definition for CAN frame, by default the receive mask requires an exact ID match
+ */
+cCANFrame::cCANFrame()
+{
+	ID   = 0;
+	mask = 0x1FFFFFFF;
+	dlc  = 8;
+	U.P.lowerPayload = 0;
+	U.P.upperPayload = 0;
+}
+
 /**
  * This method provides for writing the payload of the CAN frame. This is required for proper byte ordering in memory.
  * 
@@ -17,6 +17,8 @@
 #define ACQ_H
 #include "variant.h"
 #include <due_can.h>
+#include "CAN_Trace.h"
+#include "CAN_Trigger.h"
 
 //typedefs for clarity
 typedef unsigned int       UINT16;
@@ -32,9 +34,16 @@ typedef unsigned long long UINT64;
 #define  MAX_NUM_TX_MSGS 20  
 #define  MAX_NUM_RX_MSGS 30  
 
-//if implementing a query-response protocol (such as OBD2), delay this long (mS) in between requests
+//if implementing a query-response protocol (such as OBD2), delay this long (mS) in between requests (default, see setQueryInterval)
 #define  QUERY_MS 100  
 
+//mailbox that accepts every 29bit ID for the layers that receive through a catch-all frame (see acceptExtended)
+#define  EXT_RX_MAILBOX 2
+
+//while a trigger capture is set these mailboxes accept every 11bit / 29bit ID the receive mailbox 0 does not (see setTrigger)
+#define  TRIGGER_STD_MAILBOX 3
+#define  TRIGGER_EXT_MAILBOX 4
+
 /**
  *	forward declare the OBD class to the base class to support circular reference
  */
@@ -76,6 +85,7 @@ enum ACQ_RATE_CAN
     _5Hz_Rate       = 200,
     _10Hz_Rate      = 100,
     _100Hz_Rate     = 10,
+    TICK_MSG        = 0xFFFE,   //offered on every scheduler tick, the frame's CallbackTx() decides if it is sent (protocols with their own timing)
     QUERY_MSG       = 0xFFFF
 };
 
@@ -127,11 +137,22 @@ enum ACQ_MODE
 class cCANFrame
 {
 public:
+    /**
+     * constructor definition for CAN frame, by default the ID must match exactly when receiving
+     */
+    cCANFrame();
+
     /**
      * CAN message ID
      */
     UINT32 ID;      
 
+    /**
+     * receive acceptance mask, all bits set to "1" must match the corresponding bit in the ID.
+     * This allows for a single RX frame to accept a range of ID's (e.g. 0x7E8-0x7EF mask = 0x7F8)
+     */
+    UINT32 mask;
+
     /**
     * This struct/union combo provides multiple ways to access the payload of the message 
     * Can be referenced by byte or by U32 "upper" and "lower" payloads or by a simple byte array
@@ -155,6 +176,11 @@ public:
      */
     ACQ_RATE_CAN rate;
 
+    /**
+     * This is the data length code the frame is transmitted with (0-8, default 8)
+     */
+    UINT8 dlc;
+
     /**
      * This method provides for writing the payload of the CAN frame. This is required for proper byte ordering in memory.
      * 
@@ -209,6 +235,16 @@ public:
     {
         return(true);
     }
+
+    /**
+     * This is a function that is called by the acquisition scheduler once the frame has been loaded into the TX mailbox
+     * (after any wait for the mailbox), e.g. to time stamp a request.
+     *
+     * @param time - uS (micros()) when the frame was handed to the mailbox
+     */
+    virtual void CallbackSent(UINT32 time)
+    {
+    }
 };
 
 
@@ -268,8 +304,18 @@ public:
       * This method transmits a single frame using the low-level driver code
       * Made public such that sending of a "one-shot" message in applicaiton code is possible.
       * @param *I  - pointer to cCANFrame object to be transmitted
+      * @return - true if the frame was transmitted, false if the frame's CallbackTx() aborted it
       */
-    void TXmsg(cCANFrame *I);
+    bool TXmsg(cCANFrame *I);
+
+    /**
+      * This method queues a single raw frame for transmission and returns right away (the low-level driver's TX queue is
+      * drained from the CAN interrupt), it never waits for a mailbox. Used where the caller must not block, e.g. a gateway
+      * forwarding from the receive path.
+      * @param F  - frame to be transmitted, ID/extended/length/payload as received from another port
+      * @return - true if the frame was sent or queued, false if the queue is full (frame dropped)
+      */
+    bool sendFrame(TX_CAN_FRAME &F);
 
     /**
      * Get the number of messages sent by get scheduler (rolling counter value)
@@ -285,6 +331,67 @@ public:
      */
     UINT32 getRxCtr();
 
+    /**
+     * Set the time in between query-response requests (QUERY_MSG frames). Only shorten this if the nodes are known to 
+     * answer within the interval, e.g. from measured round trip times.
+     * 
+     * @param ms - interval in mS (rounded up to the 2mS tick in TIMER_2mS mode), default QUERY_MS
+     */
+    void setQueryInterval(UINT16 ms);
+
+    /**
+     * Get the time in between query-response requests
+     * 
+     * @return interval in mS
+     */
+    UINT16 getQueryInterval();
+
+    /**
+     * Get the physical port this scheduler runs on
+     * 
+     * @return port number
+     */
+    ACQ_CAN_PORT getPort();
+
+    /**
+     * Convert the controller timestamp of a received frame (RX_CAN_FRAME::time, end of frame) to micros(): the controller
+     * timer tells how many bit times ago the frame was complete. Call it before the controller timer wraps (65536 bit
+     * times, 65mS at 1M), e.g. from a frame's CallbackRx()
+     * 
+     * @param R - received frame
+     * @return micros() at the end of the frame, micros() now if the port is not initialized
+     */
+    UINT32 getRxTime(RX_CAN_FRAME *R);
+
+    /**
+     * Receive every 29bit ID. Receive mailbox 0 is set up from the ID's registered with addMessage() and is an 11bit
+     * mailbox unless a registered ID is above 0x7FF, so a catch-all frame (ID 0, mask 0) only sees 11bit frames. This
+     * opens mailbox EXT_RX_MAILBOX for every 29bit ID (interrupt enabled), the frames are dispatched by run() like any
+     * other. Can be called before initialize(), the mailbox is opened (again) there.
+     */
+    void acceptExtended();
+
+    /**
+     * Log every frame received or sent by this scheduler into a trace ring (compact binary format, see CAN_Trace.h).
+     * The ring is written from RXmsg()/TXmsg()/sendFrame() with interrupts off, drain it from loop().
+     * Two ports can share a ring as long as both are run from the same context (e.g. the same timer interrupt).
+     * 
+     * @param ring - trace ring, NULL to stop logging
+     */
+    void setTrace(cTraceRing *ring);
+
+    /**
+     * Check every frame received by this scheduler against the conditions of a pre/post-trigger capture (see
+     * CAN_Trigger.h), from RXmsg() with interrupts off. The cost per frame is bounded by the number of conditions.
+     * Receive mailbox 0 only takes the ID's registered with addMessage(), so while a capture is set two more mailboxes
+     * (TRIGGER_STD_MAILBOX, TRIGGER_EXT_MAILBOX) take every other ID and the capture holds the whole bus history.
+     * Those frames go through the driver's RX buffer too: on a busy bus run the scheduler often enough
+     * (CANRaw::get_rx_buffer_full_cnt() counts the frames lost).
+     * 
+     * @param capture - trigger capture, NULL to stop checking (and close the mailboxes)
+     */
+    void setTrigger(cTriggerCapture *capture);
+
 private:
 
     /**
@@ -292,6 +399,11 @@ private:
      */
     ACQ_CAN_PORT portNumber;
 
+    /**
+     * baud rate the port was initialized with (the controller timer counts bit times)
+     */
+    ACQ_BAUD_RATE baudRate;
+
     /**
      * pointer to raw CAN object, physical port (from lower-level CAN library)
      */
@@ -307,6 +419,11 @@ private:
     */
     UINT16 _1mSCntr, _10mSCntr, _100mSCntr, _200mSCntr, _1000mSCntr, _queryCntr;
 
+    /**
+     * time in between query-response requests (mS)
+     */
+    UINT16 queryMs;
+
     /**
      * diagnostic timing varibles used to track the execution time of the scheduler
      */
@@ -340,6 +457,28 @@ private:
     UINT32 RxCtr;
     UINT32 TxCtr;
 
+    /**
+     * trace ring the frames are logged into, NULL = none
+     */
+    cTraceRing *trace;
+
+    /**
+     * trigger capture the received frames are checked against, NULL = none
+     */
+    cTriggerCapture *trigger;
+
+    /**
+     * every 29bit ID is received through EXT_RX_MAILBOX
+     */
+    bool extAccept;
+
+    /**
+     * open / close the mailboxes that accept every ID for the trigger capture
+     * 
+     * @param open - open the mailboxes
+     */
+    void triggerMailboxes(bool open);
+
     /**
      * these are the masks used by the CAN controller hardware to allow multiple messages to be received by one mailbox
      * MAM mask - all bits set to "1's must match the corresponding value in the MID mask
@@ -370,8 +509,9 @@ private:
      * Each new message must be bitwise compared (NOR) with previous messages to compile a common bitmask.
      * 
      * @param ID     New ID being added to the RX queue
+     * @param mask   acceptance mask of the new ID, bits set to '0' are "don't care"
      * @return MAM mask file per STM hardware requirements 
      */
-    U32 buildMAM(U32 ID);
+    U32 buildMAM(U32 ID, U32 mask);
 };   
 #endif
@@ -0,0 +1,88 @@
+/*
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#ifndef CAN_DBC_H
+#define CAN_DBC_H
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * Support functions for the message headers generated from DBC files by extras/dbc2cpp/dbc2cpp.py.
+ *
+ * The generated code treats the 8 byte payload as one 64 bit word. Intel (little endian) signals are a shift and mask
+ * of the word as loaded from memory, Motorola (big endian) signals a shift and mask of the byte swapped word. The
+ * shifts and masks are constants of the generated code so a signal decodes to a load, shift and AND with no loops or
+ * branches. Signed signals are sign extended with an XOR and a subtract.
+ *
+ * The generated headers need C++11 (constexpr), the DUE core builds with -std=gnu++11.
+ *
+ * @author D.Kasamis - dan@togglebit.net
+ * @version 1.0
+ */
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__)
+#error "CAN_DBC.h expects a little endian CPU (the DUE and x86 hosts are)"
+#endif
+
+/**
+ * load the payload as a 64 bit word, byte 0 is the least significant byte
+ *
+ * @param b - payload bytes (e.g. cCANFrame::U.b)
+ * @return payload word
+ */
+static inline uint64_t dbcLoad(const uint8_t *b)
+{
+    uint64_t w;
+
+    //memcpy rather than a cast, the payload is not always 8 byte aligned
+    memcpy(&w, b, 8);
+    return(w);
+}
+
+/**
+ * store a 64 bit word as the payload, byte 0 is the least significant byte
+ *
+ * @param b - payload bytes (e.g. cCANFrame::U.b)
+ * @param w - payload word
+ */
+static inline void dbcStore(uint8_t *b, uint64_t w)
+{
+    memcpy(b, &w, 8);
+}
+
+/**
+ * byte swap the payload word, Motorola signals are extracted from the swapped word (byte 0 most significant)
+ *
+ * @param w - payload word
+ * @return swapped payload word
+ */
+constexpr uint64_t dbcSwap(uint64_t w)
+{
+    return(__builtin_bswap64(w));
+}
+
+/**
+ * sign extend a raw signal, branch free
+ *
+ * @param raw - raw signal, already masked to its length
+ * @param len - signal length in bits (1-64)
+ * @return signed raw value
+ */
+constexpr int64_t dbcSignExtend(uint64_t raw, uint8_t len)
+{
+    return((int64_t)((raw ^ (1ULL << (len - 1))) - (1ULL << (len - 1))));
+}
+
+#endif
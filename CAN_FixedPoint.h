@@ -0,0 +1,158 @@
+/*
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#ifndef FIXED_POINT_H
+#define FIXED_POINT_H
+#include <stdint.h>
+
+/**
+ * The RX path helpers CAN_FixedPoint.h, CAN_DBC.h, CAN_Signal.h, CAN_Trace.h and CAN_Trigger.h are header only and
+ * use stdint types instead of the Arduino core: the compiler can inline them into the scheduler's RX handler, and the
+ * host programs in extras/benchmarks build them with g++ on a PC.
+ */
+
+/**
+ * This is the number of fractional bits used internally for the slope and offset (Q16.16)
+ */
+#define FIXED_FRAC_BITS 16
+
+/**
+ * This class converts raw signal counts to engineering units without any floating point math (the Cortex-M3 has no FPU).
+ * The slope and offset (Y = mX+b) are converted once, when the object is created, to Q16.16 numbers that are pre-multiplied
+ * by 10^decimals. Each conversion is then one 32x32->64bit multiply, an add and a shift.
+ *
+ * The result is an integer with a decimal exponent, e.g. with decimals = 2 a value of 1234 represents 12.34 engineering units.
+ * The slope and offset must satisfy |slope * 10^decimals| < 32768 and |offset * 10^decimals| < 32768.
+ *
+ * @author D.Kasamis - dan@togglebit.net
+ * @version 1.0
+ */
+class cFixedScale
+{
+public:
+    /**
+     * default constructor, 1:1 scaling with no decimals (raw counts)
+     */
+    cFixedScale()
+    {
+        set(1.0f, 0.0f, 0);
+    }
+
+    /**
+     * constructor, pre-converts the slope and offset
+     *
+     * @param slope    - counts to engineering units slope (m)
+     * @param offset   - engineering units offset (b)
+     * @param decimals - number of decimal places in the converted integer result (result = EU * 10^decimals)
+     */
+    cFixedScale(float slope, float offset, uint8_t decimals)
+    {
+        set(slope, offset, decimals);
+    }
+
+    /**
+     * pre-convert the slope and offset to Q16.16, this is the only place floating point math is done
+     *
+     * @param slope    - counts to engineering units slope (m)
+     * @param offset   - engineering units offset (b)
+     * @param decimals - number of decimal places in the converted integer result (result = EU * 10^decimals)
+     */
+    void set(float slope, float offset, uint8_t decimals)
+    {
+        float pow10 = power10(decimals);
+
+        dec = decimals;
+        mQ  = roundQ(slope  * pow10 * (1L << FIXED_FRAC_BITS));
+
+        //fold the rounding of the result (+0.5) into the offset so convert() is a simple truncating shift
+        bQ  = roundQ(offset * pow10 * (1L << FIXED_FRAC_BITS)) + (1L << (FIXED_FRAC_BITS - 1));
+    }
+
+    /**
+     * convert raw counts to engineering units (no floating point)
+     *
+     * @param raw - raw signal counts (sign extended by the caller if the signal is signed)
+     * @return engineering units * 10^decimals
+     */
+    int32_t convert(int32_t raw) const
+    {
+        return((int32_t)((((int64_t)raw * mQ) + bQ) >> FIXED_FRAC_BITS));
+    }
+
+    /**
+     * get the number of decimal places of the converted result
+     *
+     * @return number of decimals (result = EU * 10^decimals)
+     */
+    uint8_t getDecimals() const
+    {
+        return(dec);
+    }
+
+    /**
+     * check a slope and offset against the limits of the Q16.16 conversion, set() does not check them (a value out of
+     * range overflows the conversion to int32_t)
+     *
+     * @param slope    - counts to engineering units slope (m)
+     * @param offset   - engineering units offset (b)
+     * @param decimals - number of decimal places in the converted integer result
+     * @return true if |slope * 10^decimals| < 32768 and |offset * 10^decimals| < 32768
+     */
+    static bool fits(float slope, float offset, uint8_t decimals)
+    {
+        float pow10 = power10(decimals);
+
+        slope  *= pow10;
+        offset *= pow10;
+        return((slope > -32768.0f) && (slope < 32768.0f) && (offset > -32768.0f) && (offset < 32768.0f));
+    }
+
+private:
+    /**
+     * 10^decimals
+     */
+    static float power10(uint8_t decimals)
+    {
+        float pow10 = 1.0f;
+        uint8_t i;
+
+        for (i=0; i < decimals; i++)
+        {
+            pow10 *= 10.0f;
+        }
+        return(pow10);
+    }
+
+    /**
+     * round a float to the nearest integer (avoids pulling in the math library)
+     */
+    static int32_t roundQ(float f)
+    {
+        return((int32_t)(f < 0 ? f - 0.5f : f + 0.5f));
+    }
+
+    /**
+     * Q16.16 slope and offset pre-multiplied by 10^decimals
+     */
+    int32_t mQ;
+    int32_t bQ;
+
+    /**
+     * number of decimal places in the result
+     */
+    uint8_t dec;
+};
+
+#endif
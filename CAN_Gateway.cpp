@@ -0,0 +1,766 @@
+/*
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#include "CAN_Gateway.h"
+
+/**
+ * the gateway that owns the cut-through interrupt hooks
+ */
+cCANGateway *cCANGateway::cutThrough = NULL;
+
+/**
+ * constructor, registers the catch-all receive frame with both acquisition schedulers
+ *
+ * @param _port0 - CAN0 scheduler
+ * @param _port1 - CAN1 scheduler
+ */
+cCANGateway::cCANGateway(cAcquireCAN *_port0, cAcquireCAN *_port1)
+{
+	UINT8 i;
+
+	ports[CAN_PORT_0] = _port0;
+	ports[CAN_PORT_1] = _port1;
+	raw[CAN_PORT_0]   = &CAN;
+	raw[CAN_PORT_1]   = &CAN2;
+	numRoutes         = 0;
+	unroutedCtr       = 0;
+	memset(stdMap, 0, sizeof(stdMap));
+	memset(extHash, 0, sizeof(extHash));
+	memset(numExtMasked, 0, sizeof(numExtMasked));
+	memset(ctQueue, 0, sizeof(ctQueue));
+	memset((void *)pendingMask, 0, sizeof(pendingMask));
+	memset(tickNs, 0, sizeof(tickNs));
+	resetLatency(CAN_PORT_0);
+	resetLatency(CAN_PORT_1);
+
+	//
+	//********** RX RECEIVE FRAMES ****************
+	//
+	//every frame on both ports (mask 0), the routing table does the filtering. Mailbox 0 takes the 11bit ID's,
+	//EXT_RX_MAILBOX the 29bit ID's
+	//
+	for (i = 0; i < 2; i++)
+	{
+		RXFrame[i].ID     = 0;
+		RXFrame[i].mask   = 0;
+		RXFrame[i].parent = this;
+		RXFrame[i].port   = (ACQ_CAN_PORT)i;
+		ports[i]->addMessage(&RXFrame[i], RECEIVE);
+		ports[i]->acceptExtended();
+	}
+
+	//
+	//********** TX POLICY FRAMES ****************
+	//
+	//never sent, forwards the frames held back by a policy on every tick
+	//
+	for (i = 0; i < 2; i++)
+	{
+		TickFrame[i].rate   = TICK_MSG;
+		TickFrame[i].parent = this;
+		TickFrame[i].port   = (ACQ_CAN_PORT)i;
+		ports[i]->addMessage(&TickFrame[i], TRANSMIT);
+	}
+}
+
+/**
+ * Add a route
+ *
+ * @param src   - source port
+ * @param ID    - CAN ID to match, ID's > 0x7FF are 29bit
+ * @param mask  - bits set to 1 must match the ID
+ * @param dest  - destination port(s)
+ * @param newID - ID to forward with, GW_KEEP_ID to keep the received ID
+ * @return - route index, GW_INVALID_ROUTE if the table is full
+ */
+UINT8 cCANGateway::addRoute(ACQ_CAN_PORT src, UINT32 ID, UINT32 mask, UINT8 dest, UINT32 newID)
+{
+	UINT8 *entry = NULL;
+	bool masked = false;
+	UINT8 i, h;
+	UINT16 id;
+
+	if (numRoutes >= GW_MAX_ROUTES)
+	{
+		return(GW_INVALID_ROUTE);
+	}
+
+	//find the slot before anything is changed, a route that doesn't fit is refused as a whole
+	if (ID > 0x7FF)
+	{
+		if ((mask & 0x1FFFFFFF) == 0x1FFFFFFF)
+		{
+			for (i = 0, h = hash(ID); i < GW_EXT_PROBES; i++, h = (h + 1) & (GW_EXT_HASH_SIZE - 1))
+			{
+				if (!extHash[src][h])
+				{
+					entry = &extHash[src][h];
+					break;
+				}
+			}
+		}
+		else if (numExtMasked[src] < GW_MAX_EXT_MASKED)
+		{
+			entry  = &extMasked[src][numExtMasked[src]];
+			masked = true;
+		}
+
+		if (!entry)
+		{
+			return(GW_INVALID_ROUTE);
+		}
+	}
+
+	sGatewayRoute &G = routes[numRoutes];
+	G.srcPort = src;
+	G.ID      = ID;
+	G.mask    = mask;
+	G.dest    = dest;
+	G.newID   = newID;
+	G.andMask = 0xFFFFFFFFFFFFFFFFULL;
+	G.orMask  = 0;
+	G.rewrite = NULL;
+	G.cutThrough = false;
+	G.policy  = false;
+	G.maxRate = 0;
+	G.burst   = 1;
+	G.onChange  = false;
+	G.refreshMs = 0;
+	G.downsampleMs = 0;
+	G.sent    = false;
+	G.lastMs  = 0;
+	G.tokens  = 0;
+	G.tokenMs = 0;
+	G.fwdCtr  = 0;
+	G.dropCtr = 0;
+	G.coalescedCtr  = 0;
+	G.suppressedCtr = 0;
+
+	noInterrupts();
+	numRoutes += 1;
+	if (entry)
+	{
+		*entry = numRoutes;
+		numExtMasked[src] += masked ? 1 : 0;
+	}
+	else
+	{
+		//11bit, expand the mask into the direct table, ID's that already have a route keep it
+		for (id = 0; id < 0x800; id++)
+		{
+			if ((((ID ^ id) & mask & 0x7FF) == 0) && !stdMap[src][id])
+			{
+				stdMap[src][id] = numRoutes;
+			}
+		}
+	}
+	interrupts();
+
+	return(numRoutes - 1);
+}
+
+/**
+ * Set the payload rewrite of a route, payload = (payload & andMask) | orMask
+ *
+ * @param route   - route index
+ * @param andMask - bits to keep (byte 0 = LSB)
+ * @param orMask  - bits to set
+ */
+void cCANGateway::setRewrite(UINT8 route, UINT64 andMask, UINT64 orMask)
+{
+	if (route < numRoutes)
+	{
+		noInterrupts();
+		routes[route].andMask = andMask;
+		routes[route].orMask  = orMask;
+		interrupts();
+	}
+}
+
+/**
+ * Set a rewrite callback for a route
+ *
+ * @param route    - route index
+ * @param callback - rewrite function, NULL for none
+ */
+void cCANGateway::setRewrite(UINT8 route, GW_REWRITE callback)
+{
+	if (route < numRoutes)
+	{
+		routes[route].rewrite = callback;
+	}
+}
+
+/**
+ * Limit the forwarding rate of a route (token bucket)
+ *
+ * @param route   - route index
+ * @param maxRate - frames/s, 0 = no limit
+ * @param burst   - number of frames that can be forwarded back to back
+ */
+void cCANGateway::setRateLimit(UINT8 route, UINT16 maxRate, UINT8 burst)
+{
+	if (route < numRoutes)
+	{
+		sGatewayRoute &G = routes[route];
+
+		noInterrupts();
+		G.maxRate = maxRate;
+		G.burst   = burst ? burst : 1;
+		G.tokens  = G.burst * 1000UL;
+		G.tokenMs = millis();
+		G.policy  = G.maxRate || G.onChange || G.downsampleMs;
+		interrupts();
+	}
+}
+
+/**
+ * Forward a route only when the frame changes
+ *
+ * @param route     - route index
+ * @param enable    - forward on change on/off
+ * @param refreshMs - unchanged frames are still forwarded when the last one is this old (mS), 0 = never
+ */
+void cCANGateway::setOnChange(UINT8 route, bool enable, UINT16 refreshMs)
+{
+	if (route < numRoutes)
+	{
+		sGatewayRoute &G = routes[route];
+
+		noInterrupts();
+		G.onChange  = enable;
+		G.refreshMs = refreshMs;
+		G.policy    = G.maxRate || G.onChange || G.downsampleMs;
+		interrupts();
+	}
+}
+
+/**
+ * Downsample a route to a scheduler rate
+ *
+ * @param route - route index
+ * @param rate  - _100Hz_Rate ... _1Hz_Rate, TICK_MSG/QUERY_MSG = off
+ */
+void cCANGateway::setDownsample(UINT8 route, ACQ_RATE_CAN rate)
+{
+	if (route < numRoutes)
+	{
+		sGatewayRoute &G = routes[route];
+
+		noInterrupts();
+		//the scheduler rates are their period in mS
+		G.downsampleMs = ((rate == TICK_MSG) || (rate == QUERY_MSG)) ? 0 : rate;
+		G.policy       = G.maxRate || G.onChange || G.downsampleMs;
+		interrupts();
+	}
+}
+
+/**
+ * Forward a route from the receive interrupt
+ *
+ * @param route  - route index
+ * @param enable - cut-through on/off
+ */
+void cCANGateway::setCutThrough(UINT8 route, bool enable)
+{
+	if (route < numRoutes)
+	{
+		routes[route].cutThrough = enable;
+	}
+}
+
+/**
+ * Start cut-through forwarding, call after both ports are initialized (the driver's init clears the hooks)
+ *
+ * @param baud0 - CAN0 baud rate
+ * @param baud1 - CAN1 baud rate
+ */
+void cCANGateway::enableCutThrough(ACQ_BAUD_RATE baud0, ACQ_BAUD_RATE baud1)
+{
+	UINT8 i;
+
+	//the controller timers count bit times
+	tickNs[CAN_PORT_0] = baud0 ? 1000000UL / baud0 : 0;
+	tickNs[CAN_PORT_1] = baud1 ? 1000000UL / baud1 : 0;
+
+	noInterrupts();
+	cutThrough = this;
+	for (i = 0; i < 2; i++)
+	{
+		//RX timestamp = the frame is complete, TX timestamp = the forwarded frame is complete
+		raw[i]->set_timestamp_capture_point(1);
+
+		raw[i]->mailbox_set_mode(GW_CT_MAILBOX, CAN_MB_TX_MODE);
+		raw[i]->mailbox_set_priority(GW_CT_MAILBOX, GW_CT_PRIORITY);
+		raw[i]->reserve_mailbox(GW_CT_MAILBOX);
+		raw[i]->setTxDoneCallback(i ? txDoneCAN1 : txDoneCAN0);
+		raw[i]->setForwardCallback(i ? forwardCAN1 : forwardCAN0);
+	}
+	interrupts();
+}
+
+/**
+ * Retrieve the cut-through latency of frames forwarded to a port
+ *
+ * @param dest - destination port
+ * @return - pointer to the latency
+ */
+const sGatewayLatency* cCANGateway::getLatency(ACQ_CAN_PORT dest)
+{
+	return(&latency[dest]);
+}
+
+/**
+ * Reset the cut-through latency of frames forwarded to a port
+ *
+ * @param dest - destination port
+ */
+void cCANGateway::resetLatency(ACQ_CAN_PORT dest)
+{
+	noInterrupts();
+	memset(&latency[dest], 0, sizeof(sGatewayLatency));
+	latency[dest].loadMin  = 0xFFFF;
+	latency[dest].totalMin = 0xFFFF;
+	interrupts();
+}
+
+/**
+ * Retrieve a route (and its counters)
+ *
+ * @param route - route index
+ * @return - pointer to the route, NULL if there is no such route
+ */
+const sGatewayRoute* cCANGateway::getRoute(UINT8 route)
+{
+	return((route < numRoutes) ? &routes[route] : NULL);
+}
+
+/**
+ * Retrieve the number of frames received that no route matched (rolling)
+ *
+ * @return - number of frames
+ */
+UINT32 cCANGateway::getUnroutedCtr()
+{
+	return(unroutedCtr);
+}
+
+/**
+ * hash of a 29bit ID, J1939 ID's differ mostly in the source address and the PDU specific byte
+ *
+ * @param id - CAN ID
+ * @return - hash table slot
+ */
+UINT8 cCANGateway::hash(UINT32 id)
+{
+	return((id ^ (id >> 6) ^ (id >> 13) ^ (id >> 21)) & (GW_EXT_HASH_SIZE - 1));
+}
+
+/**
+ * Find the route of a received frame
+ *
+ * @param src - source port
+ * @param id  - CAN ID
+ * @param ext - 29bit ID
+ * @return - route index, GW_INVALID_ROUTE if no route matches
+ */
+UINT8 cCANGateway::lookup(ACQ_CAN_PORT src, UINT32 id, bool ext)
+{
+	UINT8 i, h, r;
+
+	if (!ext)
+	{
+		return(stdMap[src][id & 0x7FF] - 1);
+	}
+
+	//exact 29bit routes, a bounded number of probes
+	for (i = 0, h = hash(id); i < GW_EXT_PROBES; i++, h = (h + 1) & (GW_EXT_HASH_SIZE - 1))
+	{
+		r = extHash[src][h];
+		if (r && (routes[r - 1].ID == id))
+		{
+			return(r - 1);
+		}
+	}
+
+	//29bit routes with a mask
+	for (i = 0; i < numExtMasked[src]; i++)
+	{
+		r = extMasked[src][i] - 1;
+		if (((routes[r].ID ^ id) & routes[r].mask & 0x1FFFFFFF) == 0)
+		{
+			return(r);
+		}
+	}
+
+	return(GW_INVALID_ROUTE);
+}
+
+/**
+ * this handler is called when any frame is received on a port, forwards it without waiting for the destination
+ *
+ * @param src - source port
+ * @param R   - pointer to the received CAN frame
+ * @return - bool the frame was routed
+ */
+bool cCANGateway::receiveFrame(ACQ_CAN_PORT src, RX_CAN_FRAME *R)
+{
+	TX_CAN_FRAME F;
+	UINT8 route;
+
+	route = lookup(src, R->id, R->extended);
+	if (route >= numRoutes)
+	{
+		unroutedCtr += 1;
+		return(false);
+	}
+
+	sGatewayRoute &G = routes[route];
+
+	if (!buildFrame(G, R, F))
+	{
+		return(true);
+	}
+
+	if (G.policy)
+	{
+		policyFrame(route, F);
+	}
+	else
+	{
+		forward(G, F);
+	}
+
+	return(true);
+}
+
+/**
+ * queue a frame on the destination port(s) of a route, never wait for a mailbox
+ *
+ * @param G - route
+ * @param F - frame to forward
+ * @return - false if no destination took the frame (TX queue full)
+ */
+bool cCANGateway::forward(sGatewayRoute &G, TX_CAN_FRAME &F)
+{
+	bool queued = false;
+	UINT8 i;
+
+	for (i = 0; i < 2; i++)
+	{
+		if (G.dest & (1 << i))
+		{
+			if (ports[i]->sendFrame(F))
+			{
+				G.fwdCtr += 1;
+				queued    = true;
+			}
+			else
+			{
+				G.dropCtr += 1;
+			}
+		}
+	}
+
+	return(queued);
+}
+
+/**
+ * apply the policies of a route to a frame to be forwarded: hold it back, and forward it if the policies allow
+ *
+ * @param route - route index
+ * @param F     - frame to forward
+ */
+void cCANGateway::policyFrame(UINT8 route, TX_CAN_FRAME &F)
+{
+	sGatewayRoute &G = routes[route];
+	UINT32 bit = 1UL << route;
+	UINT32 now = millis();
+	bool same;
+
+	same = G.sent && (F.id == G.last.id) && (F.length == G.last.length) && (F.data.value == G.last.data.value);
+
+	//unchanged and not due for a refresh: the bus already has the newest value, a held back frame is older than it
+	if (G.onChange && same && (!G.refreshMs || ((now - G.lastMs) < G.refreshMs)))
+	{
+		if (pendingMask[G.srcPort] & bit)
+		{
+			pendingMask[G.srcPort] &= ~bit;
+			G.coalescedCtr += 1;
+		}
+		G.suppressedCtr += 1;
+		return;
+	}
+
+	//a held back frame that was not forwarded yet is replaced by the newer one
+	if (pendingMask[G.srcPort] & bit)
+	{
+		G.coalescedCtr += 1;
+	}
+	G.pending = F;
+	pendingMask[G.srcPort] |= bit;
+
+	flush(route, now);
+}
+
+/**
+ * forward the held back frame of a route if the policies allow it
+ *
+ * @param route - route index
+ * @param now   - millis()
+ */
+void cCANGateway::flush(UINT8 route, UINT32 now)
+{
+	sGatewayRoute &G = routes[route];
+	UINT32 cap, elapsed;
+
+	//downsampling, one frame per period
+	if (G.downsampleMs && G.sent && ((now - G.lastMs) < G.downsampleMs))
+	{
+		return;
+	}
+
+	//token bucket, maxRate tokens per second of 1000 per frame, full after cap / maxRate mS
+	if (G.maxRate)
+	{
+		cap       = G.burst * 1000UL;
+		elapsed   = now - G.tokenMs;
+		G.tokenMs = now;
+		G.tokens  = (elapsed > (cap / G.maxRate)) ? cap : G.tokens + (elapsed * G.maxRate);
+		G.tokens  = (G.tokens > cap) ? cap : G.tokens;
+		if (G.tokens < 1000)
+		{
+			return;
+		}
+	}
+
+	//no destination took it (TX queue full), keep it for the next tick
+	if (!forward(G, G.pending))
+	{
+		return;
+	}
+
+	G.tokens -= G.maxRate ? 1000 : 0;
+	G.last    = G.pending;
+	G.lastMs  = now;
+	G.sent    = true;
+	pendingMask[G.srcPort] &= ~(1UL << route);
+}
+
+/**
+ * this handler is called by the scheduler on every tick, forwards the held back frames of a source port
+ *
+ * @param src - source port
+ */
+void cCANGateway::service(ACQ_CAN_PORT src)
+{
+	UINT32 mask = pendingMask[src];
+	UINT32 now  = millis();
+	UINT8 route;
+
+	//only the routes that hold a frame
+	while (mask)
+	{
+		route = __builtin_ctz(mask);
+		mask &= mask - 1;
+		flush(route, now);
+	}
+}
+
+/**
+ * build the frame to forward
+ *
+ * @param G - route
+ * @param R - received frame
+ * @param F - frame to forward
+ * @return - false if the rewrite callback dropped the frame
+ */
+bool cCANGateway::buildFrame(sGatewayRoute &G, RX_CAN_FRAME *R, TX_CAN_FRAME &F)
+{
+	//ID translation (the new ID decides the frame format, as with cCANFrame) and payload rewrite
+	F.id         = (G.newID == GW_KEEP_ID) ? R->id : G.newID;
+	F.extended   = (G.newID == GW_KEEP_ID) ? R->extended : (G.newID > 0x7FF);
+	F.rtr        = R->rtr;
+	F.priority   = 15;
+	F.length     = R->length;
+	F.data.value = (R->data.value & G.andMask) | G.orMask;
+
+	return(G.rewrite ? G.rewrite(&F) : true);
+}
+
+/**
+ * this handler is called from the receive interrupt, forwards the frames of cut-through routes
+ *
+ * @param src - source port
+ * @param R   - pointer to the received CAN frame
+ * @return - bool the frame was consumed (not passed on to run())
+ */
+bool cCANGateway::forwardFrame(ACQ_CAN_PORT src, RX_CAN_FRAME *R)
+{
+	TX_CAN_FRAME F;
+	UINT8 route, i, next;
+	UINT16 age;
+
+	route = lookup(src, R->id, R->extended);
+	if ((route >= numRoutes) || !routes[route].cutThrough)
+	{
+		return(false);
+	}
+
+	sGatewayRoute &G = routes[route];
+
+	if (!buildFrame(G, R, F))
+	{
+		return(true);
+	}
+
+	//time since the end of the received frame, on the source controller's timer
+	age = ((raw[src]->get_internal_timer_value() - R->time) & 0xFFFF) * tickNs[src] / 1000;
+
+	for (i = 0; i < 2; i++)
+	{
+		if (!(G.dest & (1 << i)))
+		{
+			continue;
+		}
+
+		sCutThroughQueue &Q = ctQueue[i];
+		next = (Q.tail + 1) % GW_CT_QUEUE;
+		if (next == Q.head)
+		{
+			latency[i].overflows += 1;
+			G.dropCtr += 1;
+			continue;
+		}
+
+		Q.frame[Q.tail] = F;
+		Q.age[Q.tail]   = age;
+		Q.stamp[Q.tail] = raw[i]->get_internal_timer_value();
+		Q.tail          = next;
+		G.fwdCtr       += 1;
+
+		if (!Q.busy)
+		{
+			load((ACQ_CAN_PORT)i);
+		}
+	}
+
+	return(true);
+}
+
+/**
+ * load the head of a cut-through queue into the reserved mailbox (interrupt context)
+ *
+ * @param dest - destination port
+ */
+void cCANGateway::load(ACQ_CAN_PORT dest)
+{
+	sCutThroughQueue &Q = ctQueue[dest];
+	sGatewayLatency  &L = latency[dest];
+	TX_CAN_FRAME     &F = Q.frame[Q.head];
+	CANRaw           *C = raw[dest];
+	UINT16 loadUs;
+
+	C->mailbox_set_id(GW_CT_MAILBOX, F.id, F.extended);
+	C->mailbox_set_datalen(GW_CT_MAILBOX, F.length);
+	C->mailbox_set_rtr(GW_CT_MAILBOX, F.rtr);
+	C->mailbox_set_datal(GW_CT_MAILBOX, F.data.low);
+	C->mailbox_set_datah(GW_CT_MAILBOX, F.data.high);
+	C->global_send_transfer_cmd(0x01u << GW_CT_MAILBOX);
+	C->enable_interrupt(0x01u << GW_CT_MAILBOX);
+	Q.busy = true;
+
+	loadUs = Q.age[Q.head] + ((C->get_internal_timer_value() - Q.stamp[Q.head]) & 0xFFFF) * tickNs[dest] / 1000;
+	L.loadMin = (loadUs < L.loadMin) ? loadUs : L.loadMin;
+	L.loadMax = (loadUs > L.loadMax) ? loadUs : L.loadMax;
+}
+
+/**
+ * this handler is called from the transmit interrupt when the reserved mailbox has sent its frame
+ *
+ * @param dest - destination port
+ * @param time - controller timestamp of the sent frame (end of frame)
+ */
+void cCANGateway::txDone(ACQ_CAN_PORT dest, UINT16 time)
+{
+	sCutThroughQueue &Q = ctQueue[dest];
+	sGatewayLatency  &L = latency[dest];
+	UINT16 totalUs;
+
+	if (!Q.busy)
+	{
+		return;
+	}
+
+	//end of the received frame to the end of the forwarded frame, each controller's timer is only used for a difference
+	totalUs = Q.age[Q.head] + ((time - Q.stamp[Q.head]) & 0xFFFF) * tickNs[dest] / 1000;
+	L.totalMin   = (totalUs < L.totalMin) ? totalUs : L.totalMin;
+	L.totalMax   = (totalUs > L.totalMax) ? totalUs : L.totalMax;
+	L.totalLast  = totalUs;
+	L.totalSum  += totalUs;
+	L.frames    += 1;
+
+	Q.head = (Q.head + 1) % GW_CT_QUEUE;
+	Q.busy = false;
+	if (Q.head != Q.tail)
+	{
+		load(dest);
+	}
+}
+
+/**
+ * the interrupt hooks per port
+ */
+bool cCANGateway::forwardCAN0(RX_CAN_FRAME *R)
+{
+	return(cutThrough->forwardFrame(CAN_PORT_0, R));
+}
+
+bool cCANGateway::forwardCAN1(RX_CAN_FRAME *R)
+{
+	return(cutThrough->forwardFrame(CAN_PORT_1, R));
+}
+
+void cCANGateway::txDoneCAN0(uint8_t mb, uint16_t time)
+{
+	cutThrough->txDone(CAN_PORT_0, time);
+}
+
+void cCANGateway::txDoneCAN1(uint8_t mb, uint16_t time)
+{
+	cutThrough->txDone(CAN_PORT_1, time);
+}
+
+/**
+ * This is a overridden implementaiton of the base class member that is called by the acquisition scheduler on every tick
+ *
+ * @return - a flag to transmit or skip this CAN frame, never sent
+ */
+bool cGatewayTickFrame::CallbackTx()
+{
+	parent->service(port);
+	return(false);
+}
+
+/**
+ * This is a overridden implementaiton of the base class member that is called by the acquisition scheduler when any frame is received
+ *
+ * @param R - pointer to the received CAN frame
+ * @return - a flag to accept or reject this CAN frame
+ */
+bool cGatewayRXFrame::CallbackRx(RX_CAN_FRAME *R)
+{
+	return(R ? parent->receiveFrame(port, R) : false);
+}
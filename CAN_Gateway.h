@@ -0,0 +1,472 @@
+/*
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#include "variant.h"
+#include <due_can.h>
+#include <CAN_Acquisition.h>
+
+#ifndef CAN_GATEWAY_H
+#define CAN_GATEWAY_H
+
+/**
+ *
+ * This macro is used to set the maximum number of routes (both source ports), at most 32
+ */
+#define	GW_MAX_ROUTES			32
+
+/**
+ *
+ * This macro is used to set the size of the 29bit ID hash table per source port (power of 2) and how many slots
+ * a lookup probes at most. A route that finds no free slot within GW_EXT_PROBES is refused by addRoute()
+ */
+#define	GW_EXT_HASH_SIZE		64
+#define	GW_EXT_PROBES			4
+
+/**
+ *
+ * This macro is used to set the maximum number of 29bit routes with a mask (checked one by one after the hash)
+ */
+#define	GW_MAX_EXT_MASKED		4
+
+/**
+ *
+ * These macros are used for a route that keeps the received CAN ID, and are returned when a route cannot be added
+ */
+#define	GW_KEEP_ID				0xFFFFFFFF
+#define	GW_INVALID_ROUTE		0xFF
+
+/**
+ *
+ * These macros are used to set the TX mailbox reserved for cut-through forwarding on both controllers, its priority
+ * (0 = highest, the scheduler's mailbox 1 is 15) and the number of cut-through frames that can wait for it per port.
+ * The gateway owns these mailboxes on both controllers: 0 (RX, every 11bit ID), 1 (the scheduler's TX),
+ * EXT_RX_MAILBOX (RX, every 29bit ID) and GW_CT_MAILBOX. The cut-through hook sees the frames of both RX mailboxes.
+ */
+#define	GW_CT_MAILBOX			7
+#define	GW_CT_PRIORITY			0
+#define	GW_CT_QUEUE				8
+
+/**
+ *
+ * This enum represents the destination ports of a route (bit mask)
+ */
+enum GW_DEST
+{
+	GW_TO_CAN0 = 0x01,
+	GW_TO_CAN1 = 0x02,
+	GW_TO_BOTH = 0x03
+};
+
+/**
+ * payload rewrite callback, called with the frame about to be forwarded (ID and mask rewrite already applied)
+ *
+ * @param F - frame to be forwarded, may be modified
+ * @return - false to drop the frame
+ */
+typedef bool (*GW_REWRITE)(TX_CAN_FRAME *F);
+
+/**
+ * This struct represents one routing rule: frames from the source port whose ID matches (only bits set in mask are
+ * compared, as cCANFrame does) are forwarded to the destination port(s), optionally with a new ID and a rewritten
+ * payload. The payload rewrite is payload = (payload & andMask) | orMask on the 64bit payload word (byte 0 = LSB),
+ * a callback can be set for anything else.
+ */
+struct sGatewayRoute
+{
+	ACQ_CAN_PORT srcPort;
+	UINT32 ID;
+	UINT32 mask;
+
+	/**
+	 * destination ports (GW_DEST) and the ID to send with (GW_KEEP_ID = as received)
+	 */
+	UINT8  dest;
+	UINT32 newID;
+
+	/**
+	 * payload rewrite
+	 */
+	UINT64 andMask;
+	UINT64 orMask;
+	GW_REWRITE rewrite;
+
+	/**
+	 * forwarded from the receive interrupt (see cCANGateway::enableCutThrough)
+	 */
+	bool cutThrough;
+
+	/**
+	 * forwarding policies, 0 = off (see cCANGateway::setRateLimit/setOnChange/setDownsample): token bucket of maxRate
+	 * frames/s holding up to burst frames, forward on change with a refresh of unchanged frames every refreshMs (0 = never),
+	 * at most one frame every downsampleMs
+	 */
+	bool   policy;
+	UINT16 maxRate;
+	UINT8  burst;
+	bool   onChange;
+	UINT16 refreshMs;
+	UINT16 downsampleMs;
+
+	/**
+	 * policy state: the newest frame that is held back, the last frame forwarded (millis), token bucket (1000 = one frame)
+	 */
+	TX_CAN_FRAME pending;
+	TX_CAN_FRAME last;
+	bool   sent;
+	UINT32 lastMs;
+	UINT32 tokens;
+	UINT32 tokenMs;
+
+	/**
+	 * number of frames forwarded and dropped because the destination TX queue was full (rolling, per destination port)
+	 */
+	UINT32 fwdCtr;
+	UINT32 dropCtr;
+
+	/**
+	 * number of frames held back by a policy that were replaced by a newer frame before they were forwarded, and number
+	 * of unchanged frames not forwarded (on change)
+	 */
+	UINT32 coalescedCtr;
+	UINT32 suppressedCtr;
+};
+
+/**
+ * This struct represents the cut-through forwarding latency to one destination port, measured per frame with the
+ * controllers' timestamps (end of frame), in uS. load = end of the received frame until the frame is loaded into the
+ * TX mailbox (the gateway's own delay), total = end of the received frame until the end of the forwarded frame (adds
+ * waiting for the bus and the frame's own transmission time). The jitter is max - min.
+ */
+struct sGatewayLatency
+{
+	UINT32 frames;
+	UINT32 overflows;
+	UINT16 loadMin;
+	UINT16 loadMax;
+	UINT16 totalMin;
+	UINT16 totalMax;
+	UINT16 totalLast;
+	UINT32 totalSum;
+};
+
+class cCANGateway;
+
+/**
+ * this is the receive frame that accepts every frame on a port and hands it to the routing table
+ */
+class cGatewayRXFrame : public cCANFrame
+{
+public:
+	cCANGateway *parent;
+	ACQ_CAN_PORT port;
+
+private:
+	bool  CallbackRx(RX_CAN_FRAME *R);
+};
+
+/**
+ * this is the policy frame, it is offered a transmit slot on every scheduler tick and forwards the frames held back by a policy
+ */
+class cGatewayTickFrame : public cCANFrame
+{
+public:
+	cCANGateway *parent;
+	ACQ_CAN_PORT port;
+
+private:
+	bool  CallbackTx();
+};
+
+/**
+ * Table driven gateway between CAN0 and CAN1. Every frame received on a port is looked up in the routing table and
+ * forwarded to the destination port(s) through the non-blocking cAcquireCAN::sendFrame(), so a busy destination bus
+ * never stalls the receive path: when the destination TX queue is full the frame is dropped and counted.
+ *
+ * The routing decision does not depend upon the number of routes: 11bit ID's are found through a direct table per
+ * source port (masked 11bit routes are expanded into it when they are added), exact 29bit ID's through a hash table
+ * with a bounded number of probes. Only 29bit routes with a mask are compared one by one (at most GW_MAX_EXT_MASKED).
+ * The first route added for an ID wins, an exact 29bit route wins over a masked one.
+ *
+ * Frames are forwarded when the scheduler pulls them from the driver (cAcquireCAN::run()), so the ports' run()
+ * should be called often, e.g. POLLING_noTx in loop(). Routes set to cut-through (setCutThrough()) are forwarded from
+ * the CAN receive interrupt instead: the frame goes from the RX mailbox of one controller straight into the reserved
+ * TX mailbox (GW_CT_MAILBOX) of the other, without waiting for run(). Their frames are not seen by run(), and their
+ * rewrite callback is called from the interrupt.
+ *
+ * Routes that bridge onto a slower bus can have policies (not for cut-through routes): a token bucket rate limit,
+ * forward on change with a minimum refresh and downsampling to a scheduler rate. A frame a policy holds back is kept
+ * and forwarded as soon as the policy allows, a newer frame replaces it (coalesced), so the newest value always gets
+ * through. Held back frames are sent from the scheduler tick of the source port, run it in POLLING or TIMER_2mS mode.
+ *
+ * e.g.
+ *   cCANGateway Gateway(&CANport0, &CANport1);
+ *   Gateway.addRoute(CAN_PORT_0, 0x7E0, 0x7F8, GW_TO_CAN1);          //0x7E0-0x7E7 CAN0 -> CAN1
+ *   Gateway.addRoute(CAN_PORT_1, 0x18FEF100, 0x1FFFFFFF, GW_TO_CAN0, 0x18FEF1F0);
+ *
+ * @author D.Kasamis - dan@togglebit.net
+ * @version 1.0
+ */
+class cCANGateway
+{
+public:
+	/**
+	 * constructor, registers the catch-all receive frame with both acquisition schedulers (initialize the ports afterwards)
+	 *
+	 * @param _port0 - CAN0 scheduler
+	 * @param _port1 - CAN1 scheduler
+	 */
+	cCANGateway(cAcquireCAN *_port0, cAcquireCAN *_port1);
+
+	/**
+	 * Add a route
+	 *
+	 * @param src   - source port
+	 * @param ID    - CAN ID to match, ID's > 0x7FF are 29bit (as with cCANFrame)
+	 * @param mask  - bits set to 1 must match the ID (0x7FF / 0x1FFFFFFF = exact match)
+	 * @param dest  - destination port(s)
+	 * @param newID - ID to forward with, GW_KEEP_ID to keep the received ID
+	 * @return - route index, GW_INVALID_ROUTE if the table is full (or no hash slot is left)
+	 */
+	UINT8 addRoute(ACQ_CAN_PORT src, UINT32 ID, UINT32 mask, UINT8 dest, UINT32 newID = GW_KEEP_ID);
+
+	/**
+	 * Set the payload rewrite of a route, payload = (payload & andMask) | orMask
+	 *
+	 * @param route   - route index
+	 * @param andMask - bits to keep (byte 0 = LSB)
+	 * @param orMask  - bits to set
+	 */
+	void setRewrite(UINT8 route, UINT64 andMask, UINT64 orMask);
+
+	/**
+	 * Set a rewrite callback for a route, called after the ID and mask rewrite
+	 *
+	 * @param route    - route index
+	 * @param callback - rewrite function, NULL for none
+	 */
+	void setRewrite(UINT8 route, GW_REWRITE callback);
+
+	/**
+	 * Limit the forwarding rate of a route (token bucket)
+	 *
+	 * @param route   - route index
+	 * @param maxRate - frames/s, 0 = no limit
+	 * @param burst   - number of frames that can be forwarded back to back after a quiet period (at least 1)
+	 */
+	void setRateLimit(UINT8 route, UINT16 maxRate, UINT8 burst);
+
+	/**
+	 * Forward a route only when the frame changes (ID, length or payload after the rewrite)
+	 *
+	 * @param route     - route index
+	 * @param enable    - forward on change on/off
+	 * @param refreshMs - unchanged frames are still forwarded when the last one is this old (mS), 0 = never
+	 */
+	void setOnChange(UINT8 route, bool enable, UINT16 refreshMs);
+
+	/**
+	 * Downsample a route to a scheduler rate: at most one frame (the newest) per period
+	 *
+	 * @param route - route index
+	 * @param rate  - _100Hz_Rate ... _1Hz_Rate, TICK_MSG/QUERY_MSG = off
+	 */
+	void setDownsample(UINT8 route, ACQ_RATE_CAN rate);
+
+	/**
+	 * Forward a route from the receive interrupt
+	 *
+	 * @param route  - route index
+	 * @param enable - cut-through on/off
+	 */
+	void setCutThrough(UINT8 route, bool enable);
+
+	/**
+	 * Start cut-through forwarding: reserves GW_CT_MAILBOX on both controllers, timestamps at the end of frame and
+	 * hooks the receive and transmit interrupts (11bit and 29bit routes, the hook runs for mailbox 0 and
+	 * EXT_RX_MAILBOX). Call after both ports are initialized
+	 *
+	 * @param baud0 - CAN0 baud rate, the controller timer counts bit times
+	 * @param baud1 - CAN1 baud rate
+	 */
+	void enableCutThrough(ACQ_BAUD_RATE baud0, ACQ_BAUD_RATE baud1);
+
+	/**
+	 * Retrieve / reset the cut-through latency of frames forwarded to a port
+	 *
+	 * @param dest - destination port
+	 * @return - pointer to the latency
+	 */
+	const sGatewayLatency* getLatency(ACQ_CAN_PORT dest);
+	void resetLatency(ACQ_CAN_PORT dest);
+
+	/**
+	 * Retrieve a route (and its counters)
+	 *
+	 * @param route - route index
+	 * @return - pointer to the route, NULL if there is no such route
+	 */
+	const sGatewayRoute* getRoute(UINT8 route);
+
+	/**
+	 * Retrieve the number of frames received that no route matched (rolling)
+	 */
+	UINT32 getUnroutedCtr();
+
+	/**
+	 * Find the route of a received frame
+	 *
+	 * @param src - source port
+	 * @param id  - CAN ID
+	 * @param ext - 29bit ID
+	 * @return - route index, GW_INVALID_ROUTE if no route matches
+	 */
+	UINT8 lookup(ACQ_CAN_PORT src, UINT32 id, bool ext);
+
+	/**
+	 * this handler is called when any frame is received on a port, forwards it without waiting for the destination
+	 *
+	 * @param src - source port
+	 * @param R   - pointer to the received CAN frame
+	 * @return - bool the frame was routed
+	 */
+	bool receiveFrame(ACQ_CAN_PORT src, RX_CAN_FRAME *R);
+
+	/**
+	 * this handler is called from the receive interrupt, forwards the frames of cut-through routes
+	 *
+	 * @param src - source port
+	 * @param R   - pointer to the received CAN frame
+	 * @return - bool the frame was consumed (not passed on to run())
+	 */
+	bool forwardFrame(ACQ_CAN_PORT src, RX_CAN_FRAME *R);
+
+	/**
+	 * this handler is called from the transmit interrupt when the reserved mailbox has sent its frame
+	 *
+	 * @param dest - destination port
+	 * @param time - controller timestamp of the sent frame
+	 */
+	void txDone(ACQ_CAN_PORT dest, UINT16 time);
+
+	/**
+	 * this handler is called by the scheduler on every tick, forwards the held back frames of a source port that a
+	 * policy now allows
+	 *
+	 * @param src - source port
+	 */
+	void service(ACQ_CAN_PORT src);
+
+private:
+	cAcquireCAN *ports[2];
+
+	/**
+	 * low-level controllers, the cut-through path uses them from the interrupt
+	 */
+	CANRaw *raw[2];
+
+	/**
+	 * cut-through frames waiting for the reserved mailbox per destination port, the head is in the mailbox while busy.
+	 * age = uS since the end of the received frame and stamp = destination timer when the frame was queued
+	 */
+	struct sCutThroughQueue
+	{
+		TX_CAN_FRAME frame[GW_CT_QUEUE];
+		UINT16 age[GW_CT_QUEUE];
+		UINT16 stamp[GW_CT_QUEUE];
+		volatile UINT8 head;
+		volatile UINT8 tail;
+		volatile bool busy;
+	};
+
+	sCutThroughQueue ctQueue[2];
+	sGatewayLatency  latency[2];
+
+	/**
+	 * controller timer tick (one bit time) in nS per port
+	 */
+	UINT16 tickNs[2];
+
+	/**
+	 * catch-all receive frames and policy frames, one per port
+	 */
+	cGatewayRXFrame   RXFrame[2];
+	cGatewayTickFrame TickFrame[2];
+
+	/**
+	 * routes with a held back frame per source port (bit = route index)
+	 */
+	volatile UINT32 pendingMask[2];
+
+	/**
+	 * routing table
+	 */
+	sGatewayRoute routes[GW_MAX_ROUTES];
+	UINT8  numRoutes;
+
+	/**
+	 * lookup tables per source port, all hold the routes index + 1 (0 = no route): 11bit ID's directly,
+	 * exact 29bit ID's by hash, 29bit routes with a mask as a list
+	 */
+	UINT8  stdMap[2][0x800];
+	UINT8  extHash[2][GW_EXT_HASH_SIZE];
+	UINT8  extMasked[2][GW_MAX_EXT_MASKED];
+	UINT8  numExtMasked[2];
+
+	/**
+	 * number of frames no route matched
+	 */
+	UINT32 unroutedCtr;
+
+	/**
+	 * hash of a 29bit ID
+	 */
+	static UINT8 hash(UINT32 id);
+
+	/**
+	 * build the frame to forward (ID translation, payload rewrite)
+	 *
+	 * @return - false if the rewrite callback dropped the frame
+	 */
+	bool buildFrame(sGatewayRoute &G, RX_CAN_FRAME *R, TX_CAN_FRAME &F);
+
+	/**
+	 * queue a frame on the destination port(s) of a route
+	 *
+	 * @return - false if no destination took the frame (TX queue full)
+	 */
+	bool forward(sGatewayRoute &G, TX_CAN_FRAME &F);
+
+	/**
+	 * apply the policies of a route to a frame to be forwarded, and forward the held back frame if a policy allows
+	 */
+	void policyFrame(UINT8 route, TX_CAN_FRAME &F);
+	void flush(UINT8 route, UINT32 now);
+
+	/**
+	 * load the head of a cut-through queue into the reserved mailbox
+	 */
+	void load(ACQ_CAN_PORT dest);
+
+	/**
+	 * the gateway that owns the interrupt hooks, and the hooks per port (due_can calls plain functions)
+	 */
+	static cCANGateway *cutThrough;
+	static bool forwardCAN0(RX_CAN_FRAME *R);
+	static bool forwardCAN1(RX_CAN_FRAME *R);
+	static void txDoneCAN0(uint8_t mb, uint16_t time);
+	static void txDoneCAN1(uint8_t mb, uint16_t time);
+};
+
+#endif
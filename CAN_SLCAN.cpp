@@ -0,0 +1,523 @@
+/*
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#include "CAN_SLCAN.h"
+
+/**
+ * hex digits of the output
+ */
+static const char hexDigit[] = "0123456789ABCDEF";
+
+/**
+ * bit rates of the S0-S8 commands, NONE = the controller can't run at this rate
+ */
+static const ACQ_BAUD_RATE slcanBaud[9] =
+{
+	NONE, NONE, _50K, (ACQ_BAUD_RATE)100, _125K, _250K, _500K, _800K, _1000K
+};
+
+/**
+ * constructor, registers the catch-all receive frame with the acquisition scheduler
+ *
+ * @param _port - scheduler of the port
+ * @param _io   - command / frame link to the PC
+ */
+cSLCAN::cSLCAN(cAcquireCAN *_port, Stream *_io)
+{
+	port         = _port;
+	io           = _io;
+	raw          = (port->getPort() == CAN_PORT_0) ? &CAN : &CAN2;
+	baud         = NONE;
+	open         = false;
+	listenOnly   = false;
+	timestamps   = false;
+	flags        = 0;
+	rxFrames     = 0;
+	txFrames     = 0;
+	rxDropped    = 0;
+	txDropped    = 0;
+	lastRxFull   = 0;
+	lastOverrun  = 0;
+	lineLen      = 0;
+	lineOverflow = false;
+	outLen       = 0;
+
+	//
+	//********** RX RECEIVE FRAME ****************
+	//
+	//every frame (mask 0), the PC does the filtering
+	//
+	RXFrame.ID     = 0;
+	RXFrame.mask   = 0;
+	RXFrame.parent = this;
+	port->addMessage(&RXFrame, RECEIVE);
+}
+
+/**
+ * Read and execute the commands waiting on the link, receive frames when the channel is open and write the output
+ * with a single write
+ */
+void cSLCAN::service()
+{
+	int c;
+	UINT16 n = io->available();
+
+	while (n--)
+	{
+		c = io->read();
+		if (c < 0)
+		{
+			break;
+		}
+
+		if (c == '\r')
+		{
+			if (lineOverflow)
+			{
+				reply(SLCAN_ERROR);
+			}
+			else if (lineLen)
+			{
+				command(line, lineLen);
+			}
+			lineLen      = 0;
+			lineOverflow = false;
+		}
+		else if (c != '\n')
+		{
+			if (lineLen < SLCAN_LINE_SIZE)
+			{
+				line[lineLen++] = c;
+			}
+			else
+			{
+				lineOverflow = true;
+			}
+		}
+	}
+
+	//received frames are formatted by the receive frame
+	if (open)
+	{
+		port->run(POLLING_noTx);
+	}
+
+	if (outLen)
+	{
+		io->write((const uint8_t *)out, outLen);
+		outLen = 0;
+	}
+}
+
+/**
+ * Execute one command line, the reply goes into the output
+ *
+ * @param line - command
+ * @param len  - number of characters
+ */
+void cSLCAN::command(const char *line, UINT8 len)
+{
+	UINT32 value;
+	bool ok = false;
+
+	switch (line[0])
+	{
+	case 'S':
+		if (!open && (len == 2) && (line[1] >= '0') && (line[1] <= '8') && (slcanBaud[line[1] - '0'] != NONE))
+		{
+			baud = slcanBaud[line[1] - '0'];
+			ok   = true;
+		}
+		break;
+
+	case 'O':
+	case 'L':
+		ok = !open && openChannel(line[0] == 'L');
+		break;
+
+	case 'C':
+		//closing a closed channel is not an error, tools send C before they open
+		closeChannel();
+		ok = true;
+		break;
+
+	case 't':
+	case 'T':
+	case 'r':
+	case 'R':
+		if (transmit(line, len))
+		{
+			reply((line[0] == 't') || (line[0] == 'r') ? 'z' : 'Z');
+			ok = true;
+		}
+		break;
+
+	case 'Z':
+		if ((len == 2) && ((line[1] == '0') || (line[1] == '1')))
+		{
+			timestamps = (line[1] == '1');
+			ok         = true;
+		}
+		break;
+
+	case 'F':
+		if (open)
+		{
+			reply('F');
+			replyHex(status(), 2);
+			ok = true;
+		}
+		break;
+
+	case 'V':
+		reply(SLCAN_VERSION);
+		ok = true;
+		break;
+
+	case 'N':
+		reply("NDUE0");
+		ok = true;
+		break;
+
+	case 'M':
+	case 'm':
+		ok = (len == 9) && parseHex(&line[1], 8, value);
+		break;
+	}
+
+	reply(ok ? SLCAN_OK : SLCAN_ERROR);
+}
+
+/**
+ * Format a received frame into the output: type, ID, DLC, payload, optional timestamp, CR. The frame is lost (and
+ * counted) when the output is full
+ *
+ * @param R - received frame
+ */
+void cSLCAN::receiveFrame(RX_CAN_FRAME *R)
+{
+	char *p = &out[outLen];
+	UINT8 dlc = (R->length > 8) ? 8 : R->length;
+	UINT8 i;
+	UINT16 ms;
+
+	if ((outLen + 31) > SLCAN_OUT_SIZE)
+	{
+		rxDropped += 1;
+		flags     |= 0x01;
+		return;
+	}
+
+	if (R->extended)
+	{
+		*p++ = R->rtr ? 'R' : 'T';
+		for (i = 0; i < 8; i++)
+		{
+			*p++ = hexDigit[(R->id >> (28 - 4*i)) & 0x0F];
+		}
+	}
+	else
+	{
+		*p++ = R->rtr ? 'r' : 't';
+		*p++ = hexDigit[(R->id >> 8) & 0x07];
+		*p++ = hexDigit[(R->id >> 4) & 0x0F];
+		*p++ = hexDigit[R->id & 0x0F];
+	}
+	*p++ = '0' + dlc;
+
+	if (!R->rtr)
+	{
+		for (i = 0; i < dlc; i++)
+		{
+			*p++ = hexDigit[R->data.bytes[i] >> 4];
+			*p++ = hexDigit[R->data.bytes[i] & 0x0F];
+		}
+	}
+
+	if (timestamps)
+	{
+		//when the frame was complete (controller timestamp), not when service() got to it
+		ms   = (millis() - (micros() - port->getRxTime(R)) / 1000) % 60000;
+		*p++ = hexDigit[ms >> 12];
+		*p++ = hexDigit[(ms >> 8) & 0x0F];
+		*p++ = hexDigit[(ms >> 4) & 0x0F];
+		*p++ = hexDigit[ms & 0x0F];
+	}
+	*p++ = '\r';
+
+	outLen    = p - out;
+	rxFrames += 1;
+}
+
+/**
+ * Retrieve the number of frames received (rolling)
+ */
+UINT32 cSLCAN::getRxFrames()
+{
+	return(rxFrames);
+}
+
+/**
+ * Retrieve the number of frames sent (rolling)
+ */
+UINT32 cSLCAN::getTxFrames()
+{
+	return(txFrames);
+}
+
+/**
+ * Retrieve the number of received frames lost because the output buffer was full (rolling)
+ */
+UINT32 cSLCAN::getRxDropped()
+{
+	return(rxDropped);
+}
+
+/**
+ * Retrieve the number of transmit commands refused because the TX queue was full (rolling)
+ */
+UINT32 cSLCAN::getTxDropped()
+{
+	return(txDropped);
+}
+
+/**
+ * the channel is open
+ */
+bool cSLCAN::isOpen()
+{
+	return(open);
+}
+
+/**
+ * Open the channel: initialize the port at the bit rate of the S command, add a mailbox for 29bit ID's and set
+ * listen mode
+ *
+ * @param listen - listen-only (no acknowledge, no transmission)
+ * @return - false if no bit rate was set
+ */
+bool cSLCAN::openChannel(bool listen)
+{
+	RX_CAN_FRAME F;
+
+	if (baud == NONE)
+	{
+		return(false);
+	}
+
+	port->initialize(baud);
+
+	//the scheduler's receive mailbox takes 11bit ID's, this one the 29bit ID's
+	raw->mailbox_set_mode(2, CAN_MB_RX_MODE);
+	raw->setRXFilter(2, 0, 0, true);
+
+	raw->disable();
+	if (listen)
+	{
+		raw->enable_autobaud_listen_mode();
+	}
+	else
+	{
+		raw->disable_autobaud_listen_mode();
+	}
+	raw->enable();
+
+	//frames left over from before
+	noInterrupts();
+	while (raw->read(F));
+	interrupts();
+
+	lastRxFull  = raw->get_rx_buffer_full_cnt();
+	lastOverrun = raw->get_rx_overrun_cnt();
+	flags       = 0;
+	listenOnly  = listen;
+	open        = true;
+	return(true);
+}
+
+/**
+ * Close the channel, the controller is disabled
+ */
+void cSLCAN::closeChannel()
+{
+	if (open)
+	{
+		raw->disable_interrupt(CAN_DISABLE_ALL_INTERRUPT_MASK);
+		raw->disable();
+		open = false;
+	}
+}
+
+/**
+ * Transmit command: t/r iii l [dd..], T/R iiiiiiii l [dd..]
+ *
+ * @param line - command
+ * @param len  - number of characters
+ * @return - false if the channel isn't open for transmission, the command is malformed or the TX queue is full
+ */
+bool cSLCAN::transmit(const char *line, UINT8 len)
+{
+	TX_CAN_FRAME F;
+	UINT32 value;
+	bool ext    = (line[0] == 'T') || (line[0] == 'R');
+	bool rtr    = (line[0] == 'r') || (line[0] == 'R');
+	UINT8 digits = ext ? 8 : 3;
+	UINT8 dlc, i;
+
+	if (!open || listenOnly || (len < (digits + 2)))
+	{
+		return(false);
+	}
+
+	dlc = line[digits + 1] - '0';
+	if ((dlc > 8) || (len != (digits + 2 + (rtr ? 0 : 2*dlc))) || !parseHex(&line[1], digits, value) ||
+	    (value > (ext ? 0x1FFFFFFFUL : 0x7FFUL)))
+	{
+		return(false);
+	}
+	F.id = value;
+
+	F.data.value = 0;
+	for (i = 0; !rtr && (i < dlc); i++)
+	{
+		if (!parseHex(&line[digits + 2 + 2*i], 2, value))
+		{
+			return(false);
+		}
+		F.data.bytes[i] = value;
+	}
+
+	F.extended = ext;
+	F.rtr      = rtr;
+	F.length   = dlc;
+	F.priority = 15;
+	F.fid      = 0;
+
+	if (!port->sendFrame(F))
+	{
+		txDropped += 1;
+		flags     |= 0x02;
+		return(false);
+	}
+	txFrames += 1;
+	return(true);
+}
+
+/**
+ * Status flags of the F command, the buffer flags are cleared when read
+ */
+UINT8 cSLCAN::status()
+{
+	UINT8 f = flags;
+	UINT32 rxFull  = raw->get_rx_buffer_full_cnt();
+	UINT32 overrun = raw->get_rx_overrun_cnt();
+	UINT8 tec = raw->get_tx_error_cnt();
+	UINT8 rec = raw->get_rx_error_cnt();
+
+	f |= (rxFull != lastRxFull) ? 0x01 : 0;
+	f |= ((tec >= 96) || (rec >= 96)) ? 0x04 : 0;
+	f |= (overrun != lastOverrun) ? 0x08 : 0;
+	f |= ((tec >= 128) || (rec >= 128)) ? 0x20 : 0;
+	f |= (raw->get_status() & CAN_SR_BOFF) ? 0x80 : 0;
+
+	lastRxFull  = rxFull;
+	lastOverrun = overrun;
+	flags       = 0;
+	return(f);
+}
+
+/**
+ * Append a character to the output
+ */
+void cSLCAN::reply(char c)
+{
+	if (outLen < SLCAN_OUT_SIZE)
+	{
+		out[outLen++] = c;
+	}
+}
+
+/**
+ * Append a string to the output
+ */
+void cSLCAN::reply(const char *s)
+{
+	while (*s)
+	{
+		reply(*s++);
+	}
+}
+
+/**
+ * Append a value to the output as hex digits
+ */
+void cSLCAN::replyHex(UINT32 value, UINT8 digits)
+{
+	while (digits--)
+	{
+		reply(hexDigit[(value >> (4*digits)) & 0x0F]);
+	}
+}
+
+/**
+ * Parse hex digits
+ *
+ * @param s      - digits
+ * @param digits - number of digits
+ * @param value  - value
+ * @return - false if a character is not a hex digit
+ */
+bool cSLCAN::parseHex(const char *s, UINT8 digits, UINT32 &value)
+{
+	char c;
+
+	value = 0;
+	while (digits--)
+	{
+		c = *s++;
+		if ((c >= '0') && (c <= '9'))
+		{
+			value = (value << 4) | (c - '0');
+		}
+		else if ((c >= 'A') && (c <= 'F'))
+		{
+			value = (value << 4) | (c - 'A' + 10);
+		}
+		else if ((c >= 'a') && (c <= 'f'))
+		{
+			value = (value << 4) | (c - 'a' + 10);
+		}
+		else
+		{
+			return(false);
+		}
+	}
+	return(true);
+}
+
+/**
+ * This is a overridden implementaiton of the base class member, every received frame is formatted into the output
+ *
+ * @param R - received frame
+ * @return - false, the payload is not stored in this frame
+ */
+bool cSLCANRXFrame::CallbackRx(RX_CAN_FRAME *R)
+{
+	if (R)
+	{
+		parent->receiveFrame(R);
+	}
+	return(false);
+}
@@ -0,0 +1,196 @@
+/*
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#include "variant.h"
+#include <due_can.h>
+#include <CAN_Acquisition.h>
+
+#ifndef CAN_SLCAN_H
+#define CAN_SLCAN_H
+
+/**
+ *
+ * This macro is used to set the size of the output buffer: replies and received frames are formatted into it and
+ * written with a single write per service() call. A received frame takes at most 31 characters
+ */
+#define	SLCAN_OUT_SIZE			2048
+
+/**
+ *
+ * This macro is used to set the longest command line (an extended frame with 8 bytes is 27 characters)
+ */
+#define	SLCAN_LINE_SIZE			32
+
+/**
+ *
+ * These macros are the replies to a command: ok, error
+ */
+#define	SLCAN_OK				'\r'
+#define	SLCAN_ERROR				'\a'
+
+/**
+ *
+ * This macro is used to set the version reply to the V command (hardware and software version)
+ */
+#define	SLCAN_VERSION			"V1013"
+
+class cSLCAN;
+
+/**
+ * This class represents the catch-all receive frame of the adapter, every received frame is formatted into the output
+ */
+class cSLCANRXFrame : public cCANFrame
+{
+public:
+	cSLCAN *parent;
+
+private:
+	bool  CallbackRx(RX_CAN_FRAME *R);
+};
+
+/**
+ * SLCAN (Lawicel) ASCII adapter: turns a port into a USB-CAN adapter for PC tools that speak SLCAN (can-utils slcand,
+ * python-can, SavvyCAN, CANHacker ...). Commands are read from a Stream (SerialUSB or Serial), each ends with CR:
+ *
+ *   Sn          bitrate n = 2-8: 50K, 100K, 125K, 250K, 500K, 800K, 1M (channel closed). 10K and 20K (S0, S1)
+ *               are below the lowest rate the controller can divide its 84MHz clock down to
+ *   O / L / C   open / open listen-only / close the channel
+ *   tiiildd..   send an 11bit frame: ID (3 hex digits), DLC, DLC bytes (2 hex digits each), reply z
+ *   Tiiiiiiiildd..  send a 29bit frame (8 hex digit ID), reply Z
+ *   riiil / Riiiiiiiil  send a remote frame
+ *   Zn          timestamps off / on (n = 0 / 1): mS 0-59999 as 4 hex digits after every received frame, taken
+ *               from the controller timestamp at the end of the frame
+ *   F           status flags (hex): bit 0 RX buffer full, bit 1 TX queue full, bit 2 error warning,
+ *               bit 3 data overrun, bit 5 error passive, bit 7 bus error (cleared when read)
+ *   V / N       version / serial number
+ *   Mxxxxxxxx / mxxxxxxxx  acceptance code / mask, accepted but not applied (filter on the PC)
+ *
+ * Replies are CR (ok) or BELL (error). Received frames are sent in the format of the transmit commands.
+ *
+ * The channel is opened with cAcquireCAN::initialize() (11bit ID's through the scheduler's receive mailbox, plus a
+ * CANRaw mailbox for 29bit ID's), frames are sent through the non-blocking cAcquireCAN::sendFrame() and received
+ * through the scheduler's run(). Received frames and replies are formatted (table driven hex) into one buffer that is
+ * written with a single write() per service() call, not character by character.
+ *
+ * Everything runs from service() in loop(), do not run the port's scheduler elsewhere. With SerialUSB the link is
+ * not the limit, the programming port at 115200 baud carries ~450 frames/s.
+ *
+ * e.g.
+ *   cAcquireCAN CANport0(CAN_PORT_0);
+ *   cSLCAN Adapter(&CANport0, &SerialUSB);
+ *   ... loop(): Adapter.service();
+ *
+ * @author D.Kasamis - dan@togglebit.net
+ * @version 1.0
+ */
+class cSLCAN
+{
+public:
+	/**
+	 * constructor, registers the catch-all receive frame with the acquisition scheduler (the port is initialized when the
+	 * channel is opened)
+	 *
+	 * @param _port - scheduler of the port
+	 * @param _io   - command / frame link to the PC
+	 */
+	cSLCAN(cAcquireCAN *_port, Stream *_io);
+
+	/**
+	 * Read and execute the commands waiting on the link, receive frames when the channel is open and write the output.
+	 * Call from loop()
+	 */
+	void service();
+
+	/**
+	 * Execute one command line (without the CR), the reply goes into the output
+	 *
+	 * @param line - command
+	 * @param len  - number of characters
+	 */
+	void command(const char *line, UINT8 len);
+
+	/**
+	 * Format a received frame into the output (called by the receive frame)
+	 *
+	 * @param R - received frame
+	 */
+	void receiveFrame(RX_CAN_FRAME *R);
+
+	/**
+	 * Retrieve the number of frames received / sent (rolling)
+	 */
+	UINT32 getRxFrames();
+	UINT32 getTxFrames();
+
+	/**
+	 * Retrieve the number of received frames lost because the output buffer was full and the number of transmit
+	 * commands refused because the TX queue was full (rolling)
+	 */
+	UINT32 getRxDropped();
+	UINT32 getTxDropped();
+
+	/**
+	 * the channel is open
+	 */
+	bool isOpen();
+
+private:
+	cAcquireCAN *port;
+	CANRaw *raw;
+	Stream *io;
+	cSLCANRXFrame RXFrame;
+	ACQ_BAUD_RATE baud;
+	bool open;
+	bool listenOnly;
+	bool timestamps;
+	UINT8 flags;
+	UINT32 rxFrames, txFrames, rxDropped, txDropped;
+	UINT32 lastRxFull, lastOverrun;
+	char line[SLCAN_LINE_SIZE];
+	UINT8 lineLen;
+	bool lineOverflow;
+	char out[SLCAN_OUT_SIZE];
+	UINT16 outLen;
+
+	/**
+	 * channel open / close
+	 */
+	bool openChannel(bool listen);
+	void closeChannel();
+
+	/**
+	 * transmit command (t, T, r, R)
+	 */
+	bool transmit(const char *line, UINT8 len);
+
+	/**
+	 * status flags of the F command
+	 */
+	UINT8 status();
+
+	/**
+	 * append a reply to the output
+	 */
+	void reply(char c);
+	void reply(const char *s);
+	void replyHex(UINT32 value, UINT8 digits);
+
+	/**
+	 * parse hex digits, false if a character is not a hex digit
+	 */
+	static bool parseHex(const char *s, UINT8 digits, UINT32 &value);
+};
+
+#endif
@@ -0,0 +1,256 @@
+/*
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#ifndef CAN_SIGNAL_H
+#define CAN_SIGNAL_H
+#include <stdint.h>
+#include "CAN_DBC.h"
+#include "CAN_FixedPoint.h"
+
+/**
+ * This is the maximum number of signals in one frame
+ */
+#define CAN_SIG_MAX_SIGNALS 16
+
+/**
+ * This enum represents the byte order of a signal (DBC @1 = Intel, @0 = Motorola)
+ */
+enum SIG_BYTE_ORDER
+{
+    SIG_INTEL    = 0,
+    SIG_MOTOROLA = 1
+};
+
+/**
+ * This struct describes a signal the way a DBC file does, e.g. loaded from a configuration file at runtime
+ */
+struct sCANSignal
+{
+    /**
+     * start bit, the LSB for Intel signals and the MSB for Motorola signals (DBC numbering), length 1-32 bits
+     */
+    uint8_t startBit;
+    uint8_t length;
+
+    /**
+     * byte order, signed (two's complement) raw value
+     */
+    SIG_BYTE_ORDER order;
+    bool isSigned;
+
+    /**
+     * engineering units = raw * scale + offset
+     */
+    float scale;
+    float offset;
+};
+
+/**
+ * This class decodes (and encodes) all signals of a payload in one pass from signal descriptors that are only known at runtime.
+ *
+ * setup() turns each descriptor into a shift and a 64 bit mask of the payload word (Motorola signals of the byte
+ * swapped word, as the generated DBC code does, see CAN_DBC.h), a sign bit and a cFixedScale. decode() then loads
+ * the payload once and extracts each signal with a shift, an AND and an XOR/subtract for the sign, no per bit loops
+ * and no branches per signal. The engineering values are integers * 10^decimals (no floating point math).
+ * encode() is the reverse: each raw value is masked and shifted into one of two words (Intel, Motorola), the words are
+ * merged into the payload with a single read-modify-write that keeps the bits no signal covers.
+ *
+ * Unsigned signals of 32 bits are returned as the bit pattern in an int32_t, their engineering value is not valid.
+ *
+ * @author D.Kasamis - dan@togglebit.net
+ * @version 1.0
+ */
+class cSignalCodec
+{
+public:
+    /**
+     * constructor, no signals
+     */
+    cSignalCodec()
+    {
+        num  = 0;
+        used = 0;
+        dec  = 0;
+    }
+
+    /**
+     * precompute the layout of the signals, this is the only place floating point math is done
+     *
+     * @param signals    - signal descriptors
+     * @param numSignals - number of signals (up to CAN_SIG_MAX_SIGNALS)
+     * @param decimals   - number of decimal places of the engineering values (value = EU * 10^decimals)
+     * @return false if there are too many signals, a signal does not fit the payload or its scale/offset is outside the
+     *         limits of cFixedScale at these decimals (no signals are set up)
+     */
+    bool setup(const sCANSignal *signals, uint8_t numSignals, uint8_t decimals)
+    {
+        uint64_t usedWord[2] = {0, 0};
+        uint8_t i;
+        int shift;
+
+        num  = 0;
+        used = 0;
+        if (numSignals > CAN_SIG_MAX_SIGNALS)
+        {
+            return(false);
+        }
+
+        for (i = 0; i < numSignals; i++)
+        {
+            const sCANSignal &S = signals[i];
+
+            shift = place(S);
+            if ((shift < 0) || !cFixedScale::fits(S.scale, S.offset, decimals))
+            {
+                return(false);
+            }
+
+            layout[i].shift = shift;
+            layout[i].order = S.order;
+            layout[i].mask  = (1ULL << S.length) - 1;
+            layout[i].sign  = S.isSigned ? (1ULL << (S.length - 1)) : 0;
+            layout[i].scale.set(S.scale, S.offset, decimals);
+            usedWord[S.order] |= layout[i].mask << shift;
+        }
+
+        used = usedWord[SIG_INTEL] | dbcSwap(usedWord[SIG_MOTOROLA]);
+        num  = numSignals;
+        dec  = decimals;
+        return(true);
+    }
+
+    /**
+     * decode all signals of a payload
+     *
+     * @param payload - 8 payload bytes
+     * @param raw     - raw (sign extended) values, one per signal
+     * @param value   - engineering values * 10^decimals, one per signal
+     */
+    void decode(const uint8_t *payload, int32_t *raw, int32_t *value) const
+    {
+        uint64_t word[2];
+        uint64_t r;
+        uint8_t  i;
+
+        //the swap is cheaper than a test for Motorola signals (two REV instructions on the Cortex-M3)
+        word[SIG_INTEL]    = dbcLoad(payload);
+        word[SIG_MOTOROLA] = dbcSwap(word[SIG_INTEL]);
+
+        for (i = 0; i < num; i++)
+        {
+            const sLayout &L = layout[i];
+
+            //sign extension is a no-op for unsigned signals (sign = 0)
+            r        = (word[L.order] >> L.shift) & L.mask;
+            raw[i]   = (int32_t)((r ^ L.sign) - L.sign);
+            value[i] = L.scale.convert(raw[i]);
+        }
+    }
+
+    /**
+     * encode all signals into a payload, the payload bits that are not part of a signal are kept
+     *
+     * @param raw     - raw values, one per signal (signed values in two's complement, they are masked to the signal length)
+     * @param payload - 8 payload bytes
+     */
+    void encode(const int32_t *raw, uint8_t *payload) const
+    {
+        uint64_t word[2] = {0, 0};
+        uint8_t  i;
+
+        for (i = 0; i < num; i++)
+        {
+            const sLayout &L = layout[i];
+
+            word[L.order] |= ((uint64_t)(uint32_t)raw[i] & L.mask) << L.shift;
+        }
+
+        dbcStore(payload, (dbcLoad(payload) & ~used) | word[SIG_INTEL] | dbcSwap(word[SIG_MOTOROLA]));
+    }
+
+    /**
+     * shift of a signal in the payload word of its byte order (the byte swapped word for Motorola signals)
+     *
+     * @param S - signal descriptor
+     * @return shift, -1 if the signal does not fit the payload
+     */
+    static int place(const sCANSignal &S)
+    {
+        uint8_t msb;
+        int shift;
+
+        if ((S.length < 1) || (S.length > 32) || (S.startBit > 63))
+        {
+            return(-1);
+        }
+
+        if (S.order == SIG_INTEL)
+        {
+            shift = S.startBit;
+        }
+        else
+        {
+            //the Motorola start bit is the MSB, counted LSB first within its byte, byte 0 is the top of the swapped word
+            msb   = (S.startBit & 0xF8) + (7 - (S.startBit & 7));
+            shift = 64 - msb - S.length;
+        }
+
+        return(((shift < 0) || (shift + S.length > 64)) ? -1 : shift);
+    }
+
+    /**
+     * get the number of signals that are set up
+     *
+     * @return number of signals
+     */
+    uint8_t getNumSignals() const
+    {
+        return(num);
+    }
+
+    /**
+     * get the number of decimal places of the engineering values
+     *
+     * @return number of decimals (value = EU * 10^decimals)
+     */
+    uint8_t getDecimals() const
+    {
+        return(dec);
+    }
+
+private:
+    /**
+     * precomputed layout of a signal
+     */
+    struct sLayout
+    {
+        uint64_t    mask;
+        uint64_t    sign;
+        uint8_t     shift;
+        uint8_t     order;
+        cFixedScale scale;
+    };
+
+    sLayout layout[CAN_SIG_MAX_SIGNALS];
+
+    /**
+     * payload bits covered by a signal
+     */
+    uint64_t used;
+    uint8_t  num;
+    uint8_t  dec;
+};
+
+#endif
@@ -0,0 +1,174 @@
+/*
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#include "CAN_SignalFrame.h"
+
+/**
+ * constructor, no signals
+ */
+cCANSignalFrame::cCANSignalFrame()
+{
+	rxCtr = 0;
+	txCtr = 0;
+	memset(raw, 0, sizeof(raw));
+	memset(value, 0, sizeof(value));
+}
+
+/**
+ * Set the signals of the frame
+ *
+ * @param signals    - signal descriptors
+ * @param numSignals - number of signals (up to CAN_SIG_MAX_SIGNALS)
+ * @param decimals   - number of decimal places of the engineering values (value = EU * 10^decimals)
+ * @return - false if a signal does not fit the payload or there are too many signals
+ */
+bool cCANSignalFrame::setSignals(const sCANSignal *signals, UINT8 numSignals, UINT8 decimals)
+{
+	bool ok;
+
+	//the RX handler must not see a half built layout
+	noInterrupts();
+	ok = codec.setup(signals, numSignals, decimals);
+	interrupts();
+
+	return(ok);
+}
+
+/**
+ * Retrieve a signal of the latest frame
+ *
+ * @param idx - signal index, as passed to setSignals()
+ * @return - engineering value * 10^decimals
+ */
+SINT32 cCANSignalFrame::getValue(UINT8 idx)
+{
+	return(idx < CAN_SIG_MAX_SIGNALS ? value[idx] : 0);
+}
+
+/**
+ * Retrieve a signal of the latest frame
+ *
+ * @param idx - signal index, as passed to setSignals()
+ * @return - raw (sign extended) value
+ */
+SINT32 cCANSignalFrame::getRaw(UINT8 idx)
+{
+	return(idx < CAN_SIG_MAX_SIGNALS ? raw[idx] : 0);
+}
+
+/**
+ * Copy the engineering values of all signals, all from the same frame
+ *
+ * @param dst - destination, one value per signal
+ */
+void cCANSignalFrame::getValues(SINT32 *dst)
+{
+	UINT8 i;
+
+	noInterrupts();
+	for (i = 0; i < codec.getNumSignals(); i++)
+	{
+		dst[i] = value[i];
+	}
+	interrupts();
+}
+
+/**
+ * Set the raw value of a signal of a transmit frame, it is packed when the frame is sent
+ *
+ * @param idx - signal index, as passed to setSignals()
+ * @param rawValue - raw value (signed values in two's complement)
+ */
+void cCANSignalFrame::setRaw(UINT8 idx, SINT32 rawValue)
+{
+	if (idx < CAN_SIG_MAX_SIGNALS)
+	{
+		raw[idx] = rawValue;
+	}
+}
+
+/**
+ * Set the raw values of all signals of a transmit frame, they are sent in the same frame
+ *
+ * @param src - raw values, one per signal
+ */
+void cCANSignalFrame::setRaws(const SINT32 *src)
+{
+	UINT8 i;
+
+	noInterrupts();
+	for (i = 0; i < codec.getNumSignals(); i++)
+	{
+		raw[i] = src[i];
+	}
+	interrupts();
+}
+
+/**
+ * Pack the raw values into the payload now
+ */
+void cCANSignalFrame::pack()
+{
+	noInterrupts();
+	codec.encode(raw, U.b);
+	interrupts();
+}
+
+/**
+ * Retrieve the number of frames decoded / packed for transmission (rolling)
+ */
+UINT32 cCANSignalFrame::getRxCtr()
+{
+	return(rxCtr);
+}
+
+UINT32 cCANSignalFrame::getTxCtr()
+{
+	return(txCtr);
+}
+
+/**
+ * This is a overridden implementaiton of the base class member that is called by the acquisition scheduler when a receive message matching this CAN ID has been received.
+ * All signals are decoded here, in one pass over the payload.
+ *
+ * @param R - pointer to RX Frame
+ * @return - a flag to accept or reject this CAN frame
+ */
+bool cCANSignalFrame::CallbackRx(RX_CAN_FRAME *R)
+{
+	if (!R)
+	{
+		return(false);
+	}
+
+	codec.decode(R->data.byte, raw, value);
+	rxCtr++;
+
+	//keep the payload too
+	return(true);
+}
+
+/**
+ * This is a overridden implementaiton of the base class member that is called by the acquisition scheduler when the frame is going to be transmitted.
+ * The raw values are packed here so the payload that is sent is always complete.
+ *
+ * @return - a flag to transmit or skip this CAN frame
+ */
+bool cCANSignalFrame::CallbackTx()
+{
+	codec.encode(raw, U.b);
+	txCtr++;
+	return(true);
+}
@@ -0,0 +1,121 @@
+/*
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#include "variant.h"
+#include <due_can.h>
+#include <CAN_Acquisition.h>
+
+#ifndef CAN_SIGNAL_FRAME_H
+#define CAN_SIGNAL_FRAME_H
+#include "CAN_Signal.h"
+
+/**
+ * This class is a frame whose signals are described at runtime (sCANSignal). Every received frame is decoded
+ * in one pass (cSignalCodec) from within the acquisition scheduler's RX handler, so the values are always those of the
+ * latest frame and loop() never unpacks bits.
+ *
+ * As a transmit frame the raw values set with setRaw()/setRaws() are packed into the payload in one pass when the
+ * scheduler sends the frame (CallbackTx), so the payload can never be sent half updated. pack() does the same on demand.
+ *
+ * e.g.
+ *   cCANSignalFrame Battery;
+ *   Battery.ID = 0x3A0;
+ *   Battery.setSignals(signals, 4, 2);
+ *   CANport0.addMessage(&Battery, RECEIVE);
+ *   ...
+ *   Serial.println(Battery.getValue(0));     //e.g. pack voltage in 1/100 V
+ *
+ * @author D.Kasamis - dan@togglebit.net
+ * @version 1.0
+ */
+class cCANSignalFrame : public cCANFrame
+{
+public:
+	/**
+	 * constructor, no signals
+	 */
+	cCANSignalFrame();
+
+	/**
+	 * Set the signals of the frame
+	 *
+	 * @param signals    - signal descriptors
+	 * @param numSignals - number of signals (up to CAN_SIG_MAX_SIGNALS)
+	 * @param decimals   - number of decimal places of the engineering values (value = EU * 10^decimals)
+	 * @return - false if a signal does not fit the payload or there are too many signals
+	 */
+	bool setSignals(const sCANSignal *signals, UINT8 numSignals, UINT8 decimals);
+
+	/**
+	 * Retrieve a signal of the latest frame
+	 *
+	 * @param idx - signal index, as passed to setSignals()
+	 * @return - engineering value * 10^decimals / raw (sign extended) value
+	 */
+	SINT32 getValue(UINT8 idx);
+	SINT32 getRaw(UINT8 idx);
+
+	/**
+	 * Copy the engineering values of all signals, all from the same frame
+	 *
+	 * @param dst - destination, one value per signal
+	 */
+	void getValues(SINT32 *dst);
+
+	/**
+	 * Set the raw value of a signal of a transmit frame, it is packed when the frame is sent
+	 *
+	 * @param idx - signal index, as passed to setSignals()
+	 * @param rawValue - raw value (signed values in two's complement)
+	 */
+	void setRaw(UINT8 idx, SINT32 rawValue);
+
+	/**
+	 * Set the raw values of all signals of a transmit frame, they are sent in the same frame
+	 *
+	 * @param src - raw values, one per signal
+	 */
+	void setRaws(const SINT32 *src);
+
+	/**
+	 * Pack the raw values into the payload now
+	 */
+	void pack();
+
+	/**
+	 * Retrieve the number of frames decoded / packed for transmission (rolling)
+	 */
+	UINT32 getRxCtr();
+	UINT32 getTxCtr();
+
+	/**
+	 * the signal decoder, e.g. to decode a logged payload
+	 */
+	cSignalCodec codec;
+
+private:
+	/**
+	 * decoded values of the latest frame, raw values to send
+	 */
+	int32_t raw[CAN_SIG_MAX_SIGNALS];
+	int32_t value[CAN_SIG_MAX_SIGNALS];
+	volatile UINT32 rxCtr;
+	volatile UINT32 txCtr;
+
+	bool  CallbackRx(RX_CAN_FRAME *R);
+	bool  CallbackTx();
+};
+
+#endif
@@ -0,0 +1,224 @@
+/*
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#include "CAN_Sniffer.h"
+
+/**
+ * the sniffer that owns the receive interrupt hooks
+ */
+cCANSniffer *cCANSniffer::active = NULL;
+
+/**
+ * constructor
+ *
+ * @param _ring - trace ring the frames are logged into
+ */
+cCANSniffer::cCANSniffer(cTraceRing *_ring)
+{
+	ring            = _ring;
+	raw[CAN_PORT_0] = &CAN;
+	raw[CAN_PORT_1] = &CAN2;
+	tickNs[0]       = 0;
+	tickNs[1]       = 0;
+	frames[0]       = 0;
+	frames[1]       = 0;
+	bytesOut        = 0;
+	lastWriteMs     = 0;
+}
+
+/**
+ * Start sniffing: listen mode, every mailbox accepts every ID (11bit and 29bit chains), end of frame timestamps and
+ * the receive interrupt hooked for the ports with a baud rate
+ *
+ * @param baud0 - CAN0 baud rate, NONE = don't sniff this port
+ * @param baud1 - CAN1 baud rate, NONE = don't sniff this port
+ * @return - false if a port could not be initialized
+ */
+bool cCANSniffer::begin(ACQ_BAUD_RATE baud0, ACQ_BAUD_RATE baud1)
+{
+	ACQ_BAUD_RATE baud[2] = {baud0, baud1};
+	bool ok = true;
+	bool ext;
+	UINT8 i, mb;
+
+	active = this;
+
+	for (i = 0; i < 2; i++)
+	{
+		if (baud[i] == NONE)
+		{
+			continue;
+		}
+		if (!raw[i]->init(baud[i]*1000))
+		{
+			ok = false;
+			continue;
+		}
+
+		//the controller timer counts bit times
+		tickNs[i] = 1000000UL / baud[i];
+
+		noInterrupts();
+		raw[i]->disable_interrupt(CAN_DISABLE_ALL_INTERRUPT_MASK);
+
+		//listen mode: no acknowledge, no error frames, nothing is sent
+		raw[i]->disable();
+		raw[i]->enable_autobaud_listen_mode();
+		raw[i]->enable();
+
+		//timestamp = the frame is complete
+		raw[i]->set_timestamp_capture_point(1);
+
+		//two chains of mailboxes accepting every ID, only the last one of a chain is overwritten when all are full
+		for (mb = 0; mb < 8; mb++)
+		{
+			ext = (mb >= SNIFF_STD_MAILBOXES);
+			raw[i]->mailbox_set_mode(mb, ((mb == (SNIFF_STD_MAILBOXES - 1)) || (mb == 7)) ? CAN_MB_RX_OVER_WR_MODE : CAN_MB_RX_MODE);
+			raw[i]->mailbox_set_accept_mask(mb, 0, ext);
+			raw[i]->mailbox_set_id(mb, 0, ext);
+		}
+
+		raw[i]->setForwardCallback(i ? receiveCAN1 : receiveCAN0);
+		for (mb = 0; mb < 8; mb++)
+		{
+			raw[i]->enable_interrupt(raw[i]->getMailboxIer(mb));
+		}
+		interrupts();
+	}
+
+	lastWriteMs = millis();
+	return(ok);
+}
+
+/**
+ * Stop sniffing, the controllers stay in listen mode with their interrupts off
+ */
+void cCANSniffer::end()
+{
+	UINT8 i;
+
+	noInterrupts();
+	for (i = 0; i < 2; i++)
+	{
+		if (tickNs[i])
+		{
+			raw[i]->disable_interrupt(CAN_DISABLE_ALL_INTERRUPT_MASK);
+			raw[i]->setForwardCallback(NULL);
+			tickNs[i] = 0;
+		}
+	}
+	interrupts();
+}
+
+/**
+ * Write the logged frames to a port in SNIFF_PACKET_SIZE pieces, a partly filled piece only when nothing was written
+ * for SNIFF_FLUSH_MS. The pieces are copied out of the ring first, so a piece that wraps around the end of the ring
+ * still goes out in one write. Only the bytes the port takes are released from the ring, a short write stops the call
+ *
+ * @param out - port
+ * @return - number of bytes written
+ */
+UINT32 cCANSniffer::stream(Print &out)
+{
+	UINT32 n = 0, w = 0, total = 0;
+
+	//bytes leave the ring only once the port took them, the rest goes out on the next call
+	while ((w == n) && (ring->available() >= SNIFF_PACKET_SIZE))
+	{
+		n = ring->copy(packet, SNIFF_PACKET_SIZE);
+		w = out.write(packet, n);
+		ring->consume(w);
+		total += w;
+	}
+
+	if (!total && (w == n) && ring->available() && ((millis() - lastWriteMs) >= SNIFF_FLUSH_MS))
+	{
+		n = ring->copy(packet, SNIFF_PACKET_SIZE);
+		w = out.write(packet, n);
+		ring->consume(w);
+		total += w;
+	}
+
+	if (total)
+	{
+		lastWriteMs = millis();
+		bytesOut   += total;
+	}
+	return(total);
+}
+
+/**
+ * Retrieve the number of frames received on a port (rolling)
+ */
+UINT32 cCANSniffer::getFrames(ACQ_CAN_PORT port)
+{
+	return(frames[port]);
+}
+
+/**
+ * Retrieve the number of times a frame was lost in a full mailbox chain of a port (rolling)
+ */
+UINT32 cCANSniffer::getOverruns(ACQ_CAN_PORT port)
+{
+	return(raw[port]->get_rx_overrun_cnt());
+}
+
+/**
+ * Retrieve the number of frames dropped because the ring was full (rolling)
+ */
+UINT32 cCANSniffer::getDropped()
+{
+	return(ring->getDropped());
+}
+
+/**
+ * Retrieve the number of bytes written by stream() (rolling)
+ */
+UINT32 cCANSniffer::getBytesOut()
+{
+	return(bytesOut);
+}
+
+/**
+ * Log a received frame, called from the CAN receive interrupt. The frame's timestamp is converted to micros(): the
+ * controller timer tells how many bit times ago the frame was complete
+ *
+ * @param port - port the frame was received on
+ * @param R    - received frame
+ * @return - true, the frame is consumed
+ */
+bool cCANSniffer::receiveFrame(ACQ_CAN_PORT port, RX_CAN_FRAME *R)
+{
+	UINT32 age = (raw[port]->get_internal_timer_value() - R->time) & 0xFFFF;
+	UINT32 now = micros();
+
+	ring->log(now - (UINT32)(((UINT64)age * tickNs[port]) / 1000), R->id, R->extended, R->rtr, false, R->length,
+	          R->data.bytes, port);
+	frames[port] += 1;
+	return(true);
+}
+
+/**
+ * receive interrupt hooks of CAN0 and CAN1
+ */
+bool cCANSniffer::receiveCAN0(RX_CAN_FRAME *R)
+{
+	return(active->receiveFrame(CAN_PORT_0, R));
+}
+
+bool cCANSniffer::receiveCAN1(RX_CAN_FRAME *R)
+{
+	return(active->receiveFrame(CAN_PORT_1, R));
+}
@@ -0,0 +1,140 @@
+/*
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#include "variant.h"
+#include <due_can.h>
+#include <CAN_Acquisition.h>
+#include <CAN_Trace.h>
+
+#ifndef CAN_SNIFFER_H
+#define CAN_SNIFFER_H
+
+/**
+ *
+ * This macro is used to set how many of the 8 mailboxes receive 11bit ID's, the rest receive 29bit ID's. Each group
+ * is a chain: a frame goes into the lowest free mailbox of its group, so the controller holds that many frames while
+ * the interrupt is held off
+ */
+#define	SNIFF_STD_MAILBOXES		5
+
+/**
+ *
+ * This macro is used to set the size of the packets written to the USB port (one high speed bulk packet) and how long
+ * a partly filled packet waits for more frames (mS)
+ */
+#define	SNIFF_PACKET_SIZE		512
+#define	SNIFF_FLUSH_MS			10
+
+/**
+ * Listen-only bus sniffer for CAN0 and CAN1. The controllers are put in listen mode (no acknowledge, no error frames,
+ * nothing is sent) and all 8 mailboxes of a controller accept every ID. Frames are timestamped and logged into a trace
+ * ring (CAN_Trace.h, with the port number) right in the CAN receive interrupt, they never go through the RX buffer of
+ * the driver or the scheduler, so its 32 entries do not limit the load. loop() streams the ring in full USB packets.
+ *
+ * Timestamps are the controller's end of frame timestamps converted to micros() (uS), so the time a frame waited in
+ * its mailbox does not add to it. Both CAN interrupts run at the same priority and never preempt each other, so
+ * they can share one ring (single producer), the consumer is stream().
+ *
+ * Nothing is lost when getOverruns() (frames lost in the controller) and getDropped() (ring full) stay 0.
+ *
+ * A cAcquireCAN scheduler must not run on a sniffed port.
+ *
+ * e.g.
+ *   UINT8 sniffBuffer[32768];
+ *   cTraceRing Trace;
+ *   cCANSniffer Sniffer(&Trace);
+ *   Trace.begin(sniffBuffer, sizeof(sniffBuffer));
+ *   Sniffer.begin(_1000K, _1000K);
+ *   ... loop(): Sniffer.stream(SerialUSB);
+ *
+ * @author D.Kasamis - dan@togglebit.net
+ * @version 1.0
+ */
+class cCANSniffer
+{
+public:
+	/**
+	 * constructor
+	 *
+	 * @param _ring - trace ring the frames are logged into (begin() it before the sniffer)
+	 */
+	cCANSniffer(cTraceRing *_ring);
+
+	/**
+	 * Start sniffing
+	 *
+	 * @param baud0 - CAN0 baud rate, NONE = don't sniff this port
+	 * @param baud1 - CAN1 baud rate, NONE = don't sniff this port
+	 * @return - false if a port could not be initialized
+	 */
+	bool begin(ACQ_BAUD_RATE baud0, ACQ_BAUD_RATE baud1);
+
+	/**
+	 * Stop sniffing, the controllers stay in listen mode with their interrupts off
+	 */
+	void end();
+
+	/**
+	 * Write the logged frames to a port (e.g. SerialUSB) in SNIFF_PACKET_SIZE pieces, a partly filled piece only when
+	 * nothing was written for SNIFF_FLUSH_MS. Bytes the port does not take stay in the ring. Call from loop()
+	 *
+	 * @param out - port
+	 * @return - number of bytes written
+	 */
+	UINT32 stream(Print &out);
+
+	/**
+	 * Retrieve the number of frames received on a port (rolling)
+	 */
+	UINT32 getFrames(ACQ_CAN_PORT port);
+
+	/**
+	 * Retrieve the number of times a frame was lost in a full mailbox chain of a port (rolling)
+	 */
+	UINT32 getOverruns(ACQ_CAN_PORT port);
+
+	/**
+	 * Retrieve the number of frames dropped because the ring was full (rolling)
+	 */
+	UINT32 getDropped();
+
+	/**
+	 * Retrieve the number of bytes written by stream() (rolling)
+	 */
+	UINT32 getBytesOut();
+
+private:
+	cTraceRing *ring;
+	CANRaw *raw[2];
+	UINT32 tickNs[2];
+	volatile UINT32 frames[2];
+	UINT32 bytesOut;
+	UINT32 lastWriteMs;
+	UINT8 packet[SNIFF_PACKET_SIZE];
+
+	/**
+	 * log a received frame (CAN interrupt)
+	 */
+	bool receiveFrame(ACQ_CAN_PORT port, RX_CAN_FRAME *R);
+
+	/**
+	 * the sniffer that owns the interrupt hooks, and the hooks for both controllers
+	 */
+	static cCANSniffer *active;
+	static bool receiveCAN0(RX_CAN_FRAME *R);
+	static bool receiveCAN1(RX_CAN_FRAME *R);
+};
+
+#endif
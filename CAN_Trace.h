@@ -0,0 +1,716 @@
+/*
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#ifndef CAN_TRACE_H
+#define CAN_TRACE_H
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * Compact binary frame log.
+ *
+ * A trace is a byte stream of records. Every record starts with a header byte:
+ *
+ *   frame:  bit 0-3 DLC (0-8), bit 4 TX, bit 5 29bit ID, bit 6 RTR, bit 7 padded payload, followed by
+ *           varint time delta (uS since the previous frame or sync), varint ID, payload
+ *           payload: DLC bytes, or when padded: number of bytes n, n bytes, pad byte (the last DLC - n bytes are the pad byte)
+ *   sync:   0x0F 'C' 'T' time (uS, 4 bytes LE) frame number (4 bytes LE) checksum (XOR of the 8 bytes)
+ *   drop:   0x0E varint number of frames that were not logged (ring full)
+ *   port:   0x0D port number, the following frames are from / to that port (0 after a sync marker)
+ *
+ * Varints are 7 bits per byte, LSB first, bit 7 set when another byte follows (11bit ID's take 1-2 bytes, deltas < 16mS
+ * 1-2 bytes). Sync markers are written every TRACE_SYNC_INTERVAL frames with the absolute time, a reader that starts in
+ * the middle of a stream looks for one (cTraceDecoder) and the time of a long trace doesn't depend on every delta.
+ * A trace of a single port never contains a port marker.
+ *
+ * cTraceDecoder also runs on a PC to convert a downloaded trace (see extras/benchmarks/trace_bench.cpp).
+ *
+ * @author D.Kasamis - dan@togglebit.net
+ * @version 1.0
+ */
+
+/**
+ * number of frames in between sync markers
+ */
+#define TRACE_SYNC_INTERVAL 64
+
+/**
+ * longest record: sync marker (12 bytes) + port marker (2 bytes) + frame (1 + 5 + 5 + 8 bytes)
+ */
+#define TRACE_RECORD_MAX    33
+
+/**
+ * frame header flags, a header with a DLC nibble > 8 is a marker
+ */
+#define TRACE_FLAG_TX       0x10
+#define TRACE_FLAG_EXT      0x20
+#define TRACE_FLAG_RTR      0x40
+#define TRACE_FLAG_PAD      0x80
+#define TRACE_SYNC          0x0F
+#define TRACE_DROP          0x0E
+#define TRACE_PORT          0x0D
+
+/**
+ * This enum represents the type of a decoded record
+ */
+enum TRACE_RECORD
+{
+    TRACE_REC_FRAME = 0,
+    TRACE_REC_SYNC  = 1,
+    TRACE_REC_DROP  = 2,
+    TRACE_REC_PORT  = 3
+};
+
+/**
+ * This struct represents a decoded record
+ */
+struct sTraceRecord
+{
+    TRACE_RECORD type;
+
+    /**
+     * time (uS) of frames and sync markers, frame number of sync markers, number of frames lost of drop markers or
+     * port number of port markers
+     */
+    uint32_t time;
+    uint32_t count;
+
+    /**
+     * frame
+     */
+    uint32_t id;
+    uint8_t  port;
+    bool     extended;
+    bool     rtr;
+    bool     tx;
+    uint8_t  dlc;
+    uint8_t  data[8];
+};
+
+/**
+ * This class encodes frames into records. It keeps the time of the last record and counts the frames for the sync markers.
+ */
+class cTraceEncoder
+{
+public:
+    cTraceEncoder()
+    {
+        reset();
+    }
+
+    /**
+     * start a new trace, the next frame is preceded by a sync marker
+     */
+    void reset()
+    {
+        lastTime  = 0;
+        sinceSync = TRACE_SYNC_INTERVAL;
+        frames    = 0;
+        port      = 0;
+    }
+
+    /**
+     * encode a frame, preceded by a sync marker when one is due
+     *
+     * @param out  - output, at least TRACE_RECORD_MAX bytes
+     * @param time - uS (e.g. micros(), wraps)
+     * @param id   - CAN ID
+     * @param ext  - 29bit ID
+     * @param rtr  - remote frame
+     * @param tx   - transmitted by us
+     * @param dlc  - data length code (0-8)
+     * @param data - payload
+     * @param p    - port the frame is from / to
+     * @return - number of bytes written
+     */
+    uint8_t frame(uint8_t *out, uint32_t time, uint32_t id, bool ext, bool rtr, bool tx, uint8_t dlc, const uint8_t *data,
+                  uint8_t p = 0)
+    {
+        uint8_t n = 0;
+        uint8_t stored, i;
+
+        if (sinceSync >= TRACE_SYNC_INTERVAL)
+        {
+            n += sync(out, time);
+        }
+
+        if (p != port)
+        {
+            out[n++] = TRACE_PORT;
+            out[n++] = p;
+            port     = p;
+        }
+
+        dlc = (dlc > 8) ? 8 : dlc;
+
+        //trailing pad bytes (e.g. 0x55 or 0x00 after an OBD2 response) are stored once, when that saves bytes
+        stored = dlc;
+        if (dlc && !rtr)
+        {
+            i = dlc - 1;
+            while ((i > 0) && (data[i - 1] == data[dlc - 1]))
+            {
+                i--;
+            }
+            stored = ((dlc - i) >= 3) ? i : dlc;
+        }
+
+        out[n++] = dlc | (tx ? TRACE_FLAG_TX : 0) | (ext ? TRACE_FLAG_EXT : 0) | (rtr ? TRACE_FLAG_RTR : 0) |
+                   ((stored < dlc) ? TRACE_FLAG_PAD : 0);
+        n += varint(&out[n], time - lastTime);
+        n += varint(&out[n], id);
+
+        if (stored < dlc)
+        {
+            out[n++] = stored;
+            memcpy(&out[n], data, stored);
+            n += stored;
+            out[n++] = data[dlc - 1];
+        }
+        else if (!rtr)
+        {
+            memcpy(&out[n], data, dlc);
+            n += dlc;
+        }
+
+        lastTime   = time;
+        sinceSync += 1;
+        frames    += 1;
+        return(n);
+    }
+
+    /**
+     * encode a drop marker
+     *
+     * @param out   - output, at least 6 bytes
+     * @param count - number of frames that were not logged
+     * @return - number of bytes written
+     */
+    uint8_t drop(uint8_t *out, uint32_t count)
+    {
+        out[0]  = TRACE_DROP;
+        frames += count;
+        return(1 + varint(&out[1], count));
+    }
+
+    /**
+     * number of frames encoded or dropped
+     */
+    uint32_t getFrames() const
+    {
+        return(frames);
+    }
+
+    /**
+     * write a varint
+     *
+     * @return - number of bytes written (1-5)
+     */
+    static uint8_t varint(uint8_t *out, uint32_t v)
+    {
+        uint8_t n = 0;
+
+        while (v >= 0x80)
+        {
+            out[n++] = (uint8_t)v | 0x80;
+            v >>= 7;
+        }
+        out[n++] = (uint8_t)v;
+        return(n);
+    }
+
+private:
+    uint32_t lastTime;
+    uint32_t frames;
+    uint8_t  sinceSync;
+    uint8_t  port;
+
+    /**
+     * encode a sync marker
+     */
+    uint8_t sync(uint8_t *out, uint32_t time)
+    {
+        uint8_t i;
+
+        out[0] = TRACE_SYNC;
+        out[1] = 'C';
+        out[2] = 'T';
+        memcpy(&out[3], &time, 4);
+        memcpy(&out[7], &frames, 4);
+        out[11] = 0;
+        for (i = 3; i < 11; i++)
+        {
+            out[11] ^= out[i];
+        }
+
+        lastTime  = time;
+        sinceSync = 0;
+        port      = 0;
+        return(12);
+    }
+};
+
+/**
+ * This class decodes records. Until the first sync marker it skips bytes, so a stream can be read from any point.
+ */
+class cTraceDecoder
+{
+public:
+    cTraceDecoder()
+    {
+        reset();
+    }
+
+    /**
+     * start reading a stream, look for a sync marker first
+     */
+    void reset()
+    {
+        lastTime = 0;
+        port     = 0;
+        synced   = false;
+    }
+
+    /**
+     * decode the next record
+     *
+     * @param in  - stream
+     * @param len - number of bytes in the stream
+     * @param R   - record
+     * @return - number of bytes used (records and skipped bytes), 0 if a record is incomplete (read more and call again)
+     */
+    uint32_t next(const uint8_t *in, uint32_t len, sTraceRecord &R)
+    {
+        uint32_t n = 0;
+        uint32_t used;
+
+        //look for a sync marker, the checksum guards against the pattern in a payload
+        while (!synced)
+        {
+            if ((len - n) < 12)
+            {
+                return(n);
+            }
+            if ((in[n] == TRACE_SYNC) && (in[n + 1] == 'C') && (in[n + 2] == 'T') && checksum(&in[n]))
+            {
+                synced = true;
+            }
+            else
+            {
+                n += 1;
+            }
+        }
+
+        used = record(&in[n], len - n, R);
+        return(used ? n + used : n);
+    }
+
+    /**
+     * the decoder has found a sync marker
+     */
+    bool isSynced() const
+    {
+        return(synced);
+    }
+
+    /**
+     * read a varint
+     *
+     * @return - number of bytes read, 0 if incomplete
+     */
+    static uint8_t varint(const uint8_t *in, uint32_t len, uint32_t &v)
+    {
+        uint8_t n = 0;
+
+        v = 0;
+        while ((n < len) && (n < 5))
+        {
+            v |= (uint32_t)(in[n] & 0x7F) << (7 * n);
+            if (!(in[n++] & 0x80))
+            {
+                return(n);
+            }
+        }
+        return(0);
+    }
+
+private:
+    uint32_t lastTime;
+    uint8_t  port;
+    bool     synced;
+
+    static bool checksum(const uint8_t *in)
+    {
+        uint8_t c = 0;
+        uint8_t i;
+
+        for (i = 3; i < 11; i++)
+        {
+            c ^= in[i];
+        }
+        return(c == in[11]);
+    }
+
+    /**
+     * decode a record at a record boundary
+     */
+    uint32_t record(const uint8_t *in, uint32_t len, sTraceRecord &R)
+    {
+        uint32_t n = 1;
+        uint32_t delta;
+        uint8_t  v, stored;
+
+        if (!len)
+        {
+            return(0);
+        }
+
+        if (in[0] == TRACE_SYNC)
+        {
+            if (len < 12)
+            {
+                return(0);
+            }
+            if ((in[1] != 'C') || (in[2] != 'T') || !checksum(in))
+            {
+                //corrupt stream, look for the next sync marker
+                synced = false;
+                return(1);
+            }
+            R.type = TRACE_REC_SYNC;
+            memcpy(&R.time, &in[3], 4);
+            memcpy(&R.count, &in[7], 4);
+            lastTime = R.time;
+            port     = 0;
+            return(12);
+        }
+
+        if (in[0] == TRACE_PORT)
+        {
+            if (len < 2)
+            {
+                return(0);
+            }
+            R.type  = TRACE_REC_PORT;
+            R.count = in[1];
+            port    = in[1];
+            return(2);
+        }
+
+        if (in[0] == TRACE_DROP)
+        {
+            v = varint(&in[1], len - 1, R.count);
+            R.type = TRACE_REC_DROP;
+            return(v ? 1 + v : 0);
+        }
+
+        if ((in[0] & 0x0F) > 8)
+        {
+            synced = false;
+            return(1);
+        }
+
+        R.type     = TRACE_REC_FRAME;
+        R.port     = port;
+        R.dlc      = in[0] & 0x0F;
+        R.tx       = (in[0] & TRACE_FLAG_TX) != 0;
+        R.extended = (in[0] & TRACE_FLAG_EXT) != 0;
+        R.rtr      = (in[0] & TRACE_FLAG_RTR) != 0;
+
+        v = varint(&in[n], len - n, delta);
+        n += v;
+        if (!v || !(v = varint(&in[n], len - n, R.id)))
+        {
+            return(0);
+        }
+        n += v;
+
+        memset(R.data, 0, 8);
+        if (in[0] & TRACE_FLAG_PAD)
+        {
+            if (n >= len)
+            {
+                return(0);
+            }
+            stored = in[n++];
+            if (stored >= R.dlc)
+            {
+                synced = false;
+                return(1);
+            }
+            if ((n + stored + 1) > len)
+            {
+                return(0);
+            }
+            memcpy(R.data, &in[n], stored);
+            n += stored;
+            memset(&R.data[stored], in[n++], R.dlc - stored);
+        }
+        else if (!R.rtr)
+        {
+            if ((n + R.dlc) > len)
+            {
+                return(0);
+            }
+            memcpy(R.data, &in[n], R.dlc);
+            n += R.dlc;
+        }
+
+        lastTime += delta;
+        R.time    = lastTime;
+        return(n);
+    }
+};
+
+/**
+ * This class is a lock-free single producer / single consumer ring of trace records. The producer (the scheduler's RX/TX
+ * paths, see cAcquireCAN::setTrace) writes whole records or none: when a record doesn't fit, the frame is counted and
+ * a drop marker is written ahead of the next record that fits. The consumer drains the ring into any byte sink from
+ * loop() without locking out the producer, only the write / read index is shared.
+ *
+ * The storage is given to begin(), its size must be a power of 2.
+ *
+ * e.g.
+ *   UINT8 traceBuffer[16384];
+ *   cTraceRing Trace;
+ *   Trace.begin(traceBuffer, sizeof(traceBuffer));
+ *   CANport0.setTrace(&Trace);
+ *   ... loop(): Trace.drain(SerialUSB);
+ */
+class cTraceRing
+{
+public:
+    cTraceRing()
+    {
+        begin(NULL, 0);
+    }
+
+    /**
+     * set the storage and empty the ring
+     *
+     * @param buffer - storage
+     * @param size   - size of the storage, power of 2
+     */
+    void begin(uint8_t *buffer, uint32_t size)
+    {
+        buf       = buffer;
+        mask      = size ? size - 1 : 0;
+        head      = 0;
+        tail      = 0;
+        pendDrop  = 0;
+        dropped   = 0;
+        highWater = 0;
+        enc.reset();
+    }
+
+    /**
+     * log a frame (producer)
+     *
+     * @param time - uS (e.g. micros())
+     * @param id   - CAN ID
+     * @param ext  - 29bit ID
+     * @param rtr  - remote frame
+     * @param tx   - transmitted by us
+     * @param dlc  - data length code
+     * @param data - payload
+     * @param port - port the frame is from / to (a port marker is written when it changes)
+     * @return - false if the ring is full (the frame is counted as dropped)
+     */
+    bool log(uint32_t time, uint32_t id, bool ext, bool rtr, bool tx, uint8_t dlc, const uint8_t *data, uint8_t port = 0)
+    {
+        uint8_t rec[TRACE_RECORD_MAX + 6];
+        cTraceEncoder e = enc;
+        uint32_t used;
+        uint8_t n = 0;
+
+        if (!buf)
+        {
+            return(false);
+        }
+
+        //a drop marker goes first, the encoder state only advances when the record is written
+        if (pendDrop)
+        {
+            n = e.drop(rec, pendDrop);
+        }
+        n += e.frame(&rec[n], time, id, ext, rtr, tx, dlc, data, port);
+
+        used = head - tail;
+        if ((used + n) > (mask + 1))
+        {
+            pendDrop += 1;
+            dropped  += 1;
+            return(false);
+        }
+
+        put(rec, n);
+        enc      = e;
+        pendDrop = 0;
+        used    += n;
+        highWater = (used > highWater) ? used : highWater;
+        return(true);
+    }
+
+    /**
+     * number of bytes waiting to be drained (consumer)
+     */
+    uint32_t available() const
+    {
+        return(head - tail);
+    }
+
+    /**
+     * contiguous bytes waiting to be drained, the ring is not changed (consumer)
+     *
+     * @param p - set to the first byte
+     * @return - number of contiguous bytes at p
+     */
+    uint32_t peek(const uint8_t **p) const
+    {
+        uint32_t h = head;
+        uint32_t t = tail & mask;
+        uint32_t n = h - tail;
+
+        __sync_synchronize();
+        *p = &buf[t];
+        return((n < (mask + 1 - t)) ? n : (mask + 1 - t));
+    }
+
+    /**
+     * release bytes returned by peek() (consumer)
+     *
+     * @param n - number of bytes
+     */
+    void consume(uint32_t n)
+    {
+        __sync_synchronize();
+        tail += n;
+    }
+
+    /**
+     * copy bytes out of the ring across its end, the ring is not changed: release what was used with consume() (consumer)
+     *
+     * @param dst - destination
+     * @param max - size of the destination
+     * @return - number of bytes copied
+     */
+    uint32_t copy(uint8_t *dst, uint32_t max) const
+    {
+        uint32_t n = head - tail;
+        uint32_t t = tail & mask;
+        uint32_t first;
+
+        __sync_synchronize();
+        n     = (n < max) ? n : max;
+        first = ((mask + 1 - t) < n) ? (mask + 1 - t) : n;
+        memcpy(dst, &buf[t], first);
+        memcpy(&dst[first], buf, n - first);
+        return(n);
+    }
+
+    /**
+     * copy bytes out of the ring (consumer)
+     *
+     * @param dst - destination
+     * @param max - size of the destination
+     * @return - number of bytes copied
+     */
+    uint32_t read(uint8_t *dst, uint32_t max)
+    {
+        uint32_t n = copy(dst, max);
+
+        consume(n);
+        return(n);
+    }
+
+    /**
+     * drain the ring into a byte sink, anything with write(const uint8_t *, size_t) returning the number of bytes taken
+     * (Serial, SerialUSB, an SD card File ...) (consumer)
+     *
+     * @param sink - byte sink
+     * @param max  - maximum number of bytes to drain in this call
+     * @return - number of bytes drained
+     */
+    template <class SINK> uint32_t drain(SINK &sink, uint32_t max = 0xFFFFFFFF)
+    {
+        const uint8_t *p;
+        uint32_t n, w, total = 0;
+
+        while ((total < max) && ((n = peek(&p)) != 0))
+        {
+            n = (n < (max - total)) ? n : (max - total);
+            w = sink.write(p, n);
+            consume(w);
+            total += w;
+            if (w < n)
+            {
+                break;
+            }
+        }
+        return(total);
+    }
+
+    /**
+     * number of frames logged or dropped, number of frames dropped, frames dropped since the last record (not in a drop
+     * marker yet), most bytes waiting at once
+     */
+    uint32_t getFrames() const
+    {
+        return(enc.getFrames() + pendDrop);
+    }
+    uint32_t getDropped() const
+    {
+        return(dropped);
+    }
+    uint32_t getPendingDrops() const
+    {
+        return(pendDrop);
+    }
+    uint32_t getHighWater() const
+    {
+        return(highWater);
+    }
+
+private:
+    uint8_t *buf;
+    uint32_t mask;
+
+    /**
+     * free running write / read indexes, head is only written by the producer and tail by the consumer
+     */
+    volatile uint32_t head;
+    volatile uint32_t tail;
+
+    cTraceEncoder enc;
+    uint32_t pendDrop;
+    uint32_t dropped;
+    uint32_t highWater;
+
+    /**
+     * copy a record in and publish it
+     */
+    void put(const uint8_t *rec, uint8_t n)
+    {
+        uint32_t h     = head & mask;
+        uint32_t first = ((mask + 1 - h) < n) ? (mask + 1 - h) : n;
+
+        memcpy(&buf[h], rec, first);
+        memcpy(buf, &rec[first], n - first);
+        __sync_synchronize();
+        head += n;
+    }
+};
+
+#endif
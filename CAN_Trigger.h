@@ -0,0 +1,464 @@
+/*
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#ifndef CAN_TRIGGER_H
+#define CAN_TRIGGER_H
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include "CAN_DBC.h"
+#include "CAN_Signal.h"
+#include "CAN_Trace.h"
+
+/**
+ * This is the maximum number of trigger conditions, it bounds the cost per frame
+ */
+#define TRIG_MAX_CONDITIONS 8
+
+/**
+ * This is returned by addCondition() when no condition can be added
+ */
+#define TRIG_INVALID        0xFF
+
+/**
+ * This is the raw range of a condition without a signal, beyond any raw value of a signal (up to 32 bits, signed or
+ * unsigned), thresholds beyond it are clamped to it
+ */
+#define TRIG_RAW_LIMIT      ((int64_t)1 << 33)
+
+/**
+ * This enum represents the state of a capture
+ */
+enum TRIG_STATE
+{
+    TRIG_IDLE      = 0,     //not armed, frames are not stored
+    TRIG_ARMED     = 1,     //storing frames, waiting for a condition
+    TRIG_TRIGGERED = 2,     //a condition was met, storing the post-trigger frames
+    TRIG_FROZEN    = 3      //capture complete, ready for download
+};
+
+/**
+ * This enum represents the comparison of a signal condition with its threshold (engineering units)
+ */
+enum TRIG_COMPARE
+{
+    TRIG_ABOVE = 0,
+    TRIG_BELOW = 1
+};
+
+/**
+ * This struct represents a captured frame, flags are the trace header flags (TRACE_FLAG_EXT, TRACE_FLAG_RTR)
+ */
+struct sCaptureFrame
+{
+    uint32_t time;
+    uint32_t id;
+    uint8_t  port;
+    uint8_t  flags;
+    uint8_t  dlc;
+    uint8_t  data[8];
+};
+
+/**
+ * Pre/post-trigger capture: a ring of the most recent frames that is frozen around the first frame meeting a trigger
+ * condition, for intermittent faults where the bus history around an event matters and a continuous log does not.
+ *
+ * A condition is met by a frame when all of its parts match:
+ *   - ID / mask (only bits set in the mask must match, as cCANFrame does) and 11/29bit
+ *   - payload pattern (optional): value / mask over the 8 payload bytes
+ *   - signal threshold (optional): a signal (sCANSignal, Intel or Motorola) above or below a threshold in engineering
+ *     units, e.g. coolant temperature > 105 degC
+ * Any condition triggers the capture. The threshold is converted to a raw value range when the condition is set, so a
+ * frame is checked with integer math only: per condition an ID compare, a 64 bit pattern compare and a shift, mask and
+ * two compares for the signal. The cost per frame is bounded by TRIG_MAX_CONDITIONS (see
+ * extras/benchmarks/trigger_bench.cpp), once the capture is frozen a frame costs a single test.
+ *
+ * cAcquireCAN::setTrigger() feeds every frame received on a port to the capture, with two extra mailboxes so that frames
+ * with ID's not registered with the scheduler are captured too.
+ *
+ * arm(pre, post) starts a capture: frames are stored in the ring (storage given to begin()) and conditions are checked,
+ * the trigger frame is kept together with up to pre frames before it and the next post frames, then the capture is
+ * frozen until it is armed again. getFrame() reads it in order, download() writes it in the compact trace format.
+ *
+ * e.g.
+ *   sCaptureFrame captureBuffer[512];
+ *   UINT8 pid05[8] = {0, 0x41, 0x05}, pidMask[8] = {0, 0xFF, 0xFF};     //OBD2 mode 1 PID 0x05 response
+ *   sCANSignal coolant = {24, 8, SIG_INTEL, false, 1, -40};            //byte 3 - 40 degC
+ *   cTriggerCapture Capture;
+ *   Capture.begin(captureBuffer, 512);
+ *   UINT8 c = Capture.addCondition(0x7E8, 0x7FF, false);
+ *   Capture.setPattern(c, pid05, pidMask);
+ *   Capture.setSignal(c, coolant, TRIG_ABOVE, 105);
+ *   Capture.arm(400, 100);
+ *   CANport0.setTrigger(&Capture);
+ *   ... loop(): if (Capture.getState() == TRIG_FROZEN) Capture.download(SerialUSB);
+ *
+ * @author D.Kasamis - dan@togglebit.net
+ * @version 1.0
+ */
+class cTriggerCapture
+{
+public:
+    cTriggerCapture()
+    {
+        begin(NULL, 0);
+    }
+
+    /**
+     * set the storage, no conditions, not armed
+     *
+     * @param buffer - storage
+     * @param size   - number of frames the storage holds
+     */
+    void begin(sCaptureFrame *buffer, uint16_t size)
+    {
+        buf     = buffer;
+        bufSize = buffer ? size : 0;
+        num     = 0;
+        frames  = 0;
+        disarm();
+    }
+
+    /**
+     * add a condition on the ID
+     *
+     * @param id     - CAN ID
+     * @param idMask - bits set to 1 must match the ID
+     * @param ext    - 29bit ID
+     * @return - condition index, TRIG_INVALID if there are TRIG_MAX_CONDITIONS conditions (or the capture is armed)
+     */
+    uint8_t addCondition(uint32_t id, uint32_t idMask, bool ext)
+    {
+        if ((num >= TRIG_MAX_CONDITIONS) || !editable(0xFF))
+        {
+            return(TRIG_INVALID);
+        }
+
+        sCondition &C = cond[num];
+        memset(&C, 0, sizeof(C));
+        C.id     = id & idMask;
+        C.idMask = idMask;
+        C.ext    = ext;
+        C.lo     = -TRIG_RAW_LIMIT;
+        C.hi     = TRIG_RAW_LIMIT;
+        return(num++);
+    }
+
+    /**
+     * add a payload pattern to a condition: payload bits set in mask must match value
+     *
+     * @param c     - condition index
+     * @param value - 8 bytes
+     * @param mask  - 8 bytes
+     * @return - false if there is no such condition (or the capture is armed)
+     */
+    bool setPattern(uint8_t c, const uint8_t *value, const uint8_t *mask)
+    {
+        if (!editable(c))
+        {
+            return(false);
+        }
+        cond[c].patternMask  = dbcLoad(mask);
+        cond[c].patternValue = dbcLoad(value) & cond[c].patternMask;
+        return(true);
+    }
+
+    /**
+     * add a signal threshold to a condition
+     *
+     * @param c         - condition index
+     * @param S         - signal
+     * @param compare   - signal above / below the threshold
+     * @param threshold - engineering units (raw * scale + offset)
+     * @return - false if there is no such condition (or the capture is armed), the signal does not fit the payload or
+     *           its scale is 0
+     */
+    bool setSignal(uint8_t c, const sCANSignal &S, TRIG_COMPARE compare, float threshold)
+    {
+        int shift = cSignalCodec::place(S);
+        double x;
+        bool above;
+
+        if (!editable(c) || (shift < 0) || (S.scale == 0))
+        {
+            return(false);
+        }
+
+        sCondition &C = cond[c];
+        C.order = S.order;
+        C.shift = shift;
+        C.mask  = (1ULL << S.length) - 1;
+        C.sign  = S.isSigned ? (1ULL << (S.length - 1)) : 0;
+
+        //EU above the threshold = raw above x for a positive scale, below x for a negative one
+        x     = ((double)threshold - S.offset) / S.scale;
+        above = (compare == TRIG_ABOVE) == (S.scale > 0);
+        C.lo  = above ? clamp(floor(x) + 1) : -TRIG_RAW_LIMIT;
+        C.hi  = above ? TRIG_RAW_LIMIT : clamp(ceil(x) - 1);
+        return(true);
+    }
+
+    /**
+     * remove all conditions (disarms the capture)
+     */
+    void clearConditions()
+    {
+        disarm();
+        num = 0;
+    }
+
+    /**
+     * start a capture
+     *
+     * @param pre  - frames kept before the trigger frame
+     * @param post - frames kept after the trigger frame
+     * @return - false if pre + 1 + post frames don't fit the storage
+     */
+    bool arm(uint16_t pre, uint16_t post)
+    {
+        if (!buf || ((uint32_t)pre + 1 + post > bufSize))
+        {
+            return(false);
+        }
+
+        state      = TRIG_IDLE;
+        preWindow  = pre;
+        postWindow = post;
+        head       = 0;
+        stored     = 0;
+        postCount  = 0;
+        start      = 0;
+        count      = 0;
+        trigIndex  = 0;
+        trigCond   = TRIG_INVALID;
+        state      = TRIG_ARMED;
+        return(true);
+    }
+
+    /**
+     * stop storing frames, a frozen capture is discarded
+     */
+    void disarm()
+    {
+        state     = TRIG_IDLE;
+        count     = 0;
+        trigCond  = TRIG_INVALID;
+    }
+
+    /**
+     * store a received frame and check the conditions
+     *
+     * @param time - uS (e.g. micros())
+     * @param id   - CAN ID
+     * @param ext  - 29bit ID
+     * @param rtr  - remote frame
+     * @param dlc  - data length code
+     * @param data - 8 payload bytes
+     * @param port - port the frame was received on
+     * @return - true if this frame triggered the capture
+     */
+    bool frame(uint32_t time, uint32_t id, bool ext, bool rtr, uint8_t dlc, const uint8_t *data, uint8_t port = 0)
+    {
+        uint64_t word[2];
+        uint64_t r;
+        int64_t  raw;
+        uint16_t at;
+        uint8_t  i;
+
+        if ((state == TRIG_IDLE) || (state == TRIG_FROZEN))
+        {
+            return(false);
+        }
+
+        //store the frame, while armed the oldest frame is overwritten
+        at = head;
+        sCaptureFrame &F = buf[at];
+        F.time  = time;
+        F.id    = id;
+        F.port  = port;
+        F.flags = (ext ? TRACE_FLAG_EXT : 0) | (rtr ? TRACE_FLAG_RTR : 0);
+        F.dlc   = (dlc > 8) ? 8 : dlc;
+        memcpy(F.data, data, 8);
+        head    = ((head + 1) == bufSize) ? 0 : head + 1;
+        frames += 1;
+
+        if (state == TRIG_TRIGGERED)
+        {
+            count     += 1;
+            postCount += 1;
+            if (postCount >= postWindow)
+            {
+                state = TRIG_FROZEN;
+            }
+            return(false);
+        }
+
+        stored = (stored < bufSize) ? stored + 1 : stored;
+
+        //both byte orders up front, each condition takes its signal from word[C.order]
+        word[SIG_INTEL]    = dbcLoad(data);
+        word[SIG_MOTOROLA] = dbcSwap(word[SIG_INTEL]);
+
+        for (i = 0; i < num; i++)
+        {
+            const sCondition &C = cond[i];
+
+            if ((C.ext != ext) || ((id & C.idMask) != C.id) || ((word[SIG_INTEL] & C.patternMask) != C.patternValue))
+            {
+                continue;
+            }
+
+            //no signal: lo/hi are the full range
+            r   = (word[C.order] >> C.shift) & C.mask;
+            raw = (int64_t)((r ^ C.sign) - C.sign);
+            if ((raw < C.lo) || (raw > C.hi))
+            {
+                continue;
+            }
+
+            //keep up to pre frames before this one
+            trigCond  = i;
+            trigIndex = ((stored - 1) < preWindow) ? (stored - 1) : preWindow;
+            start     = (at >= trigIndex) ? (at - trigIndex) : (at + bufSize - trigIndex);
+            count     = trigIndex + 1;
+            state     = postWindow ? TRIG_TRIGGERED : TRIG_FROZEN;
+            return(true);
+        }
+        return(false);
+    }
+
+    /**
+     * state of the capture
+     */
+    TRIG_STATE getState() const
+    {
+        return(state);
+    }
+
+    /**
+     * number of frames in the capture (0 until triggered)
+     */
+    uint16_t getCount() const
+    {
+        return(count);
+    }
+
+    /**
+     * a frame of the capture, in the order received
+     *
+     * @param i - 0 = oldest
+     * @return - frame, NULL if there is no such frame
+     */
+    const sCaptureFrame* getFrame(uint16_t i) const
+    {
+        uint32_t at = (uint32_t)start + i;
+
+        return((i < count) ? &buf[(at >= bufSize) ? at - bufSize : at] : NULL);
+    }
+
+    /**
+     * index of the trigger frame in the capture (getFrame()) and the condition that triggered it
+     */
+    uint16_t getTriggerIndex() const
+    {
+        return(trigIndex);
+    }
+
+    uint8_t getTriggerCondition() const
+    {
+        return(trigCond);
+    }
+
+    /**
+     * number of frames stored (rolling)
+     */
+    uint32_t getFrames() const
+    {
+        return(frames);
+    }
+
+    /**
+     * write the capture to a byte sink in the compact trace format (CAN_Trace.h)
+     *
+     * @param sink - anything with write(const uint8_t *, size_t), e.g. SerialUSB
+     * @return - number of bytes written
+     */
+    template <class SINK> uint32_t download(SINK &sink) const
+    {
+        cTraceEncoder enc;
+        uint8_t rec[TRACE_RECORD_MAX];
+        uint32_t total = 0;
+        uint16_t i;
+
+        for (i = 0; i < count; i++)
+        {
+            const sCaptureFrame &F = *getFrame(i);
+            total += sink.write(rec, enc.frame(rec, F.time, F.id, (F.flags & TRACE_FLAG_EXT) != 0,
+                                               (F.flags & TRACE_FLAG_RTR) != 0, false, F.dlc, F.data, F.port));
+        }
+        return(total);
+    }
+
+private:
+    /**
+     * precomputed condition, a condition without a signal has the full raw range (mask 0 extracts 0)
+     */
+    struct sCondition
+    {
+        uint64_t patternValue;
+        uint64_t patternMask;
+        uint64_t mask;
+        uint64_t sign;
+        uint32_t id;
+        uint32_t idMask;
+        int64_t  lo;
+        int64_t  hi;
+        uint8_t  shift;
+        uint8_t  order;
+        bool     ext;
+    };
+
+    sCondition cond[TRIG_MAX_CONDITIONS];
+    uint8_t    num;
+
+    sCaptureFrame *buf;
+    uint16_t bufSize;
+    uint16_t head;
+    uint16_t stored;
+    uint16_t preWindow;
+    uint16_t postWindow;
+    uint16_t postCount;
+    uint16_t start;
+    uint16_t count;
+    uint16_t trigIndex;
+    uint8_t  trigCond;
+    uint32_t frames;
+    volatile TRIG_STATE state;
+
+    /**
+     * conditions are only changed while frames are not checked against them
+     */
+    bool editable(uint8_t c) const
+    {
+        return(((c < num) || (c == 0xFF)) && (state != TRIG_ARMED) && (state != TRIG_TRIGGERED));
+    }
+
+    static int64_t clamp(double v)
+    {
+        return((v < -TRIG_RAW_LIMIT) ? -TRIG_RAW_LIMIT : ((v > TRIG_RAW_LIMIT) ? TRIG_RAW_LIMIT : (int64_t)v));
+    }
+};
+
+#endif
@@ -0,0 +1,700 @@
+/*
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#include "CANopen.h"
+
+/**
+ * constructor, registers the NMT/SYNC/heartbeat frames with the acquisition scheduler
+ *
+ * @param _portNum - physical CAN port to be used
+ * @param _nodeID  - node ID, 1-127
+ */
+cCANopenNode::cCANopenNode(cAcquireCAN *_portNum, UINT8 _nodeID)
+{
+	portNum        = _portNum;
+	nodeID         = _nodeID & 0x7F;
+	state          = NMT_PRE_OPERATIONAL;
+	numTPDOs       = 0;
+	syncPeriodMs   = 0;
+	lastSyncTx     = 0;
+	syncWindowUs   = 0;
+	syncTime       = 0;
+	heartbeatMs    = 0;
+	lastHeartbeat  = 0;
+	bootup         = true;
+	numConsumers   = 0;
+	syncCtr        = 0;
+	windowMissCtr  = 0;
+	syncLatency    = 0;
+	syncLatencyMax = 0;
+
+	//
+	//********** RX NMT / SYNC / HEARTBEAT ****************
+	//
+	//	NMT:       | command | node ID (0 = all) |
+	//	SYNC:      no data (DLC 0)
+	//	heartbeat: | NMT state |   0x700 + node ID (DLC 1)
+	//
+	NMTFrame.ID     = CANOPEN_NMT_ID;
+	NMTFrame.parent = this;
+	portNum->addMessage(&NMTFrame, RECEIVE);
+
+	SyncFrame.ID     = CANOPEN_SYNC_ID;
+	SyncFrame.parent = this;
+	portNum->addMessage(&SyncFrame, RECEIVE);
+
+	HeartbeatRxFrame.ID     = CANOPEN_HEARTBEAT_ID;
+	HeartbeatRxFrame.mask   = 0x780;
+	HeartbeatRxFrame.parent = this;
+	portNum->addMessage(&HeartbeatRxFrame, RECEIVE);
+
+	//
+	//********** TX SYNC / HEARTBEAT ****************
+	//
+	//registered ahead of the PDO's so a SYNC we produce triggers our SYNC PDO's on the same tick
+	//
+	SyncTxFrame.ID     = CANOPEN_SYNC_ID;
+	SyncTxFrame.rate   = TICK_MSG;
+	SyncTxFrame.dlc    = 0;
+	SyncTxFrame.kind   = CANOPEN_SYNC_FRAME;
+	SyncTxFrame.parent = this;
+	portNum->addMessage(&SyncTxFrame, TRANSMIT);
+
+	HeartbeatTxFrame.ID     = CANOPEN_HEARTBEAT_ID + nodeID;
+	HeartbeatTxFrame.rate   = TICK_MSG;
+	HeartbeatTxFrame.dlc    = 1;
+	HeartbeatTxFrame.kind   = CANOPEN_HEARTBEAT_FRAME;
+	HeartbeatTxFrame.parent = this;
+	portNum->addMessage(&HeartbeatTxFrame, TRANSMIT);
+}
+
+/**
+ * Register a PDO with the node and the acquisition scheduler
+ *
+ * @param pdo  - PDO, leave its ID 0 to use the predefined connection set
+ * @param type - TRANSMIT or RECEIVE
+ * @param num  - PDO number 1-4
+ * @return - false if too many transmit PDO's are registered
+ */
+bool cCANopenNode::addPDO(cCANopenPDO *pdo, ACQ_FRAME_TYPE type, UINT8 num)
+{
+	num = (num < 1) ? 1 : ((num > 4) ? 4 : num);
+
+	pdo->parent = this;
+	if (!pdo->ID)
+	{
+		pdo->ID = ((type == TRANSMIT) ? CANOPEN_TPDO_ID : CANOPEN_RPDO_ID) + 0x100 * (num - 1) + nodeID;
+	}
+
+	if (type == TRANSMIT)
+	{
+		if (numTPDOs >= CANOPEN_MAX_TPDOS)
+		{
+			return(false);
+		}
+
+		noInterrupts();
+		tpdos[numTPDOs] = pdo;
+		numTPDOs += 1;
+		interrupts();
+
+		//the trigger decides when it is sent, not a fixed rate
+		pdo->rate = TICK_MSG;
+	}
+
+	portNum->addMessage(pdo, type);
+	return(true);
+}
+
+/**
+ * Produce SYNC
+ *
+ * @param periodMs - SYNC period in mS, 0 to stop
+ */
+void cCANopenNode::setSyncProducer(UINT16 periodMs)
+{
+	syncPeriodMs = periodMs;
+	lastSyncTx   = millis();
+}
+
+/**
+ * Set the SYNC window
+ *
+ * @param us - window in uS, 0 = no window
+ */
+void cCANopenNode::setSyncWindow(UINT32 us)
+{
+	syncWindowUs = us;
+}
+
+/**
+ * Produce heartbeat
+ *
+ * @param periodMs - heartbeat period in mS, 0 to stop
+ */
+void cCANopenNode::setHeartbeat(UINT16 periodMs)
+{
+	heartbeatMs   = periodMs;
+	lastHeartbeat = millis();
+}
+
+/**
+ * Consume the heartbeat of another node
+ *
+ * @param node      - node ID
+ * @param timeoutMs - the node is considered lost when no heartbeat is received for this long
+ * @return - false if the consumer list is full
+ */
+bool cCANopenNode::addHeartbeatConsumer(UINT8 node, UINT16 timeoutMs)
+{
+	sConsumer *C;
+
+	if (numConsumers >= CANOPEN_MAX_CONSUMERS)
+	{
+		return(false);
+	}
+
+	C = &consumers[numConsumers];
+	C->node      = node & 0x7F;
+	C->timeoutMs = timeoutMs;
+	C->lastSeen  = 0;
+	C->state     = NMT_UNKNOWN;
+
+	noInterrupts();
+	numConsumers += 1;
+	interrupts();
+
+	return(true);
+}
+
+/**
+ * Retrieve the state of a node whose heartbeat is consumed
+ *
+ * @param node - node ID
+ * @return - NMT state from the last heartbeat, NMT_UNKNOWN if it timed out or is not consumed
+ */
+CANOPEN_NMT_STATE cCANopenNode::getNodeState(UINT8 node)
+{
+	UINT8 i;
+
+	for (i=0; i < numConsumers; i++)
+	{
+		if (consumers[i].node == node)
+		{
+			if ((consumers[i].state == NMT_UNKNOWN) || ((millis() - consumers[i].lastSeen) > consumers[i].timeoutMs))
+			{
+				return(NMT_UNKNOWN);
+			}
+			return((CANOPEN_NMT_STATE)consumers[i].state);
+		}
+	}
+
+	return(NMT_UNKNOWN);
+}
+
+/**
+ * Set our NMT state
+ *
+ * @param _state - NMT state
+ */
+void cCANopenNode::setState(CANOPEN_NMT_STATE _state)
+{
+	state = _state;
+}
+
+/**
+ * Retrieve our NMT state
+ *
+ * @return - NMT state
+ */
+CANOPEN_NMT_STATE cCANopenNode::getState()
+{
+	return(state);
+}
+
+/**
+ * Retrieve our node ID
+ *
+ * @return - node ID
+ */
+UINT8 cCANopenNode::getNodeID()
+{
+	return(nodeID);
+}
+
+/**
+ * Retrieve the number of SYNC's received or produced (rolling)
+ *
+ * @return - number of SYNC's
+ */
+UINT32 cCANopenNode::getSyncCtr()
+{
+	return(syncCtr);
+}
+
+/**
+ * Retrieve the number of SYNC PDO's dropped because they could not be sent within the SYNC window (rolling)
+ *
+ * @return - number of dropped PDO's
+ */
+UINT32 cCANopenNode::getWindowMissCtr()
+{
+	return(windowMissCtr);
+}
+
+/**
+ * Retrieve the time from the last SYNC to the transmission of a SYNC PDO
+ *
+ * @return - latency in uS
+ */
+UINT32 cCANopenNode::getSyncLatency()
+{
+	return(syncLatency);
+}
+
+/**
+ * Retrieve the largest time from a SYNC to the transmission of a SYNC PDO
+ *
+ * @return - latency in uS
+ */
+UINT32 cCANopenNode::getSyncLatencyMax()
+{
+	return(syncLatencyMax);
+}
+
+/**
+ * Clear the largest SYNC to PDO latency
+ */
+void cCANopenNode::resetSyncLatency()
+{
+	syncLatencyMax = 0;
+}
+
+/**
+ * this handler is called when an NMT, SYNC or heartbeat frame is received
+ *
+ * @param R - pointer to the received CAN frame
+ * @return - bool the frame was accepted
+ */
+bool cCANopenNode::receiveFrame(RX_CAN_FRAME *R)
+{
+	UINT8 i;
+
+	if (R->extended)
+	{
+		return(false);
+	}
+
+	if (R->id == CANOPEN_NMT_ID)
+	{
+		if ((R->data.byte[1] != 0) && (R->data.byte[1] != nodeID))
+		{
+			return(false);
+		}
+
+		switch (R->data.byte[0])
+		{
+		case NMT_START:
+			state = NMT_OPERATIONAL;
+			break;
+
+		case NMT_STOP:
+			state = NMT_STOPPED;
+			break;
+
+		case NMT_ENTER_PRE_OP:
+			state = NMT_PRE_OPERATIONAL;
+			break;
+
+		case NMT_RESET_NODE:
+		case NMT_RESET_COMM:
+			//nothing to reset but the state, announce ourselves again
+			state  = NMT_PRE_OPERATIONAL;
+			bootup = true;
+			break;
+
+		default:
+			break;
+		}
+
+	} else if (R->id == CANOPEN_SYNC_ID)
+	{
+		if (state == NMT_STOPPED)
+		{
+			return(false);
+		}
+		//the SYNC latency starts when the frame was complete, not when RXmsg() got to it
+		onSync(portNum->getRxTime(R));
+
+	} else
+	{
+		//heartbeat of a node we consume
+		for (i=0; i < numConsumers; i++)
+		{
+			if (consumers[i].node == (R->id & 0x7F))
+			{
+				consumers[i].lastSeen = millis();
+				consumers[i].state    = R->data.byte[0] & 0x7F;
+				break;
+			}
+		}
+	}
+
+	return(true);
+}
+
+/**
+ * A SYNC has been received (or produced), count it for the SYNC PDO's
+ *
+ * @param time - micros() at the end of the SYNC frame (received) or when it was queued (produced)
+ */
+void cCANopenNode::onSync(UINT32 time)
+{
+	cCANopenPDO *P;
+	UINT8 i;
+
+	syncTime = time;
+	syncCtr += 1;
+
+	for (i=0; i < numTPDOs; i++)
+	{
+		P = tpdos[i];
+		if (P->triggerType == PDO_SYNC)
+		{
+			P->syncCount += 1;
+			if (P->syncCount >= P->syncEvery)
+			{
+				P->syncCount = 0;
+				P->pending   = true;
+			}
+		}
+	}
+}
+
+/**
+ * this handler is called when a SYNC PDO is about to be sent, the latency is measured and PDO's outside the SYNC window
+ * are dropped
+ *
+ * @return - bool the PDO is still within the SYNC window
+ */
+bool cCANopenNode::syncPDOSent()
+{
+	UINT32 latency = micros() - syncTime;
+
+	if (syncWindowUs && (latency > syncWindowUs))
+	{
+		windowMissCtr += 1;
+		return(false);
+	}
+
+	syncLatency    = latency;
+	syncLatencyMax = (latency > syncLatencyMax) ? latency : syncLatencyMax;
+	return(true);
+}
+
+/**
+ * this handler is called by the scheduler on every tick for the SYNC and heartbeat frames
+ *
+ * @param F - frame to fill in
+ * @return - bool transmit the frame
+ */
+bool cCANopenNode::requestFrame(cCANopenTXFrame *F)
+{
+	UINT32 now = millis();
+
+	if (F->kind == CANOPEN_SYNC_FRAME)
+	{
+		if (!syncPeriodMs || ((now - lastSyncTx) < syncPeriodMs))
+		{
+			return(false);
+		}
+
+		//we don't receive our own SYNC, trigger our SYNC PDO's here
+		lastSyncTx = now;
+		onSync(micros());
+		return(true);
+	}
+
+	//boot-up message first, then the heartbeat
+	if (bootup)
+	{
+		bootup = false;
+		F->U.b[0] = NMT_BOOTUP;
+		return(true);
+	}
+
+	if (!heartbeatMs || ((now - lastHeartbeat) < heartbeatMs))
+	{
+		return(false);
+	}
+
+	lastHeartbeat = now;
+	F->U.b[0] = state;
+	return(true);
+}
+
+/**
+ * constructor, event driven with no inhibit time and nothing mapped
+ */
+cCANopenPDO::cCANopenPDO()
+{
+	parent      = NULL;
+	triggerType = PDO_EVENT;
+	syncEvery   = 1;
+	syncCount   = 0;
+	pending     = false;
+	numMapped   = 0;
+	numBits     = 0;
+	dlc         = 0;
+	inhibitUs   = 0;
+	eventMs     = 0;
+	lastTx      = 0;
+	ctr         = 0;
+	memset(lastData, 0, 8);
+}
+
+/**
+ * Map a variable into the PDO, in order from bit 0 of byte 0
+ *
+ * @param var  - variable
+ * @param bits - number of bits, 1-32
+ * @return - false if the PDO is full (8 objects or 64 bits)
+ */
+bool cCANopenPDO::map(void *var, UINT8 bits)
+{
+	if ((numMapped >= CANOPEN_MAX_MAPPED) || (bits < 1) || (bits > 32) || ((numBits + bits) > 64))
+	{
+		return(false);
+	}
+
+	mapping[numMapped].var  = var;
+	mapping[numMapped].bits = bits;
+	numMapped += 1;
+	numBits   += bits;
+
+	//a TPDO is sent with the bytes its mapping covers
+	dlc = (numBits + 7) / 8;
+
+	return(true);
+}
+
+/**
+ * Send the PDO on every Nth SYNC
+ *
+ * @param every - 1-240
+ */
+void cCANopenPDO::setSync(UINT8 every)
+{
+	triggerType = PDO_SYNC;
+	syncEvery   = (every < 1) ? 1 : ((every > 240) ? 240 : every);
+	syncCount   = 0;
+	pending     = false;
+}
+
+/**
+ * Send the PDO when the mapped data changes or trigger() is called
+ *
+ * @param inhibit100us - least time between two transmissions in 100uS (0 = none)
+ * @param _eventMs     - send anyway after this long without a transmission (0 = never)
+ */
+void cCANopenPDO::setEvent(UINT16 inhibit100us, UINT16 _eventMs)
+{
+	triggerType = PDO_EVENT;
+	inhibitUs   = (UINT32)inhibit100us * 100;
+	eventMs     = _eventMs;
+	pending     = false;
+}
+
+/**
+ * Request the PDO to be sent
+ */
+void cCANopenPDO::trigger()
+{
+	pending = true;
+}
+
+/**
+ * Retrieve the number of times the PDO has been sent or received (rolling)
+ *
+ * @return - number of PDO's
+ */
+UINT32 cCANopenPDO::getCtr()
+{
+	return(ctr);
+}
+
+/**
+ * Pack the mapped variables into a payload, little endian from bit 0 of byte 0
+ *
+ * @param b - 8 byte payload
+ */
+void cCANopenPDO::pack(UINT8 *b)
+{
+	unsigned long long v = 0;
+	UINT32 x;
+	UINT8 i, pos = 0;
+
+	for (i=0; i < numMapped; i++)
+	{
+		if (mapping[i].bits <= 8)
+		{
+			x = *(UINT8 *)mapping[i].var;
+		} else if (mapping[i].bits <= 16)
+		{
+			x = *(UINT16 *)mapping[i].var;
+		} else
+		{
+			x = *(UINT32 *)mapping[i].var;
+		}
+
+		x &= (mapping[i].bits < 32) ? (((UINT32)1 << mapping[i].bits) - 1) : 0xFFFFFFFF;
+		v |= (unsigned long long)x << pos;
+		pos += mapping[i].bits;
+	}
+
+	for (i=0; i < 8; i++)
+	{
+		b[i] = (UINT8)(v >> (8*i));
+	}
+}
+
+/**
+ * Unpack a payload into the mapped variables
+ *
+ * @param b - 8 byte payload
+ */
+void cCANopenPDO::unpack(const UINT8 *b)
+{
+	unsigned long long v = 0;
+	UINT32 x;
+	UINT8 i, pos = 0;
+
+	for (i=0; i < 8; i++)
+	{
+		v |= (unsigned long long)b[i] << (8*i);
+	}
+
+	for (i=0; i < numMapped; i++)
+	{
+		x = (UINT32)(v >> pos) & ((mapping[i].bits < 32) ? (((UINT32)1 << mapping[i].bits) - 1) : 0xFFFFFFFF);
+		pos += mapping[i].bits;
+
+		if (mapping[i].bits <= 8)
+		{
+			*(UINT8 *)mapping[i].var = (UINT8)x;
+		} else if (mapping[i].bits <= 16)
+		{
+			*(UINT16 *)mapping[i].var = (UINT16)x;
+		} else
+		{
+			*(UINT32 *)mapping[i].var = x;
+		}
+	}
+}
+
+/**
+ * This is a overridden implementaiton of the base class member that is called by the acquisition scheduler on every tick.
+ * SYNC PDO's are sent once per Nth SYNC (within the SYNC window), event PDO's when the data changes, trigger() is called
+ * or the event timer expires but never within the inhibit time of the previous transmission.
+ *
+ * @return - a flag to transmit or skip this CAN frame
+ */
+bool cCANopenPDO::CallbackTx()
+{
+	UINT32 now = micros();
+	UINT8 b[8];
+
+	if (!parent || (parent->getState() != NMT_OPERATIONAL))
+	{
+		return(false);
+	}
+
+	if (triggerType == PDO_SYNC)
+	{
+		if (!pending)
+		{
+			return(false);
+		}
+		pending = false;
+
+		if (!parent->syncPDOSent())
+		{
+			return(false);
+		}
+		pack(U.b);
+
+	} else
+	{
+		pack(b);
+
+		if (!pending && !memcmp(b, lastData, 8) && (!eventMs || ((now - lastTx) < (UINT32)eventMs * 1000)))
+		{
+			return(false);
+		}
+
+		//still due, it goes out once the inhibit time is over
+		if (inhibitUs && ((now - lastTx) < inhibitUs))
+		{
+			return(false);
+		}
+
+		pending = false;
+		memcpy(U.b, b, 8);
+		memcpy(lastData, b, 8);
+	}
+
+	lastTx = now;
+	ctr   += 1;
+	return(true);
+}
+
+/**
+ * This is a overridden implementaiton of the base class member that is called by the acquisition scheduler when a receive PDO has been received.
+ *
+ * @param R - pointer to RX Frame
+ * @return - a flag to accept or reject this CAN frame
+ */
+bool cCANopenPDO::CallbackRx(RX_CAN_FRAME *R)
+{
+	if (!R || !parent || (parent->getState() != NMT_OPERATIONAL))
+	{
+		return(false);
+	}
+
+	unpack(R->data.byte);
+	ctr += 1;
+	return(true);
+}
+
+/**
+ * This is a overridden implementaiton of the base class member that is called by the acquisition scheduler when a receive message matching this CAN ID has been received.
+ *
+ * @param R - pointer to RX Frame
+ * @return - a flag to accept or reject this CAN frame
+ */
+bool cCANopenRXFrame::CallbackRx(RX_CAN_FRAME *R)
+{
+	return(R ? parent->receiveFrame(R) : false);
+}
+
+/**
+ * This is a overridden implementaiton of the base class member that is called by the acquisition scheduler on every tick
+ *
+ * @return - a flag to transmit or skip this CAN frame
+ */
+bool cCANopenTXFrame::CallbackTx()
+{
+	return(parent->requestFrame(this));
+}
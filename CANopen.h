@@ -0,0 +1,419 @@
+/*
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#include "variant.h"
+#include <due_can.h>
+#include <CAN_Acquisition.h>
+
+#ifndef CANOPEN_H
+#define CANOPEN_H
+
+/**
+ *
+ * This macro is used to set the maximum number of objects mapped into one PDO
+ */
+#define	CANOPEN_MAX_MAPPED		8
+
+/**
+ *
+ * This macro is used to set the maximum number of transmit PDO's per node
+ */
+#define	CANOPEN_MAX_TPDOS		8
+
+/**
+ *
+ * This macro is used to set the maximum number of nodes whose heartbeat is consumed
+ */
+#define	CANOPEN_MAX_CONSUMERS	8
+
+/**
+ *
+ * These macros represent the predefined connection set: NMT, SYNC, TPDO1/RPDO1 base (+0x100 per PDO number) and heartbeat
+ */
+#define	CANOPEN_NMT_ID			0x000
+#define	CANOPEN_SYNC_ID			0x080
+#define	CANOPEN_TPDO_ID			0x180
+#define	CANOPEN_RPDO_ID			0x200
+#define	CANOPEN_HEARTBEAT_ID	0x700
+
+/**
+ *
+ * This enum represents the NMT state of a node (as sent in its heartbeat)
+ */
+enum CANOPEN_NMT_STATE
+{
+	NMT_BOOTUP          = 0x00,
+	NMT_STOPPED         = 0x04,
+	NMT_OPERATIONAL     = 0x05,
+	NMT_PRE_OPERATIONAL = 0x7F,
+	NMT_UNKNOWN         = 0xFF	//no heartbeat received (or timed out)
+};
+
+/**
+ *
+ * This enum represents the NMT commands
+ */
+enum CANOPEN_NMT_CMD
+{
+	NMT_START           = 0x01,
+	NMT_STOP            = 0x02,
+	NMT_ENTER_PRE_OP    = 0x80,
+	NMT_RESET_NODE      = 0x81,
+	NMT_RESET_COMM      = 0x82
+};
+
+/**
+ *
+ * This enum represents how a transmit PDO is triggered
+ */
+enum CANOPEN_PDO_TRIGGER
+{
+	PDO_SYNC  = 0,	//every Nth SYNC (transmission type 1-240)
+	PDO_EVENT = 1	//when the mapped data changes or trigger() is called, no faster than the inhibit time (transmission type 254/255)
+};
+
+/**
+ *
+ * This enum represents the frames a node sends by itself
+ */
+enum CANOPEN_CTRL_FRAME
+{
+	CANOPEN_SYNC_FRAME      = 0,
+	CANOPEN_HEARTBEAT_FRAME = 1
+};
+
+/**
+ *
+ * This struct represents an object mapped into a PDO, the variable is packed little endian (CANopen byte order)
+ */
+struct sCANopenMap
+{
+	void  *var;
+	UINT8 bits;
+};
+
+class cCANopenNode;
+
+/**
+ * A process data object. As a transmit PDO it is offered a transmit slot on every scheduler tick and its trigger
+ * (SYNC or event with inhibit time) decides if it is sent, the mapped variables are packed when it is sent. As a receive
+ * PDO the data is unpacked into the mapped variables when it is received (NMT operational only).
+ */
+class cCANopenPDO : public cCANFrame
+{
+public:
+	/**
+	 * constructor, event driven with no inhibit time and nothing mapped
+	 */
+	cCANopenPDO();
+
+	/**
+	 * Map a variable into the PDO, in order from bit 0 of byte 0. A TPDO is sent with the bytes its mapping covers
+	 *
+	 * @param var  - variable (UINT8 for up to 8 bits, UINT16 for up to 16, UINT32 for up to 32, signed types alike)
+	 * @param bits - number of bits, 1-32
+	 * @return - false if the PDO is full (8 objects or 64 bits)
+	 */
+	bool map(void *var, UINT8 bits);
+
+	/**
+	 * Send the PDO on every Nth SYNC
+	 *
+	 * @param every - 1-240
+	 */
+	void setSync(UINT8 every);
+
+	/**
+	 * Send the PDO when the mapped data changes or trigger() is called
+	 *
+	 * @param inhibit100us - least time between two transmissions in 100uS (0 = none)
+	 * @param _eventMs     - send anyway after this long without a transmission (0 = never)
+	 */
+	void setEvent(UINT16 inhibit100us, UINT16 _eventMs);
+
+	/**
+	 * Request the PDO to be sent (event driven PDO's, subject to the inhibit time)
+	 */
+	void trigger();
+
+	/**
+	 * Retrieve the number of times the PDO has been sent or received (rolling)
+	 *
+	 * @return - number of PDO's
+	 */
+	UINT32 getCtr();
+
+	/**
+	 * node this PDO belongs to
+	 */
+	cCANopenNode *parent;
+
+	/**
+	 * trigger, SYNC's per transmission and SYNC's counted so far, the PDO is due
+	 */
+	CANOPEN_PDO_TRIGGER triggerType;
+	UINT8  syncEvery;
+	UINT8  syncCount;
+	volatile bool pending;
+
+private:
+	/**
+	 * mapped objects, total number of mapped bits
+	 */
+	sCANopenMap mapping[CANOPEN_MAX_MAPPED];
+	UINT8  numMapped;
+	UINT8  numBits;
+
+	/**
+	 * inhibit time (uS), event timer (mS), time (micros) of the last transmission, data of the last transmission
+	 */
+	UINT32 inhibitUs;
+	UINT16 eventMs;
+	UINT32 lastTx;
+	UINT8  lastData[8];
+	UINT32 ctr;
+
+	/**
+	 * Pack the mapped variables into a payload
+	 *
+	 * @param b - 8 byte payload
+	 */
+	void pack(UINT8 *b);
+
+	/**
+	 * Unpack a payload into the mapped variables
+	 *
+	 * @param b - 8 byte payload
+	 */
+	void unpack(const UINT8 *b);
+
+	bool  CallbackTx();
+	bool  CallbackRx(RX_CAN_FRAME *R);
+};
+
+/**
+ * this is the frame that receives NMT, SYNC and heartbeat frames
+ */
+class cCANopenRXFrame : public cCANFrame
+{
+public:
+	cCANopenNode *parent;
+
+private:
+	bool  CallbackRx(RX_CAN_FRAME *R);
+};
+
+/**
+ * this is a frame the node sends by itself (SYNC or heartbeat), it is offered a transmit slot on every scheduler tick
+ */
+class cCANopenTXFrame : public cCANFrame
+{
+public:
+	cCANopenNode *parent;
+	CANOPEN_CTRL_FRAME kind;
+
+private:
+	bool  CallbackTx();
+};
+
+/**
+ * CANopen style node on a CAN port: SYNC and event triggered transmit PDO's, receive PDO's, NMT state, SYNC production
+ * and heartbeat production and consumption. The PDO's are scheduled by their trigger instead of the fixed ACQ_RATE_CAN
+ * rates. The time from the reception of a SYNC to the transmission of every SYNC PDO is measured, SYNC PDO's that
+ * can't be sent within the SYNC window are dropped so the latency is bounded.
+ *
+ * e.g.
+ *   cCANopenNode Node(&CANport0, 0x10);
+ *   cCANopenPDO  TPDO1;
+ *   TPDO1.map(&analog0, 16);
+ *   TPDO1.setSync(1);
+ *   Node.addPDO(&TPDO1, TRANSMIT, 1);
+ *   Node.setHeartbeat(100);
+ *
+ * @author D.Kasamis - dan@togglebit.net
+ * @version 1.0
+ */
+class cCANopenNode
+{
+public:
+	/**
+	 * constructor, registers the NMT/SYNC/heartbeat frames with the acquisition scheduler. The node starts pre-operational
+	 * and sends its boot-up message.
+	 *
+	 * @param _portNum - physical CAN port to be used
+	 * @param _nodeID  - node ID, 1-127
+	 */
+	cCANopenNode(cAcquireCAN *_portNum, UINT8 _nodeID);
+
+	/**
+	 * Register a PDO with the node and the acquisition scheduler
+	 *
+	 * @param pdo  - PDO, leave its ID 0 to use the predefined connection set
+	 * @param type - TRANSMIT or RECEIVE
+	 * @param num  - PDO number 1-4, selects the predefined COB-ID (TPDO 0x180/0x280/0x380/0x480 + node ID, RPDO 0x200...)
+	 * @return - false if too many transmit PDO's are registered
+	 */
+	bool addPDO(cCANopenPDO *pdo, ACQ_FRAME_TYPE type, UINT8 num);
+
+	/**
+	 * Produce SYNC
+	 *
+	 * @param periodMs - SYNC period in mS, 0 to stop
+	 */
+	void setSyncProducer(UINT16 periodMs);
+
+	/**
+	 * Set the SYNC window, SYNC PDO's not sent within this time after the SYNC are dropped
+	 *
+	 * @param us - window in uS, 0 = no window
+	 */
+	void setSyncWindow(UINT32 us);
+
+	/**
+	 * Produce heartbeat
+	 *
+	 * @param periodMs - heartbeat period in mS, 0 to stop
+	 */
+	void setHeartbeat(UINT16 periodMs);
+
+	/**
+	 * Consume the heartbeat of another node
+	 *
+	 * @param node      - node ID
+	 * @param timeoutMs - the node is considered lost when no heartbeat is received for this long
+	 * @return - false if the consumer list is full
+	 */
+	bool addHeartbeatConsumer(UINT8 node, UINT16 timeoutMs);
+
+	/**
+	 * Retrieve the state of a node whose heartbeat is consumed
+	 *
+	 * @param node - node ID
+	 * @return - NMT state from the last heartbeat, NMT_UNKNOWN if it timed out or is not consumed
+	 */
+	CANOPEN_NMT_STATE getNodeState(UINT8 node);
+
+	/**
+	 * Set/retrieve our NMT state, PDO's are only sent and received when operational
+	 */
+	void setState(CANOPEN_NMT_STATE _state);
+	CANOPEN_NMT_STATE getState();
+
+	/**
+	 * Retrieve our node ID
+	 */
+	UINT8 getNodeID();
+
+	/**
+	 * Retrieve the SYNC statistics: SYNC's received or produced (rolling), SYNC PDO's dropped outside the SYNC window
+	 * (rolling), last and largest SYNC to PDO latency (uS)
+	 */
+	UINT32 getSyncCtr();
+	UINT32 getWindowMissCtr();
+	UINT32 getSyncLatency();
+	UINT32 getSyncLatencyMax();
+
+	/**
+	 * Clear the largest SYNC to PDO latency
+	 */
+	void resetSyncLatency();
+
+	/**
+	 * this handler is called when an NMT, SYNC or heartbeat frame is received
+	 *
+	 * @param R - pointer to the received CAN frame
+	 * @return - bool the frame was accepted
+	 */
+	bool receiveFrame(RX_CAN_FRAME *R);
+
+	/**
+	 * this handler is called by the scheduler on every tick for the SYNC and heartbeat frames
+	 *
+	 * @param F - frame to fill in
+	 * @return - bool transmit the frame
+	 */
+	bool requestFrame(cCANopenTXFrame *F);
+
+	/**
+	 * this handler is called when a SYNC PDO is about to be sent
+	 *
+	 * @return - bool the PDO is still within the SYNC window
+	 */
+	bool syncPDOSent();
+
+private:
+	cAcquireCAN *portNum;
+	UINT8 nodeID;
+	volatile CANOPEN_NMT_STATE state;
+
+	/**
+	 * NMT / SYNC receive frames, heartbeat consumer frame, SYNC and heartbeat producer frames
+	 */
+	cCANopenRXFrame NMTFrame;
+	cCANopenRXFrame SyncFrame;
+	cCANopenRXFrame HeartbeatRxFrame;
+	cCANopenTXFrame SyncTxFrame;
+	cCANopenTXFrame HeartbeatTxFrame;
+
+	/**
+	 * transmit PDO's (for SYNC counting)
+	 */
+	cCANopenPDO *tpdos[CANOPEN_MAX_TPDOS];
+	UINT8  numTPDOs;
+
+	/**
+	 * SYNC: producer period (mS), time (millis) of the last SYNC produced, window (uS), time (micros) of the last SYNC
+	 */
+	UINT16 syncPeriodMs;
+	UINT32 lastSyncTx;
+	UINT32 syncWindowUs;
+	volatile UINT32 syncTime;
+
+	/**
+	 * heartbeat: producer period (mS), time (millis) of the last heartbeat, boot-up message to be sent
+	 */
+	UINT16 heartbeatMs;
+	UINT32 lastHeartbeat;
+	bool   bootup;
+
+	/**
+	 * consumed heartbeats
+	 */
+	struct sConsumer
+	{
+		UINT8  node;
+		UINT16 timeoutMs;
+		volatile UINT32 lastSeen;
+		volatile UINT8  state;
+	} consumers[CANOPEN_MAX_CONSUMERS];
+	UINT8  numConsumers;
+
+	/**
+	 * SYNC statistics
+	 */
+	UINT32 syncCtr;
+	UINT32 windowMissCtr;
+	UINT32 syncLatency;
+	UINT32 syncLatencyMax;
+
+	/**
+	 * A SYNC has been received (or produced), count it for the SYNC PDO's
+	 *
+	 * @param time - micros() at the end of the SYNC frame (received) or when it was queued (produced)
+	 */
+	void onSync(UINT32 time);
+};
+
+#endif
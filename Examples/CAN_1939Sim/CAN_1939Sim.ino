@@ -1,22 +1,38 @@
 #include <OBD2.h>
+#include <J1939.h>
 #include <DueTimer.h>
+#include "J1939Sim_dbc.h"
 /********************************************************************
-This example is built upon the "CANAcquisition" class cAcquireCAN 
-which is a simple scheduler for periodic TX/RX of CAN messages. 
-
-This example shows how to set up a "free-running" CAN bus where you have:
-	- Two messages being transmitted at 5Hz and 10Hz 
-	- One message being received at 1Hz
+This example is built upon the "CANAcquisition" class cAcquireCAN
+which is a simple scheduler for periodic TX/RX of CAN messages.
+
+This example shows how to simulate a J1939 engine ECU with the J1939 layer cJ1939:
+	- The ECU claims address 0x00 (engine #1) before anything is transmitted
+	- EEC1 (engine speed) and ETC2 (current gear) are transmitted at 10Hz
+	- CCVS (wheel based vehicle speed) is received from any source address
+	- The payloads are packed/unpacked by J1939Sim_dbc.h, generated from extras/dbc2cpp/J1939Sim.dbc with
+	  python3 extras/dbc2cpp/dbc2cpp.py extras/dbc2cpp/J1939Sim.dbc -o Examples/CAN_1939Sim/J1939Sim_dbc.h
 /********************************************************************/
 
 //create the CANport acqisition schedulers
 cAcquireCAN CANport0(CAN_PORT_0);
 
-/***** DEFINITIONS FOR RAW CAN FRAME *****/      
-cCANFrame  RAW_CAN_Frame1;
-cCANFrame  RAW_CAN_Frame2;
-UINT8 i;
-UINT32 maxTime;
+//J1939 layer on CAN port 0
+cJ1939 J1939(&CANport0);
+
+/***** DEFINITIONS FOR J1939 MESSAGES *****/
+cJ1939Message EEC1;
+cJ1939Message ETC2;
+cJ1939Message CCVS;
+
+//NAME: identity 1, manufacturer 0x7FF, function engine (0), industry group on-highway, not arbitrary address capable
+const UINT8 ecuName[8] = {0x01, 0x00, 0xE0, 0xFF, 0x00, 0x00, 0x00, 0x10};
+
+//signal values of the messages (raw counts), see J1939Sim_dbc.h for the layout and scaling
+sEEC1 eec1;
+sETC2 etc2;
+sCCVS ccvs;
+
 UINT16 engSpeed;
 UINT8  gear;
 
@@ -28,28 +44,32 @@ void setup()
 	//debugging message for monitor to indicate CPU resets are occuring
 	Serial.println("System Reset");
 
-	//start CAN ports, set the baud rate here
-	CANport0.initialize(_500K);
+	//initialize the J1939 messages, the CAN ID is built from the PGN, priority and our address
+	EEC1.pgn      = 0xF004;
+	EEC1.priority = 3;
+	EEC1.rate     = _10Hz_Rate;
+	ETC2.pgn      = 0xF005;
+	ETC2.rate     = _10Hz_Rate;
+	CCVS.pgn      = 0xFEF1;
+
+	//add our messages to the J1939 layer, CCVS is received from any source address and with any priority
+	J1939.addMessage(&EEC1, TRANSMIT);
+	J1939.addMessage(&ETC2, TRANSMIT);
+	J1939.addMessage(&CCVS, RECEIVE);
 
-	//initialize the items needed to TX/RX raw CAN mesasges
-	RAW_CAN_Frame1.ID = 0xf004;
-	RAW_CAN_Frame1.rate  = _1Hz_Rate;
-  RAW_CAN_Frame2.ID = 0xf005;
-  RAW_CAN_Frame2.rate  = _1Hz_Rate;
-  
-     
-	//add our raw messages to the scheduler	1
-	CANport0.addMessage(&RAW_CAN_Frame1, TRANSMIT);
-  CANport0.addMessage(&RAW_CAN_Frame2, TRANSMIT);
+	//start CAN ports, set the baud rate here (J1939 is 250K)
+	CANport0.initialize(_250K);
 
+	//claim our address, EEC1 and ETC2 are transmitted once the claim has not been contended for 250mS
+	J1939.claimAddress(ecuName, 0x00);
 
 	//set up the transmission/reception of messages to occur at 500Hz (2mS) timer interrupt
 	Timer3.attachInterrupt(CAN_RxTx).setFrequency(500).start();
 
 	//output pin that can be used for debugging purposes
-	pinMode(13, OUTPUT);      
+	pinMode(13, OUTPUT);
 
-  gear =1;
+	gear = 1;
 }
 
 
@@ -57,16 +77,27 @@ void setup()
 
 void loop()
 {
-  //20,000 = 2500rpm 0.125rpm per bit, 
-  engSpeed = engSpeed < 20000 ? engSpeed + 100 : 0;
-  gear = engSpeed == 0 ? gear + 1 : gear;
-  gear = gear < 5 ? gear : 1;
-  
-	RAW_CAN_Frame1.U.b[3] = engSpeed & 0xFF;
-  RAW_CAN_Frame1.U.b[4] = ( engSpeed >> 8 ) & 0xFF;
-  
-  //gear has an offset of 125
-  RAW_CAN_Frame2.U.b[3] = gear + 125;
+	//20,000 = 2500rpm 0.125rpm per bit,
+	engSpeed = engSpeed < 20000 ? engSpeed + 100 : 0;
+	gear = engSpeed == 0 ? gear + 1 : gear;
+	gear = gear < 5 ? gear : 1;
+
+	eec1.EngSpeed = engSpeed;
+	eec1.encode(EEC1);
+
+	//gear has an offset of -125
+	etc2.CurrentGear = gear - (SINT32)sETC2::CurrentGear_OFFSET;
+	etc2.encode(ETC2);
+
+	//wheel based vehicle speed, 1/256 km/h per bit
+	if (CCVS.rxCtr)
+	{
+		ccvs.decode(CCVS);
+		Serial.print("Vehicle speed (from SA ");
+		Serial.print(CCVS.source);
+		Serial.print("): ");
+		Serial.println(ccvs.WheelBasedVehicleSpeed / 256);
+	}
 
 	//pass control to other task
 	delay(100);
@@ -75,6 +106,6 @@ void loop()
 //this is our timer interrupt handler, called at XmS interval
 void CAN_RxTx()
 {
-	//run CAN acquisition schedulers on both ports including OBD and RAW CAN mesages (RX/TX)		 
+	//run CAN acquisition schedulers on both ports including J1939 mesages (RX/TX)
 	CANport0.run(TIMER_2mS);
 }
@@ -0,0 +1,451 @@
+/*
+  Generated by extras/dbc2cpp/dbc2cpp.py from J1939Sim.dbc, do not edit.
+*/
+#ifndef J1939SIM_DBC_H
+#define J1939SIM_DBC_H
+#include "CAN_DBC.h"
+
+/**
+ * EEC1 - Electronic Engine Controller 1, PGN 0xF004
+ * extended ID 0x0CF00400, 8 bytes, sent by Engine
+ */
+struct sEEC1
+{
+    static constexpr uint32_t ID  = 0x0CF00400;
+    static constexpr uint8_t  DLC = 8;
+
+    /**
+     * Intel start bit 0, 4 bits, 1/bit +0
+     */
+    uint8_t  EngTorqueMode;
+
+    /**
+     * Intel start bit 8, 8 bits, 1/bit -125 %
+     */
+    uint8_t  DriversDemandTorque;
+
+    /**
+     * Intel start bit 16, 8 bits, 1/bit -125 %
+     */
+    uint8_t  ActualEngTorque;
+
+    /**
+     * Actual engine speed, Intel start bit 24, 16 bits, 0.125/bit +0 rpm
+     */
+    uint16_t EngSpeed;
+
+    /**
+     * Intel start bit 40, 8 bits, 1/bit +0
+     */
+    uint8_t  SrcAddrEngCtrl;
+
+    /**
+     * Intel start bit 48, 4 bits, 1/bit +0
+     */
+    uint8_t  EngStarterMode;
+
+    /**
+     * Intel start bit 56, 8 bits, 1/bit -125 %
+     */
+    uint8_t  EngDemandTorque;
+
+    static constexpr uint8_t  EngTorqueMode_SHIFT  = 0;
+    static constexpr uint64_t EngTorqueMode_MASK   = 0xFULL;
+    static constexpr float    EngTorqueMode_SCALE  = 1.0f;
+    static constexpr float    EngTorqueMode_OFFSET = 0.0f;
+    static constexpr uint8_t  DriversDemandTorque_SHIFT  = 8;
+    static constexpr uint64_t DriversDemandTorque_MASK   = 0xFFULL;
+    static constexpr float    DriversDemandTorque_SCALE  = 1.0f;
+    static constexpr float    DriversDemandTorque_OFFSET = -125.0f;
+    static constexpr uint8_t  ActualEngTorque_SHIFT  = 16;
+    static constexpr uint64_t ActualEngTorque_MASK   = 0xFFULL;
+    static constexpr float    ActualEngTorque_SCALE  = 1.0f;
+    static constexpr float    ActualEngTorque_OFFSET = -125.0f;
+    static constexpr uint8_t  EngSpeed_SHIFT  = 24;
+    static constexpr uint64_t EngSpeed_MASK   = 0xFFFFULL;
+    static constexpr float    EngSpeed_SCALE  = 0.125f;
+    static constexpr float    EngSpeed_OFFSET = 0.0f;
+    static constexpr uint8_t  SrcAddrEngCtrl_SHIFT  = 40;
+    static constexpr uint64_t SrcAddrEngCtrl_MASK   = 0xFFULL;
+    static constexpr float    SrcAddrEngCtrl_SCALE  = 1.0f;
+    static constexpr float    SrcAddrEngCtrl_OFFSET = 0.0f;
+    static constexpr uint8_t  EngStarterMode_SHIFT  = 48;
+    static constexpr uint64_t EngStarterMode_MASK   = 0xFULL;
+    static constexpr float    EngStarterMode_SCALE  = 1.0f;
+    static constexpr float    EngStarterMode_OFFSET = 0.0f;
+    static constexpr uint8_t  EngDemandTorque_SHIFT  = 56;
+    static constexpr uint64_t EngDemandTorque_MASK   = 0xFFULL;
+    static constexpr float    EngDemandTorque_SCALE  = 1.0f;
+    static constexpr float    EngDemandTorque_OFFSET = -125.0f;
+
+    static constexpr uint8_t get_EngTorqueMode(uint64_t w)
+    {
+        return((uint8_t)((w >> EngTorqueMode_SHIFT) & EngTorqueMode_MASK));
+    }
+    static constexpr uint64_t put_EngTorqueMode(uint8_t raw)
+    {
+        return(((uint64_t)raw & EngTorqueMode_MASK) << EngTorqueMode_SHIFT);
+    }
+    static constexpr uint8_t get_DriversDemandTorque(uint64_t w)
+    {
+        return((uint8_t)((w >> DriversDemandTorque_SHIFT) & DriversDemandTorque_MASK));
+    }
+    static constexpr uint64_t put_DriversDemandTorque(uint8_t raw)
+    {
+        return(((uint64_t)raw & DriversDemandTorque_MASK) << DriversDemandTorque_SHIFT);
+    }
+    static constexpr uint8_t get_ActualEngTorque(uint64_t w)
+    {
+        return((uint8_t)((w >> ActualEngTorque_SHIFT) & ActualEngTorque_MASK));
+    }
+    static constexpr uint64_t put_ActualEngTorque(uint8_t raw)
+    {
+        return(((uint64_t)raw & ActualEngTorque_MASK) << ActualEngTorque_SHIFT);
+    }
+    static constexpr uint16_t get_EngSpeed(uint64_t w)
+    {
+        return((uint16_t)((w >> EngSpeed_SHIFT) & EngSpeed_MASK));
+    }
+    static constexpr uint64_t put_EngSpeed(uint16_t raw)
+    {
+        return(((uint64_t)raw & EngSpeed_MASK) << EngSpeed_SHIFT);
+    }
+    static constexpr uint8_t get_SrcAddrEngCtrl(uint64_t w)
+    {
+        return((uint8_t)((w >> SrcAddrEngCtrl_SHIFT) & SrcAddrEngCtrl_MASK));
+    }
+    static constexpr uint64_t put_SrcAddrEngCtrl(uint8_t raw)
+    {
+        return(((uint64_t)raw & SrcAddrEngCtrl_MASK) << SrcAddrEngCtrl_SHIFT);
+    }
+    static constexpr uint8_t get_EngStarterMode(uint64_t w)
+    {
+        return((uint8_t)((w >> EngStarterMode_SHIFT) & EngStarterMode_MASK));
+    }
+    static constexpr uint64_t put_EngStarterMode(uint8_t raw)
+    {
+        return(((uint64_t)raw & EngStarterMode_MASK) << EngStarterMode_SHIFT);
+    }
+    static constexpr uint8_t get_EngDemandTorque(uint64_t w)
+    {
+        return((uint8_t)((w >> EngDemandTorque_SHIFT) & EngDemandTorque_MASK));
+    }
+    static constexpr uint64_t put_EngDemandTorque(uint8_t raw)
+    {
+        return(((uint64_t)raw & EngDemandTorque_MASK) << EngDemandTorque_SHIFT);
+    }
+
+    /**
+     * decode all signals of a payload word (see dbcLoad)
+     */
+    static constexpr sEEC1 unpack(uint64_t w)
+    {
+        return(sEEC1{get_EngTorqueMode(w), get_DriversDemandTorque(w), get_ActualEngTorque(w), get_EngSpeed(w), get_SrcAddrEngCtrl(w), get_EngStarterMode(w), get_EngDemandTorque(w)});
+    }
+
+    /**
+     * encode all signals into a payload word (see dbcStore), unused bits are 0
+     */
+    static constexpr uint64_t pack(const sEEC1 &m)
+    {
+        return(put_EngTorqueMode(m.EngTorqueMode) | put_DriversDemandTorque(m.DriversDemandTorque) | put_ActualEngTorque(m.ActualEngTorque) | put_EngSpeed(m.EngSpeed) | put_SrcAddrEngCtrl(m.SrcAddrEngCtrl) | put_EngStarterMode(m.EngStarterMode) | put_EngDemandTorque(m.EngDemandTorque));
+    }
+
+    /**
+     * decode/encode a frame payload, FRAME is a cCANFrame (or anything else with a U.b[8] payload)
+     */
+    template <class FRAME> void decode(const FRAME &F)
+    {
+        *this = unpack(dbcLoad(F.U.b));
+    }
+    template <class FRAME> void encode(FRAME &F) const
+    {
+        dbcStore(F.U.b, pack(*this));
+    }
+};
+
+/**
+ * ETC2 - Electronic Transmission Controller 2, PGN 0xF005
+ * extended ID 0x18F00500, 8 bytes, sent by Engine
+ */
+struct sETC2
+{
+    static constexpr uint32_t ID  = 0x18F00500;
+    static constexpr uint8_t  DLC = 8;
+
+    /**
+     * Intel start bit 0, 8 bits, 1/bit -125
+     */
+    uint8_t  SelectedGear;
+
+    /**
+     * Intel start bit 8, 16 bits, 0.001/bit +0
+     */
+    uint16_t ActualGearRatio;
+
+    /**
+     * Gear currently engaged, 0 = neutral, negative = reverse, Intel start bit 24, 8 bits, 1/bit -125
+     */
+    uint8_t  CurrentGear;
+
+    /**
+     * Intel start bit 32, 16 bits, 1/bit +0
+     */
+    uint16_t TransRequestedRange;
+
+    /**
+     * Intel start bit 48, 16 bits, 1/bit +0
+     */
+    uint16_t TransCurrentRange;
+
+    static constexpr uint8_t  SelectedGear_SHIFT  = 0;
+    static constexpr uint64_t SelectedGear_MASK   = 0xFFULL;
+    static constexpr float    SelectedGear_SCALE  = 1.0f;
+    static constexpr float    SelectedGear_OFFSET = -125.0f;
+    static constexpr uint8_t  ActualGearRatio_SHIFT  = 8;
+    static constexpr uint64_t ActualGearRatio_MASK   = 0xFFFFULL;
+    static constexpr float    ActualGearRatio_SCALE  = 0.001f;
+    static constexpr float    ActualGearRatio_OFFSET = 0.0f;
+    static constexpr uint8_t  CurrentGear_SHIFT  = 24;
+    static constexpr uint64_t CurrentGear_MASK   = 0xFFULL;
+    static constexpr float    CurrentGear_SCALE  = 1.0f;
+    static constexpr float    CurrentGear_OFFSET = -125.0f;
+    static constexpr uint8_t  TransRequestedRange_SHIFT  = 32;
+    static constexpr uint64_t TransRequestedRange_MASK   = 0xFFFFULL;
+    static constexpr float    TransRequestedRange_SCALE  = 1.0f;
+    static constexpr float    TransRequestedRange_OFFSET = 0.0f;
+    static constexpr uint8_t  TransCurrentRange_SHIFT  = 48;
+    static constexpr uint64_t TransCurrentRange_MASK   = 0xFFFFULL;
+    static constexpr float    TransCurrentRange_SCALE  = 1.0f;
+    static constexpr float    TransCurrentRange_OFFSET = 0.0f;
+
+    static constexpr uint8_t get_SelectedGear(uint64_t w)
+    {
+        return((uint8_t)((w >> SelectedGear_SHIFT) & SelectedGear_MASK));
+    }
+    static constexpr uint64_t put_SelectedGear(uint8_t raw)
+    {
+        return(((uint64_t)raw & SelectedGear_MASK) << SelectedGear_SHIFT);
+    }
+    static constexpr uint16_t get_ActualGearRatio(uint64_t w)
+    {
+        return((uint16_t)((w >> ActualGearRatio_SHIFT) & ActualGearRatio_MASK));
+    }
+    static constexpr uint64_t put_ActualGearRatio(uint16_t raw)
+    {
+        return(((uint64_t)raw & ActualGearRatio_MASK) << ActualGearRatio_SHIFT);
+    }
+    static constexpr uint8_t get_CurrentGear(uint64_t w)
+    {
+        return((uint8_t)((w >> CurrentGear_SHIFT) & CurrentGear_MASK));
+    }
+    static constexpr uint64_t put_CurrentGear(uint8_t raw)
+    {
+        return(((uint64_t)raw & CurrentGear_MASK) << CurrentGear_SHIFT);
+    }
+    static constexpr uint16_t get_TransRequestedRange(uint64_t w)
+    {
+        return((uint16_t)((w >> TransRequestedRange_SHIFT) & TransRequestedRange_MASK));
+    }
+    static constexpr uint64_t put_TransRequestedRange(uint16_t raw)
+    {
+        return(((uint64_t)raw & TransRequestedRange_MASK) << TransRequestedRange_SHIFT);
+    }
+    static constexpr uint16_t get_TransCurrentRange(uint64_t w)
+    {
+        return((uint16_t)((w >> TransCurrentRange_SHIFT) & TransCurrentRange_MASK));
+    }
+    static constexpr uint64_t put_TransCurrentRange(uint16_t raw)
+    {
+        return(((uint64_t)raw & TransCurrentRange_MASK) << TransCurrentRange_SHIFT);
+    }
+
+    /**
+     * decode all signals of a payload word (see dbcLoad)
+     */
+    static constexpr sETC2 unpack(uint64_t w)
+    {
+        return(sETC2{get_SelectedGear(w), get_ActualGearRatio(w), get_CurrentGear(w), get_TransRequestedRange(w), get_TransCurrentRange(w)});
+    }
+
+    /**
+     * encode all signals into a payload word (see dbcStore), unused bits are 0
+     */
+    static constexpr uint64_t pack(const sETC2 &m)
+    {
+        return(put_SelectedGear(m.SelectedGear) | put_ActualGearRatio(m.ActualGearRatio) | put_CurrentGear(m.CurrentGear) | put_TransRequestedRange(m.TransRequestedRange) | put_TransCurrentRange(m.TransCurrentRange));
+    }
+
+    /**
+     * decode/encode a frame payload, FRAME is a cCANFrame (or anything else with a U.b[8] payload)
+     */
+    template <class FRAME> void decode(const FRAME &F)
+    {
+        *this = unpack(dbcLoad(F.U.b));
+    }
+    template <class FRAME> void encode(FRAME &F) const
+    {
+        dbcStore(F.U.b, pack(*this));
+    }
+};
+
+/**
+ * CCVS - Cruise Control/Vehicle Speed, PGN 0xFEF1
+ * extended ID 0x18FEF100, 8 bytes, sent by Vehicle
+ */
+struct sCCVS
+{
+    static constexpr uint32_t ID  = 0x18FEF100;
+    static constexpr uint8_t  DLC = 8;
+
+    /**
+     * Intel start bit 0, 2 bits, 1/bit +0
+     */
+    uint8_t  TwoSpeedAxleSwitch;
+
+    /**
+     * Intel start bit 2, 2 bits, 1/bit +0
+     */
+    uint8_t  ParkingBrakeSwitch;
+
+    /**
+     * Wheel-Based Vehicle Speed, Intel start bit 8, 16 bits, 0.00390625/bit +0 km/h
+     */
+    uint16_t WheelBasedVehicleSpeed;
+
+    /**
+     * Intel start bit 24, 2 bits, 1/bit +0
+     */
+    uint8_t  CruiseCtrlActive;
+
+    /**
+     * Intel start bit 28, 2 bits, 1/bit +0
+     */
+    uint8_t  BrakeSwitch;
+
+    /**
+     * Intel start bit 30, 2 bits, 1/bit +0
+     */
+    uint8_t  ClutchSwitch;
+
+    /**
+     * Intel start bit 40, 8 bits, 1/bit +0 km/h
+     */
+    uint8_t  CruiseCtrlSetSpeed;
+
+    static constexpr uint8_t  TwoSpeedAxleSwitch_SHIFT  = 0;
+    static constexpr uint64_t TwoSpeedAxleSwitch_MASK   = 0x3ULL;
+    static constexpr float    TwoSpeedAxleSwitch_SCALE  = 1.0f;
+    static constexpr float    TwoSpeedAxleSwitch_OFFSET = 0.0f;
+    static constexpr uint8_t  ParkingBrakeSwitch_SHIFT  = 2;
+    static constexpr uint64_t ParkingBrakeSwitch_MASK   = 0x3ULL;
+    static constexpr float    ParkingBrakeSwitch_SCALE  = 1.0f;
+    static constexpr float    ParkingBrakeSwitch_OFFSET = 0.0f;
+    static constexpr uint8_t  WheelBasedVehicleSpeed_SHIFT  = 8;
+    static constexpr uint64_t WheelBasedVehicleSpeed_MASK   = 0xFFFFULL;
+    static constexpr float    WheelBasedVehicleSpeed_SCALE  = 0.00390625f;
+    static constexpr float    WheelBasedVehicleSpeed_OFFSET = 0.0f;
+    static constexpr uint8_t  CruiseCtrlActive_SHIFT  = 24;
+    static constexpr uint64_t CruiseCtrlActive_MASK   = 0x3ULL;
+    static constexpr float    CruiseCtrlActive_SCALE  = 1.0f;
+    static constexpr float    CruiseCtrlActive_OFFSET = 0.0f;
+    static constexpr uint8_t  BrakeSwitch_SHIFT  = 28;
+    static constexpr uint64_t BrakeSwitch_MASK   = 0x3ULL;
+    static constexpr float    BrakeSwitch_SCALE  = 1.0f;
+    static constexpr float    BrakeSwitch_OFFSET = 0.0f;
+    static constexpr uint8_t  ClutchSwitch_SHIFT  = 30;
+    static constexpr uint64_t ClutchSwitch_MASK   = 0x3ULL;
+    static constexpr float    ClutchSwitch_SCALE  = 1.0f;
+    static constexpr float    ClutchSwitch_OFFSET = 0.0f;
+    static constexpr uint8_t  CruiseCtrlSetSpeed_SHIFT  = 40;
+    static constexpr uint64_t CruiseCtrlSetSpeed_MASK   = 0xFFULL;
+    static constexpr float    CruiseCtrlSetSpeed_SCALE  = 1.0f;
+    static constexpr float    CruiseCtrlSetSpeed_OFFSET = 0.0f;
+
+    static constexpr uint8_t get_TwoSpeedAxleSwitch(uint64_t w)
+    {
+        return((uint8_t)((w >> TwoSpeedAxleSwitch_SHIFT) & TwoSpeedAxleSwitch_MASK));
+    }
+    static constexpr uint64_t put_TwoSpeedAxleSwitch(uint8_t raw)
+    {
+        return(((uint64_t)raw & TwoSpeedAxleSwitch_MASK) << TwoSpeedAxleSwitch_SHIFT);
+    }
+    static constexpr uint8_t get_ParkingBrakeSwitch(uint64_t w)
+    {
+        return((uint8_t)((w >> ParkingBrakeSwitch_SHIFT) & ParkingBrakeSwitch_MASK));
+    }
+    static constexpr uint64_t put_ParkingBrakeSwitch(uint8_t raw)
+    {
+        return(((uint64_t)raw & ParkingBrakeSwitch_MASK) << ParkingBrakeSwitch_SHIFT);
+    }
+    static constexpr uint16_t get_WheelBasedVehicleSpeed(uint64_t w)
+    {
+        return((uint16_t)((w >> WheelBasedVehicleSpeed_SHIFT) & WheelBasedVehicleSpeed_MASK));
+    }
+    static constexpr uint64_t put_WheelBasedVehicleSpeed(uint16_t raw)
+    {
+        return(((uint64_t)raw & WheelBasedVehicleSpeed_MASK) << WheelBasedVehicleSpeed_SHIFT);
+    }
+    static constexpr uint8_t get_CruiseCtrlActive(uint64_t w)
+    {
+        return((uint8_t)((w >> CruiseCtrlActive_SHIFT) & CruiseCtrlActive_MASK));
+    }
+    static constexpr uint64_t put_CruiseCtrlActive(uint8_t raw)
+    {
+        return(((uint64_t)raw & CruiseCtrlActive_MASK) << CruiseCtrlActive_SHIFT);
+    }
+    static constexpr uint8_t get_BrakeSwitch(uint64_t w)
+    {
+        return((uint8_t)((w >> BrakeSwitch_SHIFT) & BrakeSwitch_MASK));
+    }
+    static constexpr uint64_t put_BrakeSwitch(uint8_t raw)
+    {
+        return(((uint64_t)raw & BrakeSwitch_MASK) << BrakeSwitch_SHIFT);
+    }
+    static constexpr uint8_t get_ClutchSwitch(uint64_t w)
+    {
+        return((uint8_t)((w >> ClutchSwitch_SHIFT) & ClutchSwitch_MASK));
+    }
+    static constexpr uint64_t put_ClutchSwitch(uint8_t raw)
+    {
+        return(((uint64_t)raw & ClutchSwitch_MASK) << ClutchSwitch_SHIFT);
+    }
+    static constexpr uint8_t get_CruiseCtrlSetSpeed(uint64_t w)
+    {
+        return((uint8_t)((w >> CruiseCtrlSetSpeed_SHIFT) & CruiseCtrlSetSpeed_MASK));
+    }
+    static constexpr uint64_t put_CruiseCtrlSetSpeed(uint8_t raw)
+    {
+        return(((uint64_t)raw & CruiseCtrlSetSpeed_MASK) << CruiseCtrlSetSpeed_SHIFT);
+    }
+
+    /**
+     * decode all signals of a payload word (see dbcLoad)
+     */
+    static constexpr sCCVS unpack(uint64_t w)
+    {
+        return(sCCVS{get_TwoSpeedAxleSwitch(w), get_ParkingBrakeSwitch(w), get_WheelBasedVehicleSpeed(w), get_CruiseCtrlActive(w), get_BrakeSwitch(w), get_ClutchSwitch(w), get_CruiseCtrlSetSpeed(w)});
+    }
+
+    /**
+     * encode all signals into a payload word (see dbcStore), unused bits are 0
+     */
+    static constexpr uint64_t pack(const sCCVS &m)
+    {
+        return(put_TwoSpeedAxleSwitch(m.TwoSpeedAxleSwitch) | put_ParkingBrakeSwitch(m.ParkingBrakeSwitch) | put_WheelBasedVehicleSpeed(m.WheelBasedVehicleSpeed) | put_CruiseCtrlActive(m.CruiseCtrlActive) | put_BrakeSwitch(m.BrakeSwitch) | put_ClutchSwitch(m.ClutchSwitch) | put_CruiseCtrlSetSpeed(m.CruiseCtrlSetSpeed));
+    }
+
+    /**
+     * decode/encode a frame payload, FRAME is a cCANFrame (or anything else with a U.b[8] payload)
+     */
+    template <class FRAME> void decode(const FRAME &F)
+    {
+        *this = unpack(dbcLoad(F.U.b));
+    }
+    template <class FRAME> void encode(FRAME &F) const
+    {
+        dbcStore(F.U.b, pack(*this));
+    }
+};
+
+#endif
@@ -0,0 +1,117 @@
+#include <OBD2.h>
+#include <J1939.h>
+#include <J1939_TP.h>
+#include <DueTimer.h>
+/********************************************************************
+This example is built upon the "CANAcquisition" class cAcquireCAN
+which is a simple scheduler for periodic TX/RX of CAN messages.
+
+This example runs a J1939 connection mode transfer (RTS/CTS, see J1939_TP.h) between the two CAN ports of the Due,
+wire CAN0 to CAN1 (with termination) as for the board test:
+	- CAN0 claims address 0x00, CAN1 claims address 0x01 (250K)
+	- every 2 seconds CAN0 sends a 100 byte proprietary A (PGN 0xEF00) message to 0x01: RTS, CTS, 15 data packets
+	  and the end of message acknowledge all go over the bus as 29bit frames
+	- CAN1 receives the message into a buffer, it is checked against what was sent
+	- the transfers sent, received, timed out and aborted are printed on Serial: a working bus shows sent = received
+	  and no timeouts
+/********************************************************************/
+
+#define MSG_BYTES 100
+
+//create the CANport acqisition schedulers
+cAcquireCAN CANport0(CAN_PORT_0);
+cAcquireCAN CANport1(CAN_PORT_1);
+
+//J1939 layer and transport protocol on both ports
+cJ1939   J1939_0(&CANport0);
+cJ1939   J1939_1(&CANport1);
+cJ1939TP TP0(&J1939_0);
+cJ1939TP TP1(&J1939_1);
+
+/***** DEFINITIONS FOR J1939 MESSAGES *****/
+cJ1939Message PropA;
+
+//NAME's: identity 1 / 2, manufacturer 0x7FF, not arbitrary address capable
+const UINT8 name0[8] = {0x01, 0x00, 0xE0, 0xFF, 0x00, 0x00, 0x00, 0x10};
+const UINT8 name1[8] = {0x02, 0x00, 0xE0, 0xFF, 0x00, 0x00, 0x00, 0x10};
+
+UINT8 txData[MSG_BYTES];
+UINT8 rxBuffer[MSG_BYTES];
+UINT8 counter;
+
+UINT32 lastRx;
+UINT32 goodCtr;
+
+void setup()
+{
+	//start serial port
+	Serial.begin(115200);
+
+	//debugging message for monitor to indicate CPU resets are occuring
+	Serial.println("System Reset");
+
+	//the transfer is received by CAN1 into its buffer
+	PropA.pgn = 0xEF00;
+	PropA.setBuffer(rxBuffer, sizeof(rxBuffer));
+	J1939_1.addMessage(&PropA, RECEIVE);
+
+	//start CAN ports, set the baud rate here (J1939 is 250K)
+	CANport0.initialize(_250K);
+	CANport1.initialize(_250K);
+
+	J1939_0.claimAddress(name0, 0x00);
+	J1939_1.claimAddress(name1, 0x01);
+
+	//set up the transmission/reception of messages to occur at 500Hz (2mS) timer interrupt
+	Timer3.attachInterrupt(CAN_RxTx).setFrequency(500).start();
+}
+
+void loop()
+{
+	UINT8 i, bad;
+
+	//check a transfer as soon as it is complete
+	if (PropA.rxCtr != lastRx)
+	{
+		lastRx = PropA.rxCtr;
+		bad = 0;
+		for (i = 0; i < MSG_BYTES; i++)
+		{
+			bad += (rxBuffer[i] != (UINT8)(counter + i)) ? 1 : 0;
+		}
+		goodCtr += (!bad && (PropA.length == MSG_BYTES)) ? 1 : 0;
+	}
+
+	if ((J1939_0.getState() == J1939_ADDR_CLAIMED) && !TP0.isBusy(0x01))
+	{
+		Serial.print("RTS/CTS sent: ");
+		Serial.print(TP0.getTxCtr());
+		Serial.print(" received: ");
+		Serial.print(TP1.getRxCtr());
+		Serial.print(" intact: ");
+		Serial.print(goodCtr);
+		Serial.print(" timeouts: ");
+		Serial.print(TP0.getTimeoutCtr() + TP1.getTimeoutCtr());
+		Serial.print(" aborts: ");
+		Serial.println(TP0.getAbortCtr() + TP1.getAbortCtr());
+
+		//next message, 100 bytes from CAN0 to address 0x01
+		counter += 1;
+		for (i = 0; i < MSG_BYTES; i++)
+		{
+			txData[i] = counter + i;
+		}
+		TP0.send(0xEF00, 0x01, txData, MSG_BYTES);
+	}
+
+	//pass control to other task
+	delay(2000);
+}
+
+//this is our timer interrupt handler, called at XmS interval
+void CAN_RxTx()
+{
+	//run CAN acquisition schedulers on both ports including the transport frames (RX/TX)
+	CANport0.run(TIMER_2mS);
+	CANport1.run(TIMER_2mS);
+}
@@ -1,4 +1,5 @@
 #include <OBD2.h>
+#include <CAN_SignalFrame.h>
 #include <DueTimer.h>
 /********************************************************************
 This example is built upon the "CANAcquisition" class cAcquireCAN 
@@ -7,6 +8,8 @@ which is a simple scheduler for periodic TX/RX of CAN messages.
 This example shows how to set up a "free-running" CAN bus where you have:
 	- Two messages being transmitted at 5Hz and 10Hz 
 	- One message being received at 1Hz
+	- The analog inputs are packed into the payloads when the frames are sent (cCANSignalFrame),
+	  so a frame is never sent with half of its inputs updated
 /********************************************************************/
 
 //create the CANport acqisition schedulers
@@ -14,8 +17,17 @@ cAcquireCAN CANport0(CAN_PORT_0);
 
 
 /***** DEFINITIONS FOR RAW CAN FRAME *****/      
-cCANFrame  RAW_CAN_Frame1;
-cCANFrame  RAW_CAN_Frame2;
+cCANSignalFrame  RAW_CAN_Frame1;
+cCANSignalFrame  RAW_CAN_Frame2;
+
+//four 16 bit inputs per frame, the first input in bytes 6-7 ... the last in bytes 0-1 (start bit, length, byte order, signed, scale, offset)
+sCANSignal analogSignals[] =
+{
+	{48, 16, SIG_INTEL, false, 1, 0},
+	{32, 16, SIG_INTEL, false, 1, 0},
+	{16, 16, SIG_INTEL, false, 1, 0},
+	{ 0, 16, SIG_INTEL, false, 1, 0},
+};
 
 void setup()
 {
@@ -34,6 +46,9 @@ void setup()
 
 	RAW_CAN_Frame2.ID = 0x101;
 	RAW_CAN_Frame2.rate  = _5Hz_Rate;
+
+	RAW_CAN_Frame1.setSignals(analogSignals, 4, 0);
+	RAW_CAN_Frame2.setSignals(analogSignals, 4, 0);
        
 	//add our raw messages to the scheduler	1
 	CANport0.addMessage(&RAW_CAN_Frame1, TRANSMIT);
@@ -48,7 +63,7 @@ void setup()
 
 
 UINT8 i;
-UINT16 analogInputs[8];
+SINT32 analogInputs[8];
 UINT32 maxTime;
 
 void loop()
@@ -59,17 +74,9 @@ void loop()
           analogInputs[i] = analogRead(i);
         }
         
-        RAW_CAN_Frame1.U.P.upperPayload = analogInputs[0] << 16;
-        RAW_CAN_Frame1.U.P.upperPayload |= analogInputs[1] & 0xFFFF;
-
-        RAW_CAN_Frame1.U.P.lowerPayload = analogInputs[2] << 16;
-        RAW_CAN_Frame1.U.P.lowerPayload |= analogInputs[3] & 0xFFFF;
-
-        RAW_CAN_Frame2.U.P.upperPayload = analogInputs[4] << 16;
-        RAW_CAN_Frame2.U.P.upperPayload |= analogInputs[5] & 0xFFFF;
-
-        RAW_CAN_Frame2.U.P.lowerPayload = analogInputs[6] << 16;
-        RAW_CAN_Frame2.U.P.lowerPayload |= analogInputs[7] & 0xFFFF;
+        //packed in one pass when each frame is sent
+        RAW_CAN_Frame1.setRaws(&analogInputs[0]);
+        RAW_CAN_Frame2.setRaws(&analogInputs[4]);
 
 	//pass control to other task
 	delay(100);
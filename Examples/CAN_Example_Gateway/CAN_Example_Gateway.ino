@@ -1,46 +1,35 @@
 #include <CAN_Acquisition.h>
+#include <CAN_Gateway.h>
 /**************************************************************************************************************************************************************************
-This example is built upon the "CANAcquisition" class cAcquireCAN. 
+This example is built upon the "CANAcquisition" class cAcquireCAN and the table driven gateway cCANGateway.
 This example shows how to receive message 0x7E8, modify it and re-send it on CAN1 while acting as a "gateway" and pass through the rest of the ID's between CAN0 and CAN 1
 
+Each route is one line in the routing table (source port, ID/mask, destination port(s), optional new ID and payload rewrite), frames are queued
+on the destination port without waiting for it, so a busy bus never holds up the reception on the other one.
+0x101 is forwarded cut-through: straight from the CAN receive interrupt into a TX mailbox of the other controller, its latency is printed.
+The engine speed frame 0x0C0 (100Hz on CAN0) is bridged to CAN1 at 10Hz at most and only when it changes (refreshed once a second), the
+newest value always gets through.
 /*************************************************************************************************************************************************************************/
 
 //create the CANport acqisition schedulers
 cAcquireCAN CANport0(CAN_PORT_0);
 cAcquireCAN CANport1(CAN_PORT_1);
-    
-/**
- * inheriting this class allows us to implement the RX callback function at the top layer
- */
-class cGatewayRXFrameCAN0 : public cCANFrame
-{
-    bool  CallbackRx(RX_CAN_FRAME *R);
-};
-
-class cGatewayRXFrameCAN1 : public cCANFrame
-{
-    bool  CallbackRx(RX_CAN_FRAME *R);
-};
-
-//we are going to gateway messages 101,7DF,7E0,7E1, 0x7E8
-
-/****** CAN 0 messages ******/
-cGatewayRXFrameCAN0  CAN0_0x7E8;
-cGatewayRXFrameCAN0  CAN0_0x101;
-cGatewayRXFrameCAN0  CAN0_0x7E0;
-cGatewayRXFrameCAN0  CAN0_0x7E1;
-cGatewayRXFrameCAN0  CAN0_0x7DF;
 
-/****** CAN 1 messages ******/
-cGatewayRXFrameCAN1  CAN1_0x7E8;
-cGatewayRXFrameCAN1  CAN1_0x101;
-cGatewayRXFrameCAN1  CAN1_0x7E0;
-cGatewayRXFrameCAN1  CAN1_0x7E1;
-cGatewayRXFrameCAN1  CAN1_0x7DF;
+//the gateway registers its receive frames with both schedulers
+cCANGateway Gateway(&CANport0, &CANport1);
 
+//route index of the modified message and of the rate limited one
+UINT8 route0x7E8;
+UINT8 route0x0C0;
 
-
-UINT8 i;
+/**
+ * rewrite callback for 0x7E8, we want to increment the last byte of this message before it is sent on CAN1
+ */
+bool incrementLastByte(TX_CAN_FRAME *F)
+{
+    F->data.bytes[7] += 1;
+    return(true);
+}
 
 void setup()
 {
@@ -51,97 +40,88 @@ void setup()
     Serial.println("System Reset");
 
     //output pin that can be used for debugging purposes
-    pinMode(13, OUTPUT);      
-
-    //start CAN ports, set the baud rate here. 
+    pinMode(13, OUTPUT);
+
+    //we are going to gateway messages 101,7DF,7E0,7E1,7E8 both ways, 0x7E8 (modified from CAN0 to CAN1)
+    Gateway.setCutThrough(Gateway.addRoute(CAN_PORT_0, 0x101, 0x7FF, GW_TO_CAN1), true);
+    Gateway.addRoute(CAN_PORT_0, 0x7DF, 0x7FF, GW_TO_CAN1);
+    Gateway.addRoute(CAN_PORT_0, 0x7E0, 0x7FE, GW_TO_CAN1);     //0x7E0 and 0x7E1
+    route0x7E8 = Gateway.addRoute(CAN_PORT_0, 0x7E8, 0x7FF, GW_TO_CAN1);
+    Gateway.setRewrite(route0x7E8, incrementLastByte);
+
+    //keep the load on CAN1 down: at most one 0x0C0 per 100mS, unchanged values only once a second
+    route0x0C0 = Gateway.addRoute(CAN_PORT_0, 0x0C0, 0x7FF, GW_TO_CAN1);
+    Gateway.setDownsample(route0x0C0, _10Hz_Rate);
+    Gateway.setOnChange(route0x0C0, true, 1000);
+
+    Gateway.setCutThrough(Gateway.addRoute(CAN_PORT_1, 0x101, 0x7FF, GW_TO_CAN0), true);
+    Gateway.addRoute(CAN_PORT_1, 0x7DF, 0x7FF, GW_TO_CAN0);
+    Gateway.addRoute(CAN_PORT_1, 0x7E0, 0x7FE, GW_TO_CAN0);
+    Gateway.addRoute(CAN_PORT_1, 0x7E8, 0x7FF, GW_TO_CAN0);
+
+    //start CAN ports, set the baud rate here (after the gateway has added its receive frames)
     CANport0.initialize(_500K);
     CANport1.initialize(_500K);
 
-    //initialize raw CAN mesasges
-    /****** CAN 0 - Messages ******/
-    CAN0_0x7E8.ID = 0x7E8;   
-    CAN0_0x101.ID = 0x101;   
-    CAN0_0x7E0.ID = 0x7E0;   
-    CAN0_0x7E1.ID = 0x7E1;   
-    CAN0_0x7DF.ID = 0x7DF;   
-  
-    /****** CAN 1 - Messages ******/
-    CAN1_0x7E8.ID = 0x7E8;
-    CAN1_0x101.ID = 0x101;
-    CAN1_0x7E0.ID = 0x7E0;
-    CAN1_0x7E1.ID = 0x7E1;
-    CAN1_0x7DF.ID = 0x7DF;
-
-    //add messages to rx (set RX filters)
-    CANport0.addMessage(&CAN0_0x7E8, RECEIVE);
-    CANport0.addMessage(&CAN0_0x101, RECEIVE);
-    CANport0.addMessage(&CAN0_0x7E0, RECEIVE);
-    CANport0.addMessage(&CAN0_0x7E1, RECEIVE);  
-    CANport0.addMessage(&CAN0_0x7DF, RECEIVE);  
- 
-    CANport1.addMessage(&CAN0_0x7E8, RECEIVE);
-    CANport1.addMessage(&CAN0_0x101, RECEIVE);
-    CANport1.addMessage(&CAN0_0x7E0, RECEIVE);
-    CANport1.addMessage(&CAN0_0x7E1, RECEIVE);
-    CANport1.addMessage(&CAN0_0x7DF, RECEIVE);
+    //hook the receive/transmit interrupts for the cut-through routes (after the ports are initialized)
+    Gateway.enableCutThrough(_500K, _500K);
 }
 
 //this is our timer interrupt handler, called at XmS interval
 void CAN_RxTx()
 {
-    //receive messages, don't periodically transmit (but you can transmit asynchronously via CANportx.TXmsg(xxx) in our overloaded messages below)	 
-    CANport0.run(POLLING_noTx);
-    CANport1.run(POLLING_noTx);
+    //receive (and forward) messages, the scheduler tick forwards the frames held back by a policy
+    CANport0.run(POLLING);
+    CANport1.run(POLLING);
 }
 
+UINT32 lastPrint;
+
 void loop()
 {
+    const sGatewayRoute *R;
+    const sGatewayLatency *L;
+
     //handle can port RX in tight loop
     CAN_RxTx();
-}
-
-
-//this method is called whenever we receive a registered message on CAN 0
-bool cGatewayRXFrameCAN0::CallbackRx(RX_CAN_FRAME *R)
-{
-    bool retVal = false;
-    U8 i;
-    if (R)
-    {
-        //go ahead and immediately stuff message payload from raw can frame
-        for (i=0;i<8;i++)
-        {
-            this->U.b[i] = R->data.bytes[i];
-        }
-        
-        //have a look to see if this is the message we are looking for (0x7E8) on CAN0 to modify and pass through on CAN1
-        if(this->ID == 0x7E8)
-        {
-            //we want to increment the last byte of this message and resend this on CAN1
-            this->U.b[7] += 1;
-        }
-        
-        //gateway all registered RX messages from CAN 0 to CAN 1
-        CANport1.TXmsg(this);
-    }
-    return(retVal);
-}
 
-//this method is called whenever we receive a registered message on CAN 1
-bool cGatewayRXFrameCAN1::CallbackRx(RX_CAN_FRAME *R)
-{
-    bool retVal = false;
-    U8 i;
-    if (R)
+    //once a second, report how many 0x7E8 frames have been forwarded and dropped (CAN1 TX queue full)
+    if ((millis() - lastPrint) >= 1000)
     {
-        //go ahead and immediately stuff message payload from raw can frame
-        for (i=0;i<8;i++)
+        lastPrint = millis();
+        R = Gateway.getRoute(route0x7E8);
+        Serial.print("0x7E8 forwarded: ");
+        Serial.print(R->fwdCtr);
+        Serial.print(" dropped: ");
+        Serial.print(R->dropCtr);
+        Serial.print(" unrouted: ");
+        Serial.println(Gateway.getUnroutedCtr());
+
+        R = Gateway.getRoute(route0x0C0);
+        Serial.print("0x0C0 forwarded: ");
+        Serial.print(R->fwdCtr);
+        Serial.print(" coalesced: ");
+        Serial.print(R->coalescedCtr);
+        Serial.print(" unchanged: ");
+        Serial.println(R->suppressedCtr);
+
+        //cut-through latency CAN0 -> CAN1 in uS, end of the received frame to loaded / to the end of the forwarded frame
+        L = Gateway.getLatency(CAN_PORT_1);
+        if (L->frames)
         {
-            this->U.b[i] = R->data.bytes[i];
+            Serial.print("0x101 latency uS load min/max: ");
+            Serial.print(L->loadMin);
+            Serial.print("/");
+            Serial.print(L->loadMax);
+            Serial.print(" total min/avg/max: ");
+            Serial.print(L->totalMin);
+            Serial.print("/");
+            Serial.print(L->totalSum / L->frames);
+            Serial.print("/");
+            Serial.print(L->totalMax);
+            Serial.print(" jitter: ");
+            Serial.println(L->totalMax - L->totalMin);
+            Gateway.resetLatency(CAN_PORT_1);
         }
-
-        //gateway all registered RX messages from CAN 1 to CAN 0
-        CANport0.TXmsg(this);
     }
-    return(retVal);
 }
@@ -0,0 +1,120 @@
+#include <OBD2.h>
+#include <CAN_SignalFrame.h>
+#include <DueTimer.h>
+/********************************************************************
+This example is built upon the "CANAcquisition" class cAcquireCAN
+which is a simple scheduler for periodic TX/RX of CAN messages.
+
+This example decodes the signals of a received frame from descriptors that are
+only known at runtime (e.g. read from an SD card), using cCANSignalFrame:
+	- a battery status frame 0x3A0 with 4 Motorola (big endian) signals is received
+	- all signals are decoded in the scheduler's RX handler, loop() only prints them
+	- the same signals are packed into a frame sent at 10Hz (0x3A1), packing is done when it is sent
+	- the time to decode and to encode one frame is measured and printed
+/********************************************************************/
+
+#define NUM_DECODES 10000
+
+//create the CANport acqisition schedulers
+cAcquireCAN CANport0(CAN_PORT_0);
+
+//the battery status frame, decoded on reception, and its echo, packed on transmission
+cCANSignalFrame Battery;
+cCANSignalFrame BatteryEcho;
+
+//start bit, length, byte order, signed, scale, offset
+sCANSignal batterySignals[] =
+{
+	{ 7, 16, SIG_MOTOROLA, false, 0.01, 0},		//pack voltage V
+	{23, 16, SIG_MOTOROLA, true , 0.1 , 0},		//pack current A
+	{39, 10, SIG_MOTOROLA, false, 0.1 , 0},		//state of charge %
+	{45,  7, SIG_MOTOROLA, true , 1   , 0},		//max cell temperature degC
+};
+
+const char *names[] = {"Voltage ", "Current ", "SOC     ", "Temp    "};
+
+void setup()
+{
+	//start serial port
+	Serial.begin(115200);
+
+	//debugging message for monitor to indicate CPU resets are occuring
+	Serial.println("System Reset");
+
+	//set the signals, values are reported with 2 decimal places
+	Battery.ID = 0x3A0;
+	if (!Battery.setSignals(batterySignals, 4, 2))
+	{
+		Serial.println("Bad signal configuration");
+	}
+	CANport0.addMessage(&Battery, RECEIVE);
+
+	BatteryEcho.ID   = 0x3A1;
+	BatteryEcho.rate = _10Hz_Rate;
+	BatteryEcho.setSignals(batterySignals, 4, 2);
+	CANport0.addMessage(&BatteryEcho, TRANSMIT);
+
+	//start CAN ports, set the baud rate here
+	CANport0.initialize(_500K);
+
+	//set up the transmission/reception of messages to occur at 500Hz (2mS) timer interrupt
+	Timer3.attachInterrupt(CAN_RxTx).setFrequency(500).start();
+}
+
+void loop()
+{
+	SINT32 values[CAN_SIG_MAX_SIGNALS];
+	int32_t raw[CAN_SIG_MAX_SIGNALS], eu[CAN_SIG_MAX_SIGNALS];
+	UINT8 payload[8] = {0x9C, 0x40, 0xFF, 0x38, 0xC8, 0x64, 0x00, 0x00};
+	UINT32 i, start;
+	UINT8 n;
+
+	//all values of the latest frame
+	Battery.getValues(values);
+	for (n = 0; n < 4; n++)
+	{
+		Serial.print(names[n]);
+		Serial.print(values[n] / 100);
+		Serial.print(".");
+		Serial.println(abs(values[n]) % 100);
+	}
+	Serial.print("Frames received: ");
+	Serial.println(Battery.getRxCtr());
+
+	//echo the raw values, all 4 go out in the same frame
+	for (n = 0; n < 4; n++)
+	{
+		values[n] = Battery.getRaw(n);
+	}
+	BatteryEcho.setRaws(values);
+
+	//cost of decoding a frame (this runs in the RX handler for every frame)
+	start = micros();
+	for (i = 0; i < NUM_DECODES; i++)
+	{
+		payload[7] = i;
+		Battery.codec.decode(payload, raw, eu);
+	}
+	Serial.print("Decode ns per frame: ");
+	Serial.println(((micros() - start) * 1000) / NUM_DECODES);
+
+	//cost of packing a frame (this runs in the TX handler every time the frame is sent)
+	start = micros();
+	for (i = 0; i < NUM_DECODES; i++)
+	{
+		raw[0] = i;
+		BatteryEcho.codec.encode(raw, payload);
+	}
+	Serial.print("Encode ns per frame: ");
+	Serial.println(((micros() - start) * 1000) / NUM_DECODES);
+
+	Serial.println();
+	delay(1000);
+}
+
+//this is our timer interrupt handler, called at XmS interval
+void CAN_RxTx()
+{
+	//run CAN acquisition schedulers on both ports
+	CANport0.run(TIMER_2mS);
+}
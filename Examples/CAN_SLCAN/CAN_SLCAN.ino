@@ -0,0 +1,97 @@
+#include <CAN_SLCAN.h>
+/**************************************************************************************************************************************************************************
+This example is built upon the "CANAcquisition" class cAcquireCAN and the SLCAN (Lawicel) adapter cSLCAN.
+
+CAN0 is a USB-CAN adapter on the native USB port for PC tools that speak SLCAN, e.g. on Linux:
+	slcand -o -s6 -t hw /dev/ttyACM0 can0 && ip link set up can0 && candump can0
+To measure the sustained frames/s in both directions wire CAN0 to CAN1 (as for the board test): CAN1 answers every frame it receives with ID + 1,
+so every frame the PC sends comes back. extras/slcan/slcan_load.py sends frames as fast as the adapter takes them and counts both directions,
+the programming port prints the adapter's counters once a second.
+/*************************************************************************************************************************************************************************/
+
+//create the CANport acqisition schedulers
+cAcquireCAN CANport0(CAN_PORT_0);
+cAcquireCAN CANport1(CAN_PORT_1);
+
+//the adapter registers its receive frame with the CAN0 scheduler and opens the port on the O command
+cSLCAN Adapter(&CANport0, &SerialUSB);
+
+/**
+ * catch-all receive frame on CAN1 that sends every frame back with ID + 1
+ */
+class cEchoFrame : public cCANFrame
+{
+public:
+	UINT32 echoed;
+
+private:
+	bool CallbackRx(RX_CAN_FRAME *R)
+	{
+		TX_CAN_FRAME F;
+
+		F.id          = R->extended ? ((R->id + 1) & 0x1FFFFFFF) : ((R->id + 1) & 0x7FF);
+		F.extended    = R->extended;
+		F.rtr         = R->rtr;
+		F.length      = R->length;
+		F.priority    = 15;
+		F.data.value  = R->data.value;
+		echoed       += CANport1.sendFrame(F) ? 1 : 0;
+		return(false);
+	}
+};
+
+cEchoFrame Echo;
+
+void setup()
+{
+	//start serial port at 115.2kbps for the report, SLCAN runs on the native USB port
+	Serial.begin(115200);
+	SerialUSB.begin(0);
+
+	//debugging message for monitor to indicate CPU resets are occuring
+	Serial.println("System Reset");
+
+	//every ID on CAN1
+	Echo.ID   = 0;
+	Echo.mask = 0;
+	CANport1.addMessage(&Echo, RECEIVE);
+	CANport1.initialize(_500K);
+}
+
+UINT32 lastPrint;
+UINT32 lastRx, lastTx, lastEcho;
+
+void loop()
+{
+	UINT32 rx, tx;
+
+	//SLCAN commands, frames received on CAN0 and the output to the PC
+	Adapter.service();
+
+	//the echo
+	CANport1.run(POLLING_noTx);
+
+	if ((millis() - lastPrint) >= 1000)
+	{
+		lastPrint = millis();
+		rx = Adapter.getRxFrames();
+		tx = Adapter.getTxFrames();
+
+		Serial.print("SLCAN frames/s to PC: ");
+		Serial.print(rx - lastRx);
+		Serial.print(" from PC: ");
+		Serial.print(tx - lastTx);
+		Serial.print(" echoed: ");
+		Serial.print(Echo.echoed - lastEcho);
+		Serial.print(" dropped to PC: ");
+		Serial.print(Adapter.getRxDropped());
+		Serial.print(" from PC: ");
+		Serial.print(Adapter.getTxDropped());
+		Serial.print(" CAN0 RX buffer full: ");
+		Serial.println(CAN.get_rx_buffer_full_cnt());
+
+		lastRx   = rx;
+		lastTx   = tx;
+		lastEcho = Echo.echoed;
+	}
+}
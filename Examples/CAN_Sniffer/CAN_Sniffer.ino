@@ -0,0 +1,75 @@
+#include <CAN_Sniffer.h>
+/**************************************************************************************************************************************************************************
+This example is built upon the bus sniffer cCANSniffer and the trace ring cTraceRing (CAN_Trace.h).
+
+Both ports listen to every frame on the bus (no acknowledge, nothing is sent), the frames are timestamped and logged in the CAN receive interrupt and
+streamed to the PC over the native USB port in 512 byte packets (compact binary format, see extras/benchmarks/trace_bench.cpp for a decoder).
+At 1Mbit and 100% load a port sees ~8000 frames/s, ~13 bytes each: ~105kB/s per port, the 32kB ring holds ~300mS of a fully loaded bus
+while the PC is not reading.
+
+Once a second the programming port prints the frames/s per port and the loss counters, all of them stay 0 when nothing is lost.
+/*************************************************************************************************************************************************************************/
+
+//trace ring, the size has to be a power of 2
+UINT8 sniffBuffer[32768];
+cTraceRing Trace;
+
+cCANSniffer Sniffer(&Trace);
+
+void setup()
+{
+	//start serial port at 115.2kbps for the report, the frames go to the native USB port
+	Serial.begin(115200);
+	SerialUSB.begin(0);
+
+	//debugging message for monitor to indicate CPU resets are occuring
+	Serial.println("System Reset");
+
+	//listen on both ports, set the baud rates here
+	Trace.begin(sniffBuffer, sizeof(sniffBuffer));
+	if (!Sniffer.begin(_1000K, _1000K))
+	{
+		Serial.println("CAN init failed");
+	}
+}
+
+UINT32 lastPrint;
+UINT32 lastFrames[2];
+UINT32 lastBytes;
+
+void loop()
+{
+	UINT32 frames0, frames1, bytes;
+
+	//full USB packets as soon as there are 512 bytes, the rest after 10mS
+	Sniffer.stream(SerialUSB);
+
+	if ((millis() - lastPrint) >= 1000)
+	{
+		lastPrint = millis();
+		frames0 = Sniffer.getFrames(CAN_PORT_0);
+		frames1 = Sniffer.getFrames(CAN_PORT_1);
+		bytes   = Sniffer.getBytesOut();
+
+		Serial.print("frames/s CAN0: ");
+		Serial.print(frames0 - lastFrames[0]);
+		Serial.print(" CAN1: ");
+		Serial.print(frames1 - lastFrames[1]);
+		Serial.print(" USB bytes/s: ");
+		Serial.println(bytes - lastBytes);
+
+		//mailbox overruns (interrupt held off too long) and ring drops (PC not reading fast enough)
+		Serial.print("overruns CAN0: ");
+		Serial.print(Sniffer.getOverruns(CAN_PORT_0));
+		Serial.print(" CAN1: ");
+		Serial.print(Sniffer.getOverruns(CAN_PORT_1));
+		Serial.print(" ring dropped: ");
+		Serial.print(Sniffer.getDropped());
+		Serial.print(" ring high water: ");
+		Serial.println(Trace.getHighWater());
+
+		lastFrames[0] = frames0;
+		lastFrames[1] = frames1;
+		lastBytes     = bytes;
+	}
+}
@@ -0,0 +1,107 @@
+#include <OBD2.h>
+#include <CAN_Trace.h>
+#include <DueTimer.h>
+/********************************************************************
+This example is built upon the "CANAcquisition" class cAcquireCAN
+which is a simple scheduler for periodic TX/RX of CAN messages.
+
+This example logs every frame sent and received on CAN0 into a trace ring
+(compact binary format, see CAN_Trace.h) and streams it to the PC:
+	- the scheduler logs the frames in the timer interrupt, loop() drains the ring to the native USB port
+	- the OBD2 request 0x7DF is sent at 10Hz, the responses 0x7E8 are received
+	- the time to log one frame is measured and, with the bytes written and frames dropped, printed on Serial
+	- extras/benchmarks/trace_bench.cpp shows how the stream is decoded (cTraceDecoder)
+/********************************************************************/
+
+#define NUM_LOGS 1000
+
+//create the CANport acqisition schedulers
+cAcquireCAN CANport0(CAN_PORT_0);
+
+//trace ring, the size has to be a power of 2 (~11 bytes per frame: 16kB hold ~1400 frames)
+UINT8 traceBuffer[16384];
+cTraceRing Trace;
+
+//a second ring only used to measure the cost of logging
+UINT8 scratchBuffer[16384];
+cTraceRing Scratch;
+
+cCANFrame Request;
+cCANFrame Response;
+
+void setup()
+{
+	//start serial port at 115.2kbps for the report, the trace goes to the native USB port
+	Serial.begin(115200);
+	SerialUSB.begin(0);
+
+	//debugging message for monitor to indicate CPU resets are occuring
+	Serial.println("System Reset");
+
+	//engine speed request, mode 1 PID 0x0C
+	Request.ID   = 0x7DF;
+	Request.rate = _10Hz_Rate;
+	Request.U.b[0] = 0x02;
+	Request.U.b[1] = 0x01;
+	Request.U.b[2] = 0x0C;
+	Response.ID  = 0x7E8;
+
+	CANport0.addMessage(&Request,  TRANSMIT);
+	CANport0.addMessage(&Response, RECEIVE);
+
+	//start CAN ports, set the baud rate here
+	CANport0.initialize(_500K);
+
+	//log everything sent and received on CAN0
+	Trace.begin(traceBuffer, sizeof(traceBuffer));
+	CANport0.setTrace(&Trace);
+
+	//set up the transmission/reception of messages to occur at 500Hz (2mS) timer interrupt
+	Timer3.attachInterrupt(CAN_RxTx).setFrequency(500).start();
+}
+
+UINT32 lastPrint;
+UINT32 bytesOut;
+
+void loop()
+{
+	UINT8 payload[8] = {0x04, 0x41, 0x0C, 0x1A, 0xF8, 0x55, 0x55, 0x55};
+	UINT32 i, start;
+
+	//stream the trace in USB packet sized pieces, the scheduler keeps logging meanwhile
+	bytesOut += Trace.drain(SerialUSB, 512);
+
+	if ((millis() - lastPrint) >= 1000)
+	{
+		lastPrint = millis();
+
+		//cost of logging a frame (this runs in the RX/TX handler for every frame)
+		Scratch.begin(scratchBuffer, sizeof(scratchBuffer));
+		start = micros();
+		for (i = 0; i < NUM_LOGS; i++)
+		{
+			payload[4] = i;
+			Scratch.log(start + i * 250, 0x7E8, false, false, false, 8, payload);
+		}
+		Serial.print("Log ns per frame: ");
+		Serial.println(((micros() - start) * 1000) / NUM_LOGS);
+		Serial.print("Bytes per frame: ");
+		Serial.println(Scratch.available() / NUM_LOGS);
+
+		Serial.print("Frames logged: ");
+		Serial.print(Trace.getFrames());
+		Serial.print(" dropped: ");
+		Serial.print(Trace.getDropped());
+		Serial.print(" bytes out: ");
+		Serial.print(bytesOut);
+		Serial.print(" ring high water: ");
+		Serial.println(Trace.getHighWater());
+	}
+}
+
+//this is our timer interrupt handler, called at XmS interval
+void CAN_RxTx()
+{
+	//run CAN acquisition schedulers, the frames are logged here
+	CANport0.run(TIMER_2mS);
+}
@@ -0,0 +1,154 @@
+#include <OBD2.h>
+#include <CAN_Trigger.h>
+#include <DueTimer.h>
+/********************************************************************
+This example is built upon the "CANAcquisition" class cAcquireCAN
+which is a simple scheduler for periodic TX/RX of CAN messages.
+
+This example captures the bus around an intermittent event (see CAN_Trigger.h):
+	- the OBD2 coolant temperature request (mode 1 PID 0x05) is sent on CAN0 at 10Hz
+	- every frame received on CAN0 is checked against the trigger condition in the timer interrupt:
+	  0x7E8 with the pattern 41 05 and the coolant temperature (byte 3 - 40 degC) above 105 degC. While the
+	  capture is set CAN0 receives every ID (not only the 0x7E8 registered below), so the capture holds all of
+	  the bus traffic around the event
+	- 400 frames before and 100 frames after the first frame above 105 degC are kept, when the capture is frozen
+	  it is printed on Serial and downloaded to the native USB port in the compact trace format (CAN_Trace.h),
+	  then the capture is armed again
+	- the time to check a frame against 8 conditions (the most) is measured and printed on Serial
+/********************************************************************/
+
+#define NUM_CHECKS 1000
+
+//create the CANport acqisition schedulers
+cAcquireCAN CANport0(CAN_PORT_0);
+
+//capture storage, pre + 1 + post frames have to fit (20 bytes per frame)
+sCaptureFrame captureBuffer[512];
+cTriggerCapture Capture;
+
+//a second capture only used to measure the cost of the trigger check
+sCaptureFrame scratchBuffer[512];
+cTriggerCapture Scratch;
+
+cCANFrame Request;
+cCANFrame Response;
+
+void setup()
+{
+	UINT8 pid05[8]   = {0x00, 0x41, 0x05};
+	UINT8 pidMask[8] = {0x00, 0xFF, 0xFF};
+	UINT8 none[8]    = {0};
+	sCANSignal coolant = {24, 8, SIG_INTEL, false, 1, -40};
+	UINT8 i, c;
+
+	//start serial port at 115.2kbps for the report, the capture goes to the native USB port
+	Serial.begin(115200);
+	SerialUSB.begin(0);
+
+	//debugging message for monitor to indicate CPU resets are occuring
+	Serial.println("System Reset");
+
+	//coolant temperature request, mode 1 PID 0x05
+	Request.ID   = 0x7DF;
+	Request.rate = _10Hz_Rate;
+	Request.U.b[0] = 0x02;
+	Request.U.b[1] = 0x01;
+	Request.U.b[2] = 0x05;
+	Response.ID  = 0x7E8;
+
+	CANport0.addMessage(&Request,  TRANSMIT);
+	CANport0.addMessage(&Response, RECEIVE);
+
+	//start CAN ports, set the baud rate here
+	CANport0.initialize(_500K);
+
+	//coolant temperature above 105 degC, setTrigger() opens the mailboxes for the other ID's
+	Capture.begin(captureBuffer, 512);
+	c = Capture.addCondition(0x7E8, 0x7FF, false);
+	Capture.setPattern(c, pid05, pidMask);
+	Capture.setSignal(c, coolant, TRIG_ABOVE, 105);
+	Capture.arm(400, 100);
+	CANport0.setTrigger(&Capture);
+
+	//worst case for the measurement: 8 conditions every frame gets through up to the signal compare
+	Scratch.begin(scratchBuffer, 512);
+	for (i = 0; i < TRIG_MAX_CONDITIONS; i++)
+	{
+		c = Scratch.addCondition(0, 0, false);
+		Scratch.setPattern(c, none, none);
+		Scratch.setSignal(c, coolant, TRIG_ABOVE, 1000);
+	}
+	Scratch.arm(400, 100);
+
+	//set up the transmission/reception of messages to occur at 500Hz (2mS) timer interrupt
+	Timer3.attachInterrupt(CAN_RxTx).setFrequency(500).start();
+}
+
+UINT32 lastPrint;
+
+void loop()
+{
+	UINT8 payload[8] = {0x03, 0x41, 0x05, 0x7B, 0x00, 0x00, 0x00, 0x00};
+	const sCaptureFrame *F;
+	UINT32 i, start;
+	UINT8 b;
+
+	if (Capture.getState() == TRIG_FROZEN)
+	{
+		//the trigger frame and the frames around it
+		F = Capture.getFrame(Capture.getTriggerIndex());
+		Serial.print("Triggered by condition ");
+		Serial.print(Capture.getTriggerCondition());
+		Serial.print(" at ");
+		Serial.print(F->time);
+		Serial.print("uS, coolant ");
+		Serial.print((int)F->data[3] - 40);
+		Serial.print(" degC, frames in capture: ");
+		Serial.print(Capture.getCount());
+		Serial.print(" (");
+		Serial.print(Capture.getTriggerIndex());
+		Serial.println(" before the trigger)");
+
+		for (i = 0; i < Capture.getCount(); i++)
+		{
+			F = Capture.getFrame(i);
+			Serial.print(F->time);
+			Serial.print(" ");
+			Serial.print(F->id, HEX);
+			for (b = 0; b < F->dlc; b++)
+			{
+				Serial.print(" ");
+				Serial.print(F->data[b], HEX);
+			}
+			Serial.println(i == Capture.getTriggerIndex() ? " <- trigger" : "");
+		}
+
+		//to the PC in the compact trace format, then wait for the next event
+		Capture.download(SerialUSB);
+		Capture.arm(400, 100);
+	}
+
+	if ((millis() - lastPrint) >= 1000)
+	{
+		lastPrint = millis();
+
+		//cost of the trigger check (this runs in the RX handler for every frame)
+		start = micros();
+		for (i = 0; i < NUM_CHECKS; i++)
+		{
+			payload[4] = i;
+			Scratch.frame(start + i * 250, 0x7E8, false, false, 8, payload);
+		}
+		Serial.print("Trigger check ns per frame, 8 conditions: ");
+		Serial.println(((micros() - start) * 1000) / NUM_CHECKS);
+		Serial.print("Frames stored: ");
+		Serial.println(Capture.getFrames());
+	}
+}
+
+//this is our timer interrupt handler, called at XmS interval
+void CAN_RxTx()
+{
+	//run CAN acquisition schedulers, the received frames are checked here
+	CANport0.run(TIMER_2mS);
+}
@@ -0,0 +1,106 @@
+#include <OBD2.h>
+#include <CAN_FixedPoint.h>
+/********************************************************************
+This example is a micro-benchmark of the engineering unit conversion on the DUE.
+
+It compares the floating point path (m*x+b, done in software on the Cortex-M3 which has no FPU) 
+with the fixed point path (cFixedScale, slope and offset pre-converted when the object is created)
+for both a raw CAN signal and an OBD2 parameter. Results are printed in nano seconds per conversion.
+/********************************************************************/
+
+#define NUM_CONVERSIONS 10000
+
+//create the CANport acqisition schedulers
+cAcquireCAN CANport0(CAN_PORT_0);
+
+//OBD parameters, one user defined (m*x+b) and one from the PID catalogue
+cOBDParameter OBD_Throttle(   "Throttle "     , " %"  		,  THROTTLE_POS, _8BITS,   false,   CURRENT,  0.3922, 0,  &CANport0, false);
+cOBDParameter OBD_EngineSpeed(ENGINE_RPM, CURRENT, &CANport0, false);
+
+//raw J1939 style engine speed signal 0.125 rpm/bit, 2 decimal places
+cFixedScale engSpeedScale(0.125, 0, 2);
+float engSpeedSlope  = 0.125;
+float engSpeedOffset = 0;
+
+volatile UINT16  rawSignal;
+volatile float   floatResult;
+volatile SINT32  fixedResult;
+
+void setup()
+{
+	//start serial port 
+	Serial.begin(115200);
+
+	//debugging message for monitor to indicate CPU resets are occuring
+	Serial.println("System Reset");
+}
+
+void loop()
+{
+	UINT32 i, start, floatTime, fixedTime;
+
+	//********** raw CAN signal ****************
+	start = micros();
+	for (i=0; i < NUM_CONVERSIONS; i++)
+	{
+		rawSignal   = i;
+		floatResult = (rawSignal * engSpeedSlope) + engSpeedOffset;
+	}
+	floatTime = micros() - start;
+
+	start = micros();
+	for (i=0; i < NUM_CONVERSIONS; i++)
+	{
+		rawSignal   = i;
+		fixedResult = engSpeedScale.convert(rawSignal);
+	}
+	fixedTime = micros() - start;
+
+	printResult("Raw signal    ", floatTime, fixedTime);
+
+	//********** OBD2 parameters ****************
+	start = micros();
+	for (i=0; i < NUM_CONVERSIONS; i++)
+	{
+		floatResult = OBD_Throttle.getData();
+	}
+	floatTime = micros() - start;
+
+	start = micros();
+	for (i=0; i < NUM_CONVERSIONS; i++)
+	{
+		fixedResult = OBD_Throttle.getDataFixed();
+	}
+	fixedTime = micros() - start;
+
+	printResult("OBD user m*x+b", floatTime, fixedTime);
+
+	start = micros();
+	for (i=0; i < NUM_CONVERSIONS; i++)
+	{
+		floatResult = OBD_EngineSpeed.getData();
+	}
+	floatTime = micros() - start;
+
+	start = micros();
+	for (i=0; i < NUM_CONVERSIONS; i++)
+	{
+		fixedResult = OBD_EngineSpeed.getDataFixed();
+	}
+	fixedTime = micros() - start;
+
+	printResult("OBD catalogue ", floatTime, fixedTime);
+
+	Serial.println();
+	delay(2000);
+}
+
+//print the time per conversion in nano seconds for both paths
+void printResult(char *name, UINT32 floatTime, UINT32 fixedTime)
+{
+	Serial.print(name); 
+	Serial.print(" float ns: ");
+	Serial.print((floatTime * 1000) / NUM_CONVERSIONS);
+	Serial.print(" fixed ns: ");
+	Serial.println((fixedTime * 1000) / NUM_CONVERSIONS);
+}
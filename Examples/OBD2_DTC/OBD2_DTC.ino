@@ -0,0 +1,101 @@
+#include <OBD2.h>
+#include <OBD2_DTC.h>
+#include <DueTimer.h>
+/********************************************************************
+This example is built upon the CANAcquisition class, the OBDParmameter class and the DTC reader using 11bit (non-extended) OBD2 ID's
+
+Engine speed and vehicle speed are polled continuously while the stored, pending and permanent trouble codes 
+are read in the background every 10 seconds. The trouble code request only takes one slot in the query schedule,
+multi-frame responses from all ECU's are collected by the scheduler.
+/********************************************************************/
+
+//create the CANport acqisition schedulers
+cAcquireCAN CANport0(CAN_PORT_0);
+
+//PID's from the built-in catalogue
+cOBDParameter OBD_Speed(SPEED, CURRENT, &CANport0, false);
+cOBDParameter OBD_EngineSpeed(ENGINE_RPM, CURRENT, &CANport0, false);
+
+//trouble code reader
+cOBDDTCReader DTCs(&CANport0, false);
+
+const OBD_DTC_TYPE types[3] = {DTC_STORED, DTC_PENDING, DTC_PERMANENT};
+const char *typeNames[3] = {"Stored", "Pending", "Permanent"};
+UINT8 typeIdx = 0;
+UINT32 lastRead = 0;
+bool reading = false;
+
+void setup()
+{
+  delay(2000); //allow USB time to settle
+
+	//start serial port 
+	Serial.begin(115200);
+
+	//debugging message for monitor to indicate CPU resets are occuring
+	Serial.println("System Reset");
+       
+  //start CAN ports,  enable interrupts and RX masks, set the baud rate here
+	CANport0.initialize(_500K);
+
+  //run the acquisition scheduler from a 2mS timer interrupt
+  Timer3.attachInterrupt(CANTask).setFrequency(500).start();
+}
+
+void CANTask()
+{
+  CANport0.run(TIMER_2mS);
+}
+
+void loop()
+{
+  char code[6];
+  UINT8 i;
+
+  //start the next readout every 10 seconds
+  if (!reading && ((millis() - lastRead) > 10000))
+  {
+    reading  = DTCs.request(types[typeIdx]);
+    lastRead = millis();
+  }
+
+  //print the codes once all ECU's have answered
+  switch (reading ? DTCs.getState() : DTC_IDLE)
+  {
+  case DTC_DONE:
+    Serial.print(typeNames[typeIdx]);
+    Serial.print(" DTC's from ");
+    Serial.print(DTCs.getNumECUs());
+    Serial.println(" ECU's:");
+
+    for (i=0; i < DTCs.getNumDTCs(); i++)
+    {
+      cOBDDTCReader::format(DTCs.getDTC(i)->code, code);
+      Serial.print(code);
+      Serial.print("  ECU 0x");
+      Serial.println(DTCs.getECUID(DTCs.getDTC(i)->ecu), HEX);
+    }
+    typeIdx = (typeIdx + 1) % 3;
+    reading = false;
+    break;
+
+  case DTC_NO_RESPONSE:
+    Serial.print(typeNames[typeIdx]);
+    Serial.println(" DTC's: no response");
+    typeIdx = (typeIdx + 1) % 3;
+    reading = false;
+    break;
+
+  default:
+    break;
+  }
+
+  Serial.print(OBD_Speed.getName()); 
+  Serial.print(OBD_Speed.getData());
+  Serial.print(OBD_Speed.getUnits()); 	
+  Serial.print("  ");
+  Serial.print(OBD_EngineSpeed.getName()); 
+  Serial.print(OBD_EngineSpeed.getData());
+  Serial.println(OBD_EngineSpeed.getUnits()); 
+  delay(100);
+}
@@ -0,0 +1,322 @@
+/*
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#include "ISOTP.h"
+
+/**
+ * constructor, nothing in progress
+ */
+cISOTPRx::cISOTPRx()
+{
+	reset();
+}
+
+/**
+ * Abandon any message in progress
+ */
+void cISOTPRx::reset()
+{
+	length   = 0;
+	received = 0;
+	nextSN   = 0;
+	busy     = false;
+}
+
+/**
+ * Hand a received frame to the reassembly
+ *
+ *  single frame:       | 0x0L | data (L bytes, 1-7) ...                        |
+ *  first frame:        | 0x1L | LL | data (6 bytes) ...                        |  (12 bit length)
+ *  consecutive frame:  | 0x2N | data (7 bytes) ...                             |  (N = sequence number 1..15, 0..)
+ *
+ * @param frame - the 8 data bytes of the received CAN frame
+ * @return - result of the frame, see ISOTP_RX_RESULT
+ */
+ISOTP_RX_RESULT cISOTPRx::receive(const UINT8 *frame)
+{
+	UINT16 n;
+
+	switch (frame[0] & 0xF0)
+	{
+	case ISOTP_SINGLE:
+		//a single frame also ends anything in progress from this sender
+		length = frame[0] & 0x0F;
+		if ((length == 0) || (length > 7))
+		{
+			reset();
+			return(ISOTP_RX_IGNORED);
+		}
+		memcpy(buf, &frame[1], length);
+		received = length;
+		busy     = false;
+		return(ISOTP_RX_COMPLETE);
+
+	case ISOTP_FIRST:
+		length = ((UINT16)(frame[0] & 0x0F) << 8) | frame[1];
+		if (length > ISOTP_MAX_PAYLOAD)
+		{
+			reset();
+			return(ISOTP_RX_OVERFLOW);
+		}
+		memcpy(buf, &frame[2], 6);
+		received = 6;
+		nextSN   = 1;
+		busy     = true;
+		return(ISOTP_RX_FIRST);
+
+	case ISOTP_CONSECUTIVE:
+		if (!busy)
+		{
+			return(ISOTP_RX_IGNORED);
+		}
+
+		//lost a frame, the message is no good
+		if ((frame[0] & 0x0F) != nextSN)
+		{
+			reset();
+			return(ISOTP_RX_ERROR);
+		}
+
+		n = length - received;
+		n = (n > 7) ? 7 : n;
+		memcpy(&buf[received], &frame[1], n);
+		received += n;
+		nextSN    = (nextSN + 1) & 0x0F;
+
+		if (received >= length)
+		{
+			busy = false;
+			return(ISOTP_RX_COMPLETE);
+		}
+		return(ISOTP_RX_PARTIAL);
+
+	default:
+		return(ISOTP_RX_IGNORED);
+	}
+}
+
+/**
+ * Check if a multi-frame message is in progress
+ *
+ * @return - true if consecutive frames are expected
+ */
+bool cISOTPRx::isBusy()
+{
+	return(busy);
+}
+
+/**
+ * Retrieve the reassembled message
+ *
+ * @return - pointer to the message bytes
+ */
+const UINT8* cISOTPRx::getData()
+{
+	return(buf);
+}
+
+/**
+ * Retrieve the length of the reassembled message
+ *
+ * @return - number of message bytes
+ */
+UINT16 cISOTPRx::getLength()
+{
+	return(length);
+}
+
+/**
+ * Fill in a flow control frame, padded with 0x55
+ *
+ *  flow control frame: | 0x3F (F = 0 clear to send, 2 overflow) | block size | STmin |
+ *
+ * @param frame     - the 8 data bytes of the frame to be transmitted
+ * @param overflow  - true to tell the sender the message is too big, false to clear it to send
+ * @param blockSize - number of consecutive frames before the next flow control frame (0 = all)
+ * @param stMin     - minimum separation time between consecutive frames (mS)
+ */
+void cISOTPRx::buildFlowControl(UINT8 *frame, bool overflow, UINT8 blockSize, UINT8 stMin)
+{
+	memset(frame, 0x55, 8);
+	frame[0] = ISOTP_FLOW | (overflow ? 2 : 0);
+	frame[1] = blockSize;
+	frame[2] = stMin;
+}
+
+/**
+ * Queue a flow control frame for transmission, without waiting for a mailbox
+ *
+ * @param port      - acquisition scheduler (physical CAN port) to transmit on
+ * @param txID      - CAN ID the sender listens to
+ * @param overflow  - true to tell the sender the message is too big, false to clear it to send
+ * @param blockSize - number of consecutive frames before the next flow control frame (0 = all)
+ * @param stMin     - minimum separation time between consecutive frames (mS)
+ * @return - true if the frame was queued
+ */
+bool cISOTPRx::sendFlowControl(cAcquireCAN *port, UINT32 txID, bool overflow, UINT8 blockSize, UINT8 stMin)
+{
+	TX_CAN_FRAME F;
+
+	F.id       = txID;
+	F.extended = (txID > 0x7FF);
+	F.rtr      = false;
+	F.length   = 8;
+	F.priority = 15;
+	F.fid      = 0;
+	buildFlowControl(F.data.bytes, overflow, blockSize, stMin);
+
+	return(port->sendFrame(F));
+}
+
+/**
+ * constructor, nothing in progress
+ */
+cISOTPCollector::cISOTPCollector()
+{
+	reset();
+}
+
+/**
+ * Abandon all messages in progress and clear the lost message counter
+ */
+void cISOTPCollector::reset()
+{
+	UINT8 i;
+
+	for (i=0; i < ISOTP_RX_SLOTS; i++)
+	{
+		slotID[i] = 0;
+		slot[i].reset();
+	}
+	lostCtr = 0;
+}
+
+/**
+ * Hand a received frame to the reassembly of its sender. Single frames are returned directly from the received frame,
+ * first frames take a free slot and consecutive frames are only accepted from a sender that has a slot.
+ *
+ * @param R   - pointer to the received CAN frame
+ * @param sid - first message byte a message must start with, 0 to accept any message
+ * @param msg - set to the complete message on ISOTP_RX_COMPLETE
+ * @param len - set to the length of the complete message on ISOTP_RX_COMPLETE
+ * @return - result of the frame
+ */
+ISOTP_RX_RESULT cISOTPCollector::receive(RX_CAN_FRAME *R, UINT8 sid, const UINT8 **msg, UINT16 *len)
+{
+	UINT8 pci = R->data.byte[0] & 0xF0;
+	UINT8 i, s = ISOTP_RX_SLOTS;
+	ISOTP_RX_RESULT result;
+
+	//find the slot this sender is using
+	for (i=0; i < ISOTP_RX_SLOTS; i++)
+	{
+		if (slotID[i] == R->id)
+		{
+			s = i;
+		}
+	}
+
+	if (pci == ISOTP_SINGLE)
+	{
+		*len = R->data.byte[0] & 0x0F;
+		if ((*len == 0) || (*len > 7) || (sid && (R->data.byte[1] != sid)))
+		{
+			return(ISOTP_RX_IGNORED);
+		}
+
+		//a single frame ends anything in progress from this sender
+		if (s < ISOTP_RX_SLOTS)
+		{
+			slotID[s] = 0;
+		}
+
+		*msg = &R->data.byte[1];
+		return(ISOTP_RX_COMPLETE);
+	}
+
+	if (pci == ISOTP_FIRST)
+	{
+		if (sid && (R->data.byte[2] != sid))
+		{
+			return(ISOTP_RX_IGNORED);
+		}
+
+		//start a new reassembly for this sender
+		for (i=0; (s == ISOTP_RX_SLOTS) && (i < ISOTP_RX_SLOTS); i++)
+		{
+			if (!slotID[i])
+			{
+				s = i;
+			}
+		}
+
+		//too many senders at once
+		if (s == ISOTP_RX_SLOTS)
+		{
+			lostCtr += 1;
+			return(ISOTP_RX_ERROR);
+		}
+
+		slotID[s] = R->id;
+
+	} else if ((pci != ISOTP_CONSECUTIVE) || (s == ISOTP_RX_SLOTS))
+	{
+		return(ISOTP_RX_IGNORED);
+	}
+
+	result = slot[s].receive(R->data.byte);
+
+	switch (result)
+	{
+	case ISOTP_RX_COMPLETE:
+		*msg = slot[s].getData();
+		*len = slot[s].getLength();
+		slotID[s] = 0;
+		break;
+
+	case ISOTP_RX_OVERFLOW:
+	case ISOTP_RX_ERROR:
+		lostCtr  += 1;
+		slotID[s] = 0;
+		break;
+
+	default:
+		break;
+	}
+
+	return(result);
+}
+
+/**
+ * Send a flow control frame to a sender, queued without waiting for a mailbox
+ *
+ * @param port     - acquisition scheduler (physical CAN port) to transmit on
+ * @param txID     - CAN ID the sender listens to
+ * @param overflow - true if the message is too big
+ */
+void cISOTPCollector::sendFlowControl(cAcquireCAN *port, UINT32 txID, bool overflow)
+{
+	cISOTPRx::sendFlowControl(port, txID, overflow, 0, ISOTP_STMIN);
+}
+
+/**
+ * Retrieve the number of messages lost
+ *
+ * @return - number of messages lost
+ */
+UINT8 cISOTPCollector::getLostCtr()
+{
+	return(lostCtr);
+}
@@ -0,0 +1,202 @@
+/*
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#include "variant.h"
+#include <due_can.h>
+#include <CAN_Acquisition.h>
+
+#ifndef ISOTP_H
+#define ISOTP_H
+
+/**
+ *
+ * This macro is used to set the largest ISO 15765-2 (ISO-TP) message that can be reassembled
+ */
+#define	ISOTP_MAX_PAYLOAD	128
+
+/**
+ *
+ * This macro is used to set the separation time (STmin, mS) requested in our flow control frames
+ */
+#define	ISOTP_STMIN			0
+
+/**
+ *
+ * This macro is used to set the number of senders a collector can reassemble multi-frame messages from at the same time
+ */
+#define	ISOTP_RX_SLOTS		4
+
+/**
+ *
+ * This enum represents the ISO-TP protocol control information (upper nibble of the first byte of a frame)
+ */
+enum ISOTP_PCI
+{
+	ISOTP_SINGLE      = 0x00,
+	ISOTP_FIRST       = 0x10,
+	ISOTP_CONSECUTIVE = 0x20,
+	ISOTP_FLOW        = 0x30
+};
+
+/**
+ *
+ * This enum represents the result of handing a received frame to the reassembly
+ */
+enum ISOTP_RX_RESULT
+{
+	ISOTP_RX_IGNORED  = 0,	//not part of a message (unexpected consecutive frame, flow control...)
+	ISOTP_RX_FIRST    = 1,	//first frame of a multi-frame message, the sender is waiting for a flow control frame
+	ISOTP_RX_PARTIAL  = 2,	//consecutive frame, more to come
+	ISOTP_RX_COMPLETE = 3,	//a complete message is ready (getData/getLength)
+	ISOTP_RX_OVERFLOW = 4,	//first frame of a message that is too big, answer with a flow control overflow
+	ISOTP_RX_ERROR    = 5	//sequence number error, the message has been abandoned
+};
+
+/**
+ * ISO 15765-2 (ISO-TP) receive reassembly for one sender. Single, first and consecutive frames are collected into
+ * a fixed buffer (no dynamic memory), the owner is responsible for sending the flow control frame when a first
+ * frame is received (see buildFlowControl).
+ *
+ * @author D.Kasamis - dan@togglebit.net
+ * @version 1.0
+ */
+class cISOTPRx
+{
+public:
+	cISOTPRx();
+
+	/**
+	 * Abandon any message in progress
+	 */
+	void reset();
+
+	/**
+	 * Hand a received frame to the reassembly
+	 *
+	 * @param frame - the 8 data bytes of the received CAN frame
+	 * @return - result of the frame, see ISOTP_RX_RESULT
+	 */
+	ISOTP_RX_RESULT receive(const UINT8 *frame);
+
+	/**
+	 * Check if a multi-frame message is in progress
+	 *
+	 * @return - true if consecutive frames are expected
+	 */
+	bool isBusy();
+
+	/**
+	 * Retrieve the reassembled message (valid after ISOTP_RX_COMPLETE)
+	 *
+	 * @return - pointer to the message bytes
+	 */
+	const UINT8* getData();
+
+	/**
+	 * Retrieve the length of the reassembled message (valid after ISOTP_RX_COMPLETE)
+	 *
+	 * @return - number of message bytes
+	 */
+	UINT16 getLength();
+
+	/**
+	 * Fill in a flow control frame, padded with 0x55
+	 *
+	 * @param frame     - the 8 data bytes of the frame to be transmitted
+	 * @param overflow  - true to tell the sender the message is too big, false to clear it to send
+	 * @param blockSize - number of consecutive frames before the next flow control frame (0 = all)
+	 * @param stMin     - minimum separation time between consecutive frames (mS)
+	 */
+	static void buildFlowControl(UINT8 *frame, bool overflow, UINT8 blockSize, UINT8 stMin);
+
+	/**
+	 * Queue a flow control frame for transmission, without waiting for a mailbox: this is called from the receive path
+	 * (RXmsg() with interrupts off). If the TX queue is full the frame is not sent and the sender times out
+	 *
+	 * @param port      - acquisition scheduler (physical CAN port) to transmit on
+	 * @param txID      - CAN ID the sender listens to
+	 * @param overflow  - true to tell the sender the message is too big, false to clear it to send
+	 * @param blockSize - number of consecutive frames before the next flow control frame (0 = all)
+	 * @param stMin     - minimum separation time between consecutive frames (mS)
+	 * @return - true if the frame was queued
+	 */
+	static bool sendFlowControl(cAcquireCAN *port, UINT32 txID, bool overflow, UINT8 blockSize, UINT8 stMin);
+
+private:
+	/**
+	 * message buffer, total length of the message in progress and number of bytes received so far
+	 */
+	UINT8  buf[ISOTP_MAX_PAYLOAD];
+	UINT16 length;
+	UINT16 received;
+
+	/**
+	 * sequence number of the next consecutive frame, a multi-frame message is in progress
+	 */
+	UINT8  nextSN;
+	bool   busy;
+};
+
+/**
+ * ISO-TP reassembly for responses from several senders at once (e.g. all ECU's answering a functional OBD2 request).
+ * Each sender that starts a multi-frame message gets one of ISOTP_RX_SLOTS reassembly buffers, keyed by its CAN ID.
+ *
+ * @author D.Kasamis - dan@togglebit.net
+ * @version 1.0
+ */
+class cISOTPCollector
+{
+public:
+	cISOTPCollector();
+
+	/**
+	 * Abandon all messages in progress and clear the lost message counter
+	 */
+	void reset();
+
+	/**
+	 * Hand a received frame to the reassembly of its sender
+	 *
+	 * @param R   - pointer to the received CAN frame
+	 * @param sid - first message byte (e.g. OBD2 response mode) a message must start with, 0 to accept any message
+	 * @param msg - set to the complete message on ISOTP_RX_COMPLETE, valid until the next call
+	 * @param len - set to the length of the complete message on ISOTP_RX_COMPLETE
+	 * @return - result of the frame, the owner must answer ISOTP_RX_FIRST and ISOTP_RX_OVERFLOW with a flow control frame
+	 */
+	ISOTP_RX_RESULT receive(RX_CAN_FRAME *R, UINT8 sid, const UINT8 **msg, UINT16 *len);
+
+	/**
+	 * Send a flow control frame to a sender, queued without waiting for a mailbox (see cISOTPRx::sendFlowControl)
+	 *
+	 * @param port     - acquisition scheduler (physical CAN port) to transmit on
+	 * @param txID     - CAN ID the sender listens to
+	 * @param overflow - true if the message is too big
+	 */
+	void sendFlowControl(cAcquireCAN *port, UINT32 txID, bool overflow);
+
+	/**
+	 * Retrieve the number of messages lost (out of slots, too big or a missing consecutive frame)
+	 *
+	 * @return - number of messages lost
+	 */
+	UINT8 getLostCtr();
+
+private:
+	UINT32    slotID[ISOTP_RX_SLOTS];
+	cISOTPRx  slot[ISOTP_RX_SLOTS];
+	UINT8     lostCtr;
+};
+
+#endif
@@ -0,0 +1,504 @@
+/*
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#include "J1939.h"
+
+/**
+ * constructor, registers the receive frame and the network management frame with the acquisition scheduler
+ *
+ * @param _portNum - physical CAN port to be used
+ */
+cJ1939::cJ1939(cAcquireCAN *_portNum)
+{
+	portNum       = _portNum;
+	numMsgs       = 0;
+	numPages      = 0;
+	state         = J1939_ADDR_IDLE;
+	address       = J1939_NULL_ADDRESS;
+	claimPending  = false;
+	claimTime     = 0;
+	unhandledCtr  = 0;
+	contentionCtr = 0;
+	memset(pdu1Map, 0, sizeof(pdu1Map));
+	memset(pdu2Page, 0, sizeof(pdu2Page));
+	memset(name, 0, sizeof(name));
+	memset(used, 0, sizeof(used));
+
+	//
+	//********** RX RECEIVE FRAME ****************
+	//
+	//every frame on the port (mask 0), the PGN dispatch does the filtering. J1939 ID's are 29bit, mailbox 0 only takes
+	//11bit ID's for a catch-all so the port gets a mailbox for every 29bit ID
+	//
+	RXFrame.ID     = 0;
+	RXFrame.mask   = 0;
+	RXFrame.parent = this;
+	portNum->addMessage(&RXFrame, RECEIVE);
+	portNum->acceptExtended();
+
+	//
+	//********** TX NETWORK MANAGEMENT FRAME ****************
+	//
+	//	| NAME byte 0 | ... | NAME byte 7 |   PGN 0xEE00 to global, priority 6
+	//
+	CtrlFrame.rate   = TICK_MSG;
+	CtrlFrame.parent = this;
+	portNum->addMessage(&CtrlFrame, TRANSMIT);
+}
+
+/**
+ * Register a message
+ *
+ * @param msg  - message, set the PGN (and rate for transmit messages) first
+ * @param type - RECEIVE to have frames of this PGN routed to it, TRANSMIT to have it sent at its rate
+ * @return - false if the PGN is already registered for reception or the lookup table is full
+ */
+bool cJ1939::addMessage(cJ1939Message *msg, ACQ_FRAME_TYPE type)
+{
+	UINT8 *entry;
+
+	msg->parent = this;
+
+	if (type == TRANSMIT)
+	{
+		portNum->addMessage(msg, TRANSMIT);
+		return(true);
+	}
+
+	//the destination byte is not part of a PDU1 PGN
+	msg->pgn = getPGN(msg->pgn << 8);
+
+	entry = lookup(msg->pgn, true);
+	if (!entry || *entry || (numMsgs >= J1939_MAX_PGNS))
+	{
+		return(false);
+	}
+
+	noInterrupts();
+	msgs[numMsgs] = msg;
+	numMsgs += 1;
+	*entry = numMsgs;
+	interrupts();
+
+	return(true);
+}
+
+/**
+ * Find the receive message of a PGN
+ *
+ * @param pgn - parameter group number
+ * @return - pointer to the message, NULL if the PGN is not registered
+ */
+cJ1939Message* cJ1939::find(UINT32 pgn)
+{
+	UINT8 *entry = lookup(getPGN(pgn << 8), false);
+
+	return((entry && *entry) ? msgs[*entry - 1] : NULL);
+}
+
+/**
+ * Look up the dispatch entry of a PGN
+ *
+ * @param pgn    - parameter group number
+ * @param create - allocate a PDU2 page if the PDU format does not have one yet
+ * @return - pointer to the entry, NULL if the PGN has no entry (or no page is left)
+ */
+UINT8* cJ1939::lookup(UINT32 pgn, bool create)
+{
+	UINT8 dp = (pgn >> 16) & 0x01;
+	UINT8 pf = (pgn >> 8) & 0xFF;
+	UINT8 *page;
+
+	//PDU1, one entry per PDU format
+	if (pf < 0xF0)
+	{
+		return(&pdu1Map[dp][pf]);
+	}
+
+	//PDU2, the PDU specific byte is the group extension
+	page = &pdu2Page[dp][pf - 0xF0];
+	if (!*page)
+	{
+		if (!create || (numPages >= J1939_PDU2_PAGES))
+		{
+			return(NULL);
+		}
+
+		memset(pdu2Map[numPages], 0, 256);
+		numPages += 1;
+		*page = numPages;
+	}
+
+	return(&pdu2Map[*page - 1][pgn & 0xFF]);
+}
+
+/**
+ * Start claiming an address
+ *
+ * @param _name     - 64bit NAME, in transmit order
+ * @param preferred - address to claim
+ */
+void cJ1939::claimAddress(const UINT8 *_name, UINT8 preferred)
+{
+	noInterrupts();
+	memcpy(name, _name, 8);
+	address      = preferred;
+	state        = J1939_ADDR_CLAIMING;
+	claimPending = true;
+	interrupts();
+}
+
+/**
+ * Retrieve the address claim state
+ *
+ * @return - address claim state
+ */
+J1939_ADDR_STATE cJ1939::getState()
+{
+	return(state);
+}
+
+/**
+ * Retrieve our address
+ *
+ * @return - source address, J1939_NULL_ADDRESS if no address has been claimed
+ */
+UINT8 cJ1939::getAddress()
+{
+	return((state == J1939_ADDR_CLAIMED) ? address : J1939_NULL_ADDRESS);
+}
+
+/**
+ * Retrieve the number of frames received with no registered PGN (rolling)
+ *
+ * @return - number of frames
+ */
+UINT32 cJ1939::getUnhandledCtr()
+{
+	return(unhandledCtr);
+}
+
+/**
+ * Retrieve the number of contending claims for our address (rolling)
+ *
+ * @return - number of contending claims
+ */
+UINT32 cJ1939::getContentionCtr()
+{
+	return(contentionCtr);
+}
+
+/**
+ * Split a 29bit CAN ID
+ *
+ *  | priority (3) | EDP | DP | PDU format (8) | PDU specific (8) | source address (8) |
+ *
+ * @param id - CAN ID
+ * @return - parameter group number (destination byte 0 for PDU1)
+ */
+UINT32 cJ1939::getPGN(UINT32 id)
+{
+	UINT32 pgn = (id >> 8) & 0x3FFFF;
+
+	return((((pgn >> 8) & 0xFF) < 0xF0) ? (pgn & 0x3FF00) : pgn);
+}
+
+/**
+ * Build a 29bit CAN ID
+ *
+ * @param priority - 0-7
+ * @param pgn      - parameter group number
+ * @param dest     - destination address (PDU1 only)
+ * @param source   - source address
+ * @return - CAN ID
+ */
+UINT32 cJ1939::buildID(UINT8 priority, UINT32 pgn, UINT8 dest, UINT8 source)
+{
+	UINT32 id = ((UINT32)(priority & 0x07) << 26) | ((pgn & 0x3FFFF) << 8) | source;
+
+	if (((pgn >> 8) & 0xFF) < 0xF0)
+	{
+		id = (id & 0xFFFF00FF) | ((UINT32)dest << 8);
+	}
+	return(id);
+}
+
+/**
+ * this handler is called when any frame is received on the port
+ *
+ * @param R - pointer to the received CAN frame
+ * @return - bool the frame was routed to a message
+ */
+bool cJ1939::receiveFrame(RX_CAN_FRAME *R)
+{
+	cJ1939Message *M;
+	UINT32 pgn;
+	UINT8 *entry, sa, da;
+
+	//J1939 is 29bit only, the extended data page is reserved (ISO 15765-3)
+	if (!R->extended || (R->id & 0x02000000))
+	{
+		return(false);
+	}
+
+	pgn = getPGN(R->id);
+	sa  = R->id & 0xFF;
+	da  = (((pgn >> 8) & 0xFF) < 0xF0) ? ((R->id >> 8) & 0xFF) : J1939_GLOBAL_ADDRESS;
+
+	//network management
+	if (pgn == PGN_ADDRESS_CLAIM)
+	{
+		contend(sa, R->data.byte);
+
+	} else if ((pgn == PGN_REQUEST) && (state != J1939_ADDR_IDLE) && ((da == address) || (da == J1939_GLOBAL_ADDRESS)) &&
+			   (R->data.byte[0] == (PGN_ADDRESS_CLAIM & 0xFF)) && (R->data.byte[1] == (PGN_ADDRESS_CLAIM >> 8)) && (R->data.byte[2] == 0))
+	{
+		//request for address claim, answer with our claim (or cannot claim)
+		claimPending = true;
+	}
+
+	//PDU1 frames sent to another ECU are not for us
+	if ((da != J1939_GLOBAL_ADDRESS) && ((da != address) || (state != J1939_ADDR_CLAIMED)))
+	{
+		return(false);
+	}
+
+	entry = lookup(pgn, false);
+	if (!entry || !*entry)
+	{
+		unhandledCtr += 1;
+		return(false);
+	}
+
+	M = msgs[*entry - 1];
+	M->source = sa;
+	M->destRx = da;
+	M->length = R->length;
+
+	//same as the acquisition scheduler, the message decides if it takes the data
+	if (M->CallbackRx(R))
+	{
+		memcpy(M->U.b, R->data.byte, 8);
+		M->rxCtr += 1;
+	}
+
+	return(true);
+}
+
+/**
+ * Hand a reassembled multi-packet message to the message registered for its PGN
+ *
+ * @param pgn  - parameter group number
+ * @param sa   - source address
+ * @param da   - destination address
+ * @param data - message data
+ * @param len  - number of bytes
+ * @return - bool the message was routed to a message
+ */
+bool cJ1939::deliver(UINT32 pgn, UINT8 sa, UINT8 da, const UINT8 *data, UINT16 len)
+{
+	cJ1939Message *M;
+	UINT8 *entry = lookup(pgn, false);
+
+	if (!entry || !*entry)
+	{
+		unhandledCtr += 1;
+		return(false);
+	}
+
+	M = msgs[*entry - 1];
+	M->source = sa;
+	M->destRx = da;
+	M->length = len;
+
+	if (M->CallbackRxTP(data, len))
+	{
+		memcpy(M->U.b, data, 8);
+		if (M->buffer)
+		{
+			memcpy(M->buffer, data, (len < M->bufferSize) ? len : M->bufferSize);
+		}
+		M->rxCtr += 1;
+	}
+
+	return(true);
+}
+
+/**
+ * Handle an address claim from another ECU, the lower NAME wins the address
+ *
+ * @param sa    - claimed address
+ * @param other - NAME of the other ECU
+ */
+void cJ1939::contend(UINT8 sa, const UINT8 *other)
+{
+	SINT32 i;
+
+	if (sa >= J1939_NULL_ADDRESS)
+	{
+		return;
+	}
+	used[sa / 32] |= (UINT32)1 << (sa % 32);
+
+	if ((sa != address) || ((state != J1939_ADDR_CLAIMING) && (state != J1939_ADDR_CLAIMED)))
+	{
+		return;
+	}
+	contentionCtr += 1;
+
+	//compare the NAME's as 64bit numbers, most significant byte first
+	for (i=7; (i >= 0) && (name[i] == other[i]); i--);
+
+	if ((i < 0) || (name[i] < other[i]))
+	{
+		//our NAME has priority, claim it again
+		claimPending = true;
+		return;
+	}
+
+	//we lost the address, an arbitrary address capable ECU looks for another one
+	address = (name[7] & 0x80) ? nextAddress() : J1939_NULL_ADDRESS;
+	state   = (address != J1939_NULL_ADDRESS) ? J1939_ADDR_CLAIMING : J1939_ADDR_LOST;
+	claimPending = true;
+}
+
+/**
+ * Find an address nobody has claimed, starting after the address we lost
+ *
+ * @return - address, J1939_NULL_ADDRESS if none is left
+ */
+UINT8 cJ1939::nextAddress()
+{
+	UINT8 a = address, i;
+
+	for (i=0; i <= (J1939_DYNAMIC_MAX - J1939_DYNAMIC_MIN); i++)
+	{
+		a = ((a < J1939_DYNAMIC_MIN) || (a >= J1939_DYNAMIC_MAX)) ? J1939_DYNAMIC_MIN : a + 1;
+
+		if (!((used[a / 32] >> (a % 32)) & 1))
+		{
+			return(a);
+		}
+	}
+
+	return(J1939_NULL_ADDRESS);
+}
+
+/**
+ * this handler is called by the scheduler on every tick, sends the address claim when one is due and takes the address
+ * once nobody has contended it for J1939_CLAIM_WAIT_MS
+ *
+ * @return - bool transmit the network management frame
+ */
+bool cJ1939::controlFrame()
+{
+	if (claimPending)
+	{
+		claimPending = false;
+
+		CtrlFrame.ID = buildID(J1939_DEFAULT_PRIORITY, PGN_ADDRESS_CLAIM, J1939_GLOBAL_ADDRESS, address);
+		memcpy(CtrlFrame.U.b, name, 8);
+
+		if (state == J1939_ADDR_CLAIMING)
+		{
+			claimTime = millis();
+		}
+		return(true);
+	}
+
+	if ((state == J1939_ADDR_CLAIMING) && ((millis() - claimTime) >= J1939_CLAIM_WAIT_MS))
+	{
+		state = J1939_ADDR_CLAIMED;
+	}
+
+	return(false);
+}
+
+/**
+ * constructor, default priority and global destination
+ */
+cJ1939Message::cJ1939Message()
+{
+	pgn        = 0;
+	priority   = J1939_DEFAULT_PRIORITY;
+	dest       = J1939_GLOBAL_ADDRESS;
+	source     = J1939_NULL_ADDRESS;
+	destRx     = J1939_GLOBAL_ADDRESS;
+	length     = 0;
+	rxCtr      = 0;
+	parent     = NULL;
+	buffer     = NULL;
+	bufferSize = 0;
+}
+
+/**
+ * Set the buffer that receives multi-packet (transport protocol) messages of this PGN
+ *
+ * @param buf  - buffer
+ * @param size - size of the buffer, longer messages are truncated
+ */
+void cJ1939Message::setBuffer(UINT8 *buf, UINT16 size)
+{
+	buffer     = buf;
+	bufferSize = size;
+}
+
+/**
+ * Retrieve the data of the last multi-packet message
+ *
+ * @return - pointer to the buffer, NULL if no buffer is set
+ */
+const UINT8* cJ1939Message::getBuffer()
+{
+	return(buffer);
+}
+
+/**
+ * This is a overridden implementaiton of the base class member that is called by the acquisition scheduler when the message is due.
+ * The CAN ID is built from the PGN, priority, destination and our address.
+ *
+ * @return - a flag to transmit or skip this CAN frame
+ */
+bool cJ1939Message::CallbackTx()
+{
+	if (!parent || (parent->getState() != J1939_ADDR_CLAIMED))
+	{
+		return(false);
+	}
+
+	ID = cJ1939::buildID(priority, pgn, dest, parent->getAddress());
+	return(true);
+}
+
+/**
+ * This is a overridden implementaiton of the base class member that is called by the acquisition scheduler for every received frame.
+ *
+ * @param R - pointer to RX Frame
+ * @return - a flag to accept or reject this CAN frame
+ */
+bool cJ1939RXFrame::CallbackRx(RX_CAN_FRAME *R)
+{
+	return(R ? parent->receiveFrame(R) : false);
+}
+
+/**
+ * This is a overridden implementaiton of the base class member that is called by the acquisition scheduler on every tick
+ *
+ * @return - a flag to transmit or skip this CAN frame
+ */
+bool cJ1939CtrlFrame::CallbackTx()
+{
+	return(parent->controlFrame());
+}
@@ -0,0 +1,372 @@
+/*
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#include "variant.h"
+#include <due_can.h>
+#include <CAN_Acquisition.h>
+
+#ifndef J1939_H
+#define J1939_H
+
+/**
+ *
+ * This macro is used to set the maximum number of receive PGN's per CAN port
+ */
+#define	J1939_MAX_PGNS			48
+
+/**
+ *
+ * This macro is used to set the number of PDU2 lookup pages (256 bytes each). One page is used for every PDU format
+ * 0xF0-0xFF that has a receive PGN (e.g. 0xF0, 0xFE, 0xFF = 3 pages)
+ */
+#define	J1939_PDU2_PAGES		6
+
+/**
+ *
+ * This macro is used to set how long (mS) to wait for a contending claim after an address claim before the address is used
+ */
+#define	J1939_CLAIM_WAIT_MS		250
+
+/**
+ *
+ * This macro is used to set the range of addresses an arbitrary address capable ECU picks from when it loses its address
+ */
+#define	J1939_DYNAMIC_MIN		128
+#define	J1939_DYNAMIC_MAX		247
+
+/**
+ *
+ * These macros represent the reserved addresses: no address (cannot claim) and global (broadcast)
+ */
+#define	J1939_NULL_ADDRESS		0xFE
+#define	J1939_GLOBAL_ADDRESS	0xFF
+
+/**
+ *
+ * This macro is used to set the default transmit priority (0 = highest, 7 = lowest)
+ */
+#define	J1939_DEFAULT_PRIORITY	6
+
+/**
+ *
+ * This enum represents the network management and transport PGN's
+ */
+enum J1939_PGN
+{
+	PGN_REQUEST        = 0xEA00,
+	PGN_ADDRESS_CLAIM  = 0xEE00,
+	PGN_TP_CM          = 0xEC00,
+	PGN_TP_DT          = 0xEB00
+};
+
+/**
+ *
+ * This enum represents the address claim state of a J1939 port
+ */
+enum J1939_ADDR_STATE
+{
+	J1939_ADDR_IDLE     = 0,	//claimAddress() has not been called, nothing is transmitted
+	J1939_ADDR_CLAIMING = 1,	//claim sent, waiting J1939_CLAIM_WAIT_MS for a contending claim
+	J1939_ADDR_CLAIMED  = 2,	//the address is ours, messages are transmitted
+	J1939_ADDR_LOST     = 3		//no address could be claimed (cannot claim sent), nothing is transmitted
+};
+
+class cJ1939;
+
+/**
+ * This is a J1939 message (parameter group). For reception it is registered by PGN, frames with any priority and from
+ * any source address are routed to it and the source address is kept. For transmission it is scheduled at its rate
+ * like any cCANFrame, the CAN ID is built from the PGN, priority, destination and the claimed source address.
+ * Override CallbackRx() to process the data as it is received (as with cCANFrame). A subclass that overrides
+ * CallbackTx() must call cJ1939Message::CallbackTx() to have the CAN ID built.
+ */
+class cJ1939Message : public cCANFrame
+{
+public:
+	/**
+	 * constructor, default priority and global destination
+	 */
+	cJ1939Message();
+
+	/**
+	 * parameter group number, PDU1 PGN's (PDU format < 0xF0) are given with the destination byte 0 (e.g. 0xEA00)
+	 */
+	UINT32 pgn;
+
+	/**
+	 * transmit priority (0-7) and destination address of PDU1 PGN's (ignored for PDU2)
+	 */
+	UINT8  priority;
+	UINT8  dest;
+
+	/**
+	 * source address, destination address and number of data bytes of the last received frame (or multi-packet message)
+	 */
+	UINT8  source;
+	UINT8  destRx;
+	UINT16 length;
+
+	/**
+	 * number of frames received (rolling)
+	 */
+	UINT32 rxCtr;
+
+	/**
+	 * J1939 port this message is registered with
+	 */
+	cJ1939 *parent;
+
+	/**
+	 * multi-packet receive buffer
+	 */
+	UINT8  *buffer;
+	UINT16 bufferSize;
+
+	/**
+	 * Set the buffer that receives multi-packet (transport protocol) messages of this PGN, without a buffer only the first
+	 * 8 bytes are kept (in U)
+	 *
+	 * @param buf  - buffer
+	 * @param size - size of the buffer, longer messages are truncated
+	 */
+	void setBuffer(UINT8 *buf, UINT16 size);
+
+	/**
+	 * Retrieve the data of the last multi-packet message
+	 *
+	 * @return - pointer to the buffer, NULL if no buffer is set
+	 */
+	const UINT8* getBuffer();
+
+	/**
+	 * This is a function that is called when a multi-packet (transport protocol) message of this PGN has been received
+	 *
+	 * @param data - message data
+	 * @param len  - number of bytes
+	 * @return - a flag to accept or reject the message
+	 */
+	virtual bool CallbackRxTP(const UINT8 *data, UINT16 len)
+	{
+		return(true);
+	}
+
+	/**
+	 * builds the CAN ID, the message is only transmitted once an address has been claimed
+	 *
+	 * @return - a flag to transmit or skip this CAN frame
+	 */
+	virtual bool CallbackTx();
+};
+
+/**
+ * this is the receive frame that accepts every frame on the port and hands it to the PGN dispatch
+ */
+class cJ1939RXFrame : public cCANFrame
+{
+public:
+	cJ1939 *parent;
+
+private:
+	bool  CallbackRx(RX_CAN_FRAME *R);
+};
+
+/**
+ * this is the network management transmit frame (address claim), it is offered a transmit slot on every scheduler tick
+ */
+class cJ1939CtrlFrame : public cCANFrame
+{
+public:
+	cJ1939 *parent;
+
+private:
+	bool  CallbackTx();
+};
+
+/**
+ * J1939 layer for one CAN port. Receive messages are registered by PGN and found through a direct lookup table
+ * (PDU format, then group extension for PDU2), so the cost per received frame does not depend upon the number of PGN's.
+ * PDU1 frames are only accepted when they are sent to our address or to the global address.
+ * Address claiming (J1939-81) is done in the background: the claim is sent, a contending claim with a lower NAME takes
+ * the address from us and an arbitrary address capable ECU moves on to a free address.
+ *
+ * e.g.
+ *   cJ1939 J1939(&CANport0);
+ *   cJ1939Message EEC1;
+ *   EEC1.pgn = 0xF004;
+ *   J1939.addMessage(&EEC1, RECEIVE);
+ *   J1939.claimAddress(name, 0x80);
+ *
+ * @author D.Kasamis - dan@togglebit.net
+ * @version 1.0
+ */
+class cJ1939
+{
+public:
+	/**
+	 * constructor, registers the receive frame and the network management frame with the acquisition scheduler
+	 *
+	 * @param _portNum - physical CAN port to be used
+	 */
+	cJ1939(cAcquireCAN *_portNum);
+
+	/**
+	 * Register a message
+	 *
+	 * @param msg  - message, set the PGN (and rate for transmit messages) first
+	 * @param type - RECEIVE to have frames of this PGN routed to it, TRANSMIT to have it sent at its rate
+	 * @return - false if the PGN is already registered for reception or the lookup table is full
+	 */
+	bool addMessage(cJ1939Message *msg, ACQ_FRAME_TYPE type);
+
+	/**
+	 * Find the receive message of a PGN
+	 *
+	 * @param pgn - parameter group number
+	 * @return - pointer to the message, NULL if the PGN is not registered
+	 */
+	cJ1939Message* find(UINT32 pgn);
+
+	/**
+	 * Start claiming an address
+	 *
+	 * @param _name     - 64bit NAME, in transmit order (byte 0 = LSB of the identity number, bit 7 of byte 7 = arbitrary address capable)
+	 * @param preferred - address to claim
+	 */
+	void claimAddress(const UINT8 *_name, UINT8 preferred);
+
+	/**
+	 * Retrieve the address claim state and our address
+	 */
+	J1939_ADDR_STATE getState();
+	UINT8 getAddress();
+
+	/**
+	 * Retrieve the number of frames received with no registered PGN, and the number of contending claims seen (rolling)
+	 */
+	UINT32 getUnhandledCtr();
+	UINT32 getContentionCtr();
+
+	/**
+	 * Split a 29bit CAN ID
+	 *
+	 * @param id - CAN ID
+	 * @return - parameter group number (destination byte 0 for PDU1)
+	 */
+	static UINT32 getPGN(UINT32 id);
+
+	/**
+	 * Build a 29bit CAN ID
+	 *
+	 * @param priority - 0-7
+	 * @param pgn      - parameter group number
+	 * @param dest     - destination address (PDU1 only)
+	 * @param source   - source address
+	 * @return - CAN ID
+	 */
+	static UINT32 buildID(UINT8 priority, UINT32 pgn, UINT8 dest, UINT8 source);
+
+	/**
+	 * this handler is called when any frame is received on the port
+	 *
+	 * @param R - pointer to the received CAN frame
+	 * @return - bool the frame was routed to a message
+	 */
+	bool receiveFrame(RX_CAN_FRAME *R);
+
+	/**
+	 * Hand a reassembled multi-packet message to the message registered for its PGN (called by the transport protocol)
+	 *
+	 * @param pgn  - parameter group number
+	 * @param sa   - source address
+	 * @param da   - destination address
+	 * @param data - message data
+	 * @param len  - number of bytes
+	 * @return - bool the message was routed to a message
+	 */
+	bool deliver(UINT32 pgn, UINT8 sa, UINT8 da, const UINT8 *data, UINT16 len);
+
+	/**
+	 * this handler is called by the scheduler on every tick, sends the address claim when one is due
+	 *
+	 * @return - bool transmit the network management frame
+	 */
+	bool controlFrame();
+
+private:
+	cAcquireCAN *portNum;
+
+	/**
+	 * catch-all receive frame and network management frame
+	 */
+	cJ1939RXFrame   RXFrame;
+	cJ1939CtrlFrame CtrlFrame;
+
+	/**
+	 * receive messages, dispatch tables: PDU1 by data page and PDU format, PDU2 by data page and PDU format to a page that is
+	 * indexed by group extension. All hold the msgs index + 1 (0 = no message)
+	 */
+	cJ1939Message *msgs[J1939_MAX_PGNS];
+	UINT8  numMsgs;
+	UINT8  pdu1Map[2][240];
+	UINT8  pdu2Page[2][16];
+	UINT8  pdu2Map[J1939_PDU2_PAGES][256];
+	UINT8  numPages;
+
+	/**
+	 * address claim: NAME, state, our address, a claim (or cannot claim) is to be sent, time (millis) the claim was sent
+	 */
+	UINT8  name[8];
+	volatile J1939_ADDR_STATE state;
+	volatile UINT8 address;
+	volatile bool  claimPending;
+	UINT32 claimTime;
+
+	/**
+	 * addresses claimed by other ECU's (bitmap), where the search for a free address continues
+	 */
+	UINT32 used[8];
+
+	/**
+	 * counters
+	 */
+	UINT32 unhandledCtr;
+	UINT32 contentionCtr;
+
+	/**
+	 * Look up the dispatch entry of a PGN
+	 *
+	 * @param pgn    - parameter group number
+	 * @param create - allocate a PDU2 page if the PDU format does not have one yet
+	 * @return - pointer to the entry, NULL if the PGN has no entry (or no page is left)
+	 */
+	UINT8* lookup(UINT32 pgn, bool create);
+
+	/**
+	 * Handle an address claim from another ECU
+	 *
+	 * @param sa    - claimed address
+	 * @param other - NAME of the other ECU
+	 */
+	void contend(UINT8 sa, const UINT8 *other);
+
+	/**
+	 * Find an address nobody has claimed
+	 *
+	 * @return - address, J1939_NULL_ADDRESS if none is left
+	 */
+	UINT8 nextAddress();
+};
+
+#endif
@@ -0,0 +1,704 @@
+/*
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#include "J1939_TP.h"
+
+/**
+ * constructor, registers the transport messages with the J1939 layer
+ *
+ * @param _j1939 - J1939 layer of the CAN port
+ */
+cJ1939TP::cJ1939TP(cJ1939 *_j1939)
+{
+	UINT8 i;
+
+	j1939        = _j1939;
+	rrIndex      = 0;
+	abortPending = 0;
+	abortRemote  = J1939_NULL_ADDRESS;
+	abortPGN     = 0;
+	bamMs        = J1939_TP_BAM_MS;
+	rxCtr        = 0;
+	txCtr        = 0;
+	abortCtr     = 0;
+	timeoutCtr   = 0;
+	busyCtr      = 0;
+
+	for (i=0; i < J1939_TP_SESSIONS; i++)
+	{
+		sessions[i].state = TP_FREE;
+	}
+
+	//
+	//********** RX TP.CM / TP.DT ****************
+	//
+	//from any source address, sent to us or to global
+	//
+	CMMsg.pgn = PGN_TP_CM;
+	CMMsg.tp  = this;
+	j1939->addMessage(&CMMsg, RECEIVE);
+
+	DTMsg.pgn = PGN_TP_DT;
+	DTMsg.tp  = this;
+	j1939->addMessage(&DTMsg, RECEIVE);
+
+	//
+	//********** TX TP.CM / TP.DT ****************
+	//
+	//	TP.CM: | control | size lo | size hi | packets | max packets / 0xFF | PGN lo | PGN mid | PGN hi |
+	//	TP.DT: | sequence number | 7 data bytes (0xFF after the end of the message) |
+	//
+	TxMsg.rate     = TICK_MSG;
+	TxMsg.priority = J1939_TP_PRIORITY;
+	TxMsg.tp       = this;
+	j1939->addMessage(&TxMsg, TRANSMIT);
+}
+
+/**
+ * Send a message longer than 8 bytes
+ *
+ * @param pgn  - parameter group number
+ * @param dest - destination address, J1939_GLOBAL_ADDRESS to broadcast (BAM)
+ * @param data - message data (copied)
+ * @param len  - number of bytes, 9 to J1939_TP_MAX_BYTES
+ * @return - false if no address is claimed, no session is free or a transfer to this destination is already in progress
+ */
+bool cJ1939TP::send(UINT32 pgn, UINT8 dest, const UINT8 *data, UINT16 len)
+{
+	sJ1939TPSession *S;
+	bool bam = (dest == J1939_GLOBAL_ADDRESS);
+
+	if ((len <= 8) || (len > J1939_TP_MAX_BYTES) || (j1939->getState() != J1939_ADDR_CLAIMED))
+	{
+		return(false);
+	}
+
+	noInterrupts();
+
+	//only one broadcast, and one connection per destination, at a time
+	S = isBusy(dest) ? NULL : allocate();
+
+	if (S)
+	{
+		memcpy(S->data, data, len);
+		S->pgn       = pgn;
+		S->remote    = dest;
+		S->size      = len;
+		S->packets   = (len + 6) / 7;
+		S->seq       = 1;
+		S->windowEnd = 0;
+		S->maxWindow = 0xFF;
+		S->ctrl      = bam ? TP_CM_BAM : TP_CM_RTS;
+		S->timer     = millis();
+		S->state     = bam ? TP_TX_BAM : TP_TX_WAIT;
+	}
+
+	interrupts();
+
+	return(S != NULL);
+}
+
+/**
+ * Check if a transfer to a destination is in progress
+ *
+ * @param dest - destination address, J1939_GLOBAL_ADDRESS for a broadcast
+ * @return - true if the transfer is still in progress
+ */
+bool cJ1939TP::isBusy(UINT8 dest)
+{
+	return((dest == J1939_GLOBAL_ADDRESS) ? (find(TP_TX_BAM, TP_TX_BAM, dest) != NULL) : (find(TP_TX_WAIT, TP_TX_EOM, dest) != NULL));
+}
+
+/**
+ * Set the time between broadcast packets
+ *
+ * @param ms - J1939_TP_BAM_MIN_MS to J1939_TP_BAM_MAX_MS
+ */
+void cJ1939TP::setBAMInterval(UINT16 ms)
+{
+	bamMs = (ms < J1939_TP_BAM_MIN_MS) ? J1939_TP_BAM_MIN_MS : ((ms > J1939_TP_BAM_MAX_MS) ? J1939_TP_BAM_MAX_MS : ms);
+}
+
+/**
+ * Find the session in a state (or range of states) with a node
+ *
+ * @param first  - first state
+ * @param last   - last state
+ * @param remote - address of the other node
+ * @return - pointer to the session, NULL if there is none
+ */
+sJ1939TPSession* cJ1939TP::find(J1939_TP_STATE first, J1939_TP_STATE last, UINT8 remote)
+{
+	UINT8 i;
+
+	for (i=0; i < J1939_TP_SESSIONS; i++)
+	{
+		if ((sessions[i].state >= first) && (sessions[i].state <= last) && (sessions[i].remote == remote))
+		{
+			return(&sessions[i]);
+		}
+	}
+
+	return(NULL);
+}
+
+/**
+ * Take a free session from the pool
+ *
+ * @return - pointer to the session, NULL if the pool is empty
+ */
+sJ1939TPSession* cJ1939TP::allocate()
+{
+	UINT8 i;
+
+	for (i=0; i < J1939_TP_SESSIONS; i++)
+	{
+		if (sessions[i].state == TP_FREE)
+		{
+			return(&sessions[i]);
+		}
+	}
+
+	busyCtr += 1;
+	return(NULL);
+}
+
+/**
+ * this handler is called when a TP.CM or TP.DT frame is received
+ *
+ * @param M - transport message that received the frame (source and destination)
+ * @param d - frame data
+ */
+void cJ1939TP::receiveFrame(cJ1939Message *M, const UINT8 *d)
+{
+	if (M->pgn == PGN_TP_CM)
+	{
+		receiveCM(M->source, M->destRx, d);
+	} else
+	{
+		receiveDT(M->source, M->destRx, d);
+	}
+}
+
+/**
+ * Handle a connection management frame
+ *
+ * @param sa - source address
+ * @param da - destination address
+ * @param d  - frame data
+ */
+void cJ1939TP::receiveCM(UINT8 sa, UINT8 da, const UINT8 *d)
+{
+	sJ1939TPSession *S;
+	UINT32 pgn  = (UINT32)d[5] | ((UINT32)d[6] << 8) | ((UINT32)d[7] << 16);
+	UINT16 size = (UINT16)d[1] | ((UINT16)d[2] << 8);
+
+	switch (d[0])
+	{
+	case TP_CM_BAM:
+		//a new broadcast from a node replaces the one in progress
+		if (da != J1939_GLOBAL_ADDRESS)
+		{
+			break;
+		}
+
+		S = find(TP_RX_BAM, TP_RX_BAM, sa);
+		S = S ? S : allocate();
+		if (!S)
+		{
+			break;
+		}
+
+		if ((size <= 8) || (size > J1939_TP_MAX_BYTES) || (d[3] != (size + 6) / 7))
+		{
+			S->state = TP_FREE;
+			break;
+		}
+
+		S->pgn     = pgn;
+		S->remote  = sa;
+		S->size    = size;
+		S->packets = d[3];
+		S->seq     = 1;
+		S->ctrl    = 0;
+		S->timer   = millis();
+		S->state   = TP_RX_BAM;
+		break;
+
+	case TP_CM_RTS:
+		if (da == J1939_GLOBAL_ADDRESS)
+		{
+			break;
+		}
+
+		//a new request from a node replaces the one in progress
+		S = find(TP_RX_CMDT, TP_RX_CMDT, sa);
+		S = S ? S : allocate();
+		if (!S)
+		{
+			abortPending = TP_ABORT_RESOURCES;
+			abortRemote  = sa;
+			abortPGN     = pgn;
+			break;
+		}
+
+		S->pgn       = pgn;
+		S->remote    = sa;
+		S->size      = size;
+		S->packets   = d[3];
+		S->seq       = 1;
+		S->windowEnd = 0;
+		S->maxWindow = d[4] ? d[4] : 0xFF;
+		S->timer     = millis();
+		S->state     = TP_RX_CMDT;
+
+		if ((size <= 8) || (size > J1939_TP_MAX_BYTES) || (d[3] != (size + 6) / 7))
+		{
+			S->ctrl   = TP_CM_ABORT;
+			S->reason = TP_ABORT_RESOURCES;
+		} else
+		{
+			grant(S);
+		}
+		break;
+
+	case TP_CM_CTS:
+		S = find(TP_TX_WAIT, TP_TX_EOM, sa);
+		if (!S || (S->pgn != pgn))
+		{
+			break;
+		}
+
+		S->timer = millis();
+
+		if (d[1] == 0)
+		{
+			S->state = TP_TX_HOLD;
+		} else
+		{
+			//the receiver may ask for any packets again (retransmission)
+			S->seq       = d[2];
+			S->windowEnd = ((UINT16)d[2] + d[1] - 1 < S->packets) ? d[2] + d[1] - 1 : S->packets;
+			S->state     = ((S->seq >= 1) && (S->seq <= S->packets)) ? TP_TX_DATA : TP_TX_WAIT;
+		}
+		break;
+
+	case TP_CM_EOM:
+		S = find(TP_TX_WAIT, TP_TX_EOM, sa);
+		if (S && (S->pgn == pgn))
+		{
+			txCtr   += 1;
+			S->state = TP_FREE;
+		}
+		break;
+
+	case TP_CM_ABORT:
+		S = find(TP_TX_WAIT, TP_TX_EOM, sa);
+		S = S ? S : find(TP_RX_CMDT, TP_RX_CMDT, sa);
+		if (S && (S->pgn == pgn))
+		{
+			abortCtr += 1;
+			S->state  = TP_FREE;
+		}
+		break;
+
+	default:
+		break;
+	}
+}
+
+/**
+ * Handle a data transfer frame
+ *
+ * @param sa - source address
+ * @param da - destination address
+ * @param d  - frame data
+ */
+void cJ1939TP::receiveDT(UINT8 sa, UINT8 da, const UINT8 *d)
+{
+	sJ1939TPSession *S;
+	UINT16 pos, n;
+	bool bam = (da == J1939_GLOBAL_ADDRESS);
+
+	S = bam ? find(TP_RX_BAM, TP_RX_BAM, sa) : find(TP_RX_CMDT, TP_RX_CMDT, sa);
+
+	//packets before our clear to send is out, or repeated packets
+	if (!S || S->ctrl || (d[0] < S->seq))
+	{
+		return;
+	}
+
+	//a packet went missing
+	if ((d[0] != S->seq) || (!bam && (d[0] > S->windowEnd)))
+	{
+		abortCtr += 1;
+		if (bam)
+		{
+			S->state = TP_FREE;
+		} else
+		{
+			S->ctrl   = TP_CM_ABORT;
+			S->reason = TP_ABORT_TIMEOUT;
+		}
+		return;
+	}
+
+	pos = (UINT16)(d[0] - 1) * 7;
+	n   = (S->size - pos < 7) ? S->size - pos : 7;
+	memcpy(&S->data[pos], &d[1], n);
+
+	S->seq  += 1;
+	S->timer = millis();
+
+	if (S->seq > S->packets)
+	{
+		//complete, hand it to the message of this PGN
+		rxCtr += 1;
+		j1939->deliver(S->pgn, sa, da, S->data, S->size);
+
+		if (bam)
+		{
+			S->state = TP_FREE;
+		} else
+		{
+			S->ctrl = TP_CM_EOM;
+		}
+
+	} else if (!bam && (S->seq > S->windowEnd))
+	{
+		grant(S);
+	}
+}
+
+/**
+ * Grant the next clear to send window of a receive session
+ *
+ * @param S - session
+ */
+void cJ1939TP::grant(sJ1939TPSession *S)
+{
+	UINT16 n = S->packets - S->seq + 1;
+
+	n = (n > J1939_TP_CTS_PACKETS) ? J1939_TP_CTS_PACKETS : n;
+	n = (n > S->maxWindow) ? S->maxWindow : n;
+
+	S->windowEnd = S->seq + n - 1;
+	S->ctrl      = TP_CM_CTS;
+}
+
+/**
+ * Check the timeouts of all sessions
+ *
+ * @param claimed - an address is claimed
+ */
+void cJ1939TP::checkTimeouts(bool claimed)
+{
+	UINT32 now = millis();
+	UINT8 i;
+
+	for (i=0; i < J1939_TP_SESSIONS; i++)
+	{
+		if (sessions[i].state != TP_FREE)
+		{
+			checkTimeout(&sessions[i], now, claimed);
+		}
+	}
+}
+
+/**
+ * Check the timeouts of a session
+ *
+ * @param S       - session
+ * @param now     - current time (millis)
+ * @param claimed - an address is claimed
+ */
+void cJ1939TP::checkTimeout(sJ1939TPSession *S, UINT32 now, bool claimed)
+{
+	UINT32 limit;
+
+	switch (S->state)
+	{
+	case TP_RX_BAM:
+		limit = J1939_TP_T1_MS;
+		break;
+
+	case TP_RX_CMDT:
+		//waiting for a packet after clear to send
+		limit = J1939_TP_T2_MS;
+		break;
+
+	case TP_TX_WAIT:
+	case TP_TX_EOM:
+		limit = J1939_TP_T3_MS;
+		break;
+
+	case TP_TX_HOLD:
+		limit = J1939_TP_T4_MS;
+		break;
+
+	default:
+		//sending, paced by our own ticks, stalls only while no address is claimed
+		if (claimed)
+		{
+			return;
+		}
+		limit = J1939_TP_T1_MS;
+		break;
+	}
+
+	//a pending frame is sent on one of the next ticks, unless there is no address to send it from
+	if ((S->ctrl && claimed) || ((now - S->timer) <= limit))
+	{
+		return;
+	}
+
+	timeoutCtr += 1;
+
+	//a broadcast just ends, a connection is aborted (without an address it just ends too)
+	if ((S->state == TP_RX_BAM) || !claimed)
+	{
+		S->ctrl  = 0;
+		S->state = TP_FREE;
+	} else
+	{
+		S->ctrl   = TP_CM_ABORT;
+		S->reason = TP_ABORT_TIMEOUT;
+	}
+}
+
+/**
+ * this handler is called by the scheduler on every tick, one transport frame is sent per tick: a pending connection
+ * management frame or the next data packet, the sessions take turns
+ *
+ * @param M - transport message to fill in
+ * @return - bool transmit the frame
+ */
+bool cJ1939TP::requestFrame(cJ1939Message *M)
+{
+	UINT32 now = millis();
+	sJ1939TPSession *S;
+	UINT16 pos;
+	UINT8 i, k;
+
+	if (abortPending)
+	{
+		buildCM(M, NULL);
+		return(true);
+	}
+
+	for (k=0; k < J1939_TP_SESSIONS; k++)
+	{
+		S = &sessions[(rrIndex + k) % J1939_TP_SESSIONS];
+
+		if (S->state == TP_FREE)
+		{
+			continue;
+		}
+
+		if (S->ctrl)
+		{
+			rrIndex = (rrIndex + k + 1) % J1939_TP_SESSIONS;
+			buildCM(M, S);
+			return(true);
+		}
+
+		if ((S->state == TP_TX_DATA) || ((S->state == TP_TX_BAM) && ((now - S->timer) >= bamMs)))
+		{
+			rrIndex = (rrIndex + k + 1) % J1939_TP_SESSIONS;
+
+			M->pgn    = PGN_TP_DT;
+			M->dest   = S->remote;
+			M->U.b[0] = S->seq;
+			pos = (UINT16)(S->seq - 1) * 7;
+			for (i=0; i < 7; i++)
+			{
+				M->U.b[1 + i] = (pos + i < S->size) ? S->data[pos + i] : 0xFF;
+			}
+
+			S->timer = now;
+			S->seq  += 1;
+
+			if (S->seq > S->packets)
+			{
+				//a broadcast is done, a connection waits for the acknowledge
+				if (S->state == TP_TX_BAM)
+				{
+					txCtr   += 1;
+					S->state = TP_FREE;
+				} else
+				{
+					S->state = TP_TX_EOM;
+				}
+			} else if ((S->state == TP_TX_DATA) && (S->seq > S->windowEnd))
+			{
+				S->state = TP_TX_WAIT;
+			}
+			return(true);
+		}
+	}
+
+	return(false);
+}
+
+/**
+ * Fill in the connection management frame of a session (or the pending abort) and move the session on
+ *
+ * @param M - transport message to fill in
+ * @param S - session, NULL for the pending abort
+ */
+void cJ1939TP::buildCM(cJ1939Message *M, sJ1939TPSession *S)
+{
+	UINT32 pgn = S ? S->pgn : abortPGN;
+
+	M->pgn  = PGN_TP_CM;
+	M->dest = S ? S->remote : abortRemote;
+	M->U.b[5] = pgn & 0xFF;
+	M->U.b[6] = (pgn >> 8) & 0xFF;
+	M->U.b[7] = (pgn >> 16) & 0xFF;
+
+	if (!S)
+	{
+		M->U.b[0] = TP_CM_ABORT;
+		M->U.b[1] = abortPending;
+		M->U.b[2] = 0xFF;
+		M->U.b[3] = 0xFF;
+		M->U.b[4] = 0xFF;
+		abortPending = 0;
+		return;
+	}
+
+	M->U.b[0] = S->ctrl;
+
+	switch (S->ctrl)
+	{
+	case TP_CM_CTS:
+		M->U.b[1] = S->windowEnd - S->seq + 1;
+		M->U.b[2] = S->seq;
+		M->U.b[3] = 0xFF;
+		M->U.b[4] = 0xFF;
+		break;
+
+	case TP_CM_ABORT:
+		M->U.b[1] = S->reason;
+		M->U.b[2] = 0xFF;
+		M->U.b[3] = 0xFF;
+		M->U.b[4] = 0xFF;
+		break;
+
+	default:
+		//RTS, BAM and end of message acknowledge carry the size and number of packets
+		M->U.b[1] = S->size & 0xFF;
+		M->U.b[2] = S->size >> 8;
+		M->U.b[3] = S->packets;
+		M->U.b[4] = (S->ctrl == TP_CM_RTS) ? S->maxWindow : 0xFF;
+		break;
+	}
+
+	//the timers run from the connection management frame, an acknowledge or abort ends the session
+	S->timer = millis();
+	if ((S->ctrl == TP_CM_EOM) || (S->ctrl == TP_CM_ABORT))
+	{
+		S->state = TP_FREE;
+	}
+	S->ctrl = 0;
+}
+
+/**
+ * Retrieve the number of messages received (rolling)
+ *
+ * @return - number of messages
+ */
+UINT32 cJ1939TP::getRxCtr()
+{
+	return(rxCtr);
+}
+
+/**
+ * Retrieve the number of messages sent (rolling), connection mode messages count once acknowledged
+ *
+ * @return - number of messages
+ */
+UINT32 cJ1939TP::getTxCtr()
+{
+	return(txCtr);
+}
+
+/**
+ * Retrieve the number of transfers aborted by either side (rolling)
+ *
+ * @return - number of aborts
+ */
+UINT32 cJ1939TP::getAbortCtr()
+{
+	return(abortCtr);
+}
+
+/**
+ * Retrieve the number of transfers that timed out (rolling)
+ *
+ * @return - number of timeouts
+ */
+UINT32 cJ1939TP::getTimeoutCtr()
+{
+	return(timeoutCtr);
+}
+
+/**
+ * Retrieve the number of transfers refused because no session was free (rolling)
+ *
+ * @return - number of refused transfers
+ */
+UINT32 cJ1939TP::getBusyCtr()
+{
+	return(busyCtr);
+}
+
+/**
+ * This is a overridden implementaiton of the base class member that is called by the J1939 layer when a TP.CM or TP.DT frame has been received.
+ *
+ * @param R - pointer to RX Frame
+ * @return - a flag to accept or reject this CAN frame
+ */
+bool cJ1939TPRxMsg::CallbackRx(RX_CAN_FRAME *R)
+{
+	if (R)
+	{
+		tp->receiveFrame(this, R->data.byte);
+	}
+	return(false);
+}
+
+/**
+ * This is a overridden implementaiton of the base class member that is called by the acquisition scheduler on every tick.
+ * The sessions time out on every tick, nothing is sent before an address has been claimed.
+ *
+ * @return - a flag to transmit or skip this CAN frame
+ */
+bool cJ1939TPTxMsg::CallbackTx()
+{
+	if (!parent)
+	{
+		return(false);
+	}
+
+	tp->checkTimeouts(parent->getState() == J1939_ADDR_CLAIMED);
+
+	if ((parent->getState() != J1939_ADDR_CLAIMED) || !tp->requestFrame(this))
+	{
+		return(false);
+	}
+
+	return(cJ1939Message::CallbackTx());
+}
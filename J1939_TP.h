@@ -0,0 +1,355 @@
+/*
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#include <J1939.h>
+
+#ifndef J1939_TP_H
+#define J1939_TP_H
+
+/**
+ *
+ * This macro is used to set the number of transport sessions (receive and transmit) that can be open at once
+ */
+#define	J1939_TP_SESSIONS		8
+
+/**
+ *
+ * This macro is used to set the largest message (bytes) a session can hold (the protocol allows up to 1785)
+ */
+#define	J1939_TP_MAX_BYTES		256
+
+#if J1939_TP_MAX_BYTES > 255 * 7
+#error "J1939_TP_MAX_BYTES is larger than the 255 packets of 7 bytes the transport protocol can carry"
+#endif
+
+/**
+ *
+ * This macro is used to set the number of packets we allow the sender to send per clear to send
+ */
+#define	J1939_TP_CTS_PACKETS	16
+
+/**
+ *
+ * This macro is used to set the default and the allowed range (mS) of the time between BAM packets
+ */
+#define	J1939_TP_BAM_MS			50
+#define	J1939_TP_BAM_MIN_MS		50
+#define	J1939_TP_BAM_MAX_MS		200
+
+/**
+ *
+ * This macro is used to set the transport timeouts (mS): T1 between BAM packets and from a data packet to the next,
+ * T2 from clear to send to a data packet, T3 from the last data packet (or RTS) to clear to send / acknowledge, T4 hold
+ */
+#define	J1939_TP_T1_MS			750
+#define	J1939_TP_T2_MS			1250
+#define	J1939_TP_T3_MS			1250
+#define	J1939_TP_T4_MS			1050
+
+/**
+ *
+ * This macro is used to set the priority of the transport frames
+ */
+#define	J1939_TP_PRIORITY		7
+
+/**
+ *
+ * This enum represents the connection management (TP.CM) control bytes
+ */
+enum J1939_TP_CM
+{
+	TP_CM_RTS    = 16,
+	TP_CM_CTS    = 17,
+	TP_CM_EOM    = 19,
+	TP_CM_BAM    = 32,
+	TP_CM_ABORT  = 255
+};
+
+/**
+ *
+ * This enum represents the connection abort reasons
+ */
+enum J1939_TP_ABORT
+{
+	TP_ABORT_BUSY      = 1,	//already in a session with this node
+	TP_ABORT_RESOURCES = 2,	//no session or buffer for the message
+	TP_ABORT_TIMEOUT   = 3	//a timeout occurred
+};
+
+/**
+ *
+ * This enum represents the state of a transport session
+ */
+enum J1939_TP_STATE
+{
+	TP_FREE     = 0,
+	TP_RX_BAM   = 1,	//receiving a broadcast
+	TP_RX_CMDT  = 2,	//receiving a connection mode transfer
+	TP_TX_BAM   = 3,	//sending a broadcast, one packet every BAM interval
+	TP_TX_WAIT  = 4,	//RTS (or a window) sent, waiting for clear to send
+	TP_TX_HOLD  = 5,	//the receiver asked us to hold (clear to send 0 packets)
+	TP_TX_DATA  = 6,	//sending the packets of the clear to send window
+	TP_TX_EOM   = 7		//all packets sent, waiting for the end of message acknowledge
+};
+
+/**
+ *
+ * This struct represents one transport session
+ */
+struct sJ1939TPSession
+{
+	/**
+	 * state, PGN of the message, address of the other node (global for a broadcast we send)
+	 */
+	J1939_TP_STATE state;
+	UINT32 pgn;
+	UINT8  remote;
+
+	/**
+	 * message size (bytes) and number of packets, next packet expected/to send, last packet of the clear to send window,
+	 * most packets per clear to send the sender accepts. The packet numbers on the bus are one byte, seq is wider because
+	 * it runs to packets + 1 (256 for a 1785 byte message)
+	 */
+	UINT16 size;
+	UINT16 packets;
+	UINT16 seq;
+	UINT16 windowEnd;
+	UINT8  maxWindow;
+
+	/**
+	 * connection management frame to be sent (0 = none), abort reason, time (millis) of the last event
+	 */
+	UINT8  ctrl;
+	UINT8  reason;
+	UINT32 timer;
+
+	/**
+	 * message data
+	 */
+	UINT8  data[J1939_TP_MAX_BYTES];
+};
+
+class cJ1939TP;
+
+/**
+ * this is the message that receives the connection management (TP.CM) and data transfer (TP.DT) frames
+ */
+class cJ1939TPRxMsg : public cJ1939Message
+{
+public:
+	cJ1939TP *tp;
+
+private:
+	bool  CallbackRx(RX_CAN_FRAME *R);
+};
+
+/**
+ * this is the message that sends the transport frames, it is offered a transmit slot on every scheduler tick
+ */
+class cJ1939TPTxMsg : public cJ1939Message
+{
+public:
+	cJ1939TP *tp;
+
+private:
+	bool  CallbackTx();
+};
+
+/**
+ * J1939 transport protocol (J1939-21) for messages longer than 8 bytes. Broadcast (BAM) and connection mode
+ * (RTS/CTS) transfers are handled in both directions, any number of them at once up to J1939_TP_SESSIONS. Received
+ * messages are handed to the cJ1939Message registered for their PGN (see cJ1939Message::setBuffer). One transport frame
+ * is sent per scheduler tick, broadcast packets are spaced by the BAM interval (50-200mS).
+ *
+ * e.g.
+ *   cJ1939TP TP(&J1939);
+ *   UINT8 dm1Buffer[256];
+ *   DM1.pgn = 0xFECA;
+ *   DM1.setBuffer(dm1Buffer, sizeof(dm1Buffer));
+ *   J1939.addMessage(&DM1, RECEIVE);
+ *   ...
+ *   TP.send(0xFECA, J1939_GLOBAL_ADDRESS, dm1, 14);
+ *
+ * @author D.Kasamis - dan@togglebit.net
+ * @version 1.0
+ */
+class cJ1939TP
+{
+public:
+	/**
+	 * constructor, registers the transport messages with the J1939 layer
+	 *
+	 * @param _j1939 - J1939 layer of the CAN port
+	 */
+	cJ1939TP(cJ1939 *_j1939);
+
+	/**
+	 * Send a message longer than 8 bytes
+	 *
+	 * @param pgn  - parameter group number
+	 * @param dest - destination address, J1939_GLOBAL_ADDRESS to broadcast (BAM)
+	 * @param data - message data (copied)
+	 * @param len  - number of bytes, 9 to J1939_TP_MAX_BYTES
+	 * @return - false if no address is claimed, no session is free or a transfer to this destination is already in progress
+	 */
+	bool send(UINT32 pgn, UINT8 dest, const UINT8 *data, UINT16 len);
+
+	/**
+	 * Check if a transfer to a destination is in progress
+	 *
+	 * @param dest - destination address, J1939_GLOBAL_ADDRESS for a broadcast
+	 * @return - true if the transfer is still in progress
+	 */
+	bool isBusy(UINT8 dest);
+
+	/**
+	 * Set the time between broadcast packets
+	 *
+	 * @param ms - J1939_TP_BAM_MIN_MS to J1939_TP_BAM_MAX_MS
+	 */
+	void setBAMInterval(UINT16 ms);
+
+	/**
+	 * Retrieve the counters (rolling): messages received and sent, transfers aborted (by either side), timeouts,
+	 * transfers refused because no session was free
+	 */
+	UINT32 getRxCtr();
+	UINT32 getTxCtr();
+	UINT32 getAbortCtr();
+	UINT32 getTimeoutCtr();
+	UINT32 getBusyCtr();
+
+	/**
+	 * this handler is called when a TP.CM or TP.DT frame is received
+	 *
+	 * @param M - transport message that received the frame (source and destination)
+	 * @param d - frame data
+	 */
+	void receiveFrame(cJ1939Message *M, const UINT8 *d);
+
+	/**
+	 * this handler is called by the scheduler on every tick
+	 *
+	 * @param M - transport message to fill in
+	 * @return - bool transmit the frame
+	 */
+	bool requestFrame(cJ1939Message *M);
+
+	/**
+	 * this handler is called by the scheduler on every tick, also while no address is claimed (nothing can be sent
+	 * then), so that sessions always time out and go back to the pool
+	 *
+	 * @param claimed - an address is claimed
+	 */
+	void checkTimeouts(bool claimed);
+
+private:
+	cJ1939 *j1939;
+
+	/**
+	 * connection management and data transfer receive messages, transmit message
+	 */
+	cJ1939TPRxMsg CMMsg;
+	cJ1939TPRxMsg DTMsg;
+	cJ1939TPTxMsg TxMsg;
+
+	/**
+	 * session pool, the next session to look at when sending (round robin)
+	 */
+	sJ1939TPSession sessions[J1939_TP_SESSIONS];
+	UINT8  rrIndex;
+
+	/**
+	 * abort for a transfer we could not open a session for
+	 */
+	UINT8  abortPending;
+	UINT8  abortRemote;
+	UINT32 abortPGN;
+
+	/**
+	 * time between broadcast packets (mS)
+	 */
+	UINT16 bamMs;
+
+	/**
+	 * counters
+	 */
+	UINT32 rxCtr;
+	UINT32 txCtr;
+	UINT32 abortCtr;
+	UINT32 timeoutCtr;
+	UINT32 busyCtr;
+
+	/**
+	 * Find the session in a state (or range of states) with a node
+	 *
+	 * @param first  - first state
+	 * @param last   - last state
+	 * @param remote - address of the other node
+	 * @return - pointer to the session, NULL if there is none
+	 */
+	sJ1939TPSession* find(J1939_TP_STATE first, J1939_TP_STATE last, UINT8 remote);
+
+	/**
+	 * Take a free session from the pool
+	 *
+	 * @return - pointer to the session, NULL if the pool is empty
+	 */
+	sJ1939TPSession* allocate();
+
+	/**
+	 * Handle a connection management frame
+	 *
+	 * @param sa - source address
+	 * @param da - destination address
+	 * @param d  - frame data
+	 */
+	void receiveCM(UINT8 sa, UINT8 da, const UINT8 *d);
+
+	/**
+	 * Handle a data transfer frame
+	 *
+	 * @param sa - source address
+	 * @param da - destination address
+	 * @param d  - frame data
+	 */
+	void receiveDT(UINT8 sa, UINT8 da, const UINT8 *d);
+
+	/**
+	 * Grant the next clear to send window of a receive session
+	 *
+	 * @param S - session
+	 */
+	void grant(sJ1939TPSession *S);
+
+	/**
+	 * Check the timeouts of a session
+	 *
+	 * @param S       - session
+	 * @param now     - current time (millis)
+	 * @param claimed - an address is claimed, else a timed out session is freed without an abort
+	 */
+	void checkTimeout(sJ1939TPSession *S, UINT32 now, bool claimed);
+
+	/**
+	 * Fill in the connection management frame of a session (or the pending abort) and move the session on
+	 *
+	 * @param M - transport message to fill in
+	 * @param S - session, NULL for the pending abort
+	 */
+	void buildCM(cJ1939Message *M, sJ1939TPSession *S);
+};
+
+#endif
@@ -52,16 +52,11 @@ cOBDParameter:: cOBDParameter (char _name[STR_LNGTH],
 							   cAcquireCAN *_portNum,
                                bool _extended)
 {
-	UINT8 strSize,i;
-
 	//set simple members, name, units etc
 
 	//copy strings
-	for (i=0; i < STR_LNGTH; i++)
-	{
-		name[i]  = _name[i];
-		units[i] = _units[i];
-	}
+	copyString(name,  _name);
+	copyString(units, _units);
 
 	//set parameter ID
 	pid = _pid;
@@ -69,13 +64,105 @@ cOBDParameter:: cOBDParameter (char _name[STR_LNGTH],
 	//set OBD data size
 	size = _size;
 
-	//set OBD mode
-	dataMode = _mode;
-
 	//set default slope and offset
 	m =  _slope;
 	b =  _offset;
 
+	//set sign
+	sign = _signed;
+
+	//conversion is user defined (m*x+b), not from the catalogue
+	info = NULL;
+
+	//pre-convert the slope and offset for the fixed point path
+	fixedScale.set(m, b, OBD_FIXED_DECIMALS);
+
+	//set up the request/response frames
+	init(_mode, _portNum, _extended);
+}
+
+/**
+ * This is the constructor for an OBD parameter that is in the built-in mode 01 PID catalogue. The name, units, size 
+ * and conversion to engineering units are all taken from the catalogue.
+ * 
+ * @param _pid     -  parameter ID number
+ * @param _mode    -  this is the OBD mode of data we have requested (as provided by the standard) current data, freeze, etc,
+ * @param _portNum -  physical CAN port to be used for this OBD parameter
+ * @param _extended-  indicate we are using OBD2 extended ID's
+ */
+cOBDParameter:: cOBDParameter (OBD_PID _pid,
+							   OBD_MODE_REQ _mode,
+							   cAcquireCAN *_portNum,
+                               bool _extended)
+{
+	//look up this PID in the catalogue
+	info = getOBDPIDInfo((UINT8)_pid);
+
+	//set parameter ID
+	pid = _pid;
+
+	//name, units and size come from the catalogue
+	copyString(name,  info ? info->name  : "PID ");
+	copyString(units, info ? info->units : "");
+
+	if (!info || (info->bytes > 2))
+	{
+		size = _32BITS;
+	} else
+	{
+		size = (info->bytes == 2) ? _16BITS : _8BITS;
+	}
+
+	//unused with the catalogue, raw counts if the PID is not in the catalogue
+	m    = 1;
+	b    = 0;
+	sign = info ? info->isSigned : false;
+
+	//pre-convert the slope and offset for the fixed point path
+	setFixedDecimals(OBD_FIXED_DECIMALS);
+
+	//set up the request/response frames
+	init(_mode, _portNum, _extended);
+}
+
+/**
+ * Common initialization for all OBD parameters, set up the request frame and register with the shared response handler
+ * 
+ * @param _mode    -  this is the OBD mode of data we have requested (as provided by the standard) current data, freeze, etc,
+ * @param _portNum -  physical CAN port to be used for this OBD parameter
+ * @param _extended-  indicate we are using OBD2 extended ID's
+ */
+void cOBDParameter::init(OBD_MODE_REQ _mode, cAcquireCAN *_portNum, bool _extended)
+{
+	UINT8 i;
+
+	//set OBD mode
+	dataMode = _mode;
+
+	//nothing received yet, by default only keep the most recent response from any ECU
+	responderID = 0;
+	perECU      = false;
+	numECUs     = 0;
+
+	//start off with functional requests until we know which ECU responds
+	physicalRespID   = 0;
+	physAllowed      = true;
+	multiECU         = false;
+	awaitingResponse = false;
+	missedResponses  = 0;
+	requestCtr       = 0;
+	responseCtr      = 0;
+
+	//request on every turn until the ECU tells us otherwise
+	status           = PID_ACTIVE;
+	backoffExp       = 0;
+	skipCount        = 0;
+	timeoutCtr       = 0;
+	negativeCtr      = 0;
+	lastNRC          = NRC_NONE;
+	requestTime      = 0;
+	retryCtr         = 0;
+
 	//assign scheduler (set port number)
 	portNum = _portNum;
 
@@ -96,14 +183,21 @@ cOBDParameter:: cOBDParameter (char _name[STR_LNGTH],
 	//
 	//							   | add bytes (2) | mode | PID  |  value[0] (0x55 = NA) |  value[1]  |   value[2]  |  value[3]  |   NA  |
 	//
+	//freeze frame (mode 02) requests also carry the freeze frame number:
 	//
-	//NOTE: for transmisison requests now we are going to use the main broadcast message to speak to all ECU's 0x7DF
+	//							   | add bytes (3) | mode | PID  |  frame  |  0x55 ...
 	//
-	TXFrame.ID   	 = _extended ? 0x18DB33F1 : 0x7DF;
-    TXFrame.U.b[0]   = 2;
+	//NOTE: requests start out on the main broadcast message to speak to all ECU's 0x7DF, once a single ECU is known to respond
+	//the request is sent to that ECU only 0x7E0-0x7E7 (or 0x18DAxxF1), see requestFrame()
+	//
+	functionalID     = _extended ? 0x18DB33F1 : 0x7DF;
+	TXFrame.ID   	 = functionalID;
+	TXFrame.parent   = this;
+	freezeFrame      = 0;
+    TXFrame.U.b[0]   = (dataMode == FREEZE) ? 3 : 2;
     TXFrame.U.b[1]   = (UINT8)dataMode;
 	TXFrame.U.b[2]   = (UINT8)pid;
-	TXFrame.U.b[3]   = 0x55;                            
+	TXFrame.U.b[3]   = (dataMode == FREEZE) ? freezeFrame : 0x55;                            
 	TXFrame.U.P.upperPayload = 0x55555555;
 
 	//add message to acquisition list in associated acquire class.
@@ -118,24 +212,29 @@ cOBDParameter:: cOBDParameter (char _name[STR_LNGTH],
 	//
 	//							   | add bytes | mode & 0x40 (ack) | PID |  value[0] |  value[1]  |   value[2]  |  value[3]  |   NA  |
 	//
-	//NOTE: for now we are going to assume the main ECU response 0x7E8
+	//NOTE: all parameters on a port share one response handler that accepts the response from any ECU, 0x7E8-0x7EF for 11bit 
+	//or 0x18DAF1xx for 29bit (where xx is the source address of the ECU)
 	//
-	RXFrame.ID   	 = _extended ? 0x18DAF10E : 0x7E8;  
-    RXFrame.U.b[0]   = (UINT8)size;
-    RXFrame.U.b[1]   = (UINT8)dataMode;
-	RXFrame.U.b[2]   = (UINT8)pid;
-	RXFrame.U.b[3]   = 0x00;
-
-	//(we have not received anything, so really the payload irrelevant)
-	RXFrame.U.P.upperPayload = 0x00000000;
 
-	//add message to acquisition list for periodic reception in the acquire class
-	portNum->addMessage(&RXFrame, RECEIVE);
+	//(we have not received anything, so really the data is irrelevant)
+	for (i=0; i < OBD_MAX_DATA; i++)
+	{
+		data[i] = 0;
+	}
 
+	//add message to static list of all OBDMessages created, and to the dispatch table of the response handler for this port
+	RXHandler = NULL;
+	if (listIdx < MAX_NUM_PIDS)
+	{
+		OBDList[listIdx] = this;
+		listIdx += 1;
 
-	//add message to static list of all OBDMessages created
-	OBDList[listIdx] = this;
-	listIdx = listIdx < MAX_NUM_PIDS ? listIdx +1 : MAX_NUM_PIDS;
+		RXHandler = cOBDRXFrame::getHandler(portNum, _extended);
+		if (RXHandler)
+		{
+			RXHandler->pidMap[(dataMode == FREEZE) ? 1 : 0][(UINT8)pid] = listIdx;
+		}
+	}
 }
 
 
@@ -146,28 +245,50 @@ cOBDParameter:: cOBDParameter (char _name[STR_LNGTH],
  * @return UINT32 - integer that represents OBD message data (no scaling or sign applied)
  */
 UINT32 cOBDParameter::getIntData()
+{
+	return(parseIntData(data));
+}
+
+/**
+ * Same as getIntData() but for the value last reported by a particular ECU (requires per-ECU values, see setPerECU)
+ * 
+ * @param ecu - index of the responding ECU (0 to getNumECUs() - 1)
+ * @return UINT32 - integer that represents OBD message data (no scaling or sign applied)
+ */
+UINT32 cOBDParameter::getIntData(UINT8 ecu)
+{
+	return(ecu < numECUs ? parseIntData(ecuData[ecu]) : 0);
+}
+
+/**
+ * This method converts the raw value bytes of a response to an integer based upon 8,16,32bit message sizes
+ * 
+ * @param d - pointer to the first value byte of the response
+ * @return UINT32 - integer that represents OBD message data (no scaling or sign applied)
+ */
+UINT32 cOBDParameter::parseIntData(UINT8 *d)
 {
 
 	//temp  value used for parsing out packet
-	UINT32 uValue;
+	UINT32 uValue = 0;
 
 	switch (size)
 	{
 		case _8BITS:
 			{
-				uValue = RXFrame.U.b[3];
+				uValue = d[0];
 			}
 			break;
 
 		case _16BITS:
 			{
-				uValue =  (UINT32)(( RXFrame.U.b[3] << 8) |  RXFrame.U.b[4]);
+				uValue =  (UINT32)(( d[0] << 8) |  d[1]);
 			}
 			break;
 		
 		case _32BITS:
 		  {
-			  uValue =  (UINT32)(( RXFrame.U.b[3] << 24) | ( RXFrame.U.b[4] << 16) | ( RXFrame.U.b[5] << 8) | RXFrame.U.b[6]); 
+			  uValue =  (UINT32)(( d[0] << 24) | ( d[1] << 16) | ( d[2] << 8) | d[3]); 
 		  }
 			break;
 	}
@@ -186,11 +307,16 @@ float cOBDParameter::getData()
 {
 	float retVal;
 
-	//NOTE: the implementation of the sign bit here needs to be evaluated against the OBDII spec
+	//PID's from the catalogue use the exact conversion for that PID
+	if (info)
+	{
+		return(info->decode(data, 0));
+	}
+
 	if (sign)
 	{
 		//normalize data based on slope, offset
-		retVal =  ((SINT32)getIntData() * m) + b;
+		retVal =  (signExtend(getIntData()) * m) + b;
 	} else
 	{
 		//normalize data based on slope, offset
@@ -200,62 +326,905 @@ float cOBDParameter::getData()
 	return(retVal);
 }
 
+/**
+ * Same as getData() but for the value last reported by a particular ECU (requires per-ECU values, see setPerECU)
+ * 
+ * @param ecu - index of the responding ECU (0 to getNumECUs() - 1)
+ * @return float - floating point result representing OBD parameter in EU
+ */
+float cOBDParameter::getData(UINT8 ecu)
+{
+	float retVal;
+
+	//PID's from the catalogue use the exact conversion for that PID
+	if (info)
+	{
+		return(ecu < numECUs ? info->decode(ecuData[ecu], 0) : 0);
+	}
+
+	if (sign)
+	{
+		retVal =  (signExtend(getIntData(ecu)) * m) + b;
+	} else
+	{
+		retVal =  ((UINT32)getIntData(ecu) * m) + b;
+	}
+
+	return(retVal);
+}
 
 /**
- * Retrieve the string name for a particular parameter ID
- *
- * @return char* - String representing parameter name
+ * This function is responsible for producing fixed point engineering unit data (EU) without any floating point math. 
+ * The slope and offset have been pre-converted (see setFixedDecimals).
+ * 
+ * @return SINT32 - engineering units * 10^decimals, raw integer value if the PID has no linear conversion
  */
-char* cOBDParameter::getName()
+SINT32 cOBDParameter::getDataFixed()
 {
-	return(name);
+	return(fixedScale.convert(sign ? signExtend(getIntData()) : (SINT32)getIntData()));
 }
 
 /**
- * Retrieve the string units for a particular parameter ID
- *
- * @return char* - String representing parameter units
+ * Same as getDataFixed() but for the value last reported by a particular ECU (requires per-ECU values, see setPerECU)
+ * 
+ * @param ecu - index of the responding ECU (0 to getNumECUs() - 1)
+ * @return SINT32 - engineering units * 10^decimals
  */
-char* cOBDParameter::getUnits()
+SINT32 cOBDParameter::getDataFixed(UINT8 ecu)
 {
+	return(fixedScale.convert(sign ? signExtend(getIntData(ecu)) : (SINT32)getIntData(ecu)));
+}
 
-	return(units);
+/**
+ * Set the number of decimal places returned by getDataFixed(), this re-converts the slope and offset.
+ * PID's from the catalogue use the linear conversion from the catalogue (raw counts if there is none).
+ * 
+ * @param decimals - result of getDataFixed() = EU * 10^decimals
+ */
+void cOBDParameter::setFixedDecimals(UINT8 decimals)
+{
+	if (!info)
+	{
+		fixedScale.set(m, b, decimals);
+
+	} else if (info->slope != 0)
+	{
+		fixedScale.set(info->slope, info->offset, decimals);
+
+	} else
+	{
+		//no linear conversion for this PID, raw counts
+		fixedScale.set(1, 0, 0);
+	}
 }
 
 /**
- * This is a overridden implementaiton of the base class member that is called by the acquisition scheduler when a receive message matching this CAN ID has been received.
- * This is designed for higher-layer protocols that might use a single CAN ID to transmit multiple channels/messages (OBD2).
- * We are checking to see if this was the response to our request.
- *
- * @param R      *R - pointer to RX Frame
- *               
- * @return - a flag to accept or reject this CAN frame
+ * This method sign extends a raw integer value based upon the 8,16,32bit message size
+ * 
+ * @param raw - raw integer value from parseIntData()
+ * @return SINT32 - signed integer value
  */
-bool cOBDRXFrame::CallbackRx(RX_CAN_FRAME *R)
+SINT32 cOBDParameter::signExtend(UINT32 raw)
 {
-	bool retVal = false;
-	if (R)
+	SINT32 retVal;
+
+	switch (size)
+	{
+		case _8BITS:
+			retVal = (signed char)raw;
+			break;
+
+		case _16BITS:
+			retVal = (short)raw;
+			break;
+
+		default:
+			retVal = (SINT32)raw;
+			break;
+	}
+
+	return(retVal);
+}
+
+/**
+ * Retrieve one of the values of a PID that returns more than one value (e.g. O2 sensor voltage and fuel trim).
+ * Only PID's from the built-in catalogue support this.
+ * 
+ * @param idx - which value (0 to getNumValues() - 1)
+ * @return float - floating point result representing the value in EU
+ */
+float cOBDParameter::getValue(UINT8 idx)
+{
+	return((info && (idx < info->numValues)) ? info->decode(data, idx) : getData());
+}
+
+/**
+ * Retrieve the number of values returned by this PID
+ * 
+ * @return - number of values (1 for most PID's)
+ */
+UINT8 cOBDParameter::getNumValues()
+{
+	return(info ? info->numValues : 1);
+}
+
+/**
+ * Copy a null terminated string into a name/units member, truncating it if it is too long
+ * 
+ * @param dest - destination string (STR_LNGTH chars)
+ * @param src  - null terminated source string
+ */
+void cOBDParameter::copyString(char *dest, const char *src)
+{
+	UINT8 i;
+
+	for (i=0; (i < STR_LNGTH - 1) && src[i]; i++)
+	{
+		dest[i] = src[i];
+	}
+	dest[i] = 0;
+}
+
+/**
+ * Enable/disable keeping a separate copy of the data for every ECU that responds to this PID.
+ * 
+ * @param enable - true to keep per-ECU values
+ */
+void cOBDParameter::setPerECU(bool enable)
+{
+	perECU  = enable;
+	numECUs = 0;
+}
+
+/**
+ * Retrieve the CAN ID of the ECU that supplied the most recent value
+ * 
+ * @return - response CAN ID, 0 if nothing has been received yet
+ */
+UINT32 cOBDParameter::getResponderID()
+{
+	return(responderID);
+}
+
+/**
+ * Retrieve the number of different ECU's that have responded to this PID (per-ECU values only)
+ * 
+ * @return - number of responding ECU's
+ */
+UINT8 cOBDParameter::getNumECUs()
+{
+	return(numECUs);
+}
+
+/**
+ * Retrieve the response CAN ID of a particular ECU that has responded to this PID
+ * 
+ * @param ecu - index of the responding ECU (0 to getNumECUs() - 1)
+ * @return - response CAN ID of this ECU, 0 if out of range
+ */
+UINT32 cOBDParameter::getECUID(UINT8 ecu)
+{
+	return(ecu < numECUs ? ecuID[ecu] : 0);
+}
+
+/**
+ * This handler is called when a response to this PID has been received from any ECU.
+ * The responding ECU is recorded and, if enabled, a per-ECU copy of the value is kept.
+ * 
+ * @param I - pointer to the received CAN frame
+ * @return -  bool this is the proper response for this PID
+ */
+bool cOBDParameter::receiveFrame(RX_CAN_FRAME *I)
+{
+	UINT8 i;
+	UINT8 vals[OBD_MAX_DATA];
+	UINT8 first = 3;
+
+	//freeze frame responses echo the frame number before the value bytes: | add bytes | 0x42 | PID | frame | value[0]...
+	if (dataMode == FREEZE)
 	{
-		//check contents of raw CAN frame to see if it matches this OBD parameter
-		//we already know that the ID matches, check the data mode (0x40 in most significant nibble is the ack response), check the PID
-		if ((R->data.byte[1] == (0x40 | (0x0F & U.b[1]))) && (R->data.byte[2] == U.b[2]))
+		if (I->data.byte[3] != freezeFrame)
 		{
-			retVal = true;
+			return(false);
+		}
+		first = 4;
+	}
+
+	//value bytes of this response
+	for (i=0; i < OBD_MAX_DATA; i++)
+	{
+		vals[i] = ((first + i) < 8) ? I->data.byte[first + i] : 0;
+	}
+
+	//a second ECU answering the same functional request, stay with functional requests
+	if (!physicalRespID && !awaitingResponse && responderID && (responderID != I->id))
+	{
+		multiECU = true;
+	}
+
+	//first answer to the outstanding request, measure the round trip
+	if (awaitingResponse)
+	{
+		latency.add(micros() - requestTime);
+	}
+
+	//request answered, back on every turn of the query schedule
+	awaitingResponse = false;
+	missedResponses  = 0;
+	responseCtr     += 1;
+	backoffExp       = 0;
+	skipCount        = 0;
+	status           = (status == PID_BACKOFF) ? PID_ACTIVE : status;
+
+	//record which ECU supplied this value
+	responderID = I->id;
+
+	//keep the value bytes
+	memcpy(data, vals, OBD_MAX_DATA);
+
+	if (perECU)
+	{
+		//look for this ECU in the list of ECU's that have already responded
+		for (i=0; i < numECUs; i++)
+		{
+			if (ecuID[i] == I->id)
+			{
+				break;
+			}
+		}
+
+		//first response from this ECU, add it to the list (ignore it if the list is full)
+		if ((i == numECUs) && (numECUs < OBD_MAX_ECUS))
+		{
+			ecuID[numECUs] = I->id;
+			numECUs += 1;
+		}
 
+		//we want the values of all ECU's, so physical requests are not an option
+		multiECU = multiECU || (numECUs > 1);
+
+		//keep a copy of the value bytes for this ECU
+		if (i < numECUs)
+		{
+			memcpy(ecuData[i], vals, OBD_MAX_DATA);
 		}
 	}
-	return(retVal);
+
+	return(true);
 }
 
 
 /**
- * This is a overridden implementaiton of the base class member that is called by the acquisition scheduler when a receive message matching this CAN ID has been received.
- * This is designed for higher-layer protocols that might use a single CAN ID to transmit multiple channels/messages (OBD2).
+ * This handler is called by the scheduler just before a request for this PID is transmitted. Once a single ECU 
+ * is known to respond to this PID the request is addressed to that ECU only (physical addressing), this keeps 
+ * all of the other ECU's from processing (and possibly answering) every request. If the ECU stops responding
+ * the requests fall back to the functional (broadcast) ID.
  * 
- * @return - a flag to accept or reject this CAN frame
+ * @return -  bool transmit this request
  */
-bool cOBDTXFrame::CallbackTx()
+bool cOBDParameter::requestFrame()
 {
+	//dropped from the schedule
+	if ((status == PID_DROPPED_NRC) || (status == PID_DROPPED_TIMEOUT) || (status == PID_UNSUPPORTED))
+	{
+		return(false);
+	}
+
+	//was the previous request answered?
+	if (awaitingResponse)
+	{
+		awaitingResponse = false;
+		missedResponses  = (missedResponses < 0xFF) ? missedResponses + 1 : 0xFF;
+		timeoutCtr      += 1;
+
+		//the ECU has stopped answering physical requests, go back to functional requests
+		if (physicalRespID && (missedResponses >= OBD_PHYS_MAX_MISSED))
+		{
+			physicalRespID = 0;
+			multiECU       = false;
+		}
+
+		//nobody answers this PID, stop asking
+		if (missedResponses >= OBD_MAX_TIMEOUTS)
+		{
+			status = PID_DROPPED_TIMEOUT;
+			return(false);
+		}
+
+		backOff();
+	}
+
+	//backing off, give this turn to the next PID in the schedule
+	if (skipCount)
+	{
+		skipCount -= 1;
+		return(false);
+	}
+
+	if (!physicalRespID && physAllowed && !multiECU && responderID)
+	{
+		//only a single ECU answers, address the requests to that ECU
+		physicalRespID = responderID;
+	}
+
+	//address the ECU or broadcast
+	if (physicalRespID)
+	{
+		TXFrame.ID = getOBDRequestID(physicalRespID);
+
+	} else
+	{
+		TXFrame.ID = functionalID;
+	}
+
+	//the previous request for this PID was not answered
+	if (missedResponses)
+	{
+		retryCtr += 1;
+	}
+
+	awaitingResponse = true;
+	requestCtr += 1;
+
+	//negative responses do not carry the PID, let the response handler know who is asking
+	if (RXHandler)
+	{
+		RXHandler->pending = this;
+	}
+
 	return(true);
 }
 
+/**
+ * This handler is called by the scheduler once the request has been loaded into the TX mailbox, the round trip latency
+ * is measured from here so the wait for the mailbox is not counted.
+ * 
+ * @param time - uS (micros()) when the request was handed to the mailbox
+ */
+void cOBDParameter::requestSent(UINT32 time)
+{
+	requestTime = time;
+}
+
+/**
+ * This handler is called when a negative response (0x7F) to a request for this PID has been received.
+ * A PID that the ECU reports as not supported is dropped from the schedule, unless the PID has been answered before
+ * (e.g. a second ECU on a functional request does not support it). All other negative responses (busy, conditions 
+ * not correct) make the PID back off.
+ * A negative response only counts while the request is outstanding and, once an ECU has answered this PID, only from
+ * that ECU: on a functional request another ECU rejecting it says nothing about the ECU that supplies the value.
+ * 
+ * @param nrc    - negative response code
+ * @param respID - CAN ID of the responding ECU
+ */
+void cOBDParameter::negativeResponse(UINT8 nrc, UINT32 respID)
+{
+	//the ECU is still working on it, keep waiting
+	if (nrc == NRC_RESPONSE_PENDING)
+	{
+		return;
+	}
+
+	//already answered, or rejected by an ECU other than the one we track
+	if (!awaitingResponse || (responderID && (respID != responderID)))
+	{
+		return;
+	}
+
+	awaitingResponse = false;
+	negativeCtr     += 1;
+	lastNRC          = nrc;
+
+	if (((nrc == NRC_SERVICE_NOT_SUPPORTED) || (nrc == NRC_SUBFUNCTION_NOT_SUPPORTED) || (nrc == NRC_REQUEST_OUT_OF_RANGE)) && !responseCtr)
+	{
+		status = PID_DROPPED_NRC;
+
+	} else
+	{
+		backOff();
+	}
+}
+
+/**
+ * The request was unanswered or rejected, double the number of query turns skipped before the next request
+ * (1, 3, 7... up to 2^OBD_MAX_BACKOFF_EXP - 1)
+ */
+void cOBDParameter::backOff()
+{
+	if (backoffExp < OBD_MAX_BACKOFF_EXP)
+	{
+		backoffExp += 1;
+	}
+
+	skipCount = (1 << backoffExp) - 1;
+	status    = PID_BACKOFF;
+}
+
+/**
+ * Retrieve the scheduling state of this PID
+ * 
+ * @return - PID_ACTIVE, PID_BACKOFF, PID_DROPPED_NRC or PID_DROPPED_TIMEOUT
+ */
+OBD_PID_STATUS cOBDParameter::getStatus()
+{
+	return(status);
+}
+
+/**
+ * Retrieve the most recent negative response code received for this PID
+ * 
+ * @return - negative response code (see OBD_NRC), NRC_NONE if none has been received
+ */
+UINT8 cOBDParameter::getLastNRC()
+{
+	return(lastNRC);
+}
+
+/**
+ * Retrieve the number of requests for this PID that were not answered (rolling)
+ * 
+ * @return - number of timeouts
+ */
+UINT32 cOBDParameter::getTimeoutCtr()
+{
+	return(timeoutCtr);
+}
+
+/**
+ * Retrieve the number of negative responses received for this PID (rolling)
+ * 
+ * @return - number of negative responses
+ */
+UINT32 cOBDParameter::getNegativeCtr()
+{
+	return(negativeCtr);
+}
+
+/**
+ * Retrieve the number of consecutive requests for this PID that have not been answered
+ * 
+ * @return - number of consecutive timeouts
+ */
+UINT8 cOBDParameter::getConsecutiveTimeouts()
+{
+	return(missedResponses);
+}
+
+/**
+ * Retrieve the number of requests that were sent again after the previous request for this PID was not answered (rolling)
+ * 
+ * @return - number of retries
+ */
+UINT32 cOBDParameter::getRetryCtr()
+{
+	return(retryCtr);
+}
+
+/**
+ * Retrieve the request/response round trip latency statistics of this PID
+ * 
+ * @return - pointer to the latency statistics
+ */
+cOBDLatency* cOBDParameter::getLatency()
+{
+	return(&latency);
+}
+
+/**
+ * Put a backed-off or dropped PID back on the query schedule
+ */
+void cOBDParameter::resetStatus()
+{
+	status           = PID_ACTIVE;
+	backoffExp       = 0;
+	skipCount        = 0;
+	missedResponses  = 0;
+	awaitingResponse = false;
+}
+
+/**
+ * Mark this PID as (not) supported by the vehicle
+ * 
+ * @param supported - false to take the PID off the schedule, true to put it back
+ */
+void cOBDParameter::setSupported(bool supported)
+{
+	if (!supported)
+	{
+		status = PID_UNSUPPORTED;
+
+	} else if (status == PID_UNSUPPORTED)
+	{
+		resetStatus();
+	}
+}
+
+/**
+ * Select the freeze frame that is requested (mode 02 only)
+ * 
+ * @param frame - freeze frame number (0 = the frame stored with the first fault)
+ */
+void cOBDParameter::setFreezeFrame(UINT8 frame)
+{
+	freezeFrame = frame;
+
+	if (dataMode == FREEZE)
+	{
+		TXFrame.U.b[3] = frame;
+	}
+}
+
+/**
+ * Retrieve the parameter ID
+ * 
+ * @return - parameter ID
+ */
+OBD_PID cOBDParameter::getPID()
+{
+	return(pid);
+}
+
+/**
+ * Retrieve the OBD mode of the requests
+ * 
+ * @return - current data or freeze frame
+ */
+OBD_MODE_REQ cOBDParameter::getMode()
+{
+	return(dataMode);
+}
+
+/**
+ * Retrieve the acquisition scheduler (physical CAN port) of this parameter
+ * 
+ * @return - pointer to the scheduler
+ */
+cAcquireCAN* cOBDParameter::getPort()
+{
+	return(portNum);
+}
+
+/**
+ * Retrieve the number of OBD parameters created
+ * 
+ * @return - number of parameters
+ */
+UINT8 cOBDParameter::getNumParameters()
+{
+	return(listIdx);
+}
+
+/**
+ * Retrieve one of the OBD parameters created
+ * 
+ * @param idx - parameter index
+ * @return - pointer to the parameter, NULL if idx is out of range
+ */
+cOBDParameter* cOBDParameter::getParameter(UINT8 idx)
+{
+	return((idx < listIdx) ? OBDList[idx] : NULL);
+}
+
+/**
+ * Enable/disable automatic physical (ECU addressed) requests, enabled by default
+ * 
+ * @param enable - true to allow physical requests once the responding ECU is known
+ */
+void cOBDParameter::setPhysicalAddressing(bool enable)
+{
+	physAllowed = enable;
+
+	if (!enable)
+	{
+		physicalRespID = 0;
+	}
+}
+
+/**
+ * Check if requests are currently addressed to a single ECU
+ * 
+ * @return - true for physical requests, false for functional (broadcast) requests
+ */
+bool cOBDParameter::isPhysical()
+{
+	return(physicalRespID != 0);
+}
+
+/**
+ * Retrieve the number of requests transmitted for this PID (rolling)
+ * 
+ * @return - number of requests
+ */
+UINT32 cOBDParameter::getRequestCtr()
+{
+	return(requestCtr);
+}
+
+/**
+ * Retrieve the number of responses received for this PID from all ECU's (rolling)
+ * 
+ * @return - number of responses
+ */
+UINT32 cOBDParameter::getResponseCtr()
+{
+	return(responseCtr);
+}
+
+/**
+ * Retrieve the string name for a particular parameter ID
+ *
+ * @return char* - String representing parameter name
+ */
+char* cOBDParameter::getName()
+{
+	return(name);
+}
+
+/**
+ * Retrieve the string units for a particular parameter ID
+ *
+ * @return char* - String representing parameter units
+ */
+char* cOBDParameter::getUnits()
+{
+
+	return(units);
+}
+
+/**
+ * Find the physical (ECU addressed) request ID for an ECU response ID, 0x7E8+n -> 0x7E0+n, 0x18DAF1xx -> 0x18DAxxF1 
+ * 
+ * @param responseID - response CAN ID of the ECU
+ * @return - request CAN ID of the ECU
+ */
+UINT32 getOBDRequestID(UINT32 responseID)
+{
+	return((responseID > 0x7FF) ? (0x18DA00F1 | ((responseID & 0xFF) << 8)) : responseID - 8);
+}
+
+/**
+ * Find the shared response handler for a port/addressing combination. The handler is created and registered with the 
+ * acquisition scheduler the first time it is requested.
+ * NOTE: the handlers are a function static so they are constructed on first use, this allows OBD parameters to be 
+ * global objects in the sketch (no dependence on the order that global objects are constructed in)
+ * 
+ * @param _portNum  - acquisition scheduler (physical CAN port)
+ * @param _extended - 29bit OBD2 ID's
+ * @return - pointer to the shared response handler, NULL if all handlers are in use
+ */
+cOBDRXFrame* cOBDRXFrame::getHandler(cAcquireCAN *_portNum, bool _extended)
+{
+	static cOBDRXFrame handlers[OBD_MAX_RX_HANDLERS];
+	static UINT8 numHandlers = 0;
+	cOBDRXFrame *H = NULL;
+	UINT8 i;
+
+	//look for an existing handler
+	for (i=0; i < numHandlers; i++)
+	{
+		if ((handlers[i].portNum == _portNum) && (handlers[i].extended == _extended))
+		{
+			H = &handlers[i];
+		}
+	}
+
+	//first parameter on this port, create the handler
+	if (!H && (numHandlers < OBD_MAX_RX_HANDLERS))
+	{
+		H = &handlers[numHandlers];
+		numHandlers += 1;
+
+		H->portNum  = _portNum;
+		H->extended = _extended;
+		H->pending  = NULL;
+		memset(H->pidMap, 0, sizeof(H->pidMap));
+
+		//accept the response from any ECU, 0x7E8-0x7EF for 11bit or 0x18DAF1xx for 29bit
+		H->ID   = _extended ? 0x18DAF100 : 0x7E8;  
+		H->mask = _extended ? 0x1FFFFF00 : 0x7F8;
+
+		//add message to acquisition list for periodic reception in the acquire class
+		_portNum->addMessage(H, RECEIVE);
+	}
+
+	return(H);
+}
+
+/**
+ * This is a overridden implementaiton of the base class member that is called by the acquisition scheduler when a receive message matching this CAN ID has been received.
+ * This is designed for higher-layer protocols that might use a single CAN ID to transmit multiple channels/messages (OBD2).
+ * The response is routed directly to the OBD parameter by mode and PID, so the cost per frame does not depend upon the number of PID's.
+ *
+ * @param R      *R - pointer to RX Frame
+ *               
+ * @return - a flag to accept or reject this CAN frame
+ */
+bool cOBDRXFrame::CallbackRx(RX_CAN_FRAME *R)
+{
+	bool retVal = false;
+	UINT8 idx = 0;
+
+	if (R)
+	{
+		//we already know that the ID is one of the ECU response ID's, PID values are always single frame responses (ISO-TP 
+		//first/consecutive frames belong to multi-frame readers e.g. DTC's)
+		if ((R->data.byte[0] & 0xF0) != 0)
+		{
+			//not a single frame
+
+		//check the data mode (0x40 in most significant nibble is the ack response) then look up the parameter for this PID
+		} else if (R->data.byte[1] == (0x40 | CURRENT))
+		{
+			idx = pidMap[0][R->data.byte[2]];
+
+		} else if (R->data.byte[1] == (0x40 | FREEZE))
+		{
+			idx = pidMap[1][R->data.byte[2]];
+
+		} else if ((R->data.byte[1] == 0x7F) && pending && (R->data.byte[2] == (UINT8)pending->dataMode))
+		{
+			//negative response: | 0x03 | 0x7F | requested mode | NRC |, this is the answer to the most recent request
+			pending->negativeResponse(R->data.byte[3], R->id);
+			retVal = true;
+		}
+
+		//let the parameter know which ECU responded
+		if (idx)
+		{
+			retVal = cOBDParameter::OBDList[idx - 1]->receiveFrame(R);
+		}
+	}
+	return(retVal);
+}
+
+
+/**
+ * This is a overridden implementaiton of the base class member that is called by the acquisition scheduler when a receive message matching this CAN ID has been received.
+ * This is designed for higher-layer protocols that might use a single CAN ID to transmit multiple channels/messages (OBD2).
+ * 
+ * @return - a flag to accept or reject this CAN frame
+ */
+bool cOBDTXFrame::CallbackTx()
+{
+	//let the parameter choose functional or physical addressing
+	return(parent->requestFrame());
+}
+
+/**
+ * This handler is called by the scheduler once the request has been loaded into the TX mailbox
+ * 
+ * @param time - uS (micros()) when the request was handed to the mailbox
+ */
+void cOBDTXFrame::CallbackSent(UINT32 time)
+{
+	parent->requestSent(time);
+}
+
+
+
+/**
+ * constructor, no measurements
+ */
+cOBDLatency::cOBDLatency()
+{
+	reset();
+}
+
+/**
+ * Clear all measurements
+ */
+void cOBDLatency::reset()
+{
+	count = 0;
+	minUs = 0xFFFFFFFF;
+	maxUs = 0;
+	sumUs = 0;
+	memset(bins, 0, sizeof(bins));
+}
+
+/**
+ * Add one round trip measurement
+ * 
+ * @param us - round trip time in microseconds
+ */
+void cOBDLatency::add(UINT32 us)
+{
+	UINT32 bin = us / OBD_RTT_BIN_US;
+	UINT8 i;
+
+	bin = (bin < OBD_RTT_BINS) ? bin : OBD_RTT_BINS - 1;
+
+	//keep the shape of the distribution rather than saturating a bin
+	if (bins[bin] == 0xFFFF)
+	{
+		for (i=0; i < OBD_RTT_BINS; i++)
+		{
+			bins[i] >>= 1;
+		}
+	}
+
+	bins[bin] += 1;
+	count     += 1;
+	sumUs     += us;
+	minUs      = (us < minUs) ? us : minUs;
+	maxUs      = (us > maxUs) ? us : maxUs;
+}
+
+/**
+ * Retrieve the number of round trips measured
+ * 
+ * @return - number of measurements (rolling)
+ */
+UINT32 cOBDLatency::getCount()
+{
+	return(count);
+}
+
+/**
+ * Retrieve the shortest round trip
+ * 
+ * @return - round trip time in microseconds, 0 if nothing has been measured
+ */
+UINT32 cOBDLatency::getMin()
+{
+	return(count ? minUs : 0);
+}
+
+/**
+ * Retrieve the longest round trip
+ * 
+ * @return - round trip time in microseconds, 0 if nothing has been measured
+ */
+UINT32 cOBDLatency::getMax()
+{
+	return(maxUs);
+}
+
+/**
+ * Retrieve the average round trip
+ * 
+ * @return - round trip time in microseconds, 0 if nothing has been measured
+ */
+UINT32 cOBDLatency::getMean()
+{
+	return(count ? (UINT32)(sumUs / count) : 0);
+}
+
+/**
+ * Retrieve a percentile of the round trip time from the histogram
+ * 
+ * @param pct - percentile (1-100)
+ * @return - round trip time in microseconds (upper edge of the bin), 0 if nothing has been measured
+ */
+UINT32 cOBDLatency::getPercentile(UINT8 pct)
+{
+	UINT32 total = 0, target, sum = 0, edge;
+	UINT8 i;
+
+	for (i=0; i < OBD_RTT_BINS; i++)
+	{
+		total += bins[i];
+	}
+
+	if (!total)
+	{
+		return(0);
+	}
+
+	//number of measurements at or below the percentile (rounded up)
+	pct    = (pct > 100) ? 100 : pct;
+	target = (total * pct + 99) / 100;
+
+	for (i=0; i < OBD_RTT_BINS - 1; i++)
+	{
+		sum += bins[i];
+		if (sum >= target)
+		{
+			break;
+		}
+	}
+
+	//the last bin is open ended, the longest round trip is the best answer there
+	edge = (UINT32)(i + 1) * OBD_RTT_BIN_US;
+	return((edge < maxUs) ? edge : maxUs);
+}
@@ -16,6 +16,7 @@
 #include "variant.h"
 #include <due_can.h>
 #include <CAN_Acquisition.h>
+#include <CAN_FixedPoint.h>
 
 #ifndef OBD2_H
 #define OBD2_H
@@ -34,21 +35,222 @@
 
 /**
  * 
- * This enum represents the Parameter ID field for a particular signal per OBD2 protocol
+ * This macro is used to set the maximum number of ECU's that can respond to a single OBD2 request (0x7E8-0x7EF)
+ */
+#define	OBD_MAX_ECUS	8
+
+/**
+ * 
+ * This macro is used to set the maximum number of data bytes in a single frame OBD2 response (after mode and PID)
+ */
+#define	OBD_MAX_DATA	5
+
+/**
+ * 
+ * This macro is used to set the default number of decimal places of the fixed point engineering unit conversion (getDataFixed)
+ */
+#define	OBD_FIXED_DECIMALS	2
+
+/**
+ * 
+ * This macro is used to set the number of consecutive unanswered physical (ECU addressed) requests before falling back 
+ * to functional (broadcast) requests
+ */
+#define	OBD_PHYS_MAX_MISSED	3
+
+/**
+ * 
+ * This macro is used to set the number of consecutive unanswered requests before a PID is dropped from the schedule
+ */
+#define	OBD_MAX_TIMEOUTS	8
+
+/**
+ * 
+ * This macro is used to set the maximum back-off exponent, a PID that backs off skips up to 2^OBD_MAX_BACKOFF_EXP - 1 
+ * of its turns in the query schedule before it is requested again
+ */
+#define	OBD_MAX_BACKOFF_EXP	5
+
+/**
+ * 
+ * This enum represents the Parameter ID field for a particular signal per OBD2 protocol (SAE J1979 mode 01)
  */
 enum OBD_PID
 {
+	PIDS_SUPPORTED_01_20        = 0x00,
+	MONITOR_STATUS              = 0x01,
+	FREEZE_DTC                  = 0x02,
+	FUEL_SYSTEM_STATUS          = 0x03,
+	ENGINE_LOAD                 = 0x04,
+	COOLANT_TEMP                = 0x05,
+	STFT_BANK1                  = 0x06,
+	LTFT_BANK1                  = 0x07,
+	STFT_BANK2                  = 0x08,
+	LTFT_BANK2                  = 0x09,
+	FUEL_PRESSURE               = 0x0A,
+	INTAKE_MAP                  = 0x0B,
+	ENGINE_RPM                  = 0x0C,
+	SPEED                       = 0x0D,
+	TIMING_ADVANCE              = 0x0E,
+	ENGINE_IAT                  = 0x0F,
+	ENGINE_MAF                  = 0x10,
+	THROTTLE_POS                = 0x11,
+	SECONDARY_AIR_STATUS        = 0x12,
+	O2_SENSORS_PRESENT          = 0x13,
+	O2_B1S1_VOLTAGE             = 0x14,
+	O2_B1S2_VOLTAGE             = 0x15,
+	O2_B1S3_VOLTAGE             = 0x16,
+	O2_B1S4_VOLTAGE             = 0x17,
+	O2_B2S1_VOLTAGE             = 0x18,
+	O2_B2S2_VOLTAGE             = 0x19,
+	O2_B2S3_VOLTAGE             = 0x1A,
+	O2_B2S4_VOLTAGE             = 0x1B,
+	OBD_STANDARD                = 0x1C,
+	O2_SENSORS_PRESENT_4BANK    = 0x1D,
+	AUX_INPUT_STATUS            = 0x1E,
+	RUN_TIME                    = 0x1F,
+	PIDS_SUPPORTED_21_40        = 0x20,
+	DISTANCE_MIL_ON             = 0x21,
+	FUEL_RAIL_PRESSURE_REL      = 0x22,
+	FUEL_RAIL_PRESSURE_GAUGE    = 0x23,
+	O2_S1_WR_VOLTAGE            = 0x24,
+	O2_S2_WR_VOLTAGE            = 0x25,
+	O2_S3_WR_VOLTAGE            = 0x26,
+	O2_S4_WR_VOLTAGE            = 0x27,
+	O2_S5_WR_VOLTAGE            = 0x28,
+	O2_S6_WR_VOLTAGE            = 0x29,
+	O2_S7_WR_VOLTAGE            = 0x2A,
+	O2_S8_WR_VOLTAGE            = 0x2B,
+	COMMANDED_EGR               = 0x2C,
+	EGR_ERROR                   = 0x2D,
+	COMMANDED_EVAP_PURGE        = 0x2E,
+	FUEL_LEVEL                  = 0x2F,
+	WARMUPS_SINCE_CLEAR         = 0x30,
+	DISTANCE_SINCE_CLEAR        = 0x31,
+	EVAP_VAPOR_PRESSURE         = 0x32,
+	BAROMETRIC_PRESSURE         = 0x33,
+	O2_S1_WR_CURRENT            = 0x34,
+	O2_S2_WR_CURRENT            = 0x35,
+	O2_S3_WR_CURRENT            = 0x36,
+	O2_S4_WR_CURRENT            = 0x37,
+	O2_S5_WR_CURRENT            = 0x38,
+	O2_S6_WR_CURRENT            = 0x39,
+	O2_S7_WR_CURRENT            = 0x3A,
+	O2_S8_WR_CURRENT            = 0x3B,
+	CATALYST_TEMP_B1S1          = 0x3C,
+	CATALYST_TEMP_B2S1          = 0x3D,
+	CATALYST_TEMP_B1S2          = 0x3E,
+	CATALYST_TEMP_B2S2          = 0x3F,
+	PIDS_SUPPORTED_41_60        = 0x40,
+	MONITOR_STATUS_DRIVE_CYCLE  = 0x41,
+	CONTROL_MODULE_VOLTAGE      = 0x42,
+	ABSOLUTE_LOAD               = 0x43,
+	COMMANDED_EQUIV_RATIO       = 0x44,
+	RELATIVE_THROTTLE_POS       = 0x45,
+	AMBIENT_AIR_TEMP            = 0x46,
+	THROTTLE_POS_B              = 0x47,
+	THROTTLE_POS_C              = 0x48,
+	ACCEL_PEDAL_POS_D           = 0x49,
+	ACCEL_PEDAL_POS_E           = 0x4A,
+	ACCEL_PEDAL_POS_F           = 0x4B,
+	COMMANDED_THROTTLE_ACTUATOR = 0x4C,
+	TIME_RUN_MIL_ON             = 0x4D,
+	TIME_SINCE_CLEAR            = 0x4E,
+	MAX_VALUES_EQUIV_O2_MAP     = 0x4F,
+	MAX_MAF                     = 0x50,
+	FUEL_TYPE                   = 0x51,
+	ETHANOL_PERCENT             = 0x52,
+	EVAP_VAPOR_PRESSURE_ABS     = 0x53,
+	EVAP_VAPOR_PRESSURE_ALT     = 0x54,
+	ST_O2_TRIM_B1B3             = 0x55,
+	LT_O2_TRIM_B1B3             = 0x56,
+	ST_O2_TRIM_B2B4             = 0x57,
+	LT_O2_TRIM_B2B4             = 0x58,
+	FUEL_RAIL_PRESSURE_ABS      = 0x59,
+	RELATIVE_ACCEL_PEDAL_POS    = 0x5A,
+	HYBRID_BATTERY_LIFE         = 0x5B,
+	ENGINE_OIL_TEMP             = 0x5C,
+	FUEL_INJECTION_TIMING       = 0x5D,
+	FUEL_FLOW                   = 0x5E,
+	EMISSION_REQUIREMENTS       = 0x5F,
+	PIDS_SUPPORTED_61_80        = 0x60,
+	DEMAND_ENGINE_TORQUE        = 0x61,
+	ACTUAL_ENGINE_TORQUE        = 0x62,
+	ENGINE_REFERENCE_TORQUE     = 0x63,
+	ENGINE_TORQUE_DATA          = 0x64
+};
 
-	ENGINE_LOAD  = 0x04,
-	COOLANT_TEMP = 0x05,
-	ENGINE_RPM   = 0x0C,
-	SPEED        = 0x0D,
-	ENGINE_IAT   = 0x0F,
-	ENGINE_MAF   = 0x10,
-	THROTTLE_POS = 0x11,
-	FUEL_FLOW    = 0x5E
+/**
+ * 
+ * This is the last PID in the built-in catalogue (the catalogue is indexed directly by PID)
+ */
+#define	OBD_PID_CATALOGUE_MAX	ENGINE_TORQUE_DATA
+
+/**
+ * 
+ * This is the decode function for a PID in the catalogue, it converts the response data bytes to engineering units
+ * 
+ * @param A   - pointer to the response data bytes (A = A[0], B = A[1] etc)
+ * @param idx - which value to decode for PID's that return more than one value (0 for single value PID's)
+ * @return engineering unit value. Bit encoded PID's return the raw byte selected by idx.
+ */
+typedef float (*OBD_DECODE_FN)(const UINT8 *A, UINT8 idx);
+
+/**
+ * 
+ * This struct represents one entry in the built-in (flash-resident) SAE J1979 mode 01 PID catalogue
+ */
+struct sOBDPIDInfo
+{
+	/**
+	 * number of data bytes returned by the ECU (A, B, C...)
+	 */
+	UINT8 bytes;
+
+	/**
+	 * number of values decoded from the data bytes (e.g. O2 sensor voltage and fuel trim)
+	 */
+	UINT8 numValues;
+
+	/**
+	 * strings describing the parameter name and engineering units
+	 */
+	const char *name;
+	const char *units;
+
+	/**
+	 * conversion from data bytes to engineering units
+	 */
+	OBD_DECODE_FN decode;
+
+	/**
+	 * linear conversion (Y = mX+b) of the raw integer value, used by the fixed point path. slope = 0 if not linear
+	 */
+	float slope;
+	float offset;
+
+	/**
+	 * flag indicating if the raw value is a signed number
+	 */
+	bool isSigned;
 };
 
+/**
+ * Look up a PID in the built-in catalogue
+ * 
+ * @param pid - mode 01 parameter ID
+ * @return - pointer to the catalogue entry, NULL if the PID is not in the catalogue
+ */
+const sOBDPIDInfo* getOBDPIDInfo(UINT8 pid);
+
+/**
+ * Find the physical (ECU addressed) request ID for an ECU response ID
+ * 
+ * @param responseID - response CAN ID of the ECU, 0x7E8-0x7EF or 0x18DAF1xx
+ * @return - request CAN ID of the ECU, 0x7E0-0x7E7 or 0x18DAxxF1
+ */
+UINT32 getOBDRequestID(UINT32 responseID);
+
 /**
  * 
  * This enum represents the size of the OBD2 signal in bits (8,16,32) per OBD2 protocol
@@ -71,11 +273,152 @@ enum OBD_MODE_REQ
 };
 
 /**
- * this is the receive frame that is used to make the OBD data request to the CAN receiver
+ * 
+ * This macro is used to set the width of one bin of the round trip latency histogram in microseconds
+ */
+#define	OBD_RTT_BIN_US		2000
+
+/**
+ * 
+ * This macro is used to set the number of bins of the round trip latency histogram, round trips longer than 
+ * OBD_RTT_BINS * OBD_RTT_BIN_US go into the last bin
+ */
+#define	OBD_RTT_BINS		50
+
+/**
+ * Request/response round trip latency statistics (min, mean, max and percentiles from a fixed bin histogram).
+ * 
+ * @author D.Kasamis - dan@togglebit.net
+ * @version 1.0
+ */
+class cOBDLatency
+{
+public:
+	cOBDLatency();
+
+	/**
+	 * Add one round trip measurement
+	 * 
+	 * @param us - round trip time in microseconds
+	 */
+	void add(UINT32 us);
+
+	/**
+	 * Clear all measurements
+	 */
+	void reset();
+
+	/**
+	 * Retrieve the number of round trips measured
+	 * 
+	 * @return - number of measurements (rolling)
+	 */
+	UINT32 getCount();
+
+	/**
+	 * Retrieve the shortest, longest and average round trip
+	 * 
+	 * @return - round trip time in microseconds, 0 if nothing has been measured
+	 */
+	UINT32 getMin();
+	UINT32 getMax();
+	UINT32 getMean();
+
+	/**
+	 * Retrieve a percentile of the round trip time from the histogram (e.g. 99 for p99). The result is the upper edge of
+	 * the histogram bin (resolution OBD_RTT_BIN_US), limited to the longest round trip measured.
+	 * 
+	 * @param pct - percentile (1-100)
+	 * @return - round trip time in microseconds, 0 if nothing has been measured
+	 */
+	UINT32 getPercentile(UINT8 pct);
+
+private:
+	UINT32 count;
+	UINT32 minUs;
+	UINT32 maxUs;
+
+	/**
+	 * sum of all round trips in microseconds (64 bit so the mean does not overflow on long runs)
+	 */
+	unsigned long long sumUs;
+
+	/**
+	 * histogram bins, all bins are halved when one is about to overflow so the distribution is kept
+	 */
+	UINT16 bins[OBD_RTT_BINS];
+};
+
+/**
+ * 
+ * This enum represents the scheduling state of an OBD2 parameter (see getStatus)
+ */
+enum OBD_PID_STATUS
+{
+	PID_ACTIVE          = 0,	//requested on every turn in the query schedule
+	PID_BACKOFF         = 1,	//unanswered or rejected (busy), skipping turns in the query schedule
+	PID_DROPPED_NRC     = 2,	//rejected with a negative response code (not supported), no longer requested
+	PID_DROPPED_TIMEOUT = 3,	//OBD_MAX_TIMEOUTS consecutive requests unanswered, no longer requested
+	PID_UNSUPPORTED     = 4		//not in the ECU's supported PID bitmap (see cOBDVehicleInfo), not requested
+};
+
+/**
+ * 
+ * This enum represents the negative response codes (ISO 14229/15031-5) that are handled by the OBD layer
+ */
+enum OBD_NRC
+{
+	NRC_NONE                     = 0x00,
+	NRC_GENERAL_REJECT           = 0x10,
+	NRC_SERVICE_NOT_SUPPORTED    = 0x11,
+	NRC_SUBFUNCTION_NOT_SUPPORTED= 0x12,
+	NRC_BUSY_REPEAT_REQUEST      = 0x21,
+	NRC_CONDITIONS_NOT_CORRECT   = 0x22,
+	NRC_REQUEST_OUT_OF_RANGE     = 0x31,
+	NRC_RESPONSE_PENDING         = 0x78
+};
+
+/**
+ * 
+ * This macro is used to set the maximum number of shared OBD2 response handlers (one per CAN port and 11/29bit addressing)
+ */
+#define	OBD_MAX_RX_HANDLERS	4
+
+/**
+ * this is the receive frame that is shared by all OBD parameters on a CAN port to receive the OBD data responses.
+ * Only one of these is registered with the acquisition scheduler per port (and 11/29bit addressing), the responses 
+ * are then routed to the correct OBD parameter by mode and PID through a direct lookup table.
  * inheriting this class allows us to implement the RX callback function at the top layer
  */
 class cOBDRXFrame : public cCANFrame
 {
+public:
+	/**
+	 * find the response handler for a port/addressing combination, one is created and registered the first time it is requested
+	 * 
+	 * @param _portNum  - acquisition scheduler (physical CAN port)
+	 * @param _extended - 29bit OBD2 ID's
+	 * @return - pointer to the shared response handler, NULL if all handlers are in use
+	 */
+	static cOBDRXFrame* getHandler(cAcquireCAN *_portNum, bool _extended);
+
+	/**
+	 * dispatch table, for each OBD mode (current, freeze) and PID this holds the OBDList index + 1 of the parameter (0 = no parameter)
+	 */
+	UINT8 pidMap[2][256];
+
+	/**
+	 * the parameter that made the most recent request on this port, negative responses (0x7F) do not carry the PID
+	 * so they are attributed to this parameter
+	 */
+	cOBDParameter *pending;
+
+private:
+	/**
+	 * acquisition scheduler and addressing this handler was created for
+	 */
+	cAcquireCAN *portNum;
+	bool extended;
 
 	bool  CallbackRx(RX_CAN_FRAME *R);
 };
@@ -85,8 +428,15 @@ class cOBDRXFrame : public cCANFrame
  */
 class cOBDTXFrame : public cCANFrame
 {
+public:
+	/**
+	 * OBD parameter that owns this frame, sets the request ID (functional or physical) before each request
+	 */
+	cOBDParameter *parent;
 
+private:
 	bool  CallbackTx();
+	void  CallbackSent(UINT32 time);
 };
 
 
@@ -129,6 +479,19 @@ public:
 				   float _offset,
 				   cAcquireCAN *_portNum,
                    bool _extended);
+	/**
+	* This is the constructor for an OBD parameter that is in the built-in mode 01 PID catalogue (see getOBDPIDInfo).
+	* The name, units, size and conversion to engineering units are all taken from the catalogue.
+	* 
+	* @param _pid     -  parameter ID number
+	* @param _mode    -  this is the OBD mode of data we have requested (as provided by the standard) current data, freeze, etc,
+	* @param _portNum -  physical CAN port to be used for this OBD parameter
+	* @param _extended-  indicate we are using OBD2 extended ID's
+	*/
+	cOBDParameter (OBD_PID _pid,
+				   OBD_MODE_REQ _mode,
+				   cAcquireCAN *_portNum,
+                   bool _extended);
 	/**
 	 * Retreive OBD2 signal data in floating point engineering units. Note the floating point/EU conversion only occurs
 	 * when this method is called
@@ -136,6 +499,34 @@ public:
 	 * @return floating point engineering unit representation of OBD2 signal
 	 */
 	float getData();
+	/**
+	 * Retreive OBD2 signal data in fixed point engineering units. No floating point math is done, the slope and offset are
+	 * pre-converted when the parameter is created. For PID's without a linear conversion the raw integer value is returned.
+	 * 
+	 * @return engineering units * 10^decimals (see setFixedDecimals, default OBD_FIXED_DECIMALS)
+	 */
+	SINT32 getDataFixed();
+	/**
+	 * Same as getDataFixed() but for the value last reported by a particular ECU (see setPerECU)
+	 * 
+	 * @param ecu - index of the responding ECU (0 to getNumECUs() - 1)
+	 * @return engineering units * 10^decimals
+	 */
+	SINT32 getDataFixed(UINT8 ecu);
+	/**
+	 * Set the number of decimal places returned by getDataFixed(), this re-converts the slope and offset
+	 * 
+	 * @param decimals - result of getDataFixed() = EU * 10^decimals
+	 */
+	void setFixedDecimals(UINT8 decimals);
+	/**
+	 * Retreive OBD2 signal data in floating point engineering units as last reported by a particular ECU.
+	 * Only valid once per-ECU values have been enabled (see setPerECU)
+	 * 
+	 * @param ecu - index of the responding ECU (0 to getNumECUs() - 1)
+	 * @return floating point engineering unit representation of OBD2 signal
+	 */
+	float getData(UINT8 ecu);
 	/**
 	 * This method is responsible for extracting the data portion of a received CAN frame (OBD message) based upon 8,16,32bit message sizes.
 	 * This works in UINT32 data type (calling funciton needs to cast this for sign support).
@@ -143,6 +534,53 @@ public:
 	 * @return UINT32 - integer that represents OBD message data (no scaling or sign applied)
 	 */
 	UINT32 getIntData();
+	/**
+	 * Same as getIntData() but for the value last reported by a particular ECU (see setPerECU)
+	 * 
+	 * @param ecu - index of the responding ECU (0 to getNumECUs() - 1)
+	 * @return UINT32 - integer that represents OBD message data (no scaling or sign applied)
+	 */
+	UINT32 getIntData(UINT8 ecu);
+	/**
+	 * Retrieve one of the values of a PID that returns more than one value (e.g. O2 sensor voltage and fuel trim).
+	 * Only PID's from the built-in catalogue support this.
+	 * 
+	 * @param idx - which value (0 to getNumValues() - 1)
+	 * @return floating point engineering unit representation of the value
+	 */
+	float getValue(UINT8 idx);
+	/**
+	 * Retrieve the number of values returned by this PID
+	 * 
+	 * @return - number of values (1 for most PID's)
+	 */
+	UINT8 getNumValues();
+	/**
+	 * Enable/disable keeping a separate copy of the data for every ECU that responds to this PID.
+	 * By default only the most recent response (from any ECU) is kept.
+	 * 
+	 * @param enable - true to keep per-ECU values
+	 */
+	void setPerECU(bool enable);
+	/**
+	 * Retrieve the CAN ID of the ECU that supplied the most recent value (e.g. 0x7E8-0x7EF or 0x18DAF1xx)
+	 * 
+	 * @return - response CAN ID, 0 if nothing has been received yet
+	 */
+	UINT32 getResponderID();
+	/**
+	 * Retrieve the number of different ECU's that have responded to this PID (only tracked with per-ECU values enabled)
+	 * 
+	 * @return - number of responding ECU's
+	 */
+	UINT8 getNumECUs();
+	/**
+	 * Retrieve the response CAN ID of a particular ECU that has responded to this PID
+	 * 
+	 * @param ecu - index of the responding ECU (0 to getNumECUs() - 1)
+	 * @return - response CAN ID of this ECU
+	 */
+	UINT32 getECUID(UINT8 ecu);
 	/**
 	 * this handler is called when a CAN frame ID matching a OBD2 response message is received
 	 * 
@@ -150,6 +588,127 @@ public:
 	 * @return -  bool this is the proper response for this PID
 	 */
 	bool receiveFrame(RX_CAN_FRAME *I);
+	/**
+	 * this handler is called by the scheduler just before a request for this PID is transmitted. Once a single ECU 
+	 * is known to respond to this PID the request is addressed to that ECU only (physical addressing), if the ECU stops 
+	 * responding the requests fall back to the functional (broadcast) ID.
+	 * 
+	 * @return -  bool transmit this request
+	 */
+	bool requestFrame();
+	/**
+	 * this handler is called by the scheduler once the request has been loaded into the TX mailbox, the round trip
+	 * latency is measured from here (without the wait for the mailbox)
+	 * 
+	 * @param time - uS (micros()) when the request was handed to the mailbox
+	 */
+	void requestSent(UINT32 time);
+	/**
+	 * Enable/disable automatic physical (ECU addressed) requests, enabled by default
+	 * 
+	 * @param enable - true to allow physical requests once the responding ECU is known
+	 */
+	void setPhysicalAddressing(bool enable);
+	/**
+	 * Check if requests are currently addressed to a single ECU
+	 * 
+	 * @return - true for physical requests, false for functional (broadcast) requests
+	 */
+	bool isPhysical();
+	/**
+	 * Retrieve the number of requests transmitted for this PID (rolling)
+	 * 
+	 * @return - number of requests
+	 */
+	UINT32 getRequestCtr();
+	/**
+	 * Retrieve the number of responses received for this PID from all ECU's (rolling). 
+	 * Together with getRequestCtr() this gives the bus frames used per acquired sample.
+	 * 
+	 * @return - number of responses
+	 */
+	UINT32 getResponseCtr();
+	/**
+	 * Retrieve the scheduling state of this PID. PID's that are not answered, or answered with a negative response, back off 
+	 * exponentially (skip turns in the query schedule) and are eventually dropped from the schedule.
+	 * 
+	 * @return - PID_ACTIVE, PID_BACKOFF, PID_DROPPED_NRC or PID_DROPPED_TIMEOUT
+	 */
+	OBD_PID_STATUS getStatus();
+	/**
+	 * Retrieve the most recent negative response code received for this PID
+	 * 
+	 * @return - negative response code (see OBD_NRC), NRC_NONE if none has been received
+	 */
+	UINT8 getLastNRC();
+	/**
+	 * Retrieve the number of requests for this PID that were not answered (rolling)
+	 * 
+	 * @return - number of timeouts
+	 */
+	UINT32 getTimeoutCtr();
+	/**
+	 * Retrieve the number of negative responses received for this PID (rolling)
+	 * 
+	 * @return - number of negative responses
+	 */
+	UINT32 getNegativeCtr();
+	/**
+	 * Retrieve the number of consecutive requests for this PID that have not been answered
+	 * 
+	 * @return - number of consecutive timeouts
+	 */
+	UINT8 getConsecutiveTimeouts();
+	/**
+	 * Retrieve the number of requests that were sent again after the previous request for this PID was not answered (rolling)
+	 * 
+	 * @return - number of retries
+	 */
+	UINT32 getRetryCtr();
+	/**
+	 * Retrieve the request/response round trip latency statistics of this PID. Each request is time stamped when it is 
+	 * handed to the CAN controller and matched against the first response, late responses (after the request timed out)
+	 * are not measured. The response time stamp is taken when the scheduler reads the frame, so polling latency is included.
+	 * 
+	 * @return - pointer to the latency statistics (min/mean/max/percentiles in microseconds)
+	 */
+	cOBDLatency* getLatency();
+	/**
+	 * Put a backed-off or dropped PID back on the query schedule (e.g. after the ignition has been cycled)
+	 */
+	void resetStatus();
+	/**
+	 * Mark this PID as (not) supported by the vehicle, unsupported PID's are taken off the query schedule without ever 
+	 * being requested. This is normally done by cOBDVehicleInfo from the supported PID bitmaps.
+	 * 
+	 * @param supported - false to take the PID off the schedule, true to put it back
+	 */
+	void setSupported(bool supported);
+	/**
+	 * Select the freeze frame that is requested (mode 02 only), responses for other frames are ignored
+	 * 
+	 * @param frame - freeze frame number (0 = the frame stored with the first fault)
+	 */
+	void setFreezeFrame(UINT8 frame);
+	/**
+	 * Retrieve the parameter ID, mode and acquisition scheduler of this parameter
+	 */
+	OBD_PID getPID();
+	OBD_MODE_REQ getMode();
+	cAcquireCAN* getPort();
+	/**
+	 * Retrieve the number of OBD parameters created (all ports)
+	 * 
+	 * @return - number of parameters
+	 */
+	static UINT8 getNumParameters();
+	/**
+	 * Retrieve one of the OBD parameters created (all ports), in order of creation
+	 * 
+	 * @param idx - parameter index (0 to getNumParameters() - 1)
+	 * @return - pointer to the parameter, NULL if idx is out of range
+	 */
+	static cOBDParameter* getParameter(UINT8 idx);
 	/**
 	 * Retreive the string representing the OBD2 signal name
 	 * 
@@ -212,15 +771,144 @@ protected:
 	cOBDTXFrame TXFrame;
 
 	/**
-	 * this is the receive frame that is used to make the OBD data request to the CAN receiver
+	 * this is the shared receive frame that routes the OBD data response for this PID to this parameter
+	 */
+	cOBDRXFrame *RXHandler;
+
+	/**
+	 * freeze frame number of mode 02 requests
+	 */
+	UINT8 freezeFrame;
+
+	/**
+	 * value bytes of the most recent response (data[0] = A, data[1] = B etc.)
+	 */
+	UINT8 data[OBD_MAX_DATA];
+
+	/**
+	 * catalogue entry for this PID, NULL if the conversion is user defined (m*x+b)
+	 */
+	const sOBDPIDInfo *info;
+
+	/**
+	 * CAN ID of the ECU that supplied the most recent response
+	 */
+	UINT32 responderID;
+
+	/**
+	 * optional per-ECU copies of the response data (value bytes only), indexed in order of first response
+	 */
+	bool   perECU;
+	UINT8  numECUs;
+	UINT32 ecuID[OBD_MAX_ECUS];
+	UINT8  ecuData[OBD_MAX_ECUS][OBD_MAX_DATA];
+
+	/**
+	 * This method converts the raw value bytes of a response to an integer based upon 8,16,32bit message sizes
+	 * 
+	 * @param d - pointer to the first value byte of the response
+	 * @return UINT32 - integer that represents OBD message data (no scaling or sign applied)
+	 */
+	UINT32 parseIntData(UINT8 *d);
+
+	/**
+	 * This method sign extends a raw integer value based upon the 8,16,32bit message size
+	 * 
+	 * @param raw - raw integer value from parseIntData()
+	 * @return SINT32 - signed integer value
+	 */
+	SINT32 signExtend(UINT32 raw);
+
+	/**
+	 * request addressing: functional (broadcast) request ID, response ID of the ECU physical requests are sent to (0 = functional)
+	 */
+	UINT32 functionalID;
+	UINT32 physicalRespID;
+	bool   physAllowed;
+
+	/**
+	 * more than one ECU responds to a functional request for this PID, physical requests would lose data
+	 */
+	bool   multiECU;
+
+	/**
+	 * a request has been made that has not been answered yet, number of consecutive unanswered requests
+	 */
+	bool   awaitingResponse;
+	UINT8  missedResponses;
+
+	/**
+	 * request/response counters
+	 */
+	UINT32 requestCtr;
+	UINT32 responseCtr;
+
+	/**
+	 * scheduling state, current back-off exponent and number of query turns left to skip
+	 */
+	OBD_PID_STATUS status;
+	UINT8  backoffExp;
+	UINT8  skipCount;
+
+	/**
+	 * negative response and timeout counters, most recent negative response code
+	 */
+	UINT32 timeoutCtr;
+	UINT32 negativeCtr;
+	UINT8  lastNRC;
+
+	/**
+	 * time stamp (micros) of the outstanding request, number of retries and round trip latency statistics
+	 */
+	UINT32 requestTime;
+	UINT32 retryCtr;
+	cOBDLatency latency;
+
+	/**
+	 * This handler is called when a negative response (0x7F) to a request for this PID has been received
+	 * 
+	 * @param nrc    - negative response code
+	 * @param respID - CAN ID of the responding ECU
+	 */
+	void negativeResponse(UINT8 nrc, UINT32 respID);
+
+	/**
+	 * The request was unanswered or rejected, double the number of query turns skipped before the next request
 	 */
-	cOBDRXFrame RXFrame;
+	void backOff();
+
+	/**
+	 * pre-converted fixed point slope and offset used by getDataFixed()
+	 */
+	cFixedScale fixedScale;
+
+	/**
+	 * Common initialization for all OBD parameters, set up the request frame and register with the shared response handler
+	 * 
+	 * @param _mode    -  this is the OBD mode of data we have requested (as provided by the standard) current data, freeze, etc,
+	 * @param _portNum -  physical CAN port to be used for this OBD parameter
+	 * @param _extended-  indicate we are using OBD2 extended ID's
+	 */
+	void init(OBD_MODE_REQ _mode, cAcquireCAN *_portNum, bool _extended);
+
+	/**
+	 * Copy a null terminated string into a name/units member, truncating it if it is too long
+	 * 
+	 * @param dest - destination string (STR_LNGTH chars)
+	 * @param src  - null terminated source string
+	 */
+	static void copyString(char *dest, const char *src);
 
 	/**
 	 * this is a list that keeps track of all of the OBD2 PID created
 	 */
 	static cOBDParameter *OBDList[MAX_NUM_PIDS];
 	static UINT8  listIdx;
+
+	/**
+	 * the shared response handler routes responses directly to the parameters in the list
+	 */
+	friend class cOBDRXFrame;
 };
 
 
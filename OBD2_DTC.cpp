@@ -0,0 +1,316 @@
+/*
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#include "OBD2_DTC.h"
+
+/**
+ * constructor, registers the request and response frames with the acquisition scheduler
+ *
+ * @param _portNum  -  physical CAN port to be used
+ * @param _extended -  indicate we are using OBD2 extended ID's
+ */
+cOBDDTCReader::cOBDDTCReader(cAcquireCAN *_portNum, bool _extended)
+{
+	portNum      = _portNum;
+	state        = DTC_IDLE;
+	type         = DTC_STORED;
+	lastActivity = 0;
+	numDTCs      = 0;
+	numECUs      = 0;
+	lostCtr      = 0;
+
+	//
+	//********** TX REQUEST FRAME ****************
+	//
+	//	| add bytes (1) | mode | 0x55 ... |
+	//
+	//the request is always functional (broadcast) so that all ECU's report their codes. It shares the query schedule with
+	//the OBD PID's but only takes a slot when a readout has been requested
+	//
+	TXFrame.ID       = _extended ? 0x18DB33F1 : 0x7DF;
+	TXFrame.rate     = QUERY_MSG;
+	TXFrame.parent   = this;
+	TXFrame.U.P.lowerPayload = 0x55555555;
+	TXFrame.U.P.upperPayload = 0x55555555;
+	TXFrame.U.b[0]   = 1;
+	portNum->addMessage(&TXFrame, TRANSMIT);
+
+	//
+	//********** RX RECEIVE FRAME ****************
+	//
+	//accept the response from any ECU, 0x7E8-0x7EF for 11bit or 0x18DAF1xx for 29bit. This is in addition to the shared
+	//OBD PID response handler (which ignores multi-frame responses)
+	//
+	RXFrame.ID     = _extended ? 0x18DAF100 : 0x7E8;
+	RXFrame.mask   = _extended ? 0x1FFFFF00 : 0x7F8;
+	RXFrame.parent = this;
+	portNum->addMessage(&RXFrame, RECEIVE);
+}
+
+/**
+ * Start a trouble code readout, the request is sent on the next free query slot. Any previous codes are cleared.
+ *
+ * @param _type - stored (03), pending (07) or permanent (0A) codes
+ * @return - false if a readout is already in progress
+ */
+bool cOBDDTCReader::request(OBD_DTC_TYPE _type)
+{
+	if ((state == DTC_WAITING) || (state == DTC_READING))
+	{
+		return(false);
+	}
+
+	type    = _type;
+	numDTCs = 0;
+	numECUs = 0;
+	lostCtr = 0;
+	collector.reset();
+
+	TXFrame.U.b[1] = (UINT8)type;
+
+	//the scheduler picks this up on the next query slot
+	state = DTC_WAITING;
+
+	return(true);
+}
+
+/**
+ * Retrieve the state of the readout. The readout is over once no response frame has been received for OBD_DTC_WINDOW_MS,
+ * functional requests do not tell us how many ECU's are going to answer.
+ *
+ * @return - readout state
+ */
+OBD_DTC_STATE cOBDDTCReader::getState()
+{
+	noInterrupts();
+	if ((state == DTC_READING) && ((millis() - lastActivity) >= OBD_DTC_WINDOW_MS))
+	{
+		state = numECUs ? DTC_DONE : DTC_NO_RESPONSE;
+	}
+	interrupts();
+
+	return(state);
+}
+
+/**
+ * this handler is called by the scheduler when there is a query slot available
+ *
+ * @return - bool transmit the request
+ */
+bool cOBDDTCReader::requestFrame()
+{
+	if (state != DTC_WAITING)
+	{
+		return(false);
+	}
+
+	state        = DTC_READING;
+	lastActivity = millis();
+
+	return(true);
+}
+
+/**
+ * this handler is called when a frame from any of the ECU response ID's is received
+ *
+ *  single frame response:  | 0x0L | mode + 0x40 | number of codes | code hi | code lo | ...
+ *  multi-frame response:   | 0x1L | LL | mode + 0x40 | number of codes | code hi | code lo |, then consecutive frames
+ *
+ * @param R - pointer to the received CAN frame
+ * @return - bool this frame is part of a trouble code response
+ */
+bool cOBDDTCReader::receiveFrame(RX_CAN_FRAME *R)
+{
+	const UINT8 *msg;
+	UINT16 len;
+
+	if (state != DTC_READING)
+	{
+		return(false);
+	}
+
+	switch (collector.receive(R, (UINT8)type | 0x40, &msg, &len))
+	{
+	case ISOTP_RX_FIRST:
+		//clear the ECU to send the rest of the response
+		collector.sendFlowControl(portNum, getOBDRequestID(R->id), false);
+		break;
+
+	case ISOTP_RX_OVERFLOW:
+		collector.sendFlowControl(portNum, getOBDRequestID(R->id), true);
+		break;
+
+	case ISOTP_RX_COMPLETE:
+		decode(R->id, msg, len);
+		break;
+
+	case ISOTP_RX_IGNORED:
+		return(false);
+
+	default:
+		break;
+	}
+
+	//keep the readout open while responses are coming in
+	lastActivity = millis();
+
+	return(true);
+}
+
+/**
+ * Decode a complete response and add its codes to the list
+ *
+ * @param id  - response CAN ID of the ECU
+ * @param d   - response message (response mode, number of codes, codes...)
+ * @param len - number of message bytes
+ */
+void cOBDDTCReader::decode(UINT32 id, const UINT8 *d, UINT16 len)
+{
+	UINT8 ecu, n, i;
+
+	//a response without the number of codes byte is no good
+	if (len < 2)
+	{
+		return;
+	}
+
+	//add the ECU to the list of ECU's that answered
+	for (ecu=0; ecu < numECUs; ecu++)
+	{
+		if (ecuID[ecu] == id)
+		{
+			break;
+		}
+	}
+
+	if ((ecu == numECUs) && (numECUs < OBD_MAX_ECUS))
+	{
+		ecuID[numECUs] = id;
+		numECUs += 1;
+	}
+
+	//don't trust the number of codes beyond what is actually in the message
+	n = d[1];
+	if (n > ((len - 2) / 2))
+	{
+		n = (len - 2) / 2;
+	}
+
+	for (i=0; i < n; i++)
+	{
+		if (numDTCs < OBD_MAX_DTCS)
+		{
+			dtcs[numDTCs].code = ((UINT16)d[2 + 2*i] << 8) | d[3 + 2*i];
+			dtcs[numDTCs].ecu  = ecu;
+			numDTCs += 1;
+
+		} else
+		{
+			lostCtr += 1;
+		}
+	}
+}
+
+/**
+ * Retrieve the number of codes reported by all ECU's
+ *
+ * @return - number of codes
+ */
+UINT8 cOBDDTCReader::getNumDTCs()
+{
+	return(numDTCs);
+}
+
+/**
+ * Retrieve one of the codes
+ *
+ * @param idx - code index
+ * @return - pointer to the code, NULL if idx is out of range
+ */
+const sOBDDTC* cOBDDTCReader::getDTC(UINT8 idx)
+{
+	return((idx < numDTCs) ? &dtcs[idx] : NULL);
+}
+
+/**
+ * Retrieve the number of ECU's that answered the request
+ *
+ * @return - number of ECU's
+ */
+UINT8 cOBDDTCReader::getNumECUs()
+{
+	return(numECUs);
+}
+
+/**
+ * Retrieve the response CAN ID of an ECU that answered the request
+ *
+ * @param ecu - ECU index
+ * @return - response CAN ID, 0 if ecu is out of range
+ */
+UINT32 cOBDDTCReader::getECUID(UINT8 ecu)
+{
+	return((ecu < numECUs) ? ecuID[ecu] : 0);
+}
+
+/**
+ * Retrieve the number of codes/responses lost
+ *
+ * @return - number of codes/responses lost
+ */
+UINT8 cOBDDTCReader::getLostCtr()
+{
+	return(lostCtr + collector.getLostCtr());
+}
+
+/**
+ * Convert a code to text. The upper two bits are the system (P, C, B, U), the remaining 14 bits are the digits.
+ *
+ * @param code - two byte code as in sOBDDTC
+ * @param str  - destination, at least 6 chars
+ */
+void cOBDDTCReader::format(UINT16 code, char *str)
+{
+	static const char letter[4] = {'P', 'C', 'B', 'U'};
+	static const char hex[16]   = {'0','1','2','3','4','5','6','7','8','9','A','B','C','D','E','F'};
+
+	str[0] = letter[(code >> 14) & 0x03];
+	str[1] = hex[(code >> 12) & 0x03];
+	str[2] = hex[(code >> 8) & 0x0F];
+	str[3] = hex[(code >> 4) & 0x0F];
+	str[4] = hex[code & 0x0F];
+	str[5] = 0;
+}
+
+/**
+ * This is a overridden implementaiton of the base class member that is called by the acquisition scheduler when a query slot is available
+ *
+ * @return - a flag to transmit or skip this CAN frame
+ */
+bool cOBDDTCTXFrame::CallbackTx()
+{
+	return(parent->requestFrame());
+}
+
+/**
+ * This is a overridden implementaiton of the base class member that is called by the acquisition scheduler when a receive message matching this CAN ID has been received.
+ *
+ * @param R - pointer to RX Frame
+ * @return - a flag to accept or reject this CAN frame
+ */
+bool cOBDDTCRXFrame::CallbackRx(RX_CAN_FRAME *R)
+{
+	return(R ? parent->receiveFrame(R) : false);
+}
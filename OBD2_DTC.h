@@ -0,0 +1,242 @@
+/*
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#include <OBD2.h>
+#include <ISOTP.h>
+
+#ifndef OBD2_DTC_H
+#define OBD2_DTC_H
+
+/**
+ *
+ * This macro is used to set the maximum number of trouble codes kept from one readout (all ECU's)
+ */
+#define	OBD_MAX_DTCS		32
+
+/**
+ *
+ * This macro is used to set how long (mS) to wait for more responses after the request or the last response frame
+ */
+#define	OBD_DTC_WINDOW_MS	150
+
+/**
+ *
+ * This enum represents the type of trouble codes to read (the OBD2 mode of the request)
+ */
+enum OBD_DTC_TYPE
+{
+	DTC_STORED    = 0x03,
+	DTC_PENDING   = 0x07,
+	DTC_PERMANENT = 0x0A
+};
+
+/**
+ *
+ * This enum represents the state of a trouble code readout
+ */
+enum OBD_DTC_STATE
+{
+	DTC_IDLE        = 0,	//nothing requested yet
+	DTC_WAITING     = 1,	//requested, waiting for a query slot in the scheduler
+	DTC_READING     = 2,	//request sent, collecting responses
+	DTC_DONE        = 3,	//at least one ECU answered, the codes are ready
+	DTC_NO_RESPONSE = 4		//no ECU answered
+};
+
+/**
+ *
+ * This struct represents one trouble code. The code is kept in the two byte form of the response, see cOBDDTCReader::format()
+ * for the text form (e.g. 0x0123 = "P0123", 0xC155 = "U0155")
+ */
+struct sOBDDTC
+{
+	UINT16 code;
+
+	/**
+	 * index of the ECU that reported this code (see cOBDDTCReader::getECUID)
+	 */
+	UINT8  ecu;
+};
+
+class cOBDDTCReader;
+
+/**
+ * this is the transmit frame that is used to make the trouble code request, it only asks for a query slot when a readout is pending
+ */
+class cOBDDTCTXFrame : public cCANFrame
+{
+public:
+	cOBDDTCReader *parent;
+
+private:
+	bool  CallbackTx();
+};
+
+/**
+ * this is the receive frame that accepts the (single or multi-frame) trouble code responses from any ECU
+ */
+class cOBDDTCRXFrame : public cCANFrame
+{
+public:
+	cOBDDTCReader *parent;
+
+private:
+	bool  CallbackRx(RX_CAN_FRAME *R);
+};
+
+/**
+ * Non-blocking trouble code reader (modes 03, 07 and 0A). The request takes a single slot in the query schedule of the
+ * acquisition scheduler so the normal PID polling carries on, multi-frame (ISO-TP) responses from all ECU's are reassembled
+ * in the background and decoded into a list of codes.
+ *
+ * e.g.
+ *   cOBDDTCReader DTCs(&CANport0, false);
+ *   DTCs.request(DTC_STORED);
+ *   ...
+ *   if (DTCs.getState() == DTC_DONE) { for (i=0; i < DTCs.getNumDTCs(); i++) ... }
+ *
+ * @author D.Kasamis - dan@togglebit.net
+ * @version 1.0
+ */
+class cOBDDTCReader
+{
+public:
+	/**
+	 * constructor, registers the request and response frames with the acquisition scheduler
+	 *
+	 * @param _portNum  -  physical CAN port to be used
+	 * @param _extended -  indicate we are using OBD2 extended ID's
+	 */
+	cOBDDTCReader(cAcquireCAN *_portNum, bool _extended);
+
+	/**
+	 * Start a trouble code readout, the request is sent on the next free query slot. Any previous codes are cleared.
+	 *
+	 * @param type - stored (03), pending (07) or permanent (0A) codes
+	 * @return - false if a readout is already in progress
+	 */
+	bool request(OBD_DTC_TYPE type);
+
+	/**
+	 * Retrieve the state of the readout, call this periodically (e.g. in loop()) until DTC_DONE or DTC_NO_RESPONSE
+	 *
+	 * @return - readout state
+	 */
+	OBD_DTC_STATE getState();
+
+	/**
+	 * Retrieve the number of codes reported by all ECU's
+	 *
+	 * @return - number of codes (limited to OBD_MAX_DTCS)
+	 */
+	UINT8 getNumDTCs();
+
+	/**
+	 * Retrieve one of the codes
+	 *
+	 * @param idx - code index (0 to getNumDTCs() - 1)
+	 * @return - pointer to the code, NULL if idx is out of range
+	 */
+	const sOBDDTC* getDTC(UINT8 idx);
+
+	/**
+	 * Retrieve the number of ECU's that answered the request (including ECU's without codes)
+	 *
+	 * @return - number of ECU's
+	 */
+	UINT8 getNumECUs();
+
+	/**
+	 * Retrieve the response CAN ID of an ECU that answered the request
+	 *
+	 * @param ecu - ECU index (0 to getNumECUs() - 1)
+	 * @return - response CAN ID
+	 */
+	UINT32 getECUID(UINT8 ecu);
+
+	/**
+	 * Retrieve the number of codes the ECU's reported that did not fit in the list, or were lost to a bad multi-frame response
+	 *
+	 * @return - number of codes/responses lost
+	 */
+	UINT8 getLostCtr();
+
+	/**
+	 * Convert a code to text, e.g. 0x0123 -> "P0123"
+	 *
+	 * @param code - two byte code as in sOBDDTC
+	 * @param str  - destination, at least 6 chars
+	 */
+	static void format(UINT16 code, char *str);
+
+	/**
+	 * this handler is called by the scheduler when there is a query slot available
+	 *
+	 * @return - bool transmit the request
+	 */
+	bool requestFrame();
+
+	/**
+	 * this handler is called when a frame from any of the ECU response ID's is received
+	 *
+	 * @param R - pointer to the received CAN frame
+	 * @return - bool this frame is part of a trouble code response
+	 */
+	bool receiveFrame(RX_CAN_FRAME *R);
+
+private:
+	/**
+	 * periodic scheduler that is to be used aka - physical port to be used
+	 */
+	cAcquireCAN *portNum;
+
+	/**
+	 * request and response frames
+	 */
+	cOBDDTCTXFrame TXFrame;
+	cOBDDTCRXFrame RXFrame;
+
+	/**
+	 * readout state, requested mode and the time (millis) of the request or the last response frame
+	 */
+	volatile OBD_DTC_STATE state;
+	OBD_DTC_TYPE type;
+	volatile UINT32 lastActivity;
+
+	/**
+	 * decoded codes and the ECU's that answered
+	 */
+	sOBDDTC dtcs[OBD_MAX_DTCS];
+	UINT8   numDTCs;
+	UINT32  ecuID[OBD_MAX_ECUS];
+	UINT8   numECUs;
+	UINT8   lostCtr;
+
+	/**
+	 * multi-frame reassembly of the responses from all ECU's
+	 */
+	cISOTPCollector collector;
+
+	/**
+	 * Decode a complete response and add its codes to the list
+	 *
+	 * @param id  - response CAN ID of the ECU
+	 * @param d   - response message (response mode, number of codes, codes...)
+	 * @param len - number of message bytes
+	 */
+	void decode(UINT32 id, const UINT8 *d, UINT16 len);
+};
+
+#endif
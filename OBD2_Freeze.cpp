@@ -0,0 +1,394 @@
+/*
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#include "OBD2_Freeze.h"
+
+/**
+ * the discovery requests, the DTC that stored the freeze frame with the first bitmap and then the remaining bitmaps
+ * (an ECU only answers the PID's of a group it supports)
+ */
+static const UINT8 freezeDiscovery0[2] = {PIDS_SUPPORTED_01_20, FREEZE_DTC};
+static const UINT8 freezeDiscovery1[3] = {PIDS_SUPPORTED_21_40, PIDS_SUPPORTED_41_60, PIDS_SUPPORTED_61_80};
+
+/**
+ * constructor, registers the request and response frames with the acquisition scheduler
+ *
+ * @param _portNum  -  physical CAN port to be used
+ * @param _extended -  indicate we are using OBD2 extended ID's
+ */
+cOBDFreezeFrame::cOBDFreezeFrame(cAcquireCAN *_portNum, bool _extended)
+{
+	portNum      = _portNum;
+	state        = FREEZE_IDLE;
+	phase        = 0;
+	waiting      = false;
+	answered     = false;
+	lastActivity = 0;
+	numPIDs      = 0;
+	nextPID      = 0;
+	memset(&record, 0, sizeof(record));
+
+	//
+	//********** TX REQUEST FRAME ****************
+	//
+	//	| add bytes (1 + 2 per PID) | 0x02 | PID | frame | PID | frame | PID | frame |
+	//
+	//the discovery request is functional (broadcast), the PID's are then requested from the ECU that stored the freeze frame
+	//
+	functionalID     = _extended ? 0x18DB33F1 : 0x7DF;
+	TXFrame.ID       = functionalID;
+	TXFrame.rate     = QUERY_MSG;
+	TXFrame.parent   = this;
+	portNum->addMessage(&TXFrame, TRANSMIT);
+
+	//
+	//********** RX RECEIVE FRAME ****************
+	//
+	//accept the response from any ECU, 0x7E8-0x7EF for 11bit or 0x18DAF1xx for 29bit
+	//
+	RXFrame.ID     = _extended ? 0x18DAF100 : 0x7E8;
+	RXFrame.mask   = _extended ? 0x1FFFFF00 : 0x7F8;
+	RXFrame.parent = this;
+	portNum->addMessage(&RXFrame, RECEIVE);
+}
+
+/**
+ * Start a snapshot of a freeze frame, the previous record is cleared
+ *
+ * @param frame - freeze frame number
+ * @return - false if a snapshot is already in progress
+ */
+bool cOBDFreezeFrame::request(UINT8 frame)
+{
+	if ((state == FREEZE_DISCOVERY) || (state == FREEZE_READING))
+	{
+		return(false);
+	}
+
+	noInterrupts();
+	memset(&record, 0, sizeof(record));
+	record.frame = frame;
+	phase        = 0;
+	waiting      = false;
+	numPIDs      = 0;
+	nextPID      = 0;
+	TXFrame.ID   = functionalID;
+	collector.reset();
+	buildRequest(freezeDiscovery0, 2);
+	state        = FREEZE_DISCOVERY;
+	interrupts();
+
+	return(true);
+}
+
+/**
+ * Retrieve the state of the snapshot
+ *
+ * @return - snapshot state
+ */
+OBD_FREEZE_STATE cOBDFreezeFrame::getState()
+{
+	return(state);
+}
+
+/**
+ * this handler is called by the scheduler when there is a query slot available. The next request is sent as soon as the
+ * ECU has answered the previous one, or OBD_FREEZE_WINDOW_MS after it if it does not answer.
+ *
+ * @return - bool transmit the request
+ */
+bool cOBDFreezeFrame::requestFrame()
+{
+	if ((state != FREEZE_DISCOVERY) && (state != FREEZE_READING))
+	{
+		return(false);
+	}
+
+	if (waiting)
+	{
+		if (!answered && ((millis() - lastActivity) < OBD_FREEZE_WINDOW_MS))
+		{
+			return(false);
+		}
+
+		waiting = false;
+		nextStep();
+
+		if ((state != FREEZE_DISCOVERY) && (state != FREEZE_READING))
+		{
+			return(false);
+		}
+	}
+
+	waiting      = true;
+	answered     = false;
+	lastActivity = millis();
+
+	return(true);
+}
+
+/**
+ * Move on to the next request: remaining bitmaps (if the first bitmap says PID 0x20 is supported), then the supported
+ * PID's from the catalogue in groups of OBD_FREEZE_GROUP
+ */
+void cOBDFreezeFrame::nextStep()
+{
+	UINT8 pid, n;
+
+	if (state == FREEZE_DISCOVERY)
+	{
+		//nothing stored
+		if (!record.ecuID || !record.supported[0] || ((phase == 0) && !record.dtc))
+		{
+			state = FREEZE_NO_DATA;
+			return;
+		}
+
+		//address the ECU that stored the freeze frame from now on
+		TXFrame.ID = getOBDRequestID(record.ecuID);
+
+		if ((phase == 0) && (record.supported[0] & 1))
+		{
+			phase = 1;
+			buildRequest(freezeDiscovery1, 3);
+			return;
+		}
+
+		//list the supported PID's that we know how to decode
+		numPIDs = 0;
+		for (pid = FREEZE_DTC + 1; (pid <= OBD_PID_CATALOGUE_MAX) && (numPIDs < OBD_FREEZE_MAX_PIDS); pid++)
+		{
+			if (((pid % 0x20) != 0) && ((record.supported[(pid - 1) / 32] >> (31 - ((pid - 1) % 32))) & 1))
+			{
+				pids[numPIDs] = pid;
+				numPIDs += 1;
+			}
+		}
+
+		nextPID = 0;
+		state   = FREEZE_READING;
+
+	} else
+	{
+		nextPID += OBD_FREEZE_GROUP;
+	}
+
+	if (nextPID >= numPIDs)
+	{
+		state = FREEZE_DONE;
+		return;
+	}
+
+	n = numPIDs - nextPID;
+	buildRequest(&pids[nextPID], (n > OBD_FREEZE_GROUP) ? OBD_FREEZE_GROUP : n);
+}
+
+/**
+ * Fill in a request for up to OBD_FREEZE_GROUP PID's
+ *
+ * @param list - PID's
+ * @param n    - number of PID's
+ */
+void cOBDFreezeFrame::buildRequest(const UINT8 *list, UINT8 n)
+{
+	UINT8 i;
+
+	TXFrame.U.P.lowerPayload = 0x55555555;
+	TXFrame.U.P.upperPayload = 0x55555555;
+	TXFrame.U.b[0] = 1 + 2*n;
+	TXFrame.U.b[1] = FREEZE;
+
+	for (i=0; i < n; i++)
+	{
+		TXFrame.U.b[2 + 2*i] = list[i];
+		TXFrame.U.b[3 + 2*i] = record.frame;
+	}
+}
+
+/**
+ * this handler is called when a frame from any of the ECU response ID's is received
+ *
+ * @param R - pointer to the received CAN frame
+ * @return - bool this frame is part of a freeze frame response
+ */
+bool cOBDFreezeFrame::receiveFrame(RX_CAN_FRAME *R)
+{
+	const UINT8 *msg;
+	UINT16 len;
+
+	//only the ECU that stored the freeze frame once it is known
+	if (!waiting || (record.ecuID && (R->id != record.ecuID)))
+	{
+		return(false);
+	}
+
+	switch (collector.receive(R, 0x40 | FREEZE, &msg, &len))
+	{
+	case ISOTP_RX_FIRST:
+		//clear the ECU to send the rest of the response
+		collector.sendFlowControl(portNum, getOBDRequestID(R->id), false);
+		break;
+
+	case ISOTP_RX_OVERFLOW:
+		collector.sendFlowControl(portNum, getOBDRequestID(R->id), true);
+		break;
+
+	case ISOTP_RX_COMPLETE:
+		decode(R->id, msg, len);
+		break;
+
+	case ISOTP_RX_IGNORED:
+		return(false);
+
+	default:
+		break;
+	}
+
+	lastActivity = millis();
+
+	return(true);
+}
+
+/**
+ * Decode a complete response, | 0x42 | PID | frame | value bytes | PID | frame | value bytes | ...
+ * The number of value bytes of each PID comes from the built-in catalogue, decoding stops at a PID that is not in it.
+ * Discovery responses from ECU's that have no freeze frame stored are dropped.
+ *
+ * @param id  - response CAN ID of the ECU
+ * @param d   - response message
+ * @param len - number of message bytes
+ */
+void cOBDFreezeFrame::decode(UINT32 id, const UINT8 *d, UINT16 len)
+{
+	const sOBDPIDInfo *info;
+	UINT16 pos = 1;
+	UINT8 pid, n;
+
+	while ((pos + 2) <= len)
+	{
+		pid  = d[pos];
+		info = getOBDPIDInfo(pid);
+		n    = ((pid % 0x20) == 0) ? 4 : (info ? info->bytes : 0);
+
+		if (!n || ((pos + 2 + n) > len))
+		{
+			break;
+		}
+
+		//skip values of another frame number
+		if (d[pos + 1] == record.frame)
+		{
+			if ((pid % 0x20) == 0)
+			{
+				record.supported[pid / 0x20] = ((UINT32)d[pos + 2] << 24) | ((UINT32)d[pos + 3] << 16) | ((UINT32)d[pos + 4] << 8) | d[pos + 5];
+
+			} else if (pid == FREEZE_DTC)
+			{
+				record.dtc = ((UINT16)d[pos + 2] << 8) | d[pos + 3];
+
+			} else if (record.numValues < OBD_FREEZE_MAX_PIDS)
+			{
+				record.values[record.numValues].pid = pid;
+				memset(record.values[record.numValues].data, 0, OBD_MAX_DATA);
+				memcpy(record.values[record.numValues].data, &d[pos + 2], (n < OBD_MAX_DATA) ? n : OBD_MAX_DATA);
+				record.numValues += 1;
+			}
+		}
+
+		pos += 2 + n;
+	}
+
+	//the first ECU that reports a stored freeze frame is the one we read it from. An ECU without one (DTC = 0) does not
+	//end the wait, another ECU may still hold the freeze frame
+	if (!record.ecuID)
+	{
+		if (!record.dtc || !record.supported[0])
+		{
+			record.dtc       = 0;
+			record.numValues = 0;
+			memset(record.supported, 0, sizeof(record.supported));
+			return;
+		}
+		record.ecuID = id;
+	}
+	answered = true;
+}
+
+/**
+ * Retrieve the decoded freeze frame
+ *
+ * @return - pointer to the record
+ */
+const sOBDFreezeRecord* cOBDFreezeFrame::getRecord()
+{
+	return(&record);
+}
+
+/**
+ * Find the value of a PID in the freeze frame
+ *
+ * @param pid - parameter ID
+ * @return - pointer to the value, NULL if the PID is not in the freeze frame
+ */
+const sOBDFreezeValue* cOBDFreezeFrame::find(UINT8 pid)
+{
+	UINT8 i;
+
+	for (i=0; i < record.numValues; i++)
+	{
+		if (record.values[i].pid == pid)
+		{
+			return(&record.values[i]);
+		}
+	}
+
+	return(NULL);
+}
+
+/**
+ * Retrieve the value of a PID in the freeze frame in engineering units
+ *
+ * @param pid - parameter ID
+ * @param idx - which value for PID's that return more than one value
+ * @return - engineering unit value, 0 if the PID is not in the freeze frame
+ */
+float cOBDFreezeFrame::getValue(UINT8 pid, UINT8 idx)
+{
+	const sOBDFreezeValue *v = find(pid);
+	const sOBDPIDInfo *info = getOBDPIDInfo(pid);
+
+	return((v && info) ? info->decode(v->data, idx) : 0);
+}
+
+/**
+ * This is a overridden implementaiton of the base class member that is called by the acquisition scheduler when a query slot is available
+ *
+ * @return - a flag to transmit or skip this CAN frame
+ */
+bool cOBDFreezeTXFrame::CallbackTx()
+{
+	return(parent->requestFrame());
+}
+
+/**
+ * This is a overridden implementaiton of the base class member that is called by the acquisition scheduler when a receive message matching this CAN ID has been received.
+ *
+ * @param R - pointer to RX Frame
+ * @return - a flag to accept or reject this CAN frame
+ */
+bool cOBDFreezeRXFrame::CallbackRx(RX_CAN_FRAME *R)
+{
+	return(R ? parent->receiveFrame(R) : false);
+}
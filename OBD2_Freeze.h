@@ -0,0 +1,259 @@
+/*
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#include <OBD2.h>
+#include <ISOTP.h>
+
+#ifndef OBD2_FREEZE_H
+#define OBD2_FREEZE_H
+
+/**
+ *
+ * This macro is used to set the maximum number of PID values kept from one freeze frame
+ */
+#define	OBD_FREEZE_MAX_PIDS		32
+
+/**
+ *
+ * This macro is used to set the number of PID's requested at once (a mode 02 request holds up to 3 PID/frame pairs)
+ */
+#define	OBD_FREEZE_GROUP		3
+
+/**
+ *
+ * This macro is used to set how long (mS) to wait for the response to a request
+ */
+#define	OBD_FREEZE_WINDOW_MS	150
+
+/**
+ *
+ * This enum represents the state of a freeze frame snapshot
+ */
+enum OBD_FREEZE_STATE
+{
+	FREEZE_IDLE      = 0,	//nothing requested yet
+	FREEZE_DISCOVERY = 1,	//reading the freeze frame DTC and supported PID bitmaps
+	FREEZE_READING   = 2,	//reading the supported PID's, OBD_FREEZE_GROUP per request
+	FREEZE_DONE      = 3,	//the record is complete
+	FREEZE_NO_DATA   = 4	//no ECU answered with a stored freeze frame (DTC != 0)
+};
+
+/**
+ *
+ * This struct represents one PID value of a freeze frame (value bytes A, B, C... as in mode 01)
+ */
+struct sOBDFreezeValue
+{
+	UINT8 pid;
+	UINT8 data[OBD_MAX_DATA];
+};
+
+/**
+ *
+ * This struct represents a decoded freeze frame
+ */
+struct sOBDFreezeRecord
+{
+	/**
+	 * freeze frame number and response CAN ID of the ECU that stored it
+	 */
+	UINT8  frame;
+	UINT32 ecuID;
+
+	/**
+	 * the trouble code that caused the freeze frame to be stored (PID 0x02), see cOBDDTCReader::format()
+	 */
+	UINT16 dtc;
+
+	/**
+	 * supported PID bitmaps of this freeze frame, PID's 0x01-0x20, 0x21-0x40, 0x41-0x60, 0x61-0x80 (MSB = first PID)
+	 */
+	UINT32 supported[4];
+
+	/**
+	 * values of the supported PID's, in PID order
+	 */
+	UINT8  numValues;
+	sOBDFreezeValue values[OBD_FREEZE_MAX_PIDS];
+};
+
+class cOBDFreezeFrame;
+
+/**
+ * this is the transmit frame that is used to make the grouped freeze frame requests, it only asks for a query slot when
+ * a request is pending
+ */
+class cOBDFreezeTXFrame : public cCANFrame
+{
+public:
+	cOBDFreezeFrame *parent;
+
+private:
+	bool  CallbackTx();
+};
+
+/**
+ * this is the receive frame that accepts the (single or multi-frame) freeze frame responses
+ */
+class cOBDFreezeRXFrame : public cCANFrame
+{
+public:
+	cOBDFreezeFrame *parent;
+
+private:
+	bool  CallbackRx(RX_CAN_FRAME *R);
+};
+
+/**
+ * Freeze frame (mode 02) snapshot. The freeze frame DTC and supported PID bitmaps are read first, ECU's answering with
+ * DTC 0 are skipped and the window stays open for the others. Then every supported PID in the built-in catalogue is read
+ * OBD_FREEZE_GROUP PID's per request from the ECU that stored the freeze frame.
+ * The requests share the query schedule of the acquisition scheduler with the OBD PID's.
+ *
+ * e.g.
+ *   cOBDFreezeFrame Freeze(&CANport0, false);
+ *   Freeze.request(0);
+ *   ...
+ *   if (Freeze.getState() == FREEZE_DONE) { Freeze.getValue(ENGINE_RPM, 0) ... }
+ *
+ * @author D.Kasamis - dan@togglebit.net
+ * @version 1.0
+ */
+class cOBDFreezeFrame
+{
+public:
+	/**
+	 * constructor, registers the request and response frames with the acquisition scheduler
+	 *
+	 * @param _portNum  -  physical CAN port to be used
+	 * @param _extended -  indicate we are using OBD2 extended ID's
+	 */
+	cOBDFreezeFrame(cAcquireCAN *_portNum, bool _extended);
+
+	/**
+	 * Start a snapshot of a freeze frame, the previous record is cleared
+	 *
+	 * @param frame - freeze frame number (0 = the frame stored with the first fault)
+	 * @return - false if a snapshot is already in progress
+	 */
+	bool request(UINT8 frame);
+
+	/**
+	 * Retrieve the state of the snapshot
+	 *
+	 * @return - snapshot state
+	 */
+	OBD_FREEZE_STATE getState();
+
+	/**
+	 * Retrieve the decoded freeze frame (complete once the state is FREEZE_DONE)
+	 *
+	 * @return - pointer to the record
+	 */
+	const sOBDFreezeRecord* getRecord();
+
+	/**
+	 * Find the value of a PID in the freeze frame
+	 *
+	 * @param pid - mode 01/02 parameter ID
+	 * @return - pointer to the value, NULL if the PID is not in the freeze frame
+	 */
+	const sOBDFreezeValue* find(UINT8 pid);
+
+	/**
+	 * Retrieve the value of a PID in the freeze frame in engineering units (conversion from the built-in catalogue)
+	 *
+	 * @param pid - mode 01/02 parameter ID
+	 * @param idx - which value for PID's that return more than one value (0 for most PID's)
+	 * @return - engineering unit value, 0 if the PID is not in the freeze frame
+	 */
+	float getValue(UINT8 pid, UINT8 idx);
+
+	/**
+	 * this handler is called by the scheduler when there is a query slot available
+	 *
+	 * @return - bool transmit the request
+	 */
+	bool requestFrame();
+
+	/**
+	 * this handler is called when a frame from any of the ECU response ID's is received
+	 *
+	 * @param R - pointer to the received CAN frame
+	 * @return - bool this frame is part of a freeze frame response
+	 */
+	bool receiveFrame(RX_CAN_FRAME *R);
+
+private:
+	cAcquireCAN *portNum;
+
+	/**
+	 * request and response frames, functional request ID
+	 */
+	cOBDFreezeTXFrame TXFrame;
+	cOBDFreezeRXFrame RXFrame;
+	UINT32 functionalID;
+
+	/**
+	 * snapshot state, discovery phase (0 = DTC and first bitmap, 1 = remaining bitmaps), a request is outstanding and has
+	 * been answered, time (millis) of the request or the last response frame
+	 */
+	volatile OBD_FREEZE_STATE state;
+	UINT8  phase;
+	bool   waiting;
+	volatile bool answered;
+	volatile UINT32 lastActivity;
+
+	/**
+	 * supported PID's still to be read, index of the first PID of the current request
+	 */
+	UINT8  pids[OBD_FREEZE_MAX_PIDS];
+	UINT8  numPIDs;
+	UINT8  nextPID;
+
+	/**
+	 * the decoded freeze frame
+	 */
+	sOBDFreezeRecord record;
+
+	/**
+	 * multi-frame reassembly of the responses
+	 */
+	cISOTPCollector collector;
+
+	/**
+	 * Move on to the next request (discovery, then the supported PID's)
+	 */
+	void nextStep();
+
+	/**
+	 * Fill in a request for up to OBD_FREEZE_GROUP PID's
+	 *
+	 * @param list - PID's
+	 * @param n    - number of PID's
+	 */
+	void buildRequest(const UINT8 *list, UINT8 n);
+
+	/**
+	 * Decode a complete response, | 0x42 | PID | frame | value bytes | PID | frame | value bytes | ...
+	 *
+	 * @param id  - response CAN ID of the ECU
+	 * @param d   - response message
+	 * @param len - number of message bytes
+	 */
+	void decode(UINT32 id, const UINT8 *d, UINT16 len);
+};
+
+#endif
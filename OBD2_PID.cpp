@@ -0,0 +1,311 @@
+/*
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#include "OBD2.h"
+
+/**
+ * Decode functions for the built-in SAE J1979 mode 01 PID catalogue (http://en.wikipedia.org/wiki/OBD-II_PIDs).
+ * A = A[0], B = A[1], C = A[2], D = A[3], E = A[4] as named in the standard.
+ */
+
+//two byte unsigned value 256A+B (or 256C+D for idx = 1)
+static inline UINT32 pidWord(const UINT8 *A, UINT8 idx)
+{
+	return((UINT32)(A[idx * 2] << 8) | A[idx * 2 + 1]);
+}
+
+//bit encoded, return the raw byte selected by idx
+static float decodeBits(const UINT8 *A, UINT8 idx)
+{
+	return(A[idx]);
+}
+
+//A
+static float decodeByte(const UINT8 *A, UINT8)
+{
+	return(A[0]);
+}
+
+//256A+B
+static float decodeWord(const UINT8 *A, UINT8)
+{
+	return(pidWord(A, 0));
+}
+
+//100/255 A
+static float decodePercent(const UINT8 *A, UINT8 idx)
+{
+	return(A[idx] * (100.0f / 255.0f));
+}
+
+//A-40
+static float decodeTemp(const UINT8 *A, UINT8)
+{
+	return((SINT32)A[0] - 40);
+}
+
+//100/128 A - 100, fuel trims (idx selects A or B)
+static float decodeTrim(const UINT8 *A, UINT8 idx)
+{
+	return((A[idx] * (100.0f / 128.0f)) - 100.0f);
+}
+
+//3A
+static float decodeFuelPressure(const UINT8 *A, UINT8)
+{
+	return(A[0] * 3.0f);
+}
+
+//(256A+B)/4
+static float decodeRPM(const UINT8 *A, UINT8)
+{
+	return(pidWord(A, 0) * 0.25f);
+}
+
+//A/2-64
+static float decodeTiming(const UINT8 *A, UINT8)
+{
+	return((A[0] * 0.5f) - 64.0f);
+}
+
+//(256A+B)/100
+static float decodeMAF(const UINT8 *A, UINT8)
+{
+	return(pidWord(A, 0) * 0.01f);
+}
+
+//voltage A/200, short term fuel trim 100/128 B - 100
+static float decodeO2Narrow(const UINT8 *A, UINT8 idx)
+{
+	return(idx ? decodeTrim(A, 1) : A[0] * 0.005f);
+}
+
+//0.079(256A+B)
+static float decodeRailRelative(const UINT8 *A, UINT8)
+{
+	return(pidWord(A, 0) * 0.079f);
+}
+
+//10(256A+B)
+static float decodeRailGauge(const UINT8 *A, UINT8)
+{
+	return(pidWord(A, 0) * 10.0f);
+}
+
+//equivalence ratio 2/65536(256A+B), voltage 8/65536(256C+D)
+static float decodeO2WideVoltage(const UINT8 *A, UINT8 idx)
+{
+	return(pidWord(A, idx) * (idx ? (8.0f / 65536.0f) : (2.0f / 65536.0f)));
+}
+
+//signed (256A+B)/4
+static float decodeEvapPressure(const UINT8 *A, UINT8)
+{
+	return((SINT16)(short)pidWord(A, 0) * 0.25f);
+}
+
+//equivalence ratio 2/65536(256A+B), current (256C+D)/256 - 128
+static float decodeO2WideCurrent(const UINT8 *A, UINT8 idx)
+{
+	return(idx ? (pidWord(A, 1) / 256.0f) - 128.0f : pidWord(A, 0) * (2.0f / 65536.0f));
+}
+
+//(256A+B)/10 - 40
+static float decodeCatalystTemp(const UINT8 *A, UINT8)
+{
+	return((pidWord(A, 0) * 0.1f) - 40.0f);
+}
+
+//(256A+B)/1000
+static float decodeModuleVoltage(const UINT8 *A, UINT8)
+{
+	return(pidWord(A, 0) * 0.001f);
+}
+
+//100/255(256A+B)
+static float decodeAbsoluteLoad(const UINT8 *A, UINT8)
+{
+	return(pidWord(A, 0) * (100.0f / 255.0f));
+}
+
+//2/65536(256A+B)
+static float decodeEquivRatio(const UINT8 *A, UINT8)
+{
+	return(pidWord(A, 0) * (2.0f / 65536.0f));
+}
+
+//max equivalence ratio A, O2 voltage B (V), O2 current C (mA), intake MAP 10D (kPa)
+static float decodeMaxValues(const UINT8 *A, UINT8 idx)
+{
+	return(idx == 3 ? A[3] * 10.0f : A[idx]);
+}
+
+//10A
+static float decodeMaxMAF(const UINT8 *A, UINT8)
+{
+	return(A[0] * 10.0f);
+}
+
+//(256A+B)/200
+static float decodeEvapAbsolute(const UINT8 *A, UINT8)
+{
+	return(pidWord(A, 0) * 0.005f);
+}
+
+//signed 256A+B
+static float decodeSignedWord(const UINT8 *A, UINT8)
+{
+	return((SINT16)(short)pidWord(A, 0));
+}
+
+//(256A+B)/128 - 210
+static float decodeInjectionTiming(const UINT8 *A, UINT8)
+{
+	return((pidWord(A, 0) / 128.0f) - 210.0f);
+}
+
+//(256A+B)/20
+static float decodeFuelRate(const UINT8 *A, UINT8)
+{
+	return(pidWord(A, 0) * 0.05f);
+}
+
+//A-125 (idx selects A-E for torque data)
+static float decodeTorque(const UINT8 *A, UINT8 idx)
+{
+	return((SINT32)A[idx] - 125);
+}
+
+/**
+ * Built-in mode 01 PID catalogue, indexed directly by PID (0x00 - OBD_PID_CATALOGUE_MAX).
+ * Declared const so that it is placed in flash rather than RAM.
+ *
+ * bytes, values, name, units, decode function, linear slope, offset (slope = 0 if not linear), signed
+ */
+static const sOBDPIDInfo OBDPIDCatalogue[OBD_PID_CATALOGUE_MAX + 1] =
+{
+	/*0x00*/ {4, 4, "PIDs Supported 01-20 "  , ""       , decodeBits,            0          , 0    , false},
+	/*0x01*/ {4, 4, "Monitor Status "        , ""       , decodeBits,            0          , 0    , false},
+	/*0x02*/ {2, 2, "Freeze DTC "            , ""       , decodeBits,            0          , 0    , false},
+	/*0x03*/ {2, 2, "Fuel System Status "    , ""       , decodeBits,            0          , 0    , false},
+	/*0x04*/ {1, 1, "Load "                  , " %"     , decodePercent,         100.0f/255 , 0    , false},
+	/*0x05*/ {1, 1, "Coolant "               , " C"     , decodeTemp,            1          , -40  , false},
+	/*0x06*/ {1, 1, "STFT Bank 1 "           , " %"     , decodeTrim,            100.0f/128 , -100 , false},
+	/*0x07*/ {1, 1, "LTFT Bank 1 "           , " %"     , decodeTrim,            100.0f/128 , -100 , false},
+	/*0x08*/ {1, 1, "STFT Bank 2 "           , " %"     , decodeTrim,            100.0f/128 , -100 , false},
+	/*0x09*/ {1, 1, "LTFT Bank 2 "           , " %"     , decodeTrim,            100.0f/128 , -100 , false},
+	/*0x0A*/ {1, 1, "Fuel Pressure "         , " kPa"   , decodeFuelPressure,    3          , 0    , false},
+	/*0x0B*/ {1, 1, "MAP "                   , " kPa"   , decodeByte,            1          , 0    , false},
+	/*0x0C*/ {2, 1, "Engine Speed "          , " RPM"   , decodeRPM,             0.25f      , 0    , false},
+	/*0x0D*/ {1, 1, "Speed "                 , " KPH"   , decodeByte,            1          , 0    , false},
+	/*0x0E*/ {1, 1, "Timing Advance "        , " deg"   , decodeTiming,          0.5f       , -64  , false},
+	/*0x0F*/ {1, 1, "IAT "                   , " C"     , decodeTemp,            1          , -40  , false},
+	/*0x10*/ {2, 1, "MAF "                   , " grams/s", decodeMAF,             0.01f      , 0    , false},
+	/*0x11*/ {1, 1, "Throttle "              , " %"     , decodePercent,         100.0f/255 , 0    , false},
+	/*0x12*/ {1, 1, "Secondary Air Status "  , ""       , decodeBits,            0          , 0    , false},
+	/*0x13*/ {1, 1, "O2 Sensors Present "    , ""       , decodeBits,            0          , 0    , false},
+	/*0x14*/ {2, 2, "O2 B1S1 "               , " V, %"  , decodeO2Narrow,        0          , 0    , false},
+	/*0x15*/ {2, 2, "O2 B1S2 "               , " V, %"  , decodeO2Narrow,        0          , 0    , false},
+	/*0x16*/ {2, 2, "O2 B1S3 "               , " V, %"  , decodeO2Narrow,        0          , 0    , false},
+	/*0x17*/ {2, 2, "O2 B1S4 "               , " V, %"  , decodeO2Narrow,        0          , 0    , false},
+	/*0x18*/ {2, 2, "O2 B2S1 "               , " V, %"  , decodeO2Narrow,        0          , 0    , false},
+	/*0x19*/ {2, 2, "O2 B2S2 "               , " V, %"  , decodeO2Narrow,        0          , 0    , false},
+	/*0x1A*/ {2, 2, "O2 B2S3 "               , " V, %"  , decodeO2Narrow,        0          , 0    , false},
+	/*0x1B*/ {2, 2, "O2 B2S4 "               , " V, %"  , decodeO2Narrow,        0          , 0    , false},
+	/*0x1C*/ {1, 1, "OBD Standard "          , ""       , decodeBits,            0          , 0    , false},
+	/*0x1D*/ {1, 1, "O2 Sensors Present "    , ""       , decodeBits,            0          , 0    , false},
+	/*0x1E*/ {1, 1, "Aux Input Status "      , ""       , decodeBits,            0          , 0    , false},
+	/*0x1F*/ {2, 1, "Run Time "              , " s"     , decodeWord,            1          , 0    , false},
+	/*0x20*/ {4, 4, "PIDs Supported 21-40 "  , ""       , decodeBits,            0          , 0    , false},
+	/*0x21*/ {2, 1, "Distance MIL On "       , " km"    , decodeWord,            1          , 0    , false},
+	/*0x22*/ {2, 1, "Fuel Rail Pressure "    , " kPa"   , decodeRailRelative,    0.079f     , 0    , false},
+	/*0x23*/ {2, 1, "Fuel Rail Pressure "    , " kPa"   , decodeRailGauge,       10         , 0    , false},
+	/*0x24*/ {4, 2, "O2 S1 WR "              , " ratio, V" , decodeO2WideVoltage,   0          , 0    , false},
+	/*0x25*/ {4, 2, "O2 S2 WR "              , " ratio, V" , decodeO2WideVoltage,   0          , 0    , false},
+	/*0x26*/ {4, 2, "O2 S3 WR "              , " ratio, V" , decodeO2WideVoltage,   0          , 0    , false},
+	/*0x27*/ {4, 2, "O2 S4 WR "              , " ratio, V" , decodeO2WideVoltage,   0          , 0    , false},
+	/*0x28*/ {4, 2, "O2 S5 WR "              , " ratio, V" , decodeO2WideVoltage,   0          , 0    , false},
+	/*0x29*/ {4, 2, "O2 S6 WR "              , " ratio, V" , decodeO2WideVoltage,   0          , 0    , false},
+	/*0x2A*/ {4, 2, "O2 S7 WR "              , " ratio, V" , decodeO2WideVoltage,   0          , 0    , false},
+	/*0x2B*/ {4, 2, "O2 S8 WR "              , " ratio, V" , decodeO2WideVoltage,   0          , 0    , false},
+	/*0x2C*/ {1, 1, "Commanded EGR "         , " %"     , decodePercent,         100.0f/255 , 0    , false},
+	/*0x2D*/ {1, 1, "EGR Error "             , " %"     , decodeTrim,            100.0f/128 , -100 , false},
+	/*0x2E*/ {1, 1, "Commanded Evap Purge "  , " %"     , decodePercent,         100.0f/255 , 0    , false},
+	/*0x2F*/ {1, 1, "Fuel Level "            , " %"     , decodePercent,         100.0f/255 , 0    , false},
+	/*0x30*/ {1, 1, "Warm-ups Since Clear "  , ""       , decodeByte,            1          , 0    , false},
+	/*0x31*/ {2, 1, "Distance Since Clear "  , " km"    , decodeWord,            1          , 0    , false},
+	/*0x32*/ {2, 1, "Evap Vapor Pressure "   , " Pa"    , decodeEvapPressure,    0.25f      , 0    , true },
+	/*0x33*/ {1, 1, "Barometric Pressure "   , " kPa"   , decodeByte,            1          , 0    , false},
+	/*0x34*/ {4, 2, "O2 S1 WR "              , " ratio, mA", decodeO2WideCurrent,   0          , 0    , false},
+	/*0x35*/ {4, 2, "O2 S2 WR "              , " ratio, mA", decodeO2WideCurrent,   0          , 0    , false},
+	/*0x36*/ {4, 2, "O2 S3 WR "              , " ratio, mA", decodeO2WideCurrent,   0          , 0    , false},
+	/*0x37*/ {4, 2, "O2 S4 WR "              , " ratio, mA", decodeO2WideCurrent,   0          , 0    , false},
+	/*0x38*/ {4, 2, "O2 S5 WR "              , " ratio, mA", decodeO2WideCurrent,   0          , 0    , false},
+	/*0x39*/ {4, 2, "O2 S6 WR "              , " ratio, mA", decodeO2WideCurrent,   0          , 0    , false},
+	/*0x3A*/ {4, 2, "O2 S7 WR "              , " ratio, mA", decodeO2WideCurrent,   0          , 0    , false},
+	/*0x3B*/ {4, 2, "O2 S8 WR "              , " ratio, mA", decodeO2WideCurrent,   0          , 0    , false},
+	/*0x3C*/ {2, 1, "Catalyst Temp B1S1 "    , " C"     , decodeCatalystTemp,    0.1f       , -40  , false},
+	/*0x3D*/ {2, 1, "Catalyst Temp B2S1 "    , " C"     , decodeCatalystTemp,    0.1f       , -40  , false},
+	/*0x3E*/ {2, 1, "Catalyst Temp B1S2 "    , " C"     , decodeCatalystTemp,    0.1f       , -40  , false},
+	/*0x3F*/ {2, 1, "Catalyst Temp B2S2 "    , " C"     , decodeCatalystTemp,    0.1f       , -40  , false},
+	/*0x40*/ {4, 4, "PIDs Supported 41-60 "  , ""       , decodeBits,            0          , 0    , false},
+	/*0x41*/ {4, 4, "Monitor Status Cycle "  , ""       , decodeBits,            0          , 0    , false},
+	/*0x42*/ {2, 1, "Module Voltage "        , " V"     , decodeModuleVoltage,   0.001f     , 0    , false},
+	/*0x43*/ {2, 1, "Absolute Load "         , " %"     , decodeAbsoluteLoad,    100.0f/255 , 0    , false},
+	/*0x44*/ {2, 1, "Commanded Equiv Ratio " , ""       , decodeEquivRatio,      2.0f/65536 , 0    , false},
+	/*0x45*/ {1, 1, "Relative Throttle "     , " %"     , decodePercent,         100.0f/255 , 0    , false},
+	/*0x46*/ {1, 1, "Ambient Temp "          , " C"     , decodeTemp,            1          , -40  , false},
+	/*0x47*/ {1, 1, "Throttle B "            , " %"     , decodePercent,         100.0f/255 , 0    , false},
+	/*0x48*/ {1, 1, "Throttle C "            , " %"     , decodePercent,         100.0f/255 , 0    , false},
+	/*0x49*/ {1, 1, "Accel Pedal D "         , " %"     , decodePercent,         100.0f/255 , 0    , false},
+	/*0x4A*/ {1, 1, "Accel Pedal E "         , " %"     , decodePercent,         100.0f/255 , 0    , false},
+	/*0x4B*/ {1, 1, "Accel Pedal F "         , " %"     , decodePercent,         100.0f/255 , 0    , false},
+	/*0x4C*/ {1, 1, "Commanded Throttle "    , " %"     , decodePercent,         100.0f/255 , 0    , false},
+	/*0x4D*/ {2, 1, "Time Run MIL On "       , " min"   , decodeWord,            1          , 0    , false},
+	/*0x4E*/ {2, 1, "Time Since Clear "      , " min"   , decodeWord,            1          , 0    , false},
+	/*0x4F*/ {4, 4, "Max Ratio/V/mA/MAP "    , ""       , decodeMaxValues,       0          , 0    , false},
+	/*0x50*/ {4, 1, "Max MAF "               , " grams/s", decodeMaxMAF,          0          , 0    , false},
+	/*0x51*/ {1, 1, "Fuel Type "             , ""       , decodeBits,            0          , 0    , false},
+	/*0x52*/ {1, 1, "Ethanol "               , " %"     , decodePercent,         100.0f/255 , 0    , false},
+	/*0x53*/ {2, 1, "Evap Pressure Abs "     , " kPa"   , decodeEvapAbsolute,    0.005f     , 0    , false},
+	/*0x54*/ {2, 1, "Evap Vapor Pressure "   , " Pa"    , decodeSignedWord,      1          , 0    , true },
+	/*0x55*/ {2, 2, "ST O2 Trim B1/B3 "      , " %"     , decodeTrim,            0          , 0    , false},
+	/*0x56*/ {2, 2, "LT O2 Trim B1/B3 "      , " %"     , decodeTrim,            0          , 0    , false},
+	/*0x57*/ {2, 2, "ST O2 Trim B2/B4 "      , " %"     , decodeTrim,            0          , 0    , false},
+	/*0x58*/ {2, 2, "LT O2 Trim B2/B4 "      , " %"     , decodeTrim,            0          , 0    , false},
+	/*0x59*/ {2, 1, "Fuel Rail Pressure "    , " kPa"   , decodeRailGauge,       10         , 0    , false},
+	/*0x5A*/ {1, 1, "Relative Pedal "        , " %"     , decodePercent,         100.0f/255 , 0    , false},
+	/*0x5B*/ {1, 1, "Hybrid Battery Life "   , " %"     , decodePercent,         100.0f/255 , 0    , false},
+	/*0x5C*/ {1, 1, "Oil Temp "              , " C"     , decodeTemp,            1          , -40  , false},
+	/*0x5D*/ {2, 1, "Injection Timing "      , " deg"   , decodeInjectionTiming, 1.0f/128   , -210 , false},
+	/*0x5E*/ {2, 1, "Fuel Rate "             , " L/h"   , decodeFuelRate,        0.05f      , 0    , false},
+	/*0x5F*/ {1, 1, "Emission Requirements " , ""       , decodeBits,            0          , 0    , false},
+	/*0x60*/ {4, 4, "PIDs Supported 61-80 "  , ""       , decodeBits,            0          , 0    , false},
+	/*0x61*/ {1, 1, "Demand Torque "         , " %"     , decodeTorque,          1          , -125 , false},
+	/*0x62*/ {1, 1, "Actual Torque "         , " %"     , decodeTorque,          1          , -125 , false},
+	/*0x63*/ {2, 1, "Reference Torque "      , " Nm"    , decodeWord,            1          , 0    , false},
+	/*0x64*/ {5, 5, "Torque Data "           , " %"     , decodeTorque,          0          , 0    , false}
+};
+
+/**
+ * Look up a PID in the built-in catalogue, the catalogue is indexed directly by PID
+ *
+ * @param pid - mode 01 parameter ID
+ * @return - pointer to the catalogue entry, NULL if the PID is not in the catalogue
+ */
+const sOBDPIDInfo* getOBDPIDInfo(UINT8 pid)
+{
+	return(pid <= OBD_PID_CATALOGUE_MAX ? &OBDPIDCatalogue[pid] : NULL);
+}
@@ -0,0 +1,654 @@
+/*
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#include "OBD2_Vehicle.h"
+
+/**
+ * cache image identification, the version must be changed whenever sOBDVehicleRecord changes
+ */
+#define	OBD_CACHE_MAGIC		0x4F42
+#define	OBD_CACHE_VERSION	1
+
+/**
+ * the request sequence (mode, info type/PID), mode 09 first then the mode 01 supported PID bitmaps
+ */
+static const UINT8 infoRequests[][2] =
+{
+	{0x09, INFO_VIN},
+	{0x09, INFO_CALID},
+	{0x09, INFO_CVN},
+	{0x01, PIDS_SUPPORTED_01_20},
+	{0x01, PIDS_SUPPORTED_21_40},
+	{0x01, PIDS_SUPPORTED_41_60},
+	{0x01, PIDS_SUPPORTED_61_80}
+};
+
+#define	INFO_NUM_STEPS			(sizeof(infoRequests) / sizeof(infoRequests[0]))
+#define	INFO_DISCOVERY_STEP		3
+
+/**
+ * constructor, empty cache without storage
+ */
+cOBDVehicleCache::cOBDVehicleCache()
+{
+	readFn  = NULL;
+	writeFn = NULL;
+
+	memset(&image, 0, sizeof(image));
+	image.magic   = OBD_CACHE_MAGIC;
+	image.version = OBD_CACHE_VERSION;
+}
+
+/**
+ * Set the non-volatile storage functions and load the cache. A missing or corrupt image starts an empty cache.
+ *
+ * @param _readFn  - function that reads the image, NULL for a RAM only cache
+ * @param _writeFn - function that writes the image, NULL for a RAM only cache
+ * @return - true if a valid image was loaded
+ */
+bool cOBDVehicleCache::setStorage(OBD_CACHE_READ_FN _readFn, OBD_CACHE_WRITE_FN _writeFn)
+{
+	readFn  = _readFn;
+	writeFn = _writeFn;
+
+	if (readFn && readFn((UINT8*)&image, sizeof(image)))
+	{
+		if ((image.magic == OBD_CACHE_MAGIC) && (image.version == OBD_CACHE_VERSION) &&
+			(image.checksum == calcChecksum()) && (image.next < OBD_CACHE_VEHICLES))
+		{
+			return(true);
+		}
+	}
+
+	//nothing (usable) stored yet
+	memset(&image, 0, sizeof(image));
+	image.magic   = OBD_CACHE_MAGIC;
+	image.version = OBD_CACHE_VERSION;
+
+	return(false);
+}
+
+/**
+ * Find a vehicle
+ *
+ * @param vin - null terminated VIN
+ * @return - pointer to the record, NULL if the vehicle is not in the cache
+ */
+const sOBDVehicleRecord* cOBDVehicleCache::find(const char *vin)
+{
+	UINT8 i;
+
+	if (!vin[0])
+	{
+		return(NULL);
+	}
+
+	for (i=0; i < OBD_CACHE_VEHICLES; i++)
+	{
+		if (strncmp(image.records[i].vin, vin, OBD_VIN_LENGTH) == 0)
+		{
+			return(&image.records[i]);
+		}
+	}
+
+	return(NULL);
+}
+
+/**
+ * Add or update a vehicle and save the cache. When the cache is full the oldest vehicle is replaced.
+ *
+ * @param rec - vehicle record
+ * @return - true if the cache was saved (or there is no storage)
+ */
+bool cOBDVehicleCache::store(const sOBDVehicleRecord *rec)
+{
+	sOBDVehicleRecord *dest = (sOBDVehicleRecord*)find(rec->vin);
+
+	if (!dest)
+	{
+		dest = &image.records[image.next];
+		image.next = (image.next + 1) % OBD_CACHE_VEHICLES;
+	}
+
+	*dest = *rec;
+	image.checksum = calcChecksum();
+
+	return(writeFn ? writeFn((const UINT8*)&image, sizeof(image)) : true);
+}
+
+/**
+ * Remove all vehicles and save the cache
+ */
+void cOBDVehicleCache::clear()
+{
+	memset(image.records, 0, sizeof(image.records));
+	image.next     = 0;
+	image.checksum = calcChecksum();
+
+	if (writeFn)
+	{
+		writeFn((const UINT8*)&image, sizeof(image));
+	}
+}
+
+/**
+ * Retrieve the size of the cache image in non-volatile memory
+ *
+ * @return - number of bytes
+ */
+UINT16 cOBDVehicleCache::getImageSize()
+{
+	return(sizeof(sImage));
+}
+
+/**
+ * Fletcher-16 checksum over the image (except the checksum itself)
+ *
+ * @return - checksum
+ */
+UINT16 cOBDVehicleCache::calcChecksum()
+{
+	const UINT8 *p = (const UINT8*)&image;
+	UINT16 len = (UINT16)((const UINT8*)&image.checksum - p);
+	UINT16 s1 = 0, s2 = 0;
+	UINT16 i;
+
+	for (i=0; i < len; i++)
+	{
+		s1 = (s1 + p[i]) % 255;
+		s2 = (s2 + s1) % 255;
+	}
+
+	return((s2 << 8) | s1);
+}
+
+/**
+ * constructor, registers the request and response frames with the acquisition scheduler
+ *
+ * @param _portNum  -  physical CAN port to be used
+ * @param _extended -  indicate we are using OBD2 extended ID's
+ * @param _cache    -  vehicle cache, NULL to always run discovery
+ */
+cOBDVehicleInfo::cOBDVehicleInfo(cAcquireCAN *_portNum, bool _extended, cOBDVehicleCache *_cache)
+{
+	portNum = _portNum;
+	cache   = _cache;
+	state   = INFO_IDLE;
+	step    = 0;
+	waiting = false;
+	known   = false;
+	numCal  = 0;
+	lastActivity = 0;
+	learnStart   = 0;
+	memset(&record, 0, sizeof(record));
+
+	//
+	//********** TX REQUEST FRAME ****************
+	//
+	//	| add bytes (2) | mode | info type/PID | 0x55 ... |
+	//
+	//the requests are functional (broadcast) so that all ECU's answer, a request is only sent when one is pending
+	//
+	TXFrame.ID       = _extended ? 0x18DB33F1 : 0x7DF;
+	TXFrame.rate     = QUERY_MSG;
+	TXFrame.parent   = this;
+	TXFrame.U.P.lowerPayload = 0x55555555;
+	TXFrame.U.P.upperPayload = 0x55555555;
+	TXFrame.U.b[0]   = 2;
+	portNum->addMessage(&TXFrame, TRANSMIT);
+
+	//
+	//********** RX RECEIVE FRAME ****************
+	//
+	//accept the response from any ECU, 0x7E8-0x7EF for 11bit or 0x18DAF1xx for 29bit
+	//
+	RXFrame.ID     = _extended ? 0x18DAF100 : 0x7E8;
+	RXFrame.mask   = _extended ? 0x1FFFFF00 : 0x7F8;
+	RXFrame.parent = this;
+	portNum->addMessage(&RXFrame, RECEIVE);
+}
+
+/**
+ * Start reading the vehicle information, any previous information is cleared
+ */
+void cOBDVehicleInfo::start()
+{
+	noInterrupts();
+	step     = 0;
+	waiting  = false;
+	known    = false;
+	numCal   = 0;
+	memset(&record, 0, sizeof(record));
+	collector.reset();
+	state    = INFO_READING;
+	interrupts();
+}
+
+/**
+ * Call this periodically, once the latencies of a new vehicle are measured the query interval is set and
+ * the vehicle is added to the cache
+ *
+ * @return - readout state
+ */
+OBD_INFO_STATE cOBDVehicleInfo::update()
+{
+	if (state == INFO_LEARNING)
+	{
+		if (collectLatencies((millis() - learnStart) >= OBD_LEARN_TIMEOUT_MS))
+		{
+			portNum->setQueryInterval(record.queryMs);
+
+			if (cache && record.vin[0])
+			{
+				cache->store(&record);
+			}
+
+			state = INFO_READY;
+		}
+	}
+
+	return(state);
+}
+
+/**
+ * Retrieve the readout state
+ *
+ * @return - readout state
+ */
+OBD_INFO_STATE cOBDVehicleInfo::getState()
+{
+	return(state);
+}
+
+/**
+ * this handler is called by the scheduler when there is a query slot available. Each request gets OBD_INFO_WINDOW_MS
+ * after the last response frame before the next request in the sequence is sent, the query slots in between are
+ * left to the OBD PID's.
+ *
+ * @return - bool transmit the request
+ */
+bool cOBDVehicleInfo::requestFrame()
+{
+	if ((state != INFO_READING) && (state != INFO_DISCOVERY))
+	{
+		return(false);
+	}
+
+	if (waiting)
+	{
+		//still collecting responses
+		if ((millis() - lastActivity) < OBD_INFO_WINDOW_MS)
+		{
+			return(false);
+		}
+
+		waiting = false;
+		nextStep();
+
+		if ((state != INFO_READING) && (state != INFO_DISCOVERY))
+		{
+			return(false);
+		}
+	}
+
+	TXFrame.U.b[1] = infoRequests[step][0];
+	TXFrame.U.b[2] = infoRequests[step][1];
+
+	waiting      = true;
+	lastActivity = millis();
+
+	return(true);
+}
+
+/**
+ * Move on to the next request in the sequence. A vehicle found in the cache skips discovery.
+ */
+void cOBDVehicleInfo::nextStep()
+{
+	const sOBDVehicleRecord *rec;
+
+	//VIN known, look the vehicle up
+	if ((step == 0) && cache && record.vin[0])
+	{
+		rec = cache->find(record.vin);
+		if (rec)
+		{
+			record = *rec;
+			known  = true;
+			applySupported();
+			portNum->setQueryInterval(record.queryMs);
+		}
+	}
+
+	step += 1;
+
+	if (step == INFO_DISCOVERY_STEP)
+	{
+		if (known)
+		{
+			state = INFO_READY;
+			return;
+		}
+		state = INFO_DISCOVERY;
+		return;
+	}
+
+	//each bitmap tells us if the next bitmap (PID 0x20, 0x40...) is supported
+	if ((step > INFO_DISCOVERY_STEP) && ((step == INFO_NUM_STEPS) || !(record.supported[step - INFO_DISCOVERY_STEP - 1] & 1)))
+	{
+		if (!record.supported[0])
+		{
+			//nothing answered the PID's, don't take them off the schedule
+			state = INFO_NO_RESPONSE;
+			return;
+		}
+
+		applySupported();
+		learnStart = millis();
+		state      = INFO_LEARNING;
+	}
+}
+
+/**
+ * Take the current data PID's of this port that the vehicle does not support off the query schedule
+ */
+void cOBDVehicleInfo::applySupported()
+{
+	cOBDParameter *P;
+	UINT8 i;
+
+	for (i=0; i < cOBDParameter::getNumParameters(); i++)
+	{
+		P = cOBDParameter::getParameter(i);
+		if ((P->getPort() == portNum) && (P->getMode() == CURRENT))
+		{
+			P->setSupported(isSupported((UINT8)P->getPID()));
+		}
+	}
+}
+
+/**
+ * Check if all PID's of this port have enough round trips measured and fill in the latencies of the vehicle record.
+ * The query interval is the slowest ECU's p99 round trip plus a margin, there is only one request outstanding at a time.
+ *
+ * @param force - use whatever has been measured so far
+ * @return - true if the latencies are filled in
+ */
+bool cOBDVehicleInfo::collectLatencies(bool force)
+{
+	cOBDParameter *P;
+	OBD_PID_STATUS st;
+	UINT32 rtt, worst = 0, count, id;
+	UINT8 i, e;
+
+	record.numECUs = 0;
+
+	for (i=0; i < cOBDParameter::getNumParameters(); i++)
+	{
+		P = cOBDParameter::getParameter(i);
+		if ((P->getPort() != portNum) || (P->getMode() != CURRENT))
+		{
+			continue;
+		}
+
+		st = P->getStatus();
+		if ((st != PID_ACTIVE) && (st != PID_BACKOFF))
+		{
+			continue;
+		}
+
+		count = P->getLatency()->getCount();
+		if ((count < OBD_CACHE_MIN_SAMPLES) && !force)
+		{
+			return(false);
+		}
+
+		if (!count)
+		{
+			continue;
+		}
+
+		rtt   = P->getLatency()->getPercentile(99);
+		id    = P->getResponderID();
+		worst = (rtt > worst) ? rtt : worst;
+
+		//slowest PID per ECU
+		for (e=0; e < record.numECUs; e++)
+		{
+			if (record.ecuID[e] == id)
+			{
+				break;
+			}
+		}
+
+		if ((e == record.numECUs) && (record.numECUs < OBD_CACHE_ECUS))
+		{
+			record.ecuID[e]    = id;
+			record.ecuRttUs[e] = 0;
+			record.numECUs    += 1;
+		}
+
+		if ((e < record.numECUs) && (rtt > record.ecuRttUs[e]))
+		{
+			record.ecuRttUs[e] = rtt;
+		}
+	}
+
+	record.queryMs = worst ? (worst + 999) / 1000 + OBD_QUERY_MARGIN_MS : QUERY_MS;
+	record.queryMs = (record.queryMs < OBD_MIN_QUERY_MS) ? OBD_MIN_QUERY_MS : record.queryMs;
+	record.queryMs = (record.queryMs > QUERY_MS) ? QUERY_MS : record.queryMs;
+
+	return(true);
+}
+
+/**
+ * this handler is called when a frame from any of the ECU response ID's is received
+ *
+ * @param R - pointer to the received CAN frame
+ * @return - bool this frame is part of a vehicle information response
+ */
+bool cOBDVehicleInfo::receiveFrame(RX_CAN_FRAME *R)
+{
+	const UINT8 *msg;
+	UINT16 len;
+
+	if (!waiting)
+	{
+		return(false);
+	}
+
+	switch (collector.receive(R, infoRequests[step][0] | 0x40, &msg, &len))
+	{
+	case ISOTP_RX_FIRST:
+		//clear the ECU to send the rest of the response
+		collector.sendFlowControl(portNum, getOBDRequestID(R->id), false);
+		break;
+
+	case ISOTP_RX_OVERFLOW:
+		collector.sendFlowControl(portNum, getOBDRequestID(R->id), true);
+		break;
+
+	case ISOTP_RX_COMPLETE:
+		decode(R->id, msg, len);
+		break;
+
+	case ISOTP_RX_IGNORED:
+		return(false);
+
+	default:
+		break;
+	}
+
+	//keep the request open while responses are coming in
+	lastActivity = millis();
+
+	return(true);
+}
+
+/**
+ * Decode a complete response
+ *
+ *  supported PID's:  | 0x41 | PID (0x00, 0x20...) | A | B | C | D |
+ *  VIN:              | 0x49 | 0x02 | number of items (1) | 17 chars |
+ *  calibration ID's: | 0x49 | 0x04 | number of items | 16 chars per item |
+ *  CVN's:            | 0x49 | 0x06 | number of items | 4 bytes per item |
+ *
+ * @param id  - response CAN ID of the ECU
+ * @param d   - response message
+ * @param len - number of message bytes
+ */
+void cOBDVehicleInfo::decode(UINT32 id, const UINT8 *d, UINT16 len)
+{
+	UINT8 i, n, c;
+
+	//must be the answer to the current request
+	if ((len < 2) || (d[1] != infoRequests[step][1]))
+	{
+		return;
+	}
+
+	if (d[0] == 0x41)
+	{
+		//all ECU's together support the union of their bitmaps
+		if (len >= 6)
+		{
+			record.supported[d[1] / 0x20] |= ((UINT32)d[2] << 24) | ((UINT32)d[3] << 16) | ((UINT32)d[4] << 8) | d[5];
+		}
+		return;
+	}
+
+	switch (d[1])
+	{
+	case INFO_VIN:
+		//the first ECU to answer wins, the VIN is the last 17 bytes (some ECU's pad it)
+		if (!record.vin[0] && (len >= 2 + OBD_VIN_LENGTH))
+		{
+			memcpy(record.vin, &d[len - OBD_VIN_LENGTH], OBD_VIN_LENGTH);
+			record.vin[OBD_VIN_LENGTH] = 0;
+		}
+		break;
+
+	case INFO_CALID:
+		n = (len - 3) / OBD_CALID_LENGTH;
+		for (i=0; (i < n) && (numCal < OBD_MAX_CALIDS); i++)
+		{
+			cal[numCal].ecuID    = id;
+			cal[numCal].cvn      = 0;
+			cal[numCal].cvnValid = false;
+			memcpy(cal[numCal].calID, &d[3 + i*OBD_CALID_LENGTH], OBD_CALID_LENGTH);
+
+			//calibration ID's are padded with 0x00
+			cal[numCal].calID[OBD_CALID_LENGTH] = 0;
+			numCal += 1;
+		}
+		break;
+
+	case INFO_CVN:
+		//the CVN's of an ECU are in the same order as its calibration ID's
+		n = (len - 3) / 4;
+		for (i=0, c=0; (i < n) && (c < numCal); c++)
+		{
+			if ((cal[c].ecuID == id) && !cal[c].cvnValid)
+			{
+				cal[c].cvn      = ((UINT32)d[3 + i*4] << 24) | ((UINT32)d[4 + i*4] << 16) | ((UINT32)d[5 + i*4] << 8) | d[6 + i*4];
+				cal[c].cvnValid = true;
+				i += 1;
+			}
+		}
+		break;
+
+	default:
+		break;
+	}
+}
+
+/**
+ * Retrieve the VIN
+ *
+ * @return - null terminated VIN, empty if it has not been read (yet)
+ */
+const char* cOBDVehicleInfo::getVIN()
+{
+	return(record.vin);
+}
+
+/**
+ * Retrieve the number of calibration ID's reported by all ECU's
+ *
+ * @return - number of calibration ID's
+ */
+UINT8 cOBDVehicleInfo::getNumCalibrations()
+{
+	return(numCal);
+}
+
+/**
+ * Retrieve a calibration ID and its CVN
+ *
+ * @param idx - calibration index
+ * @return - pointer to the calibration, NULL if idx is out of range
+ */
+const sOBDCalibration* cOBDVehicleInfo::getCalibration(UINT8 idx)
+{
+	return((idx < numCal) ? &cal[idx] : NULL);
+}
+
+/**
+ * Check if the vehicle was found in the cache
+ *
+ * @return - true if discovery was skipped
+ */
+bool cOBDVehicleInfo::isKnownVehicle()
+{
+	return(known);
+}
+
+/**
+ * Check if a mode 01 PID is supported by the vehicle. The "PIDs supported" PID's themselves are always supported,
+ * PID's beyond the bitmaps that are read are assumed to be supported.
+ *
+ * @param pid - mode 01 parameter ID
+ * @return - true if at least one ECU supports the PID
+ */
+bool cOBDVehicleInfo::isSupported(UINT8 pid)
+{
+	if ((pid == 0) || (pid > 0x80))
+	{
+		return(true);
+	}
+
+	return((record.supported[(pid - 1) / 32] >> (31 - ((pid - 1) % 32))) & 1);
+}
+
+/**
+ * This is a overridden implementaiton of the base class member that is called by the acquisition scheduler when a query slot is available
+ *
+ * @return - a flag to transmit or skip this CAN frame
+ */
+bool cOBDInfoTXFrame::CallbackTx()
+{
+	return(parent->requestFrame());
+}
+
+/**
+ * This is a overridden implementaiton of the base class member that is called by the acquisition scheduler when a receive message matching this CAN ID has been received.
+ *
+ * @param R - pointer to RX Frame
+ * @return - a flag to accept or reject this CAN frame
+ */
+bool cOBDInfoRXFrame::CallbackRx(RX_CAN_FRAME *R)
+{
+	return(R ? parent->receiveFrame(R) : false);
+}
@@ -0,0 +1,410 @@
+/*
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#include <OBD2.h>
+#include <ISOTP.h>
+
+#ifndef OBD2_VEHICLE_H
+#define OBD2_VEHICLE_H
+
+/**
+ *
+ * This macro is used to set the number of characters in a VIN
+ */
+#define	OBD_VIN_LENGTH			17
+
+/**
+ *
+ * This macro is used to set the number of characters in a calibration ID
+ */
+#define	OBD_CALID_LENGTH		16
+
+/**
+ *
+ * This macro is used to set the maximum number of calibration ID's (and CVN's) kept for all ECU's
+ */
+#define	OBD_MAX_CALIDS			4
+
+/**
+ *
+ * This macro is used to set how long (mS) to wait for more responses after a request or the last response frame
+ */
+#define	OBD_INFO_WINDOW_MS		150
+
+/**
+ *
+ * This macro is used to set the number of vehicles kept in the cache
+ */
+#define	OBD_CACHE_VEHICLES		4
+
+/**
+ *
+ * This macro is used to set the number of ECU's per vehicle with measured latencies kept in the cache
+ */
+#define	OBD_CACHE_ECUS			4
+
+/**
+ *
+ * This macro is used to set the number of round trips measured for every PID before the latencies of a new vehicle are cached
+ */
+#define	OBD_CACHE_MIN_SAMPLES	10
+
+/**
+ *
+ * This macro is used to set how long (mS) to measure the latencies of a new vehicle at most (PID's that are backing off
+ * may never reach OBD_CACHE_MIN_SAMPLES)
+ */
+#define	OBD_LEARN_TIMEOUT_MS	30000
+
+/**
+ *
+ * This macro is used to set the fastest query interval (mS) and the margin added to the slowest ECU's p99 round trip
+ */
+#define	OBD_MIN_QUERY_MS		10
+#define	OBD_QUERY_MARGIN_MS		4
+
+/**
+ *
+ * This enum represents the mode 09 info types that are read
+ */
+enum OBD_INFO_TYPE
+{
+	INFO_VIN   = 0x02,
+	INFO_CALID = 0x04,
+	INFO_CVN   = 0x06
+};
+
+/**
+ *
+ * This enum represents the state of the vehicle information readout
+ */
+enum OBD_INFO_STATE
+{
+	INFO_IDLE        = 0,	//nothing requested yet
+	INFO_READING     = 1,	//reading VIN, calibration ID's and CVN's (mode 09)
+	INFO_DISCOVERY   = 2,	//unknown vehicle, reading the supported PID bitmaps (mode 01 PID 0x00, 0x20...)
+	INFO_LEARNING    = 3,	//unknown vehicle, measuring the ECU latencies before caching the vehicle
+	INFO_READY       = 4,	//all done, PID's are polled at the fastest safe query interval
+	INFO_NO_RESPONSE = 5	//no ECU answered
+};
+
+/**
+ *
+ * This struct represents one vehicle in the cache, everything needed to skip discovery when the vehicle is seen again
+ */
+struct sOBDVehicleRecord
+{
+	/**
+	 * null terminated VIN, the key of the cache (empty = unused record)
+	 */
+	char   vin[OBD_VIN_LENGTH + 1];
+
+	/**
+	 * mode 01 supported PID bitmaps of all ECU's, PID's 0x01-0x20, 0x21-0x40, 0x41-0x60, 0x61-0x80 (MSB = first PID)
+	 */
+	UINT32 supported[4];
+
+	/**
+	 * response ID and p99 round trip (uS) of the ECU's that answer the PID's
+	 */
+	UINT8  numECUs;
+	UINT32 ecuID[OBD_CACHE_ECUS];
+	UINT32 ecuRttUs[OBD_CACHE_ECUS];
+
+	/**
+	 * query interval (mS) that was derived from the latencies
+	 */
+	UINT16 queryMs;
+};
+
+/**
+ *
+ * This struct represents a calibration ID and its calibration verification number as reported by an ECU
+ */
+struct sOBDCalibration
+{
+	UINT32 ecuID;
+	char   calID[OBD_CALID_LENGTH + 1];
+	UINT32 cvn;
+	bool   cvnValid;
+};
+
+/**
+ * This is the function used to read the cache from non-volatile memory (SD card, flash, FRAM...)
+ *
+ * @param buf - destination
+ * @param len - number of bytes to read
+ * @return - true if the bytes were read
+ */
+typedef bool (*OBD_CACHE_READ_FN)(UINT8 *buf, UINT16 len);
+
+/**
+ * This is the function used to write the cache to non-volatile memory
+ *
+ * @param buf - source
+ * @param len - number of bytes to write
+ * @return - true if the bytes were written
+ */
+typedef bool (*OBD_CACHE_WRITE_FN)(const UINT8 *buf, UINT16 len);
+
+/**
+ * Per-vehicle cache keyed by VIN. The cache is a fixed size image in RAM that is loaded from and saved to non-volatile
+ * memory through user supplied functions (the DUE has no EEPROM), so any storage can be used.
+ *
+ * @author D.Kasamis - dan@togglebit.net
+ * @version 1.0
+ */
+class cOBDVehicleCache
+{
+public:
+	cOBDVehicleCache();
+
+	/**
+	 * Set the non-volatile storage functions and load the cache. A missing or corrupt image starts an empty cache.
+	 *
+	 * @param _readFn  - function that reads the image, NULL for a RAM only cache
+	 * @param _writeFn - function that writes the image, NULL for a RAM only cache
+	 * @return - true if a valid image was loaded
+	 */
+	bool setStorage(OBD_CACHE_READ_FN _readFn, OBD_CACHE_WRITE_FN _writeFn);
+
+	/**
+	 * Find a vehicle
+	 *
+	 * @param vin - null terminated VIN
+	 * @return - pointer to the record, NULL if the vehicle is not in the cache
+	 */
+	const sOBDVehicleRecord* find(const char *vin);
+
+	/**
+	 * Add or update a vehicle and save the cache. When the cache is full the oldest vehicle is replaced.
+	 *
+	 * @param rec - vehicle record
+	 * @return - true if the cache was saved (or there is no storage)
+	 */
+	bool store(const sOBDVehicleRecord *rec);
+
+	/**
+	 * Remove all vehicles and save the cache
+	 */
+	void clear();
+
+	/**
+	 * Retrieve the size of the cache image in non-volatile memory
+	 *
+	 * @return - number of bytes
+	 */
+	static UINT16 getImageSize();
+
+private:
+	/**
+	 * the image written to non-volatile memory
+	 */
+	struct sImage
+	{
+		UINT16 magic;
+		UINT8  version;
+		UINT8  next;
+		sOBDVehicleRecord records[OBD_CACHE_VEHICLES];
+		UINT16 checksum;
+	} image;
+
+	OBD_CACHE_READ_FN  readFn;
+	OBD_CACHE_WRITE_FN writeFn;
+
+	/**
+	 * checksum over the image (except the checksum itself)
+	 */
+	UINT16 calcChecksum();
+};
+
+class cOBDVehicleInfo;
+
+/**
+ * this is the transmit frame that is used to make the mode 09 and supported PID requests, it only asks for a query slot when
+ * a request is pending
+ */
+class cOBDInfoTXFrame : public cCANFrame
+{
+public:
+	cOBDVehicleInfo *parent;
+
+private:
+	bool  CallbackTx();
+};
+
+/**
+ * this is the receive frame that accepts the (single or multi-frame) responses from any ECU
+ */
+class cOBDInfoRXFrame : public cCANFrame
+{
+public:
+	cOBDVehicleInfo *parent;
+
+private:
+	bool  CallbackRx(RX_CAN_FRAME *R);
+};
+
+/**
+ * Vehicle information (mode 09 VIN, calibration ID's and CVN's) and supported PID discovery.
+ * The VIN is read first, if the vehicle is in the cache its supported PID's and query interval are applied straight away.
+ * Otherwise the supported PID bitmaps are read, unsupported PID's are taken off the query schedule, the ECU latencies are
+ * measured from the normal PID polling and the vehicle is added to the cache. The requests share the query schedule of
+ * the acquisition scheduler with the OBD PID's.
+ *
+ * @author D.Kasamis - dan@togglebit.net
+ * @version 1.0
+ */
+class cOBDVehicleInfo
+{
+public:
+	/**
+	 * constructor, registers the request and response frames with the acquisition scheduler
+	 *
+	 * @param _portNum  -  physical CAN port to be used
+	 * @param _extended -  indicate we are using OBD2 extended ID's
+	 * @param _cache    -  vehicle cache, NULL to always run discovery
+	 */
+	cOBDVehicleInfo(cAcquireCAN *_portNum, bool _extended, cOBDVehicleCache *_cache);
+
+	/**
+	 * Start reading the vehicle information (e.g. once the ignition is on), any previous information is cleared
+	 */
+	void start();
+
+	/**
+	 * Call this periodically (e.g. in loop()), this is where the vehicle is added to the cache (not from the scheduler
+	 * interrupt, writing non-volatile memory can be slow)
+	 *
+	 * @return - readout state
+	 */
+	OBD_INFO_STATE update();
+
+	/**
+	 * Retrieve the readout state
+	 *
+	 * @return - readout state
+	 */
+	OBD_INFO_STATE getState();
+
+	/**
+	 * Retrieve the VIN
+	 *
+	 * @return - null terminated VIN, empty if it has not been read (yet)
+	 */
+	const char* getVIN();
+
+	/**
+	 * Retrieve the calibration ID's (with CVN's) reported by all ECU's
+	 */
+	UINT8 getNumCalibrations();
+	const sOBDCalibration* getCalibration(UINT8 idx);
+
+	/**
+	 * Check if the vehicle was found in the cache
+	 *
+	 * @return - true if discovery was skipped
+	 */
+	bool isKnownVehicle();
+
+	/**
+	 * Check if a mode 01 PID is supported by the vehicle (valid once discovery is done or the vehicle was found in the cache)
+	 *
+	 * @param pid - mode 01 parameter ID
+	 * @return - true if at least one ECU supports the PID
+	 */
+	bool isSupported(UINT8 pid);
+
+	/**
+	 * this handler is called by the scheduler when there is a query slot available
+	 *
+	 * @return - bool transmit the request
+	 */
+	bool requestFrame();
+
+	/**
+	 * this handler is called when a frame from any of the ECU response ID's is received
+	 *
+	 * @param R - pointer to the received CAN frame
+	 * @return - bool this frame is part of a vehicle information response
+	 */
+	bool receiveFrame(RX_CAN_FRAME *R);
+
+private:
+	cAcquireCAN      *portNum;
+	cOBDVehicleCache *cache;
+
+	/**
+	 * request and response frames
+	 */
+	cOBDInfoTXFrame TXFrame;
+	cOBDInfoRXFrame RXFrame;
+
+	/**
+	 * readout state, index of the current request in the request sequence, a request is outstanding,
+	 * time (millis) of the request or the last response frame and start of the latency measurement
+	 */
+	volatile OBD_INFO_STATE state;
+	UINT8   step;
+	bool    waiting;
+	volatile UINT32 lastActivity;
+	UINT32  learnStart;
+
+	/**
+	 * vehicle record (VIN, supported PID's, latencies), the vehicle was found in the cache
+	 */
+	sOBDVehicleRecord record;
+	bool    known;
+
+	/**
+	 * calibration ID's and CVN's
+	 */
+	sOBDCalibration cal[OBD_MAX_CALIDS];
+	UINT8   numCal;
+
+	/**
+	 * multi-frame reassembly of the responses from all ECU's
+	 */
+	cISOTPCollector collector;
+
+	/**
+	 * Move on to the next request in the sequence (skipping discovery for a known vehicle)
+	 */
+	void nextStep();
+
+	/**
+	 * Take the PID's of this port that the vehicle does not support off the query schedule
+	 */
+	void applySupported();
+
+	/**
+	 * Check if all PID's of this port have enough round trips measured and fill in the latencies of the vehicle record
+	 *
+	 * @param force - use whatever has been measured so far
+	 * @return - true if the latencies are filled in
+	 */
+	bool collectLatencies(bool force);
+
+	/**
+	 * Decode a complete response
+	 *
+	 * @param id  - response CAN ID of the ECU
+	 * @param d   - response message (response mode, info type/PID, data...)
+	 * @param len - number of message bytes
+	 */
+	void decode(UINT32 id, const UINT8 *d, UINT16 len);
+};
+
+#endif
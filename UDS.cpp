@@ -0,0 +1,450 @@
+/*
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#include "UDS.h"
+
+/**
+ * constructor, registers the request and response frames with the acquisition scheduler
+ *
+ * @param _portNum    - physical CAN port to be used
+ * @param _requestID  - CAN ID of the requests to the ECU
+ * @param _responseID - CAN ID of the responses from the ECU
+ */
+cUDSClient::cUDSClient(cAcquireCAN *_portNum, UINT32 _requestID, UINT32 _responseID)
+{
+	portNum        = _portNum;
+	numDIDs        = 0;
+	rrIndex        = 0;
+	head           = 0;
+	numOutstanding = 0;
+	maxOutstanding = 1;
+	didsPerRequest = UDS_MAX_DIDS_PER_REQ;
+	testerPresent  = true;
+	lastTx         = 0;
+	requestCtr     = 0;
+	timeoutCtr     = 0;
+	pendingCtr     = 0;
+	negativeCtr    = 0;
+	lastNRC        = 0;
+
+	//requests and TesterPresent, the client decides on every scheduler tick if something is to be sent
+	TXFrame.ID     = _requestID;
+	TXFrame.rate   = TICK_MSG;
+	TXFrame.parent = this;
+	portNum->addMessage(&TXFrame, TRANSMIT);
+
+	//responses from this ECU only
+	RXFrame.ID     = _responseID;
+	RXFrame.parent = this;
+	portNum->addMessage(&RXFrame, RECEIVE);
+}
+
+/**
+ * Add a data identifier to the poll schedule
+ *
+ * @param did      - data identifier
+ * @param length   - number of data bytes the ECU returns for this DID
+ * @param periodMs - poll period in mS
+ * @return - index of the DID, UDS_INVALID_DID if the list is full or the length is too big
+ */
+UINT8 cUDSClient::addDID(UINT16 did, UINT8 length, UINT16 periodMs)
+{
+	sUDSDID *D;
+
+	if ((numDIDs >= UDS_MAX_DIDS) || (length == 0) || (length > UDS_MAX_DID_DATA))
+	{
+		return(UDS_INVALID_DID);
+	}
+
+	D = &dids[numDIDs];
+	D->did         = did;
+	D->length      = length;
+	D->periodMs    = periodMs;
+	D->lastRequest = millis() - periodMs;
+	D->pending     = false;
+	D->valid       = false;
+	D->rxCtr       = 0;
+	memset(D->data, 0, UDS_MAX_DID_DATA);
+
+	numDIDs += 1;
+	return(numDIDs - 1);
+}
+
+/**
+ * Set the number of requests that may be outstanding at once
+ *
+ * @param n - 1 to UDS_MAX_OUTSTANDING
+ */
+void cUDSClient::setMaxOutstanding(UINT8 n)
+{
+	maxOutstanding = (n < 1) ? 1 : ((n > UDS_MAX_OUTSTANDING) ? UDS_MAX_OUTSTANDING : n);
+}
+
+/**
+ * Set the maximum number of DID's per request
+ *
+ * @param n - 1 to UDS_MAX_DIDS_PER_REQ
+ */
+void cUDSClient::setDIDsPerRequest(UINT8 n)
+{
+	didsPerRequest = (n < 1) ? 1 : ((n > UDS_MAX_DIDS_PER_REQ) ? UDS_MAX_DIDS_PER_REQ : n);
+}
+
+/**
+ * Enable/disable TesterPresent keep-alive
+ *
+ * @param enable - true to send TesterPresent when idle
+ */
+void cUDSClient::setTesterPresent(bool enable)
+{
+	testerPresent = enable;
+}
+
+/**
+ * this handler is called by the scheduler on every tick. At most one frame is sent per tick:
+ * a request for the DID's that are due (if a request may be outstanding) or TesterPresent when idle.
+ *
+ *  ReadDataByIdentifier: | add bytes | 0x22 | DID hi | DID lo | DID hi | DID lo | ...
+ *  TesterPresent:        | 0x02 | 0x3E | 0x80 (no response) |
+ *
+ * @return - bool transmit the frame
+ */
+bool cUDSClient::requestFrame()
+{
+	UINT32 now = millis();
+	sOutstanding *O;
+	sUDSDID *D;
+	UINT8 i, n = 0;
+
+	//the ECU did not answer the request it is working on, it won't answer it now
+	if (numOutstanding && ((SINT32)(now - outstanding[head].deadline) > 0))
+	{
+		for (i=0; i < outstanding[head].numDIDs; i++)
+		{
+			dids[outstanding[head].idx[i]].pending = false;
+		}
+		timeoutCtr += 1;
+		rx.reset();
+		popOutstanding(now);
+	}
+
+	if (numOutstanding < maxOutstanding)
+	{
+		O = &outstanding[(head + numOutstanding) % UDS_MAX_OUTSTANDING];
+
+		//collect the DID's that are due, round robin so that no DID is starved
+		for (i=0; (i < numDIDs) && (n < didsPerRequest); i++)
+		{
+			D = &dids[rrIndex];
+
+			if (!D->pending && ((now - D->lastRequest) >= D->periodMs))
+			{
+				O->idx[n] = rrIndex;
+				n += 1;
+			}
+			rrIndex = (rrIndex + 1 < numDIDs) ? rrIndex + 1 : 0;
+		}
+
+		if (n)
+		{
+			TXFrame.U.P.lowerPayload = 0x55555555;
+			TXFrame.U.P.upperPayload = 0x55555555;
+			TXFrame.U.b[0] = 1 + 2*n;
+			TXFrame.U.b[1] = UDS_READ_DATA_BY_ID;
+
+			for (i=0; i < n; i++)
+			{
+				D = &dids[O->idx[i]];
+				D->pending     = true;
+				D->lastRequest = now;
+				TXFrame.U.b[2 + 2*i] = (UINT8)(D->did >> 8);
+				TXFrame.U.b[3 + 2*i] = (UINT8)D->did;
+			}
+
+			//only the request the ECU is working on is timed, the others wait in line
+			O->numDIDs = n;
+			O->deadline = now + UDS_P2_MS;
+			numOutstanding += 1;
+
+			requestCtr += 1;
+			lastTx = now;
+			return(true);
+		}
+	}
+
+	//nothing else going on, keep the diagnostic session alive
+	if (testerPresent && ((now - lastTx) >= UDS_TESTER_PRESENT_MS))
+	{
+		TXFrame.U.P.lowerPayload = 0x55555555;
+		TXFrame.U.P.upperPayload = 0x55555555;
+		TXFrame.U.b[0] = 2;
+		TXFrame.U.b[1] = UDS_TESTER_PRESENT;
+		TXFrame.U.b[2] = 0x80;
+
+		lastTx = now;
+		return(true);
+	}
+
+	return(false);
+}
+
+/**
+ * Remove the oldest outstanding request, the next request is being processed from now on
+ *
+ * @param now - current time (millis)
+ */
+void cUDSClient::popOutstanding(UINT32 now)
+{
+	head = (head + 1) % UDS_MAX_OUTSTANDING;
+	numOutstanding -= 1;
+
+	if (numOutstanding)
+	{
+		outstanding[head].deadline = now + UDS_P2_MS;
+	}
+}
+
+/**
+ * this handler is called when a frame from the ECU is received
+ *
+ * @param R - pointer to the received CAN frame
+ * @return - bool this frame was accepted
+ */
+bool cUDSClient::receiveFrame(RX_CAN_FRAME *R)
+{
+	switch (rx.receive(R->data.byte))
+	{
+	case ISOTP_RX_FIRST:
+	case ISOTP_RX_OVERFLOW:
+		//clear the ECU to send the rest of the response (or tell it the response is too big), to the request ID as well.
+		//Queued, this runs in RXmsg() with interrupts off
+		cISOTPRx::sendFlowControl(portNum, TXFrame.ID, !rx.isBusy(), 0, ISOTP_STMIN);
+		break;
+
+	case ISOTP_RX_COMPLETE:
+		decode(rx.getData(), rx.getLength());
+		break;
+
+	case ISOTP_RX_IGNORED:
+		return(false);
+
+	default:
+		break;
+	}
+
+	return(true);
+}
+
+/**
+ * Decode a complete response
+ *
+ *  positive response: | 0x62 | DID hi | DID lo | data (length of the DID) | DID hi | DID lo | data | ...
+ *  negative response: | 0x7F | service | NRC |
+ *
+ * @param d   - response message
+ * @param len - number of message bytes
+ */
+void cUDSClient::decode(const UINT8 *d, UINT16 len)
+{
+	UINT32 now = millis();
+	sOutstanding *O;
+	UINT16 pos = 1, did;
+	UINT8 i, k;
+
+	if (!numOutstanding)
+	{
+		return;
+	}
+
+	O = &outstanding[head];
+
+	if ((d[0] == UDS_NEGATIVE_RESP) && (len >= 3) && (d[1] == UDS_READ_DATA_BY_ID))
+	{
+		//the ECU needs more time for the request it is working on
+		if (d[2] == 0x78)
+		{
+			O->deadline = now + UDS_P2_EXT_MS;
+			pendingCtr += 1;
+			return;
+		}
+
+		lastNRC      = d[2];
+		negativeCtr += 1;
+
+	} else if (d[0] == (UDS_READ_DATA_BY_ID | 0x40))
+	{
+		//the response echoes the DID's, each is followed by its data
+		while ((pos + 2) <= len)
+		{
+			did = ((UINT16)d[pos] << 8) | d[pos + 1];
+
+			for (k=0; k < numDIDs; k++)
+			{
+				if (dids[k].did == did)
+				{
+					break;
+				}
+			}
+
+			if ((k == numDIDs) || ((pos + 2 + dids[k].length) > len))
+			{
+				break;
+			}
+
+			memcpy(dids[k].data, &d[pos + 2], dids[k].length);
+			dids[k].valid  = true;
+			dids[k].rxCtr += 1;
+
+			pos += 2 + dids[k].length;
+		}
+
+	} else
+	{
+		//TesterPresent or another service, not the answer to a read
+		return;
+	}
+
+	//the oldest request has been answered
+	for (i=0; i < O->numDIDs; i++)
+	{
+		dids[O->idx[i]].pending = false;
+	}
+	popOutstanding(now);
+}
+
+/**
+ * Check if a DID has been received
+ *
+ * @param idx - index returned by addDID()
+ * @return - true once at least one response has been received
+ */
+bool cUDSClient::isValid(UINT8 idx)
+{
+	return((idx < numDIDs) ? dids[idx].valid : false);
+}
+
+/**
+ * Retrieve the most recent data of a DID
+ *
+ * @param idx - index returned by addDID()
+ * @return - pointer to the data bytes, NULL if idx is out of range
+ */
+const UINT8* cUDSClient::getData(UINT8 idx)
+{
+	return((idx < numDIDs) ? dids[idx].data : NULL);
+}
+
+/**
+ * Retrieve the first (up to) 4 data bytes of a DID as an unsigned big endian integer
+ *
+ * @param idx - index returned by addDID()
+ * @return - integer value
+ */
+UINT32 cUDSClient::getInt(UINT8 idx)
+{
+	UINT32 v = 0;
+	UINT8 i;
+
+	if (idx < numDIDs)
+	{
+		for (i=0; (i < dids[idx].length) && (i < 4); i++)
+		{
+			v = (v << 8) | dids[idx].data[i];
+		}
+	}
+	return(v);
+}
+
+/**
+ * Retrieve the number of responses received for a DID (rolling)
+ *
+ * @param idx - index returned by addDID()
+ * @return - number of responses
+ */
+UINT32 cUDSClient::getRxCtr(UINT8 idx)
+{
+	return((idx < numDIDs) ? dids[idx].rxCtr : 0);
+}
+
+/**
+ * Retrieve the number of requests sent (rolling)
+ *
+ * @return - number of requests
+ */
+UINT32 cUDSClient::getRequestCtr()
+{
+	return(requestCtr);
+}
+
+/**
+ * Retrieve the number of requests that were not answered (rolling)
+ *
+ * @return - number of timeouts
+ */
+UINT32 cUDSClient::getTimeoutCtr()
+{
+	return(timeoutCtr);
+}
+
+/**
+ * Retrieve the number of response pending (0x78) answers (rolling)
+ *
+ * @return - number of response pending answers
+ */
+UINT32 cUDSClient::getPendingCtr()
+{
+	return(pendingCtr);
+}
+
+/**
+ * Retrieve the number of negative responses (rolling)
+ *
+ * @return - number of negative responses
+ */
+UINT32 cUDSClient::getNegativeCtr()
+{
+	return(negativeCtr);
+}
+
+/**
+ * Retrieve the most recent negative response code
+ *
+ * @return - negative response code, 0 if none has been received
+ */
+UINT8 cUDSClient::getLastNRC()
+{
+	return(lastNRC);
+}
+
+/**
+ * This is a overridden implementaiton of the base class member that is called by the acquisition scheduler on every tick
+ *
+ * @return - a flag to transmit or skip this CAN frame
+ */
+bool cUDSTXFrame::CallbackTx()
+{
+	return(parent->requestFrame());
+}
+
+/**
+ * This is a overridden implementaiton of the base class member that is called by the acquisition scheduler when a receive message matching this CAN ID has been received.
+ *
+ * @param R - pointer to RX Frame
+ * @return - a flag to accept or reject this CAN frame
+ */
+bool cUDSRXFrame::CallbackRx(RX_CAN_FRAME *R)
+{
+	return(R ? parent->receiveFrame(R) : false);
+}
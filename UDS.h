@@ -0,0 +1,318 @@
+/*
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#include "variant.h"
+#include <due_can.h>
+#include <CAN_Acquisition.h>
+#include <ISOTP.h>
+
+#ifndef UDS_H
+#define UDS_H
+
+/**
+ *
+ * This macro is used to set the maximum number of data identifiers (DID's) a UDS client can poll
+ */
+#define	UDS_MAX_DIDS			16
+
+/**
+ *
+ * This macro is used to set the maximum number of data bytes kept per DID
+ */
+#define	UDS_MAX_DID_DATA		24
+
+/**
+ *
+ * This macro is used to set the maximum number of DID's per ReadDataByIdentifier request (3 DID's fit a single frame request)
+ */
+#define	UDS_MAX_DIDS_PER_REQ	3
+
+/**
+ *
+ * This macro is used to set the maximum number of outstanding (pipelined) requests per ECU
+ */
+#define	UDS_MAX_OUTSTANDING		4
+
+/**
+ *
+ * This macro is used to set the response timeout (P2 client, mS) and the extended timeout after a response pending (P2*)
+ */
+#define	UDS_P2_MS				150
+#define	UDS_P2_EXT_MS			5000
+
+/**
+ *
+ * This macro is used to set the interval (mS) of TesterPresent when no other request is sent (S3 server is 5s)
+ */
+#define	UDS_TESTER_PRESENT_MS	2000
+
+/**
+ *
+ * This macro is returned instead of a DID index when the DID could not be added
+ */
+#define	UDS_INVALID_DID			0xFF
+
+/**
+ *
+ * This enum represents the UDS services used by the client
+ */
+enum UDS_SERVICE
+{
+	UDS_READ_DATA_BY_ID = 0x22,
+	UDS_TESTER_PRESENT  = 0x3E,
+	UDS_NEGATIVE_RESP   = 0x7F
+};
+
+/**
+ *
+ * This struct represents one polled data identifier
+ */
+struct sUDSDID
+{
+	/**
+	 * data identifier, number of data bytes the ECU returns for it and the poll period (mS)
+	 */
+	UINT16 did;
+	UINT8  length;
+	UINT16 periodMs;
+
+	/**
+	 * time (millis) of the last request, a request for this DID is outstanding
+	 */
+	UINT32 lastRequest;
+	bool   pending;
+
+	/**
+	 * most recent data, at least one response has been received, number of responses (rolling)
+	 */
+	UINT8  data[UDS_MAX_DID_DATA];
+	bool   valid;
+	UINT32 rxCtr;
+};
+
+class cUDSClient;
+
+/**
+ * this is the transmit frame of a UDS client, it is offered a transmit slot on every scheduler tick (TICK_MSG)
+ */
+class cUDSTXFrame : public cCANFrame
+{
+public:
+	cUDSClient *parent;
+
+private:
+	bool  CallbackTx();
+};
+
+/**
+ * this is the receive frame of a UDS client, it accepts the (single or multi-frame) responses of the ECU
+ */
+class cUDSRXFrame : public cCANFrame
+{
+public:
+	cUDSClient *parent;
+
+private:
+	bool  CallbackRx(RX_CAN_FRAME *R);
+};
+
+/**
+ * UDS (ISO 14229) ReadDataByIdentifier client for one ECU. Every DID has its own poll period, due DID's are grouped
+ * into requests of up to UDS_MAX_DIDS_PER_REQ DID's. Up to setMaxOutstanding() requests are pipelined, the ECU answers
+ * them in order. Response pending (0x78) extends the timeout of the request being processed and TesterPresent keeps
+ * the session alive when nothing else is requested.
+ *
+ * The client is driven by the acquisition scheduler tick (not the 100mS query schedule), so DID's can be polled as fast
+ * as the ECU answers.
+ *
+ * e.g.
+ *   cUDSClient ECM(&CANport0, 0x7E0, 0x7E8);
+ *   UINT8 oilTemp = ECM.addDID(0xF40C, 2, 100);
+ *   ...
+ *   if (ECM.isValid(oilTemp)) { ECM.getInt(oilTemp) ... }
+ *
+ * @author D.Kasamis - dan@togglebit.net
+ * @version 1.0
+ */
+class cUDSClient
+{
+public:
+	/**
+	 * constructor, registers the request and response frames with the acquisition scheduler
+	 *
+	 * @param _portNum    - physical CAN port to be used
+	 * @param _requestID  - CAN ID of the requests to the ECU (e.g. 0x7E0 or 0x18DA10F1)
+	 * @param _responseID - CAN ID of the responses from the ECU (e.g. 0x7E8 or 0x18DAF110)
+	 */
+	cUDSClient(cAcquireCAN *_portNum, UINT32 _requestID, UINT32 _responseID);
+
+	/**
+	 * Add a data identifier to the poll schedule
+	 *
+	 * @param did      - data identifier
+	 * @param length   - number of data bytes the ECU returns for this DID (up to UDS_MAX_DID_DATA)
+	 * @param periodMs - poll period in mS
+	 * @return - index of the DID, UDS_INVALID_DID if the list is full or the length is too big
+	 */
+	UINT8 addDID(UINT16 did, UINT8 length, UINT16 periodMs);
+
+	/**
+	 * Set the number of requests that may be outstanding at once (default 1)
+	 *
+	 * @param n - 1 to UDS_MAX_OUTSTANDING
+	 */
+	void setMaxOutstanding(UINT8 n);
+
+	/**
+	 * Set the maximum number of DID's per request (default UDS_MAX_DIDS_PER_REQ), some ECU's only accept one
+	 *
+	 * @param n - 1 to UDS_MAX_DIDS_PER_REQ
+	 */
+	void setDIDsPerRequest(UINT8 n);
+
+	/**
+	 * Enable/disable TesterPresent keep-alive (enabled by default)
+	 *
+	 * @param enable - true to send TesterPresent when no other request has been sent for UDS_TESTER_PRESENT_MS
+	 */
+	void setTesterPresent(bool enable);
+
+	/**
+	 * Check if a DID has been received
+	 *
+	 * @param idx - index returned by addDID()
+	 * @return - true once at least one response has been received
+	 */
+	bool isValid(UINT8 idx);
+
+	/**
+	 * Retrieve the most recent data of a DID
+	 *
+	 * @param idx - index returned by addDID()
+	 * @return - pointer to the data bytes, NULL if idx is out of range
+	 */
+	const UINT8* getData(UINT8 idx);
+
+	/**
+	 * Retrieve the first (up to) 4 data bytes of a DID as an unsigned big endian integer
+	 *
+	 * @param idx - index returned by addDID()
+	 * @return - integer value
+	 */
+	UINT32 getInt(UINT8 idx);
+
+	/**
+	 * Retrieve the number of responses received for a DID (rolling)
+	 *
+	 * @param idx - index returned by addDID()
+	 * @return - number of responses
+	 */
+	UINT32 getRxCtr(UINT8 idx);
+
+	/**
+	 * Retrieve the request, timeout, response pending and negative response counters (rolling) and the last negative response code
+	 */
+	UINT32 getRequestCtr();
+	UINT32 getTimeoutCtr();
+	UINT32 getPendingCtr();
+	UINT32 getNegativeCtr();
+	UINT8  getLastNRC();
+
+	/**
+	 * this handler is called by the scheduler on every tick
+	 *
+	 * @return - bool transmit the frame (request or TesterPresent)
+	 */
+	bool requestFrame();
+
+	/**
+	 * this handler is called when a frame from the ECU is received
+	 *
+	 * @param R - pointer to the received CAN frame
+	 * @return - bool this frame was accepted
+	 */
+	bool receiveFrame(RX_CAN_FRAME *R);
+
+private:
+	cAcquireCAN *portNum;
+
+	/**
+	 * request and response frames
+	 */
+	cUDSTXFrame TXFrame;
+	cUDSRXFrame RXFrame;
+
+	/**
+	 * polled DID's, the next DID to look at (round robin)
+	 */
+	sUDSDID dids[UDS_MAX_DIDS];
+	UINT8   numDIDs;
+	UINT8   rrIndex;
+
+	/**
+	 * outstanding requests, FIFO in the order they were sent (the ECU answers in order)
+	 */
+	struct sOutstanding
+	{
+		UINT8  idx[UDS_MAX_DIDS_PER_REQ];
+		UINT8  numDIDs;
+		UINT32 deadline;
+	} outstanding[UDS_MAX_OUTSTANDING];
+	UINT8   head;
+	UINT8   numOutstanding;
+
+	/**
+	 * configuration
+	 */
+	UINT8   maxOutstanding;
+	UINT8   didsPerRequest;
+	bool    testerPresent;
+
+	/**
+	 * time (millis) of the last transmitted request
+	 */
+	UINT32  lastTx;
+
+	/**
+	 * counters and last negative response code
+	 */
+	UINT32  requestCtr;
+	UINT32  timeoutCtr;
+	UINT32  pendingCtr;
+	UINT32  negativeCtr;
+	UINT8   lastNRC;
+
+	/**
+	 * multi-frame reassembly of the responses
+	 */
+	cISOTPRx rx;
+
+	/**
+	 * Remove the oldest outstanding request, the next request is being processed from now on
+	 *
+	 * @param now - current time (millis)
+	 */
+	void popOutstanding(UINT32 now);
+
+	/**
+	 * Decode a complete response
+	 *
+	 * @param d   - response message
+	 * @param len - number of message bytes
+	 */
+	void decode(const UINT8 *d, UINT16 len);
+};
+
+#endif
@@ -0,0 +1,717 @@
+/*
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#include "XCP.h"
+
+/**
+ * event channel cycle times reported by GET_DAQ_EVENT_INFO, {cycle, unit} (unit 6 = 1mS, 9 = 1S)
+ */
+static const UINT8 xcpEventCycle[XCP_NUM_EVENTS][2] = {{10, 6}, {100, 6}, {200, 6}, {1, 9}};
+
+/**
+ * memory regions the master may access, {start, end (exclusive), writable}
+ */
+static const struct
+{
+	UINT32 start;
+	UINT32 end;
+	bool   writable;
+} xcpRegions[] =
+{
+	{XCP_SRAM0_START,        XCP_SRAM0_END,        true},
+	{XCP_SRAM0_MIRROR_START, XCP_SRAM0_MIRROR_END, true},
+	{XCP_SRAM1_START,        XCP_SRAM1_END,        true},
+	{XCP_FLASH_START,        XCP_FLASH_END,        false}
+};
+
+/**
+ * Read a little endian (Intel) word from a command
+ */
+static inline UINT16 xcpGet16(const UINT8 *p)
+{
+	return((UINT16)(p[0] | (p[1] << 8)));
+}
+
+static inline UINT32 xcpGet32(const UINT8 *p)
+{
+	return((UINT32)p[0] | ((UINT32)p[1] << 8) | ((UINT32)p[2] << 16) | ((UINT32)p[3] << 24));
+}
+
+/**
+ * constructor, registers the command, DTO and event channel frames with the acquisition scheduler
+ *
+ * @param _portNum - physical CAN port to be used
+ * @param _croID   - CAN ID of the commands from the master
+ * @param _dtoID   - CAN ID of the responses and DAQ data to the master
+ */
+cXCPSlave::cXCPSlave(cAcquireCAN *_portNum, UINT32 _croID, UINT32 _dtoID)
+{
+	static const ACQ_RATE_CAN eventRate[XCP_NUM_EVENTS] = {_100Hz_Rate, _10Hz_Rate, _5Hz_Rate, _1Hz_Rate};
+	UINT8 i;
+
+	portNum     = _portNum;
+	connected   = false;
+	ctoPending  = false;
+	ctoLen      = 0;
+	mta         = 0;
+	head        = 0;
+	count       = 0;
+	queueMax    = 0;
+	dtoCtr      = 0;
+	overloadCtr = 0;
+	freeDaq();
+
+	//
+	//********** RX COMMANDS (CRO) ****************
+	//
+	//	| command code | parameters ... |
+	//
+	CROFrame.ID     = _croID;
+	CROFrame.parent = this;
+	portNum->addMessage(&CROFrame, RECEIVE);
+
+	//
+	//********** TX EVENT CHANNELS ****************
+	//
+	//sample the DAQ lists at the free-running rates, never sent
+	//
+	for (i = 0; i < XCP_NUM_EVENTS; i++)
+	{
+		EventFrame[i].ID      = _dtoID;
+		EventFrame[i].rate    = eventRate[i];
+		EventFrame[i].channel = i;
+		EventFrame[i].parent  = this;
+		portNum->addMessage(&EventFrame[i], TRANSMIT);
+	}
+
+	//
+	//********** TX RESPONSES / DAQ (DTO) ****************
+	//
+	//	response: | 0xFF | data ... |   error: | 0xFE | code |   DAQ: | PID (absolute ODT) | entries ... |
+	//
+	for (i = 0; i < XCP_DTO_PER_TICK; i++)
+	{
+		DTOFrame[i].ID     = _dtoID;
+		DTOFrame[i].rate   = TICK_MSG;
+		DTOFrame[i].parent = this;
+		portNum->addMessage(&DTOFrame[i], TRANSMIT);
+	}
+}
+
+/**
+ * Check if a master is connected
+ *
+ * @return - true if connected
+ */
+bool cXCPSlave::isConnected()
+{
+	return(connected);
+}
+
+/**
+ * Check if any DAQ list is running
+ *
+ * @return - true if DAQ is running
+ */
+bool cXCPSlave::isDaqRunning()
+{
+	UINT8 i;
+
+	for (i = 0; i < numDaq; i++)
+	{
+		if (daq[i].running)
+		{
+			return(true);
+		}
+	}
+	return(false);
+}
+
+/**
+ * Retrieve the DTO statistics (rolling)
+ */
+UINT32 cXCPSlave::getDTOCtr()
+{
+	return(dtoCtr);
+}
+
+UINT32 cXCPSlave::getOverloadCtr()
+{
+	return(overloadCtr);
+}
+
+UINT8 cXCPSlave::getQueueMax()
+{
+	return(queueMax);
+}
+
+/**
+ * this handler is called when a command is received
+ *
+ * @param R - pointer to the received CAN frame
+ * @return - bool the frame was accepted
+ */
+bool cXCPSlave::receiveFrame(RX_CAN_FRAME *R)
+{
+	command(R->data.byte);
+
+	//the response goes out through the DTO frames, nothing to keep in the CRO frame
+	return(false);
+}
+
+/**
+ * this handler is called by the scheduler on every tick, sends the pending response or the next DTO
+ *
+ * @param F - frame to fill in
+ * @return - bool transmit the frame
+ */
+bool cXCPSlave::requestFrame(cXCPTXFrame *F)
+{
+	//a command response goes ahead of the DAQ data
+	if (ctoPending)
+	{
+		memset(F->U.b, 0, 8);
+		memcpy(F->U.b, cto, ctoLen);
+		ctoPending = false;
+		return(true);
+	}
+
+	if (count)
+	{
+		memcpy(F->U.b, queue[head], 8);
+		head   = (head + 1) % XCP_DTO_QUEUE;
+		count -= 1;
+		dtoCtr++;
+		return(true);
+	}
+
+	return(false);
+}
+
+/**
+ * this handler is called by the scheduler at the rate of an event channel, samples its DAQ lists
+ *
+ * @param channel - event channel
+ */
+void cXCPSlave::event(UINT8 channel)
+{
+	UINT8 d, o, e, pos;
+	UINT8 *q;
+	sXCPDaq *D;
+	sXCPOdt *O;
+
+	if (!connected)
+	{
+		return;
+	}
+
+	for (d = 0; d < numDaq; d++)
+	{
+		D = &daq[d];
+		if (!D->running || (D->event != channel))
+		{
+			continue;
+		}
+
+		D->prescaleCnt += 1;
+		if (D->prescaleCnt < D->prescaler)
+		{
+			continue;
+		}
+		D->prescaleCnt = 0;
+
+		//a sample is all of the list's ODT's or nothing, a partial sample would mix old and new values at the master
+		if ((UINT16)count + D->numOdt > XCP_DTO_QUEUE)
+		{
+			overloadCtr++;
+			continue;
+		}
+
+		for (o = 0; o < D->numOdt; o++)
+		{
+			O   = &odt[D->firstOdt + o];
+			q   = queue[(head + count) % XCP_DTO_QUEUE];
+			pos = 1;
+
+			memset(q, 0, 8);
+			q[0] = D->firstOdt + o;
+			for (e = 0; e < O->numEntries; e++)
+			{
+				sXCPEntry *E = &entry[O->firstEntry + e];
+				if (E->size)
+				{
+					memcpy(&q[pos], (const void *)E->addr, E->size);
+					pos += E->size;
+				}
+			}
+			count += 1;
+		}
+
+		if (count > queueMax)
+		{
+			queueMax = count;
+		}
+	}
+}
+
+/**
+ * Process a command
+ *
+ * @param c - command bytes
+ */
+void cXCPSlave::command(const UINT8 *c)
+{
+	UINT8 n, i;
+	UINT16 d;
+	UINT32 addr;
+
+	//a slave that is not connected only answers CONNECT
+	if (!connected && (c[0] != XCP_CONNECT))
+	{
+		return;
+	}
+
+	switch (c[0])
+	{
+	case XCP_CONNECT:
+		connected = true;
+		cto[1] = 0x04;						//resources: DAQ
+		cto[2] = 0x00;						//Intel byte order, byte granularity, no block mode
+		cto[3] = 8;							//MAX_CTO
+		cto[4] = 8;							//MAX_DTO
+		cto[5] = 0;
+		cto[6] = 1;							//protocol layer version
+		cto[7] = 1;							//transport layer version
+		respond(8);
+		break;
+
+	case XCP_DISCONNECT:
+		freeDaq();
+		count     = 0;
+		connected = false;
+		respond(1);
+		break;
+
+	case XCP_GET_STATUS:
+		cto[1] = isDaqRunning() ? 0x40 : 0x00;
+		cto[2] = 0;							//no resource protection
+		cto[3] = 0;
+		cto[4] = 0;							//session configuration ID
+		cto[5] = 0;
+		respond(6);
+		break;
+
+	case XCP_SYNCH:
+		error(XCP_ERR_CMD_SYNCH);
+		break;
+
+	case XCP_SET_MTA:
+		mta = xcpGet32(&c[4]);
+		respond(1);
+		break;
+
+	case XCP_SHORT_UPLOAD:
+	case XCP_UPLOAD:
+		n = c[1];
+		if (c[0] == XCP_SHORT_UPLOAD)
+		{
+			mta = xcpGet32(&c[4]);
+		}
+		if ((n < 1) || (n > 7))
+		{
+			error(XCP_ERR_OUT_OF_RANGE);
+		}
+		else if (!checkAccess(mta, n, false))
+		{
+			error(XCP_ERR_ACCESS_DENIED);
+		}
+		else
+		{
+			memcpy(&cto[1], (const void *)mta, n);
+			mta += n;
+			respond(1 + n);
+		}
+		break;
+
+	case XCP_DOWNLOAD:
+		n = c[1];
+		if ((n < 1) || (n > 6))
+		{
+			error(XCP_ERR_OUT_OF_RANGE);
+		}
+		else if (!checkAccess(mta, n, true))
+		{
+			error(XCP_ERR_ACCESS_DENIED);
+		}
+		else
+		{
+			memcpy((void *)mta, &c[2], n);
+			mta += n;
+			respond(1);
+		}
+		break;
+
+	case XCP_FREE_DAQ:
+		freeDaq();
+		respond(1);
+		break;
+
+	case XCP_ALLOC_DAQ:
+		d = xcpGet16(&c[2]);
+		if (isDaqRunning())
+		{
+			error(XCP_ERR_DAQ_ACTIVE);
+		}
+		else if (numDaq || numOdt)
+		{
+			//only once after FREE_DAQ
+			error(XCP_ERR_SEQUENCE);
+		}
+		else if (d > XCP_MAX_DAQ)
+		{
+			error(XCP_ERR_MEMORY_OVERFLOW);
+		}
+		else
+		{
+			for (i = 0; i < d; i++)
+			{
+				memset(&daq[i], 0, sizeof(sXCPDaq));
+				daq[i].prescaler = 1;
+			}
+			numDaq = d;
+			respond(1);
+		}
+		break;
+
+	case XCP_ALLOC_ODT:
+		d = xcpGet16(&c[2]);
+		n = c[4];
+		if (d >= numDaq)
+		{
+			error(XCP_ERR_OUT_OF_RANGE);
+		}
+		else if (numEntries || daq[d].numOdt)
+		{
+			//the ODT's of a list are contiguous, all ODT's come before the entries
+			error(XCP_ERR_SEQUENCE);
+		}
+		else if ((UINT16)numOdt + n > XCP_MAX_ODT)
+		{
+			error(XCP_ERR_MEMORY_OVERFLOW);
+		}
+		else
+		{
+			for (i = 0; i < n; i++)
+			{
+				odt[numOdt + i].firstEntry = 0;
+				odt[numOdt + i].numEntries = 0;
+			}
+			daq[d].firstOdt = numOdt;
+			daq[d].numOdt   = n;
+			numOdt         += n;
+			respond(1);
+		}
+		break;
+
+	case XCP_ALLOC_ODT_ENTRY:
+		d = xcpGet16(&c[2]);
+		n = c[5];
+		if ((d >= numDaq) || (c[4] >= daq[d].numOdt))
+		{
+			error(XCP_ERR_OUT_OF_RANGE);
+		}
+		else if (odt[daq[d].firstOdt + c[4]].numEntries)
+		{
+			error(XCP_ERR_SEQUENCE);
+		}
+		else if ((UINT16)numEntries + n > XCP_MAX_ODT_ENTRIES)
+		{
+			error(XCP_ERR_MEMORY_OVERFLOW);
+		}
+		else
+		{
+			for (i = 0; i < n; i++)
+			{
+				entry[numEntries + i].addr = 0;
+				entry[numEntries + i].size = 0;
+			}
+			odt[daq[d].firstOdt + c[4]].firstEntry = numEntries;
+			odt[daq[d].firstOdt + c[4]].numEntries = n;
+			numEntries += n;
+			respond(1);
+		}
+		break;
+
+	case XCP_SET_DAQ_PTR:
+		d = xcpGet16(&c[2]);
+		if ((d >= numDaq) || (c[4] >= daq[d].numOdt) || (c[5] >= odt[daq[d].firstOdt + c[4]].numEntries))
+		{
+			error(XCP_ERR_OUT_OF_RANGE);
+		}
+		else if (daq[d].running)
+		{
+			error(XCP_ERR_DAQ_ACTIVE);
+		}
+		else
+		{
+			ptrOdt   = daq[d].firstOdt + c[4];
+			ptrEntry = odt[ptrOdt].firstEntry + c[5];
+			ptrEnd   = odt[ptrOdt].firstEntry + odt[ptrOdt].numEntries;
+			respond(1);
+		}
+		break;
+
+	case XCP_WRITE_DAQ:
+		addr = xcpGet32(&c[4]);
+		n    = c[2];
+		if ((ptrEntry >= ptrEnd) || (c[1] != 0xFF) || ((n != 1) && (n != 2) && (n != 4)))
+		{
+			error(XCP_ERR_OUT_OF_RANGE);
+		}
+		else if (!checkAccess(addr, n, false))
+		{
+			error(XCP_ERR_ACCESS_DENIED);
+		}
+		else
+		{
+			//the entries of an ODT have to fit a DTO behind the PID
+			UINT8 used = n;
+			for (i = odt[ptrOdt].firstEntry; i < ptrEnd; i++)
+			{
+				if (i != ptrEntry)
+				{
+					used += entry[i].size;
+				}
+			}
+
+			if (used > 7)
+			{
+				error(XCP_ERR_DAQ_CONFIG);
+			}
+			else
+			{
+				entry[ptrEntry].addr = addr;
+				entry[ptrEntry].size = n;
+				ptrEntry += 1;
+				respond(1);
+			}
+		}
+		break;
+
+	case XCP_SET_DAQ_LIST_MODE:
+		d = xcpGet16(&c[2]);
+		if ((d >= numDaq) || (xcpGet16(&c[4]) >= XCP_NUM_EVENTS))
+		{
+			error(XCP_ERR_OUT_OF_RANGE);
+		}
+		else if (c[1] & 0x32)
+		{
+			//STIM, timestamps and PID off are not supported
+			error(XCP_ERR_MODE_NOT_VALID);
+		}
+		else if (daq[d].running)
+		{
+			error(XCP_ERR_DAQ_ACTIVE);
+		}
+		else
+		{
+			daq[d].mode        = c[1];
+			daq[d].event       = c[4];
+			daq[d].prescaler   = c[6] ? c[6] : 1;
+			daq[d].prescaleCnt = 0;
+			respond(1);
+		}
+		break;
+
+	case XCP_START_STOP_DAQ_LIST:
+		d = xcpGet16(&c[2]);
+		if ((d >= numDaq) || (c[1] > 2))
+		{
+			error(XCP_ERR_OUT_OF_RANGE);
+		}
+		else if ((c[1] != 0) && !daq[d].numOdt)
+		{
+			error(XCP_ERR_DAQ_CONFIG);
+		}
+		else
+		{
+			if (c[1] == 2)
+			{
+				daq[d].selected = true;
+			}
+			else
+			{
+				daq[d].prescaleCnt = 0;
+				daq[d].running     = (c[1] == 1);
+			}
+			cto[1] = daq[d].firstOdt;		//first PID
+			respond(2);
+		}
+		break;
+
+	case XCP_START_STOP_SYNCH:
+		if (c[1] > 2)
+		{
+			error(XCP_ERR_OUT_OF_RANGE);
+			break;
+		}
+		for (i = 0; i < numDaq; i++)
+		{
+			if ((c[1] == 0) || daq[i].selected)
+			{
+				daq[i].prescaleCnt = 0;
+				daq[i].running     = (c[1] == 1);
+				daq[i].selected    = false;
+			}
+		}
+		respond(1);
+		break;
+
+	case XCP_GET_DAQ_PROCESSOR_INFO:
+		cto[1] = 0x01 | 0x02;				//dynamic configuration, prescaler
+		cto[2] = XCP_MAX_DAQ;				//MAX_DAQ
+		cto[3] = 0;
+		cto[4] = XCP_NUM_EVENTS;			//MAX_EVENT_CHANNEL
+		cto[5] = 0;
+		cto[6] = 0;							//MIN_DAQ
+		cto[7] = 0;							//absolute ODT number as PID
+		respond(8);
+		break;
+
+	case XCP_GET_DAQ_RESOLUTION_INFO:
+		cto[1] = 1;							//ODT entry granularity, max size DAQ
+		cto[2] = 4;
+		cto[3] = 1;							//ODT entry granularity, max size STIM
+		cto[4] = 4;
+		cto[5] = 0;							//no timestamps
+		cto[6] = 0;
+		cto[7] = 0;
+		respond(8);
+		break;
+
+	case XCP_GET_DAQ_EVENT_INFO:
+		d = xcpGet16(&c[2]);
+		if (d >= XCP_NUM_EVENTS)
+		{
+			error(XCP_ERR_OUT_OF_RANGE);
+			break;
+		}
+		cto[1] = 0x04;						//DAQ
+		cto[2] = 0xFF;						//any number of DAQ lists
+		cto[3] = 0;							//no name
+		cto[4] = xcpEventCycle[d][0];
+		cto[5] = xcpEventCycle[d][1];
+		cto[6] = 0;							//priority
+		respond(7);
+		break;
+
+	default:
+		error(XCP_ERR_CMD_UNKNOWN);
+		break;
+	}
+}
+
+/**
+ * Set a positive response
+ *
+ * @param len - number of bytes (PID 0xFF included), the data is filled in by the caller
+ */
+void cXCPSlave::respond(UINT8 len)
+{
+	cto[0]     = 0xFF;
+	ctoLen     = len;
+	ctoPending = true;
+}
+
+/**
+ * Set an error response
+ *
+ * @param err - error code
+ */
+void cXCPSlave::error(UINT8 err)
+{
+	cto[0]     = 0xFE;
+	cto[1]     = err;
+	ctoLen     = 2;
+	ctoPending = true;
+}
+
+/**
+ * Check that a memory range may be accessed
+ *
+ * @param addr  - start address
+ * @param len   - number of bytes
+ * @param write - the range is written
+ * @return - true if the access is allowed
+ */
+bool cXCPSlave::checkAccess(UINT32 addr, UINT32 len, bool write)
+{
+	UINT8 i;
+
+	//the whole range has to be inside one region (a range across two adjacent regions is refused)
+	for (i = 0; i < sizeof(xcpRegions) / sizeof(xcpRegions[0]); i++)
+	{
+		if ((addr >= xcpRegions[i].start) && (addr < xcpRegions[i].end) && (len <= xcpRegions[i].end - addr))
+		{
+			return(!write || xcpRegions[i].writable);
+		}
+	}
+	return(false);
+}
+
+/**
+ * Stop all DAQ lists and release the DAQ configuration
+ */
+void cXCPSlave::freeDaq()
+{
+	numDaq     = 0;
+	numOdt     = 0;
+	numEntries = 0;
+	ptrOdt     = 0;
+	ptrEntry   = 0;
+	ptrEnd     = 0;
+}
+
+/**
+ * This is a overridden implementaiton of the base class member that is called by the acquisition scheduler when a receive message matching this CAN ID has been received.
+ *
+ * @param R - pointer to RX Frame
+ * @return - a flag to accept or reject this CAN frame
+ */
+bool cXCPRXFrame::CallbackRx(RX_CAN_FRAME *R)
+{
+	return(R ? parent->receiveFrame(R) : false);
+}
+
+/**
+ * This is a overridden implementaiton of the base class member that is called by the acquisition scheduler on every tick
+ *
+ * @return - a flag to transmit or skip this CAN frame
+ */
+bool cXCPTXFrame::CallbackTx()
+{
+	return(parent->requestFrame(this));
+}
+
+/**
+ * This is a overridden implementaiton of the base class member that is called by the acquisition scheduler at the rate of the event channel
+ *
+ * @return - always false, the event frame is never sent
+ */
+bool cXCPEventFrame::CallbackTx()
+{
+	parent->event(channel);
+	return(false);
+}
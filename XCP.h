@@ -0,0 +1,347 @@
+/*
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#include "variant.h"
+#include <due_can.h>
+#include <CAN_Acquisition.h>
+
+#ifndef XCP_H
+#define XCP_H
+
+/**
+ *
+ * This macro is used to set the DAQ resources shared by all DAQ lists: DAQ lists, ODT's and ODT entries
+ */
+#define	XCP_MAX_DAQ				8
+#define	XCP_MAX_ODT				32
+#define	XCP_MAX_ODT_ENTRIES		128
+
+/**
+ *
+ * This macro is used to set the number of DTO frames that can wait for transmission
+ */
+#define	XCP_DTO_QUEUE			32
+
+/**
+ *
+ * This macro is used to set the number of DTO frames sent per scheduler tick (the ODT throughput is this many ODT's per
+ * tick, e.g. 2 = 2000 ODT/s when polling every 1mS or 1000 ODT/s with a 2mS timer)
+ */
+#define	XCP_DTO_PER_TICK		2
+
+/**
+ *
+ * These macros are used to set the memory the master may read (RAM and flash) and write (RAM only), start and end
+ * (exclusive) of each region. The SAM3X maps SRAM0 twice (at 0x20000000 and at 0x20070000, right below SRAM1), the
+ * addresses between them are reserved and fault when accessed
+ */
+#define	XCP_SRAM0_START			0x20000000
+#define	XCP_SRAM0_END			0x20010000
+#define	XCP_SRAM0_MIRROR_START	0x20070000
+#define	XCP_SRAM0_MIRROR_END	0x20080000
+#define	XCP_SRAM1_START			0x20080000
+#define	XCP_SRAM1_END			0x20088000
+#define	XCP_FLASH_START			0x00080000
+#define	XCP_FLASH_END			0x00100000
+
+/**
+ *
+ * This macro is used to set the number of event channels, one per free-running rate of the acquisition scheduler
+ */
+#define	XCP_NUM_EVENTS			4
+
+/**
+ *
+ * This enum represents the XCP commands that are supported
+ */
+enum XCP_CMD
+{
+	XCP_CONNECT                 = 0xFF,
+	XCP_DISCONNECT              = 0xFE,
+	XCP_GET_STATUS              = 0xFD,
+	XCP_SYNCH                   = 0xFC,
+	XCP_SET_MTA                 = 0xF6,
+	XCP_UPLOAD                  = 0xF5,
+	XCP_SHORT_UPLOAD            = 0xF4,
+	XCP_DOWNLOAD                = 0xF0,
+	XCP_SET_DAQ_PTR             = 0xE2,
+	XCP_WRITE_DAQ               = 0xE1,
+	XCP_SET_DAQ_LIST_MODE       = 0xE0,
+	XCP_START_STOP_DAQ_LIST     = 0xDE,
+	XCP_START_STOP_SYNCH        = 0xDD,
+	XCP_GET_DAQ_PROCESSOR_INFO  = 0xDA,
+	XCP_GET_DAQ_RESOLUTION_INFO = 0xD9,
+	XCP_GET_DAQ_EVENT_INFO      = 0xD7,
+	XCP_FREE_DAQ                = 0xD6,
+	XCP_ALLOC_DAQ               = 0xD5,
+	XCP_ALLOC_ODT               = 0xD4,
+	XCP_ALLOC_ODT_ENTRY         = 0xD3
+};
+
+/**
+ *
+ * This enum represents the XCP error codes
+ */
+enum XCP_ERR
+{
+	XCP_ERR_CMD_SYNCH       = 0x00,
+	XCP_ERR_DAQ_ACTIVE      = 0x11,
+	XCP_ERR_CMD_UNKNOWN     = 0x20,
+	XCP_ERR_CMD_SYNTAX      = 0x21,
+	XCP_ERR_OUT_OF_RANGE    = 0x22,
+	XCP_ERR_ACCESS_DENIED   = 0x24,
+	XCP_ERR_MODE_NOT_VALID  = 0x27,
+	XCP_ERR_SEQUENCE        = 0x29,
+	XCP_ERR_DAQ_CONFIG      = 0x2A,
+	XCP_ERR_MEMORY_OVERFLOW = 0x30
+};
+
+/**
+ *
+ * This struct represents an ODT entry, an element sampled from memory
+ */
+struct sXCPEntry
+{
+	UINT32 addr;
+	UINT8  size;
+};
+
+/**
+ *
+ * This struct represents an ODT, the entries sent in one DTO
+ */
+struct sXCPOdt
+{
+	UINT8 firstEntry;
+	UINT8 numEntries;
+};
+
+/**
+ *
+ * This struct represents a DAQ list
+ */
+struct sXCPDaq
+{
+	/**
+	 * first (absolute) ODT, which is also the PID of its first DTO, number of ODT's
+	 */
+	UINT8 firstOdt;
+	UINT8 numOdt;
+
+	/**
+	 * event channel, prescaler and its counter, mode bits, running, selected for START_STOP_SYNCH
+	 */
+	UINT8 event;
+	UINT8 prescaler;
+	UINT8 prescaleCnt;
+	UINT8 mode;
+	bool  running;
+	bool  selected;
+};
+
+class cXCPSlave;
+
+/**
+ * this is the frame that receives the commands from the master (CRO)
+ */
+class cXCPRXFrame : public cCANFrame
+{
+public:
+	cXCPSlave *parent;
+
+private:
+	bool  CallbackRx(RX_CAN_FRAME *R);
+};
+
+/**
+ * this is the frame that sends the responses and the DAQ data (DTO), it is offered a transmit slot on every scheduler tick
+ */
+class cXCPTXFrame : public cCANFrame
+{
+public:
+	cXCPSlave *parent;
+
+private:
+	bool  CallbackTx();
+};
+
+/**
+ * this is the frame of an event channel, the scheduler calls it at one of the free-running rates. It samples the DAQ
+ * lists of the event and is never sent itself.
+ */
+class cXCPEventFrame : public cCANFrame
+{
+public:
+	cXCPSlave *parent;
+	UINT8 channel;
+
+private:
+	bool  CallbackTx();
+};
+
+/**
+ * XCP on CAN measurement slave. Supports CONNECT, memory upload/download (SHORT_UPLOAD, SET_MTA/UPLOAD, DOWNLOAD) and
+ * dynamic DAQ list configuration. The event channels are the free-running rates of the acquisition scheduler
+ * (0 = 100Hz, 1 = 10Hz, 2 = 5Hz, 3 = 1Hz). An event samples its DAQ lists into the DTO queue, the queue is sent
+ * XCP_DTO_PER_TICK frames per scheduler tick so a large DAQ configuration never delays the other scheduled frames,
+ * a sample that does not fit the queue is dropped as a whole (see getOverloadCtr).
+ *
+ * e.g.
+ *   cXCPSlave XCP(&CANport0, 0x7F0, 0x7F1);
+ *
+ * @author D.Kasamis - dan@togglebit.net
+ * @version 1.0
+ */
+class cXCPSlave
+{
+public:
+	/**
+	 * constructor, registers the command, DTO and event channel frames with the acquisition scheduler
+	 *
+	 * @param _portNum - physical CAN port to be used
+	 * @param _croID   - CAN ID of the commands from the master
+	 * @param _dtoID   - CAN ID of the responses and DAQ data to the master
+	 */
+	cXCPSlave(cAcquireCAN *_portNum, UINT32 _croID, UINT32 _dtoID);
+
+	/**
+	 * Check if a master is connected
+	 *
+	 * @return - true if connected
+	 */
+	bool isConnected();
+
+	/**
+	 * Check if any DAQ list is running
+	 *
+	 * @return - true if DAQ is running
+	 */
+	bool isDaqRunning();
+
+	/**
+	 * Retrieve the DTO statistics (rolling): DAQ frames sent, samples dropped because the DTO queue was full,
+	 * the most frames that have been waiting in the queue
+	 */
+	UINT32 getDTOCtr();
+	UINT32 getOverloadCtr();
+	UINT8  getQueueMax();
+
+	/**
+	 * this handler is called when a command is received
+	 *
+	 * @param R - pointer to the received CAN frame
+	 * @return - bool the frame was accepted
+	 */
+	bool receiveFrame(RX_CAN_FRAME *R);
+
+	/**
+	 * this handler is called by the scheduler on every tick, sends the pending response or the next DTO
+	 *
+	 * @param F - frame to fill in
+	 * @return - bool transmit the frame
+	 */
+	bool requestFrame(cXCPTXFrame *F);
+
+	/**
+	 * this handler is called by the scheduler at the rate of an event channel, samples its DAQ lists
+	 *
+	 * @param channel - event channel
+	 */
+	void event(UINT8 channel);
+
+private:
+	cAcquireCAN *portNum;
+
+	/**
+	 * command, response/DTO and event channel frames
+	 */
+	cXCPRXFrame    CROFrame;
+	cXCPTXFrame    DTOFrame[XCP_DTO_PER_TICK];
+	cXCPEventFrame EventFrame[XCP_NUM_EVENTS];
+
+	/**
+	 * session: connected, response to be sent, memory transfer address
+	 */
+	volatile bool connected;
+	volatile bool ctoPending;
+	UINT8  cto[8];
+	UINT8  ctoLen;
+	UINT32 mta;
+
+	/**
+	 * DAQ configuration, DAQ pointer (SET_DAQ_PTR / WRITE_DAQ): ODT, next entry, end of the ODT's entries
+	 */
+	sXCPDaq   daq[XCP_MAX_DAQ];
+	sXCPOdt   odt[XCP_MAX_ODT];
+	sXCPEntry entry[XCP_MAX_ODT_ENTRIES];
+	UINT8  numDaq;
+	UINT8  numOdt;
+	UINT8  numEntries;
+	UINT8  ptrOdt;
+	UINT8  ptrEntry;
+	UINT8  ptrEnd;
+
+	/**
+	 * DTO queue (ring), frames in the queue, high water mark
+	 */
+	UINT8  queue[XCP_DTO_QUEUE][8];
+	UINT8  head;
+	volatile UINT8 count;
+	UINT8  queueMax;
+
+	/**
+	 * statistics
+	 */
+	UINT32 dtoCtr;
+	UINT32 overloadCtr;
+
+	/**
+	 * Process a command
+	 *
+	 * @param c - command bytes
+	 */
+	void command(const UINT8 *c);
+
+	/**
+	 * Set a positive response
+	 *
+	 * @param len - number of bytes (PID 0xFF included), the data is filled in by the caller
+	 */
+	void respond(UINT8 len);
+
+	/**
+	 * Set an error response
+	 *
+	 * @param err - error code
+	 */
+	void error(UINT8 err);
+
+	/**
+	 * Check that a memory range may be accessed
+	 *
+	 * @param addr  - start address
+	 * @param len   - number of bytes
+	 * @param write - the range is written
+	 * @return - true if the access is allowed
+	 */
+	bool checkAccess(UINT32 addr, UINT32 len, bool write);
+
+	/**
+	 * Stop all DAQ lists and release the DAQ configuration
+	 */
+	void freeDaq();
+};
+
+#endif
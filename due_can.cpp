@@ -135,6 +135,11 @@ uint32_t CANRaw::init(uint32_t ul_baudrate)
 
 	//initialize all function pointers to null
 	for (int i = 0; i < 9; i++) cbCANFrame[i] = 0;
+	cbForward = 0;
+	cbTxDone = 0;
+	txReserved = 0;
+	rxOverrunCnt = 0;
+	rxBufferFullCnt = 0;
 
 //arduino 1.5.2 doesn't init canbus so make sure to do it here. 
 #ifdef ARDUINO152
@@ -255,6 +260,39 @@ void CANRaw::detachCANInterrupt(uint8_t mailBox)
 	cbCANFrame[mailBox] = 0;
 }
 
+/**
+ * \brief Set up a hook that sees every received frame before the callbacks and the RX buffer
+ *
+ * \param cb A function pointer to a function with prototype "bool functionname(CAN_FRAME *frame);", it is called
+ *           from the interrupt and returns true when it has consumed the frame (it is not buffered or passed on)
+ */
+void CANRaw::setForwardCallback(bool (*cb)(RX_CAN_FRAME *))
+{
+	cbForward = cb;
+}
+
+/**
+ * \brief Set up a callback for the reserved TX mailboxes
+ *
+ * \param cb A function pointer to a function with prototype "void functionname(uint8_t mailbox, uint16_t timestamp);",
+ *           called from the interrupt once a reserved mailbox has sent its frame (timestamp of the sent frame)
+ */
+void CANRaw::setTxDoneCallback(void (*cb)(uint8_t, uint16_t))
+{
+	cbTxDone = cb;
+}
+
+/**
+ * \brief Reserve a TX mailbox for its owner, sendFrame and the TX queue don't use it
+ *
+ * \param mailbox Which mailbox (0-7), must be set to CAN_MB_TX_MODE
+ */
+void CANRaw::reserve_mailbox(uint8_t mailbox)
+{
+	if (mailbox > 7) return;
+	txReserved |= (0x01u << mailbox);
+}
+
 
 /**
  * \brief Enable CAN Controller.
@@ -499,6 +537,26 @@ uint8_t CANRaw::get_rx_error_cnt()
 	return (uint8_t) (m_pCan->CAN_ECR >> CAN_ECR_REC_Pos);
 }
 
+/**
+ * \brief Get the number of receive mailbox overruns.
+ *
+ * \retval Number of times a frame was received into a full mailbox, at least one frame was lost each time.
+ */
+uint32_t CANRaw::get_rx_overrun_cnt()
+{
+	return rxOverrunCnt;
+}
+
+/**
+ * \brief Get the number of frames lost because the RX buffer was full.
+ *
+ * \retval Number of received frames that were not buffered.
+ */
+uint32_t CANRaw::get_rx_buffer_full_cnt()
+{
+	return rxBufferFullCnt;
+}
+
 /**
  * \brief Reset the internal free-running 16-bit timer.
  *
@@ -663,13 +721,15 @@ template <typename t> void CANRaw::write(t inputValue)
  */
 bool CANRaw::sendFrame(TX_CAN_FRAME& txFrame) 
 {
-	for (int i = 0; i < 8; i++) {
-		if (((m_pCan->CAN_MB[i].CAN_MMR >> 24) & 7) == CAN_MB_TX_MODE)
+	//frames that are already queued go out first, a free mailbox must not let this one overtake them
+	for (int i = 0; (i < 8) && (tx_buffer_head == tx_buffer_tail); i++) {
+		if ((((m_pCan->CAN_MB[i].CAN_MMR >> 24) & 7) == CAN_MB_TX_MODE) && !(txReserved & (0x01u << i)))
 		{//is this mailbox set up as a TX box?
 			if (m_pCan->CAN_MB[i].CAN_MSR & CAN_MSR_MRDY) 
 			{//is it also available (not sending anything?)
 				mailbox_set_id(i, txFrame.id, txFrame.extended);
 				mailbox_set_datalen(i, txFrame.length);
+				mailbox_set_rtr(i, txFrame.rtr);
 				mailbox_set_priority(i, txFrame.priority);
 				for (uint8_t cnt = 0; cnt < 8; cnt++)
 				{    
@@ -691,8 +751,15 @@ bool CANRaw::sendFrame(TX_CAN_FRAME& txFrame)
     tx_frame_buff[tx_buffer_tail].id = txFrame.id;
     tx_frame_buff[tx_buffer_tail].extended = txFrame.extended;
     tx_frame_buff[tx_buffer_tail].length = txFrame.length;
+    tx_frame_buff[tx_buffer_tail].priority = txFrame.priority;
+    tx_frame_buff[tx_buffer_tail].rtr = txFrame.rtr;
     tx_frame_buff[tx_buffer_tail].data.value = txFrame.data.value;
     tx_buffer_tail = temp;
+
+	//the TX interrupt of a mailbox drains the queue, it is only enabled once a frame has been sent through that mailbox
+	for (int i = 0; i < 8; i++) {
+		if ((((m_pCan->CAN_MB[i].CAN_MMR >> 24) & 7) == CAN_MB_TX_MODE) && !(txReserved & (0x01u << i))) enable_interrupt(0x01u << i);
+	}
 	return true;
 }
 
@@ -734,7 +801,9 @@ uint32_t CANRaw::mailbox_read(uint8_t uc_index, volatile RX_CAN_FRAME *rxframe)
 		rxframe->extended = false;
 	}
 	rxframe->fid = m_pCan->CAN_MB[uc_index].CAN_MFID;
+	rxframe->time = (ul_status & CAN_MSR_MTIMESTAMP_Msk) >> CAN_MSR_MTIMESTAMP_Pos;
 	rxframe->length = (ul_status & CAN_MSR_MDLC_Msk) >> CAN_MSR_MDLC_Pos;
+	rxframe->rtr = (ul_status & CAN_MSR_MRTR) ? 1 : 0;
 	ul_datal = m_pCan->CAN_MB[uc_index].CAN_MDL;
 	ul_datah = m_pCan->CAN_MB[uc_index].CAN_MDH;
 
@@ -922,6 +991,19 @@ void CANRaw::mailbox_set_datalen(uint8_t uc_index, uint8_t dlen)
 			~CAN_MCR_MDLC_Msk) | CAN_MCR_MDLC(dlen);
 }
 
+/**
+ * \brief Set whether a TX mailbox sends a remote frame
+ *
+ * \param uc_index Which mailbox to set (0-7)
+ * \param rtr true = remote frame (the data length is still sent), false = data frame
+ */
+void CANRaw::mailbox_set_rtr(uint8_t uc_index, bool rtr)
+{
+	if (uc_index > CANMB_NUMBER-1) uc_index = CANMB_NUMBER-1;
+	if (rtr) m_pCan->CAN_MB[uc_index].CAN_MCR |= CAN_MCR_MRTR;
+	else m_pCan->CAN_MB[uc_index].CAN_MCR &= ~CAN_MCR_MRTR;
+}
+
 /**
  * \brief Command a mailbox to send the frame stored in it
  *
@@ -1216,8 +1298,9 @@ void CANRaw::mailbox_int_handler(uint8_t mb, uint32_t ul_status) {
 		case 1: //receive
 		case 2: //receive w/ overwrite
 		case 4: //consumer - technically still a receive buffer
-			mailbox_read(mb, &tempFrame);
-			//First, try to send a callback. If no callback registered then buffer the frame.
+			if (mailbox_read(mb, &tempFrame) & CAN_MAILBOX_RX_OVER) rxOverrunCnt++;
+			//A cut-through hook gets the first look, then try to send a callback. If no callback registered then buffer the frame.
+			if (cbForward && (*cbForward)(&tempFrame)) break;
 			if (cbCANFrame[mb]) (*cbCANFrame[mb])(&tempFrame);
 			else if (cbCANFrame[8]) (*cbCANFrame[8])(&tempFrame);
 			else 
@@ -1228,13 +1311,20 @@ void CANRaw::mailbox_int_handler(uint8_t mb, uint32_t ul_status) {
 					memcpy((void *)&rx_frame_buff[rx_buffer_head], &tempFrame, sizeof(RX_CAN_FRAME));
 					rx_buffer_head = temp;
 				}
+				else rxBufferFullCnt++;
 			}
 			break;
 		case 3: //transmit
-			if (tx_buffer_head != tx_buffer_tail) 
+			if (txReserved & (0x01u << mb))
+			{ //reserved mailbox, its owner loads it again (and enables the interrupt)
+				disable_interrupt(0x01 << mb);
+				if (cbTxDone) (*cbTxDone)(mb, (m_pCan->CAN_MB[mb].CAN_MSR & CAN_MSR_MTIMESTAMP_Msk) >> CAN_MSR_MTIMESTAMP_Pos);
+			}
+			else if (tx_buffer_head != tx_buffer_tail) 
 			{ //if there is a frame in the queue to send
 				mailbox_set_id(mb, tx_frame_buff[tx_buffer_head].id, tx_frame_buff[tx_buffer_head].extended);
 				mailbox_set_datalen(mb, tx_frame_buff[tx_buffer_head].length);
+				mailbox_set_rtr(mb, tx_frame_buff[tx_buffer_head].rtr);
 				mailbox_set_priority(mb, tx_frame_buff[tx_buffer_head].priority);
 				for (uint8_t cnt = 0; cnt < 8; cnt++)
 					mailbox_set_databyte(mb, cnt, tx_frame_buff[tx_buffer_head].data.bytes[cnt]);
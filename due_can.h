@@ -152,6 +152,7 @@ typedef struct
 	uint8_t extended;	// Extended ID flag
 	uint8_t length;		// Number of data bytes
 	BytesUnion data;	// 64 bits - lots of ways to access it.
+	uint16_t time;		// Controller timestamp (bit times) at the start or end of frame, see set_timestamp_capture_point
 }RX_CAN_FRAME;
 
 typedef struct
@@ -187,6 +188,11 @@ class CANRaw
 	bool bigEndian;
 
 	void (*cbCANFrame[9])(RX_CAN_FRAME *); //8 mailboxes plus an optional catch all
+	bool (*cbForward)(RX_CAN_FRAME *); //cut-through hook, sees every received frame first
+	void (*cbTxDone)(uint8_t, uint16_t); //called when a reserved TX mailbox has sent its frame
+	uint8_t txReserved; //TX mailboxes that sendFrame and the TX queue leave alone
+	volatile uint32_t rxOverrunCnt; //frames lost in a full receive mailbox (at least one per MMI)
+	volatile uint32_t rxBufferFullCnt; //frames lost because the RX buffer was full
 
   public:
 
@@ -236,6 +242,8 @@ class CANRaw
 	uint32_t get_timestamp_value();
 	uint8_t get_tx_error_cnt();
 	uint8_t get_rx_error_cnt();
+	uint32_t get_rx_overrun_cnt();
+	uint32_t get_rx_buffer_full_cnt();
 	void reset_internal_timer();
 	void global_send_transfer_cmd(uint8_t uc_mask);
 	void global_send_abort_cmd(uint8_t uc_mask);
@@ -252,6 +260,7 @@ class CANRaw
 	void mailbox_set_mode(uint8_t uc_index, uint8_t mode);
 	void mailbox_set_databyte(uint8_t uc_index, uint8_t bytepos, uint8_t val);
 	void mailbox_set_datalen(uint8_t uc_index, uint8_t dlen);
+	void mailbox_set_rtr(uint8_t uc_index, bool rtr);
 	void mailbox_set_datal(uint8_t uc_index, uint32_t val);
 	void mailbox_set_datah(uint8_t uc_index, uint32_t val);
 
@@ -266,6 +275,9 @@ class CANRaw
 	void attachCANInterrupt(void (*cb)(RX_CAN_FRAME *)); //alternative callname for setGeneralCallback
 	void attachCANInterrupt(uint8_t mailBox, void (*cb)(RX_CAN_FRAME *));
 	void detachCANInterrupt(uint8_t mailBox);
+	void setForwardCallback(bool (*cb)(RX_CAN_FRAME *));
+	void setTxDoneCallback(void (*cb)(uint8_t, uint16_t));
+	void reserve_mailbox(uint8_t mailbox);
 
 	void reset_all_mailbox();
 	void interruptHandler();
@@ -0,0 +1,455 @@
+/*
+  Generated by extras/dbc2cpp/dbc2cpp.py from dbc_bench.dbc, do not edit.
+*/
+#ifndef DBC_BENCH_DBC_H
+#define DBC_BENCH_DBC_H
+#include "CAN_DBC.h"
+
+/**
+ * WHEEL_SPEEDS
+ * standard ID 0x200, 8 bytes, sent by Chassis
+ */
+struct sWHEEL_SPEEDS
+{
+    static constexpr uint32_t ID  = 0x200;
+    static constexpr uint8_t  DLC = 8;
+
+    /**
+     * Intel start bit 0, 12 bits, 0.1/bit +0 km/h
+     */
+    uint16_t WheelFL;
+
+    /**
+     * Intel start bit 12, 12 bits, 0.1/bit +0 km/h
+     */
+    uint16_t WheelFR;
+
+    /**
+     * Intel start bit 24, 12 bits, 0.1/bit +0 km/h
+     */
+    uint16_t WheelRL;
+
+    /**
+     * Intel start bit 36, 12 bits, 0.1/bit +0 km/h
+     */
+    uint16_t WheelRR;
+
+    /**
+     * Intel signed start bit 48, 13 bits, 0.01/bit +0 deg/s
+     */
+    int16_t  YawRate;
+
+    /**
+     * Intel start bit 61, 3 bits, 1/bit +0
+     */
+    uint8_t  Counter;
+
+    static constexpr uint8_t  WheelFL_SHIFT  = 0;
+    static constexpr uint64_t WheelFL_MASK   = 0xFFFULL;
+    static constexpr float    WheelFL_SCALE  = 0.1f;
+    static constexpr float    WheelFL_OFFSET = 0.0f;
+    static constexpr uint8_t  WheelFR_SHIFT  = 12;
+    static constexpr uint64_t WheelFR_MASK   = 0xFFFULL;
+    static constexpr float    WheelFR_SCALE  = 0.1f;
+    static constexpr float    WheelFR_OFFSET = 0.0f;
+    static constexpr uint8_t  WheelRL_SHIFT  = 24;
+    static constexpr uint64_t WheelRL_MASK   = 0xFFFULL;
+    static constexpr float    WheelRL_SCALE  = 0.1f;
+    static constexpr float    WheelRL_OFFSET = 0.0f;
+    static constexpr uint8_t  WheelRR_SHIFT  = 36;
+    static constexpr uint64_t WheelRR_MASK   = 0xFFFULL;
+    static constexpr float    WheelRR_SCALE  = 0.1f;
+    static constexpr float    WheelRR_OFFSET = 0.0f;
+    static constexpr uint8_t  YawRate_SHIFT  = 48;
+    static constexpr uint64_t YawRate_MASK   = 0x1FFFULL;
+    static constexpr float    YawRate_SCALE  = 0.01f;
+    static constexpr float    YawRate_OFFSET = 0.0f;
+    static constexpr uint8_t  Counter_SHIFT  = 61;
+    static constexpr uint64_t Counter_MASK   = 0x7ULL;
+    static constexpr float    Counter_SCALE  = 1.0f;
+    static constexpr float    Counter_OFFSET = 0.0f;
+
+    static constexpr uint16_t get_WheelFL(uint64_t w)
+    {
+        return((uint16_t)((w >> WheelFL_SHIFT) & WheelFL_MASK));
+    }
+    static constexpr uint64_t put_WheelFL(uint16_t raw)
+    {
+        return(((uint64_t)raw & WheelFL_MASK) << WheelFL_SHIFT);
+    }
+    static constexpr uint16_t get_WheelFR(uint64_t w)
+    {
+        return((uint16_t)((w >> WheelFR_SHIFT) & WheelFR_MASK));
+    }
+    static constexpr uint64_t put_WheelFR(uint16_t raw)
+    {
+        return(((uint64_t)raw & WheelFR_MASK) << WheelFR_SHIFT);
+    }
+    static constexpr uint16_t get_WheelRL(uint64_t w)
+    {
+        return((uint16_t)((w >> WheelRL_SHIFT) & WheelRL_MASK));
+    }
+    static constexpr uint64_t put_WheelRL(uint16_t raw)
+    {
+        return(((uint64_t)raw & WheelRL_MASK) << WheelRL_SHIFT);
+    }
+    static constexpr uint16_t get_WheelRR(uint64_t w)
+    {
+        return((uint16_t)((w >> WheelRR_SHIFT) & WheelRR_MASK));
+    }
+    static constexpr uint64_t put_WheelRR(uint16_t raw)
+    {
+        return(((uint64_t)raw & WheelRR_MASK) << WheelRR_SHIFT);
+    }
+    static constexpr int16_t get_YawRate(uint64_t w)
+    {
+        return((int16_t)dbcSignExtend(((w >> YawRate_SHIFT) & YawRate_MASK), 13));
+    }
+    static constexpr uint64_t put_YawRate(int16_t raw)
+    {
+        return(((uint64_t)raw & YawRate_MASK) << YawRate_SHIFT);
+    }
+    static constexpr uint8_t get_Counter(uint64_t w)
+    {
+        return((uint8_t)((w >> Counter_SHIFT) & Counter_MASK));
+    }
+    static constexpr uint64_t put_Counter(uint8_t raw)
+    {
+        return(((uint64_t)raw & Counter_MASK) << Counter_SHIFT);
+    }
+
+    /**
+     * decode all signals of a payload word (see dbcLoad)
+     */
+    static constexpr sWHEEL_SPEEDS unpack(uint64_t w)
+    {
+        return(sWHEEL_SPEEDS{get_WheelFL(w), get_WheelFR(w), get_WheelRL(w), get_WheelRR(w), get_YawRate(w), get_Counter(w)});
+    }
+
+    /**
+     * encode all signals into a payload word (see dbcStore), unused bits are 0
+     */
+    static constexpr uint64_t pack(const sWHEEL_SPEEDS &m)
+    {
+        return(put_WheelFL(m.WheelFL) | put_WheelFR(m.WheelFR) | put_WheelRL(m.WheelRL) | put_WheelRR(m.WheelRR) | put_YawRate(m.YawRate) | put_Counter(m.Counter));
+    }
+
+    /**
+     * decode/encode a frame payload, FRAME is a cCANFrame (or anything else with a U.b[8] payload)
+     */
+    template <class FRAME> void decode(const FRAME &F)
+    {
+        *this = unpack(dbcLoad(F.U.b));
+    }
+    template <class FRAME> void encode(FRAME &F) const
+    {
+        dbcStore(F.U.b, pack(*this));
+    }
+};
+
+/**
+ * BMS_STATUS
+ * standard ID 0x3A0, 8 bytes, sent by BMS
+ */
+struct sBMS_STATUS
+{
+    static constexpr uint32_t ID  = 0x3A0;
+    static constexpr uint8_t  DLC = 8;
+
+    /**
+     * Motorola start bit 7, 16 bits, 0.01/bit +0 V
+     */
+    uint16_t PackVoltage;
+
+    /**
+     * Motorola signed start bit 23, 16 bits, 0.1/bit +0 A
+     */
+    int16_t  PackCurrent;
+
+    /**
+     * Motorola start bit 39, 10 bits, 0.1/bit +0 %
+     */
+    uint16_t StateOfCharge;
+
+    /**
+     * Motorola signed start bit 45, 7 bits, 1/bit +0 degC
+     */
+    int8_t   CellTempMax;
+
+    /**
+     * Motorola start bit 54, 3 bits, 1/bit +0
+     */
+    uint8_t  Contactor;
+
+    /**
+     * Motorola start bit 51, 12 bits, 1/bit +0
+     */
+    uint16_t Checksum;
+
+    static constexpr uint8_t  PackVoltage_SHIFT  = 48;
+    static constexpr uint64_t PackVoltage_MASK   = 0xFFFFULL;
+    static constexpr float    PackVoltage_SCALE  = 0.01f;
+    static constexpr float    PackVoltage_OFFSET = 0.0f;
+    static constexpr uint8_t  PackCurrent_SHIFT  = 32;
+    static constexpr uint64_t PackCurrent_MASK   = 0xFFFFULL;
+    static constexpr float    PackCurrent_SCALE  = 0.1f;
+    static constexpr float    PackCurrent_OFFSET = 0.0f;
+    static constexpr uint8_t  StateOfCharge_SHIFT  = 22;
+    static constexpr uint64_t StateOfCharge_MASK   = 0x3FFULL;
+    static constexpr float    StateOfCharge_SCALE  = 0.1f;
+    static constexpr float    StateOfCharge_OFFSET = 0.0f;
+    static constexpr uint8_t  CellTempMax_SHIFT  = 15;
+    static constexpr uint64_t CellTempMax_MASK   = 0x7FULL;
+    static constexpr float    CellTempMax_SCALE  = 1.0f;
+    static constexpr float    CellTempMax_OFFSET = 0.0f;
+    static constexpr uint8_t  Contactor_SHIFT  = 12;
+    static constexpr uint64_t Contactor_MASK   = 0x7ULL;
+    static constexpr float    Contactor_SCALE  = 1.0f;
+    static constexpr float    Contactor_OFFSET = 0.0f;
+    static constexpr uint8_t  Checksum_SHIFT  = 0;
+    static constexpr uint64_t Checksum_MASK   = 0xFFFULL;
+    static constexpr float    Checksum_SCALE  = 1.0f;
+    static constexpr float    Checksum_OFFSET = 0.0f;
+
+    static constexpr uint16_t get_PackVoltage(uint64_t sw)
+    {
+        return((uint16_t)((sw >> PackVoltage_SHIFT) & PackVoltage_MASK));
+    }
+    static constexpr uint64_t put_PackVoltage(uint16_t raw)
+    {
+        return(((uint64_t)raw & PackVoltage_MASK) << PackVoltage_SHIFT);
+    }
+    static constexpr int16_t get_PackCurrent(uint64_t sw)
+    {
+        return((int16_t)dbcSignExtend(((sw >> PackCurrent_SHIFT) & PackCurrent_MASK), 16));
+    }
+    static constexpr uint64_t put_PackCurrent(int16_t raw)
+    {
+        return(((uint64_t)raw & PackCurrent_MASK) << PackCurrent_SHIFT);
+    }
+    static constexpr uint16_t get_StateOfCharge(uint64_t sw)
+    {
+        return((uint16_t)((sw >> StateOfCharge_SHIFT) & StateOfCharge_MASK));
+    }
+    static constexpr uint64_t put_StateOfCharge(uint16_t raw)
+    {
+        return(((uint64_t)raw & StateOfCharge_MASK) << StateOfCharge_SHIFT);
+    }
+    static constexpr int8_t get_CellTempMax(uint64_t sw)
+    {
+        return((int8_t)dbcSignExtend(((sw >> CellTempMax_SHIFT) & CellTempMax_MASK), 7));
+    }
+    static constexpr uint64_t put_CellTempMax(int8_t raw)
+    {
+        return(((uint64_t)raw & CellTempMax_MASK) << CellTempMax_SHIFT);
+    }
+    static constexpr uint8_t get_Contactor(uint64_t sw)
+    {
+        return((uint8_t)((sw >> Contactor_SHIFT) & Contactor_MASK));
+    }
+    static constexpr uint64_t put_Contactor(uint8_t raw)
+    {
+        return(((uint64_t)raw & Contactor_MASK) << Contactor_SHIFT);
+    }
+    static constexpr uint16_t get_Checksum(uint64_t sw)
+    {
+        return((uint16_t)((sw >> Checksum_SHIFT) & Checksum_MASK));
+    }
+    static constexpr uint64_t put_Checksum(uint16_t raw)
+    {
+        return(((uint64_t)raw & Checksum_MASK) << Checksum_SHIFT);
+    }
+
+    /**
+     * decode all signals of a payload word (see dbcLoad)
+     */
+    static constexpr sBMS_STATUS unpack(uint64_t w)
+    {
+        return(unpack(w, dbcSwap(w)));
+    }
+    static constexpr sBMS_STATUS unpack(uint64_t, uint64_t sw)
+    {
+        return(sBMS_STATUS{get_PackVoltage(sw), get_PackCurrent(sw), get_StateOfCharge(sw), get_CellTempMax(sw), get_Contactor(sw), get_Checksum(sw)});
+    }
+
+    /**
+     * encode all signals into a payload word (see dbcStore), unused bits are 0
+     */
+    static constexpr uint64_t pack(const sBMS_STATUS &m)
+    {
+        return(dbcSwap(put_PackVoltage(m.PackVoltage) | put_PackCurrent(m.PackCurrent) | put_StateOfCharge(m.StateOfCharge) | put_CellTempMax(m.CellTempMax) | put_Contactor(m.Contactor) | put_Checksum(m.Checksum)));
+    }
+
+    /**
+     * decode/encode a frame payload, FRAME is a cCANFrame (or anything else with a U.b[8] payload)
+     */
+    template <class FRAME> void decode(const FRAME &F)
+    {
+        *this = unpack(dbcLoad(F.U.b));
+    }
+    template <class FRAME> void encode(FRAME &F) const
+    {
+        dbcStore(F.U.b, pack(*this));
+    }
+};
+
+/**
+ * EEC1
+ * extended ID 0x0CF00400, 8 bytes, sent by ECU
+ */
+struct sEEC1
+{
+    static constexpr uint32_t ID  = 0x0CF00400;
+    static constexpr uint8_t  DLC = 8;
+
+    /**
+     * Intel start bit 0, 4 bits, 1/bit +0
+     */
+    uint8_t  EngTorqueMode;
+
+    /**
+     * Intel start bit 8, 8 bits, 1/bit -125 %
+     */
+    uint8_t  DriversDemandTorque;
+
+    /**
+     * Intel start bit 16, 8 bits, 1/bit -125 %
+     */
+    uint8_t  ActualEngTorque;
+
+    /**
+     * Intel start bit 24, 16 bits, 0.125/bit +0 rpm
+     */
+    uint16_t EngSpeed;
+
+    /**
+     * Intel start bit 40, 8 bits, 1/bit +0
+     */
+    uint8_t  SrcAddrEngCtrl;
+
+    /**
+     * Intel start bit 48, 4 bits, 1/bit +0
+     */
+    uint8_t  EngStarterMode;
+
+    /**
+     * Intel start bit 56, 8 bits, 1/bit -125 %
+     */
+    uint8_t  EngDemandTorque;
+
+    static constexpr uint8_t  EngTorqueMode_SHIFT  = 0;
+    static constexpr uint64_t EngTorqueMode_MASK   = 0xFULL;
+    static constexpr float    EngTorqueMode_SCALE  = 1.0f;
+    static constexpr float    EngTorqueMode_OFFSET = 0.0f;
+    static constexpr uint8_t  DriversDemandTorque_SHIFT  = 8;
+    static constexpr uint64_t DriversDemandTorque_MASK   = 0xFFULL;
+    static constexpr float    DriversDemandTorque_SCALE  = 1.0f;
+    static constexpr float    DriversDemandTorque_OFFSET = -125.0f;
+    static constexpr uint8_t  ActualEngTorque_SHIFT  = 16;
+    static constexpr uint64_t ActualEngTorque_MASK   = 0xFFULL;
+    static constexpr float    ActualEngTorque_SCALE  = 1.0f;
+    static constexpr float    ActualEngTorque_OFFSET = -125.0f;
+    static constexpr uint8_t  EngSpeed_SHIFT  = 24;
+    static constexpr uint64_t EngSpeed_MASK   = 0xFFFFULL;
+    static constexpr float    EngSpeed_SCALE  = 0.125f;
+    static constexpr float    EngSpeed_OFFSET = 0.0f;
+    static constexpr uint8_t  SrcAddrEngCtrl_SHIFT  = 40;
+    static constexpr uint64_t SrcAddrEngCtrl_MASK   = 0xFFULL;
+    static constexpr float    SrcAddrEngCtrl_SCALE  = 1.0f;
+    static constexpr float    SrcAddrEngCtrl_OFFSET = 0.0f;
+    static constexpr uint8_t  EngStarterMode_SHIFT  = 48;
+    static constexpr uint64_t EngStarterMode_MASK   = 0xFULL;
+    static constexpr float    EngStarterMode_SCALE  = 1.0f;
+    static constexpr float    EngStarterMode_OFFSET = 0.0f;
+    static constexpr uint8_t  EngDemandTorque_SHIFT  = 56;
+    static constexpr uint64_t EngDemandTorque_MASK   = 0xFFULL;
+    static constexpr float    EngDemandTorque_SCALE  = 1.0f;
+    static constexpr float    EngDemandTorque_OFFSET = -125.0f;
+
+    static constexpr uint8_t get_EngTorqueMode(uint64_t w)
+    {
+        return((uint8_t)((w >> EngTorqueMode_SHIFT) & EngTorqueMode_MASK));
+    }
+    static constexpr uint64_t put_EngTorqueMode(uint8_t raw)
+    {
+        return(((uint64_t)raw & EngTorqueMode_MASK) << EngTorqueMode_SHIFT);
+    }
+    static constexpr uint8_t get_DriversDemandTorque(uint64_t w)
+    {
+        return((uint8_t)((w >> DriversDemandTorque_SHIFT) & DriversDemandTorque_MASK));
+    }
+    static constexpr uint64_t put_DriversDemandTorque(uint8_t raw)
+    {
+        return(((uint64_t)raw & DriversDemandTorque_MASK) << DriversDemandTorque_SHIFT);
+    }
+    static constexpr uint8_t get_ActualEngTorque(uint64_t w)
+    {
+        return((uint8_t)((w >> ActualEngTorque_SHIFT) & ActualEngTorque_MASK));
+    }
+    static constexpr uint64_t put_ActualEngTorque(uint8_t raw)
+    {
+        return(((uint64_t)raw & ActualEngTorque_MASK) << ActualEngTorque_SHIFT);
+    }
+    static constexpr uint16_t get_EngSpeed(uint64_t w)
+    {
+        return((uint16_t)((w >> EngSpeed_SHIFT) & EngSpeed_MASK));
+    }
+    static constexpr uint64_t put_EngSpeed(uint16_t raw)
+    {
+        return(((uint64_t)raw & EngSpeed_MASK) << EngSpeed_SHIFT);
+    }
+    static constexpr uint8_t get_SrcAddrEngCtrl(uint64_t w)
+    {
+        return((uint8_t)((w >> SrcAddrEngCtrl_SHIFT) & SrcAddrEngCtrl_MASK));
+    }
+    static constexpr uint64_t put_SrcAddrEngCtrl(uint8_t raw)
+    {
+        return(((uint64_t)raw & SrcAddrEngCtrl_MASK) << SrcAddrEngCtrl_SHIFT);
+    }
+    static constexpr uint8_t get_EngStarterMode(uint64_t w)
+    {
+        return((uint8_t)((w >> EngStarterMode_SHIFT) & EngStarterMode_MASK));
+    }
+    static constexpr uint64_t put_EngStarterMode(uint8_t raw)
+    {
+        return(((uint64_t)raw & EngStarterMode_MASK) << EngStarterMode_SHIFT);
+    }
+    static constexpr uint8_t get_EngDemandTorque(uint64_t w)
+    {
+        return((uint8_t)((w >> EngDemandTorque_SHIFT) & EngDemandTorque_MASK));
+    }
+    static constexpr uint64_t put_EngDemandTorque(uint8_t raw)
+    {
+        return(((uint64_t)raw & EngDemandTorque_MASK) << EngDemandTorque_SHIFT);
+    }
+
+    /**
+     * decode all signals of a payload word (see dbcLoad)
+     */
+    static constexpr sEEC1 unpack(uint64_t w)
+    {
+        return(sEEC1{get_EngTorqueMode(w), get_DriversDemandTorque(w), get_ActualEngTorque(w), get_EngSpeed(w), get_SrcAddrEngCtrl(w), get_EngStarterMode(w), get_EngDemandTorque(w)});
+    }
+
+    /**
+     * encode all signals into a payload word (see dbcStore), unused bits are 0
+     */
+    static constexpr uint64_t pack(const sEEC1 &m)
+    {
+        return(put_EngTorqueMode(m.EngTorqueMode) | put_DriversDemandTorque(m.DriversDemandTorque) | put_ActualEngTorque(m.ActualEngTorque) | put_EngSpeed(m.EngSpeed) | put_SrcAddrEngCtrl(m.SrcAddrEngCtrl) | put_EngStarterMode(m.EngStarterMode) | put_EngDemandTorque(m.EngDemandTorque));
+    }
+
+    /**
+     * decode/encode a frame payload, FRAME is a cCANFrame (or anything else with a U.b[8] payload)
+     */
+    template <class FRAME> void decode(const FRAME &F)
+    {
+        *this = unpack(dbcLoad(F.U.b));
+    }
+    template <class FRAME> void encode(FRAME &F) const
+    {
+        dbcStore(F.U.b, pack(*this));
+    }
+};
+
+#endif
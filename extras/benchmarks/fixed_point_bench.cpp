@@ -0,0 +1,94 @@
+/*
+  Host micro-benchmark: floating point (m*x+b) vs. fixed point (cFixedScale) engineering unit conversion.
+
+  build & run (from the library root):
+      g++ -O2 -I. extras/benchmarks/fixed_point_bench.cpp -o fixed_point_bench && ./fixed_point_bench
+
+  NOTE: a desktop CPU has a hardware FPU so the float path is cheap here, the numbers that matter are from the
+  target sketch Examples/FixedPoint_Benchmark (the Cortex-M3 does all float math in software). This program also
+  checks that the fixed point result matches the float result to within one count of the last decimal.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include "CAN_FixedPoint.h"
+
+#define NUM_SAMPLES 4096
+#define NUM_PASSES  20000
+
+struct sScaling
+{
+    const char *name;
+    float slope;
+    float offset;
+    int32_t rawMax;
+};
+
+//scalings used by the OBD2 examples and the J1939 engine speed (0.125 rpm/bit)
+static const sScaling scalings[] =
+{
+    {"Engine Speed 0.25"   , 0.25f      ,   0.0f, 65535},
+    {"Throttle 0.3922"     , 0.3922f    ,   0.0f,   255},
+    {"Coolant 1, -40"      , 1.0f       , -40.0f,   255},
+    {"MAF 0.01"            , 0.01f      ,   0.0f, 65535},
+    {"J1939 RPM 0.125"     , 0.125f     ,   0.0f, 64255},
+};
+
+int main()
+{
+    static int32_t raw[NUM_SAMPLES];
+    volatile float   floatSink = 0;
+    volatile int32_t fixedSink = 0;
+    unsigned s, p, i;
+
+    srand(1);
+
+    printf("%-20s %12s %12s %8s %10s\n", "scaling", "float ns", "fixed ns", "ratio", "max err");
+
+    for (s = 0; s < sizeof(scalings) / sizeof(scalings[0]); s++)
+    {
+        const sScaling &S = scalings[s];
+        cFixedScale scale(S.slope, S.offset, 2);
+        int32_t maxErr = 0;
+
+        for (i = 0; i < NUM_SAMPLES; i++)
+        {
+            raw[i] = rand() % (S.rawMax + 1);
+
+            //accuracy check against the float result, in counts of the last decimal
+            float f = ((raw[i] * S.slope) + S.offset) * 100.0f;
+            int32_t ref = (int32_t)(f < 0 ? f - 0.5f : f + 0.5f);
+            int32_t err = abs(scale.convert(raw[i]) - ref);
+            maxErr = err > maxErr ? err : maxErr;
+        }
+
+        auto t0 = std::chrono::steady_clock::now();
+        for (p = 0; p < NUM_PASSES; p++)
+        {
+            for (i = 0; i < NUM_SAMPLES; i++)
+            {
+                floatSink = (raw[i] * S.slope) + S.offset;
+            }
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        for (p = 0; p < NUM_PASSES; p++)
+        {
+            for (i = 0; i < NUM_SAMPLES; i++)
+            {
+                fixedSink = scale.convert(raw[i]);
+            }
+        }
+        auto t2 = std::chrono::steady_clock::now();
+
+        double n = (double)NUM_PASSES * NUM_SAMPLES;
+        double floatNs = std::chrono::duration<double, std::nano>(t1 - t0).count() / n;
+        double fixedNs = std::chrono::duration<double, std::nano>(t2 - t1).count() / n;
+
+        printf("%-20s %12.3f %12.3f %8.2f %10d\n", S.name, floatNs, fixedNs, floatNs / fixedNs, (int)maxErr);
+    }
+
+    //the sinks keep the conversions from being optimised away
+    printf("\nlast results: float %.2f, fixed %d\n", (double)floatSink, (int)fixedSink);
+
+    return(0);
+}
@@ -0,0 +1,283 @@
+/*
+  Host micro-benchmark: runtime signal decoding and encoding (cSignalCodec) vs. a naive bit by bit loop and the
+  generated DBC code (extras/dbc2cpp), per frame with all signals decoded / packed.
+
+  build & run (from the library root):
+      python3 extras/dbc2cpp/dbc2cpp.py extras/benchmarks/dbc_bench.dbc
+      g++ -O2 -std=c++11 -I. extras/benchmarks/signal_bench.cpp -o signal_bench && ./signal_bench
+
+  The descriptors are those of extras/benchmarks/dbc_bench.dbc, the runtime raw values are checked against the
+  generated decoders for every frame, and re-encoding the decoded values has to give back the frame. A descriptor whose
+  scale/offset is outside the cFixedScale limits has to be refused by setup().
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include "CAN_Signal.h"
+#include "extras/benchmarks/dbc_bench_dbc.h"
+
+#define NUM_FRAMES 4096
+#define NUM_PASSES 2000
+
+struct sFrame
+{
+    union
+    {
+        uint8_t b[8];
+    }U;
+};
+
+static const sCANSignal wheelSignals[] =
+{
+    { 0, 12, SIG_INTEL, false, 0.1f , 0.0f},
+    {12, 12, SIG_INTEL, false, 0.1f , 0.0f},
+    {24, 12, SIG_INTEL, false, 0.1f , 0.0f},
+    {36, 12, SIG_INTEL, false, 0.1f , 0.0f},
+    {48, 13, SIG_INTEL, true , 0.01f, 0.0f},
+    {61,  3, SIG_INTEL, false, 1.0f , 0.0f},
+};
+
+static const sCANSignal bmsSignals[] =
+{
+    { 7, 16, SIG_MOTOROLA, false, 0.01f, 0.0f},
+    {23, 16, SIG_MOTOROLA, true , 0.1f , 0.0f},
+    {39, 10, SIG_MOTOROLA, false, 0.1f , 0.0f},
+    {45,  7, SIG_MOTOROLA, true , 1.0f , 0.0f},
+    {54,  3, SIG_MOTOROLA, false, 1.0f , 0.0f},
+    {51, 12, SIG_MOTOROLA, false, 1.0f , 0.0f},
+};
+
+/**
+ * naive extraction, one bit per iteration
+ */
+static int32_t naiveGet(const uint8_t *b, const sCANSignal &S)
+{
+    uint32_t raw = 0;
+    uint8_t  pos = S.startBit;
+    uint8_t  i;
+
+    for (i = 0; i < S.length; i++)
+    {
+        if (S.order == SIG_INTEL)
+        {
+            raw |= (uint32_t)((b[pos >> 3] >> (pos & 7)) & 1) << i;
+            pos++;
+        }
+        else
+        {
+            raw = (raw << 1) | ((b[pos >> 3] >> (pos & 7)) & 1);
+            pos = (pos & 7) ? pos - 1 : pos + 15;
+        }
+    }
+
+    if (S.isSigned && (raw & (1UL << (S.length - 1))))
+    {
+        raw |= ~0UL << S.length;
+    }
+    return((int32_t)raw);
+}
+
+/**
+ * naive packing, one bit per iteration
+ */
+static void naiveSet(uint8_t *b, const sCANSignal &S, int32_t value)
+{
+    uint32_t raw = (uint32_t)value;
+    uint8_t  pos = S.startBit;
+    uint8_t  i, bit;
+
+    for (i = 0; i < S.length; i++)
+    {
+        if (S.order == SIG_INTEL)
+        {
+            bit = (raw >> i) & 1;
+            b[pos >> 3] = (b[pos >> 3] & ~(1 << (pos & 7))) | (bit << (pos & 7));
+            pos++;
+        }
+        else
+        {
+            bit = (raw >> (S.length - 1 - i)) & 1;
+            b[pos >> 3] = (b[pos >> 3] & ~(1 << (pos & 7))) | (bit << (pos & 7));
+            pos = (pos & 7) ? pos - 1 : pos + 15;
+        }
+    }
+}
+
+static void generatedRaw(const sFrame &F, sWHEEL_SPEEDS &m, int32_t *raw)
+{
+    m.decode(F);
+    raw[0] = m.WheelFL; raw[1] = m.WheelFR; raw[2] = m.WheelRL; raw[3] = m.WheelRR; raw[4] = m.YawRate;
+    raw[5] = m.Counter;
+}
+
+static void generatedRaw(const sFrame &F, sBMS_STATUS &m, int32_t *raw)
+{
+    m.decode(F);
+    raw[0] = m.PackVoltage; raw[1] = m.PackCurrent; raw[2] = m.StateOfCharge; raw[3] = m.CellTempMax;
+    raw[4] = m.Contactor; raw[5] = m.Checksum;
+}
+
+static void generatedPack(sFrame &F, sWHEEL_SPEEDS &m, const int32_t *raw)
+{
+    m.WheelFL = raw[0]; m.WheelFR = raw[1]; m.WheelRL = raw[2]; m.WheelRR = raw[3]; m.YawRate = raw[4];
+    m.Counter = raw[5];
+    m.encode(F);
+}
+
+static void generatedPack(sFrame &F, sBMS_STATUS &m, const int32_t *raw)
+{
+    m.PackVoltage = raw[0]; m.PackCurrent = raw[1]; m.StateOfCharge = raw[2]; m.CellTempMax = raw[3];
+    m.Contactor = raw[4]; m.Checksum = raw[5];
+    m.encode(F);
+}
+
+template <class MSG> static void bench(const char *name, const sFrame *frames, const sCANSignal *signals, uint8_t num)
+{
+    cSignalCodec codec;
+    int32_t raw[CAN_SIG_MAX_SIGNALS], value[CAN_SIG_MAX_SIGNALS], ref[CAN_SIG_MAX_SIGNALS];
+    volatile int64_t sink = 0;
+    int64_t acc;
+    unsigned p, i, s, errors = 0;
+    static int32_t values[NUM_FRAMES][CAN_SIG_MAX_SIGNALS];
+    sFrame out;
+    MSG m;
+
+    errors += !codec.setup(signals, num, 2);
+
+    for (i = 0; i < NUM_FRAMES; i++)
+    {
+        codec.decode(frames[i].U.b, raw, value);
+        generatedRaw(frames[i], m, ref);
+        for (s = 0; s < num; s++)
+        {
+            errors += (raw[s] != ref[s]) || (raw[s] != naiveGet(frames[i].U.b, signals[s]));
+            values[i][s] = raw[s];
+        }
+
+        //packing the decoded values over a copy of the frame has to give back the same frame
+        out = frames[i];
+        codec.encode(raw, out.U.b);
+        errors += (memcmp(out.U.b, frames[i].U.b, 8) != 0);
+
+        memset(out.U.b, 0, 8);
+        for (s = 0; s < num; s++)
+        {
+            naiveSet(out.U.b, signals[s], raw[s]);
+        }
+        errors += (dbcLoad(out.U.b) != MSG::pack(m));
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (p = 0, acc = 0; p < NUM_PASSES; p++)
+    {
+        for (i = 0; i < NUM_FRAMES; i++)
+        {
+            for (s = 0; s < num; s++)
+            {
+                acc += naiveGet(frames[i].U.b, signals[s]);
+            }
+        }
+    }
+    sink = acc;
+    auto t1 = std::chrono::steady_clock::now();
+    for (p = 0, acc = 0; p < NUM_PASSES; p++)
+    {
+        for (i = 0; i < NUM_FRAMES; i++)
+        {
+            codec.decode(frames[i].U.b, raw, value);
+            acc += raw[0] + value[num - 1];
+        }
+    }
+    sink = acc;
+    auto t2 = std::chrono::steady_clock::now();
+    for (p = 0, acc = 0; p < NUM_PASSES; p++)
+    {
+        for (i = 0; i < NUM_FRAMES; i++)
+        {
+            generatedRaw(frames[i], m, raw);
+            acc += raw[0] + raw[num - 1];
+        }
+    }
+    sink = acc;
+    auto t3 = std::chrono::steady_clock::now();
+
+    //encode
+    for (p = 0, acc = 0; p < NUM_PASSES; p++)
+    {
+        for (i = 0; i < NUM_FRAMES; i++)
+        {
+            for (s = 0; s < num; s++)
+            {
+                naiveSet(out.U.b, signals[s], values[i][s]);
+            }
+            acc += out.U.b[i & 7];
+        }
+    }
+    sink = acc;
+    auto t4 = std::chrono::steady_clock::now();
+    for (p = 0, acc = 0; p < NUM_PASSES; p++)
+    {
+        for (i = 0; i < NUM_FRAMES; i++)
+        {
+            codec.encode(values[i], out.U.b);
+            acc += out.U.b[i & 7];
+        }
+    }
+    sink = acc;
+    auto t5 = std::chrono::steady_clock::now();
+    for (p = 0, acc = 0; p < NUM_PASSES; p++)
+    {
+        for (i = 0; i < NUM_FRAMES; i++)
+        {
+            generatedPack(out, m, values[i]);
+            acc += out.U.b[i & 7];
+        }
+    }
+    sink = acc;
+    auto t6 = std::chrono::steady_clock::now();
+    (void)sink;
+
+    double n = (double)NUM_PASSES * NUM_FRAMES;
+    double naiveNs   = std::chrono::duration<double, std::nano>(t1 - t0).count() / n;
+    double runtimeNs = std::chrono::duration<double, std::nano>(t2 - t1).count() / n;
+    double genNs     = std::chrono::duration<double, std::nano>(t3 - t2).count() / n;
+
+    printf("%-14s %-7s %8u %10.3f %12.3f %14.3f %8u\n", name, "decode", num, naiveNs, runtimeNs, genNs, errors);
+
+    naiveNs   = std::chrono::duration<double, std::nano>(t4 - t3).count() / n;
+    runtimeNs = std::chrono::duration<double, std::nano>(t5 - t4).count() / n;
+    genNs     = std::chrono::duration<double, std::nano>(t6 - t5).count() / n;
+
+    printf("%-14s %-7s %8u %10.3f %12.3f %14.3f\n", name, "encode", num, naiveNs, runtimeNs, genNs);
+}
+
+int main()
+{
+    static sFrame frames[NUM_FRAMES];
+    unsigned i, j;
+
+    srand(1);
+    for (i = 0; i < NUM_FRAMES; i++)
+    {
+        for (j = 0; j < 8; j++)
+        {
+            frames[i].U.b[j] = rand() & 0xFF;
+        }
+    }
+
+    printf("%-14s %-7s %8s %10s %12s %14s %8s\n", "message", "", "signals", "naive ns", "runtime ns", "generated ns",
+           "errors");
+    bench<sWHEEL_SPEEDS>("WHEEL_SPEEDS", frames, wheelSignals, 6);
+    bench<sBMS_STATUS>("BMS_STATUS", frames, bmsSignals, 6);
+
+    //a descriptor outside the cFixedScale limits is refused, e.g. J1939 SPN 580 altitude (offset -2500m) at 2 decimals
+    sCANSignal altitude = {0, 16, SIG_INTEL, false, 0.125f, -2500.0f};
+    cSignalCodec codec;
+    bool at2 = codec.setup(&altitude, 1, 2);
+    bool at0 = codec.setup(&altitude, 1, 0);
+    printf("\naltitude (0.125, -2500): 2 decimals %s, 0 decimals %s\n", at2 ? "accepted" : "refused",
+           at0 ? "accepted" : "refused");
+
+    return((at2 || !at0) ? 1 : 0);
+}
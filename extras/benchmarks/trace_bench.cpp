@@ -0,0 +1,268 @@
+/*
+  Host benchmark: compact binary trace format (CAN_Trace.h) on the drive recorded in driveHome.trc.
+
+  build & run (from the library root):
+      g++ -O2 -std=c++11 -I. extras/benchmarks/trace_bench.cpp -o trace_bench && ./trace_bench [driveHome.trc]
+
+  Every frame of the PCAN trace is logged into a cTraceRing, the ring is drained and decoded again and compared with
+  the input. Reported: the size of the trace as PCAN text, as a fixed binary struct per frame and in the compact format,
+  the time to log a frame (ring write incl. encoding) and to decode it, and the drop accounting of a ring that is too
+  small (frames decoded + frames in drop markers + drops not written yet has to be the number of frames).
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <chrono>
+#include "CAN_Trace.h"
+
+#define NUM_PASSES 200
+
+struct sFrame
+{
+    uint32_t time;
+    uint32_t id;
+    uint8_t  dlc;
+    uint8_t  data[8];
+};
+
+/**
+ * byte sink for drain(), as Print::write
+ */
+struct sSink
+{
+    std::vector<uint8_t> bytes;
+
+    size_t write(const uint8_t *p, size_t n)
+    {
+        bytes.insert(bytes.end(), p, p + n);
+        return(n);
+    }
+};
+
+static long fileSize(const char *name)
+{
+    FILE *f = fopen(name, "rb");
+    long n;
+
+    if (!f)
+    {
+        return(0);
+    }
+    fseek(f, 0, SEEK_END);
+    n = ftell(f);
+    fclose(f);
+    return(n);
+}
+
+/**
+ * read the frames of a PCAN trace (v1.1: "  N)  time(mS)  Rx  ID  DLC  bytes")
+ */
+static std::vector<sFrame> readTrc(const char *name)
+{
+    std::vector<sFrame> frames;
+    char line[256], type[8];
+    unsigned num, id, dlc, b[8];
+    double ms;
+    FILE *f = fopen(name, "r");
+    int n, i;
+
+    if (!f)
+    {
+        return(frames);
+    }
+
+    while (fgets(line, sizeof(line), f))
+    {
+        n = sscanf(line, " %u) %lf %7s %x %u %x %x %x %x %x %x %x %x", &num, &ms, type, &id, &dlc,
+                   &b[0], &b[1], &b[2], &b[3], &b[4], &b[5], &b[6], &b[7]);
+        if ((n < 5) || (dlc > 8) || (n < (int)(5 + dlc)))
+        {
+            continue;
+        }
+
+        sFrame F;
+        F.time = (uint32_t)(ms * 1000.0 + 0.5);
+        F.id   = id;
+        F.dlc  = dlc;
+        memset(F.data, 0, 8);
+        for (i = 0; i < (int)dlc; i++)
+        {
+            F.data[i] = b[i];
+        }
+        frames.push_back(F);
+    }
+    fclose(f);
+    return(frames);
+}
+
+/**
+ * decode a stream, count the frames and the frames in drop markers, compare the frames with the input from index first
+ * (frame i was logged on port i & 1 when alternate is set, else on port 0)
+ */
+static unsigned decode(const std::vector<uint8_t> &s, const std::vector<sFrame> &frames, size_t first,
+                       unsigned &decoded, unsigned &lost, bool alternate = false)
+{
+    cTraceDecoder D;
+    sTraceRecord R;
+    unsigned errors = 0;
+    size_t pos = 0, i = first;
+    uint32_t n;
+
+    decoded = 0;
+    lost    = 0;
+    while ((n = D.next(&s[pos], s.size() - pos, R)) != 0)
+    {
+        pos += n;
+        if (!D.isSynced())
+        {
+            continue;
+        }
+        if (R.type == TRACE_REC_DROP)
+        {
+            lost += R.count;
+            i    += R.count;
+        }
+        if (R.type == TRACE_REC_SYNC)
+        {
+            //a reader that starts in the middle of the stream picks up the frame number here
+            i = R.count;
+        }
+        if (R.type != TRACE_REC_FRAME)
+        {
+            continue;
+        }
+
+        decoded += 1;
+        if (i >= frames.size())
+        {
+            errors += 1;
+            continue;
+        }
+        const sFrame &F = frames[i];
+        errors += (R.time != F.time) || (R.id != F.id) || (R.dlc != F.dlc) || R.tx || R.extended ||
+                  (R.port != (alternate ? (i & 1) : 0)) || (memcmp(R.data, F.data, 8) != 0);
+        i += 1;
+    }
+    return(errors);
+}
+
+int main(int argc, char **argv)
+{
+    const char *name = (argc > 1) ? argv[1] : "driveHome.trc";
+    std::vector<sFrame> frames = readTrc(name);
+    static uint8_t storage[1 << 20];
+    static uint8_t small[4096];
+    cTraceRing ring;
+    sSink sink;
+    unsigned p, i, decoded, lost, errors;
+    volatile uint32_t sinkBytes = 0;
+
+    if (frames.empty())
+    {
+        printf("no frames in %s\n", name);
+        return(1);
+    }
+
+    //correctness, logged and drained in chunks as loop() would
+    ring.begin(storage, sizeof(storage));
+    for (i = 0; i < frames.size(); i++)
+    {
+        const sFrame &F = frames[i];
+        ring.log(F.time, F.id, false, false, false, F.dlc, F.data);
+        if ((i & 63) == 63)
+        {
+            ring.drain(sink, 512);
+        }
+    }
+    ring.drain(sink);
+    errors = decode(sink.bytes, frames, 0, decoded, lost);
+    errors += (decoded != frames.size());
+
+    //a reader that starts in the middle of the stream
+    std::vector<uint8_t> tail(sink.bytes.begin() + sink.bytes.size() / 3, sink.bytes.end());
+    unsigned tailDecoded, tailLost;
+    errors += decode(tail, frames, 0, tailDecoded, tailLost);
+
+    //two ports sharing a ring, worst case: every frame from the other port than the one before (port markers)
+    sSink ports;
+    unsigned portsDecoded, portsLost;
+    ring.begin(storage, sizeof(storage));
+    for (i = 0; i < frames.size(); i++)
+    {
+        const sFrame &F = frames[i];
+        ring.log(F.time, F.id, false, false, false, F.dlc, F.data, i & 1);
+    }
+    ring.drain(ports);
+    errors += decode(ports.bytes, frames, 0, portsDecoded, portsLost, true);
+    errors += (portsDecoded != frames.size());
+
+    //logging cost, ring write incl. encoding
+    auto t0 = std::chrono::steady_clock::now();
+    for (p = 0; p < NUM_PASSES; p++)
+    {
+        ring.begin(storage, sizeof(storage));
+        for (i = 0; i < frames.size(); i++)
+        {
+            const sFrame &F = frames[i];
+            ring.log(F.time, F.id, false, false, false, F.dlc, F.data);
+        }
+        sinkBytes += ring.available();
+    }
+    auto t1 = std::chrono::steady_clock::now();
+
+    //decoding cost
+    for (p = 0; p < NUM_PASSES / 10; p++)
+    {
+        errors += decode(sink.bytes, frames, 0, decoded, lost);
+    }
+    auto t2 = std::chrono::steady_clock::now();
+
+    //ring too small: every frame is either in the stream, counted in a drop marker or still pending in the ring, the
+    //frame numbers stay in step. Both drains go to the same sink so one decoder stays synced across them
+    ring.begin(small, sizeof(small));
+    sSink drained;
+    for (i = 0; i < frames.size(); i++)
+    {
+        const sFrame &F = frames[i];
+        ring.log(F.time, F.id, false, false, false, F.dlc, F.data);
+        if (i == frames.size() / 2)
+        {
+            //drain once half way so a drop marker is written after it
+            ring.drain(drained);
+        }
+    }
+    ring.drain(drained);
+    unsigned smallDecoded, smallLost;
+    errors += decode(drained.bytes, frames, 0, smallDecoded, smallLost);
+    errors += ((smallDecoded + smallLost + ring.getPendingDrops()) != frames.size());
+    errors += (ring.getFrames() != frames.size());
+    (void)sinkBytes;
+
+    double n = (double)frames.size();
+    long trcBytes   = fileSize(name);
+    long serialLog  = fileSize("driveHomeSerialLog.txt");
+    long fixedBytes = (long)frames.size() * 17;
+    long traceBytes = (long)sink.bytes.size();
+
+    printf("%s: %u frames\n\n", name, (unsigned)frames.size());
+    printf("%-40s %10s %12s %8s\n", "format", "bytes", "bytes/frame", "ratio");
+    printf("%-40s %10ld %12.2f %8.2f\n", "PCAN trace text (.trc)", trcBytes, trcBytes / n, 1.0);
+    printf("%-40s %10ld %12.2f %8.2f\n", "binary struct (time, ID, DLC, 8 bytes)", fixedBytes, fixedBytes / n,
+           (double)trcBytes / fixedBytes);
+    printf("%-40s %10ld %12.2f %8.2f\n", "compact trace (CAN_Trace.h)", traceBytes, traceBytes / n,
+           (double)trcBytes / traceBytes);
+    printf("%-40s %10ld %12.2f %8.2f\n", "compact trace, 2 ports alternating", (long)ports.bytes.size(),
+           ports.bytes.size() / n, (double)trcBytes / ports.bytes.size());
+    printf("%-40s %10ld %12s %8s\n", "(Serial.print float text of the drive)", serialLog, "-", "-");
+    printf("\ncompact vs. binary struct: %.2fx smaller\n", (double)fixedBytes / traceBytes);
+    printf("log   %.1f ns/frame (ring write incl. encoding)\n",
+           std::chrono::duration<double, std::nano>(t1 - t0).count() / (n * NUM_PASSES));
+    printf("decode %.1f ns/frame\n", std::chrono::duration<double, std::nano>(t2 - t1).count() / (n * (NUM_PASSES / 10)));
+    printf("reader from the middle: %u frames decoded after the first sync marker\n", tailDecoded);
+    printf("4kB ring, drained once half way: %u frames counted, %u dropped, decoded %u frames + %u in drop markers"
+           " + %u pending\n", ring.getFrames(), ring.getDropped(), smallDecoded, smallLost, ring.getPendingDrops());
+    printf("errors %u\n", errors);
+
+    return(errors ? 1 : 0);
+}
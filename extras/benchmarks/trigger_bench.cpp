@@ -0,0 +1,327 @@
+/*
+  Host benchmark: pre/post-trigger capture (CAN_Trigger.h) on the drive recorded in driveHome.trc.
+
+  build & run (from the library root):
+      g++ -O2 -std=c++11 -I. extras/benchmarks/trigger_bench.cpp -o trigger_bench && ./trigger_bench [driveHome.trc]
+
+  Correctness: the drive is fed to a capture triggering on the OBD2 coolant temperature response (0x7E8, 41 05,
+  byte 3 - 40 degC) above a threshold, the capture has to hold the frames before and after the first frame above it in
+  the order received, also when the trigger comes before the pre-trigger window is filled and without post-trigger
+  frames, and download() has to decode to the same frames. 32 bit signals have to compare over their whole range.
+  Cost: ns per frame with TRIG_MAX_CONDITIONS conditions that match every frame's ID and pattern but whose signal never
+  reaches its threshold (every part of every condition is checked, the bound), with one condition and once frozen.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <chrono>
+#include "CAN_Trigger.h"
+
+#define NUM_PASSES 200
+#define CAPTURE_SIZE 512
+
+struct sFrame
+{
+    uint32_t time;
+    uint32_t id;
+    uint8_t  dlc;
+    uint8_t  data[8];
+};
+
+/**
+ * byte sink for download(), as Print::write
+ */
+struct sSink
+{
+    std::vector<uint8_t> bytes;
+
+    size_t write(const uint8_t *p, size_t n)
+    {
+        bytes.insert(bytes.end(), p, p + n);
+        return(n);
+    }
+};
+
+/**
+ * read the frames of a PCAN trace (v1.1: "  N)  time(mS)  Rx  ID  DLC  bytes")
+ */
+static std::vector<sFrame> readTrc(const char *name)
+{
+    std::vector<sFrame> frames;
+    char line[256], type[8];
+    unsigned num, id, dlc, b[8];
+    double ms;
+    FILE *f = fopen(name, "r");
+    int n, i;
+
+    if (!f)
+    {
+        return(frames);
+    }
+
+    while (fgets(line, sizeof(line), f))
+    {
+        n = sscanf(line, " %u) %lf %7s %x %u %x %x %x %x %x %x %x %x", &num, &ms, type, &id, &dlc,
+                   &b[0], &b[1], &b[2], &b[3], &b[4], &b[5], &b[6], &b[7]);
+        if ((n < 5) || (dlc > 8) || (n < (int)(5 + dlc)))
+        {
+            continue;
+        }
+
+        sFrame F;
+        F.time = (uint32_t)(ms * 1000.0 + 0.5);
+        F.id   = id;
+        F.dlc  = dlc;
+        memset(F.data, 0, 8);
+        for (i = 0; i < (int)dlc; i++)
+        {
+            F.data[i] = b[i];
+        }
+        frames.push_back(F);
+    }
+    fclose(f);
+    return(frames);
+}
+
+/**
+ * index of the first coolant temperature response above degC, -1 if none
+ */
+static long firstAbove(const std::vector<sFrame> &frames, int degC)
+{
+    size_t i;
+
+    for (i = 0; i < frames.size(); i++)
+    {
+        const sFrame &F = frames[i];
+        if ((F.id == 0x7E8) && (F.data[1] == 0x41) && (F.data[2] == 0x05) && ((int)F.data[3] - 40 > degC))
+        {
+            return((long)i);
+        }
+    }
+    return(-1);
+}
+
+/**
+ * feed the drive to a coolant capture, compare the capture with the frames around the first frame above degC
+ */
+static unsigned coolantCapture(const std::vector<sFrame> &frames, sCaptureFrame *storage, int degC, uint16_t pre,
+                               uint16_t post, unsigned &count, unsigned &trigIndex, long &trigFrame)
+{
+    static const uint8_t pid05[8]   = {0, 0x41, 0x05};
+    static const uint8_t pidMask[8] = {0, 0xFF, 0xFF};
+    sCANSignal coolant = {24, 8, SIG_INTEL, false, 1, -40};
+    cTriggerCapture Capture;
+    unsigned errors = 0, triggers = 0;
+    uint16_t i;
+    size_t f;
+    long first;
+    uint8_t c;
+
+    Capture.begin(storage, CAPTURE_SIZE);
+    Capture.addCondition(0x100, 0x7FF, false);                     //never received, checked before the coolant one
+    c = Capture.addCondition(0x7E8, 0x7FF, false);
+    errors += !Capture.setPattern(c, pid05, pidMask);
+    errors += !Capture.setSignal(c, coolant, TRIG_ABOVE, (float)degC);
+    errors += !Capture.arm(pre, post);
+    errors += (Capture.addCondition(0x7DF, 0x7FF, false) != TRIG_INVALID);   //armed: conditions are fixed
+
+    for (f = 0; f < frames.size(); f++)
+    {
+        const sFrame &F = frames[f];
+        triggers += Capture.frame(F.time, F.id, false, false, F.dlc, F.data, f & 1);
+    }
+
+    first     = firstAbove(frames, degC);
+    count     = Capture.getCount();
+    trigIndex = Capture.getTriggerIndex();
+    trigFrame = first;
+    if (first < 0)
+    {
+        return(errors + (triggers != 0) + (Capture.getState() != TRIG_ARMED));
+    }
+
+    //expected: up to pre frames before the trigger frame, post frames after it
+    size_t expectPre  = ((size_t)first < pre) ? (size_t)first : pre;
+    size_t expectPost = ((frames.size() - first - 1) < post) ? (frames.size() - first - 1) : post;
+    errors += (triggers != 1) || (Capture.getTriggerCondition() != c) || (trigIndex != expectPre);
+    errors += (count != expectPre + 1 + expectPost);
+    errors += (Capture.getState() != ((expectPost == post) ? TRIG_FROZEN : TRIG_TRIGGERED));
+
+    for (i = 0; i < count; i++)
+    {
+        const sCaptureFrame *C = Capture.getFrame(i);
+        size_t n = first - expectPre + i;
+        const sFrame &F = frames[n];
+        errors += (C->time != F.time) || (C->id != F.id) || (C->dlc != F.dlc) || (C->flags != 0) ||
+                  (C->port != (n & 1)) || (memcmp(C->data, F.data, 8) != 0);
+    }
+    errors += (Capture.getFrame(count) != NULL);
+
+    //download: the same frames in the compact trace format
+    sSink sink;
+    cTraceDecoder D;
+    sTraceRecord R;
+    size_t pos = 0;
+    uint32_t n;
+    i = 0;
+    Capture.download(sink);
+    while ((n = D.next(&sink.bytes[pos], sink.bytes.size() - pos, R)) != 0)
+    {
+        pos += n;
+        if (R.type != TRACE_REC_FRAME)
+        {
+            continue;
+        }
+        const sCaptureFrame *C = Capture.getFrame(i++);
+        errors += !C || (R.time != C->time) || (R.id != C->id) || (R.dlc != C->dlc) || (R.port != C->port) ||
+                  R.extended || R.rtr || (memcmp(R.data, C->data, 8) != 0);
+    }
+    errors += (i != count);
+
+    //a frozen capture is kept until it is armed again
+    if (Capture.getState() == TRIG_FROZEN)
+    {
+        const sFrame &F = frames[first];
+        errors += Capture.frame(F.time, F.id, false, false, F.dlc, F.data);
+        errors += (Capture.getCount() != count);
+    }
+    return(errors);
+}
+
+/**
+ * 32 bit signals: unsigned values from 2^31 up and signed values down to -2^31 compare as the signal's type
+ */
+static unsigned wideSignals(sCaptureFrame *storage)
+{
+    static const struct
+    {
+        bool     isSigned;
+        uint32_t value;
+        bool     triggers;
+    } cases[] =
+    {
+        {false, 3000000001u, true}, {false, 3000000000u, false}, {false, 0x7FFFFFFFu, false}, {false, 0xFFFFFFFFu, true},
+        {true, (uint32_t)-2000000001, true}, {true, (uint32_t)-2000000000, false}, {true, 0x7FFFFFFFu, false}
+    };
+    cTriggerCapture Capture;
+    unsigned errors = 0;
+    uint8_t d[8] = {0};
+    size_t k;
+
+    for (k = 0; k < sizeof(cases) / sizeof(cases[0]); k++)
+    {
+        sCANSignal S = {0, 32, SIG_INTEL, cases[k].isSigned, 1, 0};
+
+        Capture.begin(storage, CAPTURE_SIZE);
+        errors += !Capture.setSignal(Capture.addCondition(0x100, 0x7FF, false), S,
+                                     cases[k].isSigned ? TRIG_BELOW : TRIG_ABOVE, cases[k].isSigned ? -2e9f : 3e9f);
+        Capture.arm(0, 0);
+        memcpy(d, &cases[k].value, 4);
+        errors += (Capture.frame(0, 0x100, false, false, 8, d) != cases[k].triggers);
+    }
+    return(errors);
+}
+
+/**
+ * ns per frame of the drive through a capture that is never triggered (or frozen)
+ */
+static double cost(const std::vector<sFrame> &frames, cTriggerCapture &Capture)
+{
+    volatile unsigned triggers = 0;
+    unsigned p;
+    size_t f;
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (p = 0; p < NUM_PASSES; p++)
+    {
+        for (f = 0; f < frames.size(); f++)
+        {
+            const sFrame &F = frames[f];
+            triggers += Capture.frame(F.time, F.id, false, false, F.dlc, F.data);
+        }
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    (void)triggers;
+    return(std::chrono::duration<double, std::nano>(t1 - t0).count() / ((double)frames.size() * NUM_PASSES));
+}
+
+int main(int argc, char **argv)
+{
+    const char *name = (argc > 1) ? argv[1] : "driveHome.trc";
+    std::vector<sFrame> frames = readTrc(name);
+    static sCaptureFrame storage[CAPTURE_SIZE];
+    static const uint8_t none[8] = {0};
+    cTriggerCapture Capture;
+    unsigned errors = 0, count, trigIndex;
+    long trigFrame;
+    uint8_t i;
+
+    if (frames.empty())
+    {
+        printf("no frames in %s\n", name);
+        return(1);
+    }
+
+    printf("%s: %u frames, %u frame capture\n\n", name, (unsigned)frames.size(), CAPTURE_SIZE);
+    printf("%-48s %8s %8s %8s %8s\n", "coolant capture", "frame", "pre", "count", "errors");
+
+    //ring wrapped before the trigger
+    unsigned e = coolantCapture(frames, storage, 84, 400, 100, count, trigIndex, trigFrame);
+    printf("%-48s %8ld %8u %8u %8u\n", "> 84 degC, 400 pre / 100 post", trigFrame, trigIndex, count, e);
+    errors += e + (trigFrame < 0);
+
+    //trigger before the pre-trigger window is filled
+    e = coolantCapture(frames, storage, 74, 400, 100, count, trigIndex, trigFrame);
+    printf("%-48s %8ld %8u %8u %8u\n", "> 74 degC (first response), 400 pre / 100 post", trigFrame, trigIndex, count, e);
+    errors += e;
+
+    //no post-trigger frames, the whole storage before the trigger
+    e = coolantCapture(frames, storage, 84, CAPTURE_SIZE - 1, 0, count, trigIndex, trigFrame);
+    printf("%-48s %8ld %8u %8u %8u\n", "> 84 degC, 511 pre / 0 post", trigFrame, trigIndex, count, e);
+    errors += e;
+
+    //never above
+    e = coolantCapture(frames, storage, 120, 400, 100, count, trigIndex, trigFrame);
+    printf("%-48s %8ld %8u %8u %8u\n", "> 120 degC (never)", trigFrame, trigIndex, count, e);
+    errors += e;
+
+    e = wideSignals(storage);
+    printf("%-48s %8s %8s %8s %8u\n", "32 bit signals above 2^31 / below -2^31", "-", "-", "-", e);
+    errors += e;
+
+    //worst case: every condition matches every frame's ID and pattern, the signal is extracted and compared
+    sCANSignal never = {8, 16, SIG_MOTOROLA, false, 1, 0};
+    Capture.begin(storage, CAPTURE_SIZE);
+    for (i = 0; i < TRIG_MAX_CONDITIONS; i++)
+    {
+        uint8_t c = Capture.addCondition(0, 0, false);
+        errors += !Capture.setPattern(c, none, none);
+        errors += !Capture.setSignal(c, never, TRIG_ABOVE, 70000);
+    }
+    errors += (Capture.addCondition(0, 0, false) != TRIG_INVALID);
+    errors += !Capture.arm(400, 100);
+    double worst = cost(frames, Capture);
+    errors += (Capture.getState() != TRIG_ARMED);
+
+    //one condition
+    Capture.clearConditions();
+    errors += (Capture.setSignal(0, never, TRIG_ABOVE, 70000));
+    Capture.setSignal(Capture.addCondition(0, 0, false), never, TRIG_ABOVE, 70000);
+    Capture.arm(400, 100);
+    double one = cost(frames, Capture);
+
+    //frozen: a condition every frame meets
+    Capture.disarm();
+    Capture.setSignal(0, never, TRIG_BELOW, 70000);
+    Capture.arm(400, 0);
+    double frozen = cost(frames, Capture);
+    errors += (Capture.getState() != TRIG_FROZEN) || (Capture.getCount() != 1);
+
+    printf("\n%-48s %8.1f ns/frame\n", "8 conditions, ID + pattern + signal each", worst);
+    printf("%-48s %8.1f ns/frame\n", "1 condition", one);
+    printf("%-48s %8.1f ns/frame\n", "frozen", frozen);
+    printf("errors %u\n", errors);
+
+    return(errors ? 1 : 0);
+}
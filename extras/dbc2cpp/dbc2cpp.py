@@ -0,0 +1,288 @@
+#!/usr/bin/env python3
+"""
+DBC to C++ message header generator for the CAN acquisition library.
+
+Reads the messages (BO_), signals (SG_) and comments (CM_) of a DBC file and writes a header with one struct per
+message. Each struct holds the raw signal values as typed fields and has:
+
+    - ID / DLC constants (ID is the 29 bit ID for extended frames, cCANFrame sends ID's > 0x7FF as extended)
+    - <signal>_SHIFT / <signal>_MASK / <signal>_SCALE / <signal>_OFFSET constants
+    - constexpr get_<signal>(word) / put_<signal>(raw) for a single signal
+    - constexpr unpack(word) / pack(msg) for the whole payload
+    - decode(frame) / encode(frame) for anything with a U.b[8] payload (cCANFrame, RX_CAN_FRAME's data is .byte)
+
+All shifts and masks are resolved when the header is generated, decoding is one load of the payload word followed by
+a shift and an AND per signal (see CAN_DBC.h). Multiplexed signals are decoded like any other signal, the comment
+says which multiplexor value they are valid for.
+
+usage (from the library root):
+    python3 extras/dbc2cpp/dbc2cpp.py extras/dbc2cpp/J1939Sim.dbc -o Examples/CAN_1939Sim/J1939Sim_dbc.h
+"""
+import argparse
+import os
+import re
+import sys
+
+RE_MESSAGE = re.compile(r'^BO_\s+(\d+)\s+(\w+)\s*:\s*(\d+)\s+(\w+)')
+RE_SIGNAL = re.compile(r'^SG_\s+(\w+)\s*(M|m\d+)?\s*:\s*(\d+)\|(\d+)@([01])([+-])\s*'
+                       r'\(([^,]+),([^)]+)\)\s*\[([^|]*)\|([^\]]*)\]\s*"([^"]*)"')
+RE_COMMENT = re.compile(r'CM_\s+(BO_|SG_)\s+(\d+)\s+(\w+)?\s*"([^"]*)"\s*;')
+
+CAN_EXTENDED_FLAG = 0x80000000
+
+
+class Signal(object):
+    def __init__(self, name, mux, start, length, intel, signed, scale, offset, minimum, maximum, unit):
+        self.name = name
+        self.mux = mux
+        self.start = start
+        self.length = length
+        self.intel = intel
+        self.signed = signed
+        self.scale = scale
+        self.offset = offset
+        self.minimum = minimum
+        self.maximum = maximum
+        self.unit = unit
+        self.comment = ''
+
+    @property
+    def mask(self):
+        return (1 << self.length) - 1
+
+    @property
+    def shift(self):
+        """shift of the signal's LSB in the payload word (Intel) or in the byte swapped payload word (Motorola)"""
+        if self.intel:
+            return self.start
+
+        # Motorola start bit is the MSB, counted LSB first within each byte: position from the top of the swapped word
+        msb = (self.start // 8) * 8 + (7 - self.start % 8)
+        return 64 - msb - self.length
+
+    @property
+    def ctype(self):
+        for bits in (8, 16, 32, 64):
+            if self.length <= bits:
+                return ('int%d_t' if self.signed else 'uint%d_t') % bits
+        raise ValueError('signal %s is longer than 64 bits' % self.name)
+
+
+class Message(object):
+    def __init__(self, can_id, name, dlc, sender):
+        self.extended = bool(can_id & CAN_EXTENDED_FLAG)
+        self.can_id = can_id & ~CAN_EXTENDED_FLAG
+        self.name = name
+        self.dlc = dlc
+        self.sender = sender
+        self.signals = []
+        self.comment = ''
+
+
+def parse_dbc(text):
+    """parse the messages, signals and comments of a DBC file"""
+    messages = {}
+    current = None
+
+    for line in text.splitlines():
+        line = line.strip()
+
+        m = RE_MESSAGE.match(line)
+        if m:
+            current = Message(int(m.group(1)), m.group(2), int(m.group(3)), m.group(4))
+            messages[current.can_id] = current
+            continue
+
+        m = RE_SIGNAL.match(line)
+        if m and current is not None:
+            sig = Signal(m.group(1), m.group(2), int(m.group(3)), int(m.group(4)), m.group(5) == '1',
+                         m.group(6) == '-', float(m.group(7)), float(m.group(8)), m.group(9), m.group(10), m.group(11))
+            if sig.length < 1 or sig.length > 64 or sig.shift < 0 or sig.shift + sig.length > 64:
+                raise ValueError('signal %s.%s does not fit an 8 byte payload' % (current.name, sig.name))
+            current.signals.append(sig)
+            continue
+
+        if not line.startswith('SG_'):
+            current = None
+
+    # comments can span lines, search the whole file
+    for m in RE_COMMENT.finditer(text):
+        msg = messages.get(int(m.group(2)) & ~CAN_EXTENDED_FLAG)
+        if msg is None:
+            continue
+        comment = ' '.join(m.group(4).split())
+        if m.group(1) == 'BO_':
+            msg.comment = (m.group(3) + ' ' + comment).strip() if m.group(3) else comment
+        else:
+            for sig in msg.signals:
+                if sig.name == m.group(3):
+                    sig.comment = comment
+
+    return [messages[k] for k in sorted(messages)]
+
+
+def fmt_float(value):
+    text = repr(float(value))
+    return text + 'f'
+
+
+def signal_doc(sig):
+    parts = []
+    if sig.comment:
+        parts.append(sig.comment)
+    parts.append('%s%s start bit %d, %d bits' % ('Intel' if sig.intel else 'Motorola', ' signed' if sig.signed else '',
+                                                sig.start, sig.length))
+    parts.append('%g/bit %+g %s' % (sig.scale, sig.offset, sig.unit) if sig.unit else
+                 '%g/bit %+g' % (sig.scale, sig.offset))
+    if sig.mux == 'M':
+        parts.append('multiplexor')
+    elif sig.mux:
+        parts.append('valid when the multiplexor is %s' % sig.mux[1:])
+    return ', '.join(parts)
+
+
+def emit_message(msg, out):
+    name = 's' + msg.name
+    intel = [s for s in msg.signals if s.intel]
+    motorola = [s for s in msg.signals if not s.intel]
+    can_id = ('%08X' if msg.extended else '%03X') % msg.can_id
+
+    out.append('/**')
+    out.append(' * %s%s' % (msg.name, (' - ' + msg.comment) if msg.comment else ''))
+    out.append(' * %s ID 0x%s, %d bytes, sent by %s' % ('extended' if msg.extended else 'standard', can_id,
+                                                       msg.dlc, msg.sender))
+    out.append(' */')
+    out.append('struct %s' % name)
+    out.append('{')
+    out.append('    static constexpr uint32_t ID  = 0x%s;' % can_id)
+    out.append('    static constexpr uint8_t  DLC = %d;' % msg.dlc)
+    out.append('')
+
+    # raw values
+    for sig in msg.signals:
+        out.append('    /**')
+        out.append('     * %s' % signal_doc(sig))
+        out.append('     */')
+        out.append('    %-8s %s;' % (sig.ctype, sig.name))
+        out.append('')
+
+    # layout and scaling constants
+    for sig in msg.signals:
+        out.append('    static constexpr uint8_t  %s_SHIFT  = %d;' % (sig.name, sig.shift))
+        out.append('    static constexpr uint64_t %s_MASK   = 0x%XULL;' % (sig.name, sig.mask))
+        out.append('    static constexpr float    %s_SCALE  = %s;' % (sig.name, fmt_float(sig.scale)))
+        out.append('    static constexpr float    %s_OFFSET = %s;' % (sig.name, fmt_float(sig.offset)))
+    if msg.signals:
+        out.append('')
+
+    # single signal access, Intel from the payload word, Motorola from the swapped payload word
+    for sig in msg.signals:
+        word = 'w' if sig.intel else 'sw'
+        raw = '((%s >> %s_SHIFT) & %s_MASK)' % (word, sig.name, sig.name)
+        if sig.signed:
+            raw = 'dbcSignExtend(%s, %d)' % (raw, sig.length)
+        out.append('    static constexpr %s get_%s(uint64_t %s)' % (sig.ctype, sig.name, word))
+        out.append('    {')
+        out.append('        return((%s)%s);' % (sig.ctype, raw))
+        out.append('    }')
+        out.append('    static constexpr uint64_t put_%s(%s raw)' % (sig.name, sig.ctype))
+        out.append('    {')
+        out.append('        return(((uint64_t)raw & %s_MASK) << %s_SHIFT);' % (sig.name, sig.name))
+        out.append('    }')
+    if msg.signals:
+        out.append('')
+
+    # whole message, aggregate initialisation in declaration order
+    out.append('    /**')
+    out.append('     * decode all signals of a payload word (see dbcLoad)')
+    out.append('     */')
+    if motorola:
+        args = ', '.join('get_%s(%s)' % (s.name, 'w' if s.intel else 'sw') for s in msg.signals)
+        out.append('    static constexpr %s unpack(uint64_t w)' % name)
+        out.append('    {')
+        out.append('        return(unpack(w, dbcSwap(w)));')
+        out.append('    }')
+        # all Motorola: the plain word is not used, leave it unnamed
+        out.append('    static constexpr %s unpack(uint64_t%s, uint64_t sw)' % (name, ' w' if intel else ''))
+        out.append('    {')
+        out.append('        return(%s{%s});' % (name, args))
+        out.append('    }')
+    else:
+        args = ', '.join('get_%s(w)' % s.name for s in msg.signals)
+        out.append('    static constexpr %s unpack(uint64_t w)' % name)
+        out.append('    {')
+        out.append('        return(%s{%s});' % (name, args))
+        out.append('    }')
+    out.append('')
+
+    out.append('    /**')
+    out.append('     * encode all signals into a payload word (see dbcStore), unused bits are 0')
+    out.append('     */')
+    le = ' | '.join('put_%s(m.%s)' % (s.name, s.name) for s in intel)
+    be = ' | '.join('put_%s(m.%s)' % (s.name, s.name) for s in motorola)
+    out.append('    static constexpr uint64_t pack(const %s &m)' % name)
+    out.append('    {')
+    if le and be:
+        out.append('        return((%s) | dbcSwap(%s));' % (le, be))
+    elif be:
+        out.append('        return(dbcSwap(%s));' % be)
+    else:
+        out.append('        return(%s);' % (le or '0'))
+    out.append('    }')
+    out.append('')
+
+    out.append('    /**')
+    out.append('     * decode/encode a frame payload, FRAME is a cCANFrame (or anything else with a U.b[8] payload)')
+    out.append('     */')
+    out.append('    template <class FRAME> void decode(const FRAME &F)')
+    out.append('    {')
+    out.append('        *this = unpack(dbcLoad(F.U.b));')
+    out.append('    }')
+    out.append('    template <class FRAME> void encode(FRAME &F) const')
+    out.append('    {')
+    out.append('        dbcStore(F.U.b, pack(*this));')
+    out.append('    }')
+    out.append('};')
+    out.append('')
+
+
+def generate(messages, source, guard):
+    out = []
+    out.append('/*')
+    out.append('  Generated by extras/dbc2cpp/dbc2cpp.py from %s, do not edit.' % source)
+    out.append('*/')
+    out.append('#ifndef %s' % guard)
+    out.append('#define %s' % guard)
+    out.append('#include "CAN_DBC.h"')
+    out.append('')
+    for msg in messages:
+        emit_message(msg, out)
+    out.append('#endif')
+    return '\n'.join(out) + '\n'
+
+
+def main():
+    parser = argparse.ArgumentParser(description='generate C++ message structs from a DBC file')
+    parser.add_argument('dbc', help='input DBC file')
+    parser.add_argument('-o', '--output', help='output header (default: <dbc name>_dbc.h)')
+    args = parser.parse_args()
+
+    with open(args.dbc, 'r', encoding='latin-1') as f:
+        text = f.read()
+
+    output = args.output or os.path.splitext(args.dbc)[0] + '_dbc.h'
+    guard = re.sub(r'\W', '_', os.path.basename(output)).upper()
+
+    try:
+        messages = parse_dbc(text)
+    except ValueError as e:
+        sys.exit('%s: %s' % (args.dbc, e))
+
+    with open(output, 'w') as f:
+        f.write(generate(messages, os.path.basename(args.dbc), guard))
+
+    print('%s: %d messages, %d signals' % (output, len(messages), sum(len(m.signals) for m in messages)))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,87 @@
+#!/usr/bin/env python3
+"""
+SLCAN throughput test for the cSLCAN adapter (CAN_SLCAN.h), see Examples/CAN_SLCAN.
+
+Opens the channel, then sends 11bit frames with 8 bytes as fast as the adapter acknowledges them (at most --window
+commands waiting for their reply) and counts, per second and in total:
+
+    - frames sent (z replies) and refused (BELL, the adapter's TX queue was full)
+    - frames received (t/T lines), with Examples/CAN_SLCAN and CAN0 wired to CAN1 these are the echoes of the sent frames
+
+Commands are written in batches, replies are read in whatever pieces the port delivers.
+
+usage (pyserial):
+    python3 extras/slcan/slcan_load.py /dev/ttyACM0 --bitrate 6 --seconds 10
+"""
+import argparse
+import sys
+import time
+
+try:
+    import serial
+except ImportError:
+    sys.exit('pyserial is needed: pip install pyserial')
+
+
+def main():
+    parser = argparse.ArgumentParser(description='SLCAN throughput test')
+    parser.add_argument('port', help='serial port of the adapter, e.g. /dev/ttyACM0 or COM5')
+    parser.add_argument('--bitrate', type=int, default=6, help='S command digit, 6 = 500K (default), 8 = 1M')
+    parser.add_argument('--seconds', type=float, default=10.0, help='test duration')
+    parser.add_argument('--window', type=int, default=16, help='transmit commands waiting for their reply')
+    parser.add_argument('--id', type=lambda x: int(x, 0), default=0x123, help='11bit ID of the sent frames')
+    args = parser.parse_args()
+
+    link = serial.Serial(args.port, 115200, timeout=0)
+    link.write(b'C\rS%d\rO\r' % args.bitrate)
+    time.sleep(0.2)
+    setup = link.read(4096)
+    if b'\a' in setup:
+        sys.exit('the adapter refused to open the channel: %r' % setup)
+
+    sent = refused = received = 0
+    last_sent = last_received = 0
+    waiting = 0
+    counter = 0
+    line = bytearray()
+    start = last_print = time.time()
+
+    while (time.time() - start) < args.seconds:
+        # keep the window full, one write for all of the commands
+        batch = bytearray()
+        while waiting < args.window:
+            batch += b't%03X8%016X\r' % (args.id, counter)
+            counter = (counter + 1) & 0xFFFFFFFFFFFFFFFF
+            waiting += 1
+        if batch:
+            link.write(batch)
+
+        for c in link.read(max(1, link.in_waiting)):
+            if c == 0x07:
+                refused += 1
+                waiting -= 1
+            elif c == 0x0D:
+                if line[:1] == b'z':
+                    sent += 1
+                    waiting -= 1
+                elif line[:1] in (b't', b'T', b'r', b'R'):
+                    received += 1
+                line = bytearray()
+            else:
+                line.append(c)
+
+        now = time.time()
+        if (now - last_print) >= 1.0:
+            print('frames/s to CAN: %6d  from CAN: %6d  refused: %d' %
+                  ((sent - last_sent) / (now - last_print), (received - last_received) / (now - last_print), refused))
+            last_sent, last_received, last_print = sent, received, now
+
+    elapsed = time.time() - start
+    link.write(b'C\r')
+    link.close()
+    print('total %.1fs: %d frames to CAN (%.0f/s), %d from CAN (%.0f/s), %d refused' %
+          (elapsed, sent, sent / elapsed, received, received / elapsed, refused))
+
+
+if __name__ == '__main__':
+    main()